@@ -92,12 +92,31 @@ namespace Microsoft.MixedReality.WebRTC.Interop
             [MarshalAs(UnmanagedType.LPStr)]
             public string encodedStreamIds;
 
+            /// <summary>
+            /// Optional user data. Unused by the managed library.
+            /// </summary>
+            public IntPtr userData;
+
+            /// <summary>
+            /// Optional array of send encodings, or <c>IntPtr.Zero</c> for a single
+            /// encoding with default parameters. Not exposed by the managed library yet.
+            /// </summary>
+            public IntPtr sendEncodings;
+
+            /// <summary>
+            /// Number of elements in the <see cref="sendEncodings"/> array.
+            /// </summary>
+            public uint sendEncodingCount;
+
             public InitConfig(MediaKind mediaKind, TransceiverInitSettings settings)
             {
                 name = settings?.Name;
                 this.mediaKind = mediaKind;
                 desiredDirection = (settings != null ? settings.InitialDesiredDirection : new TransceiverInitSettings().InitialDesiredDirection);
                 encodedStreamIds = Utils.EncodeTransceiverStreamIDs(settings?.StreamIDs);
+                userData = IntPtr.Zero;
+                sendEncodings = IntPtr.Zero;
+                sendEncodingCount = 0;
             }
         }
 
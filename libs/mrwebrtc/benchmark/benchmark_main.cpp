@@ -0,0 +1,51 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "benchmark_utils.h"
+
+namespace {
+
+constexpr const char kJsonOutputFlag[] = "--json_output=";
+constexpr const char kDefaultJsonOutput[] = "mrwebrtc_benchmarks.json";
+
+/// Test environment writing all recorded results once all benchmarks ran.
+class JsonOutputEnvironment : public ::testing::Environment {
+ public:
+  explicit JsonOutputEnvironment(std::string path) : path_(std::move(path)) {}
+  void TearDown() override {
+    if (!BenchmarkUtils::Results::Instance().WriteJson(path_)) {
+      std::cerr << "Failed to write benchmark results to " << path_
+                << std::endl;
+    } else {
+      std::cout << "Benchmark results written to " << path_ << std::endl;
+    }
+  }
+
+ private:
+  std::string path_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Let gtest consume its own flags first (--gtest_filter, etc.)
+  ::testing::InitGoogleTest(&argc, argv);
+
+  std::string json_output = kDefaultJsonOutput;
+  const size_t flag_len = sizeof(kJsonOutputFlag) - 1;
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], kJsonOutputFlag, flag_len) == 0) {
+      json_output = argv[i] + flag_len;
+    }
+  }
+
+  // Owned and destroyed by gtest
+  ::testing::AddGlobalTestEnvironment(
+      new JsonOutputEnvironment(std::move(json_output)));
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+
+#include "benchmark_utils.h"
+
+namespace {
+
+/// Nearest-rank percentile of an already sorted, non-empty vector.
+double Percentile(const std::vector<double>& sorted, double p) {
+  const size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+  return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+/// Write |str| as a JSON string literal. Benchmark and metric names are plain
+/// ASCII identifiers, so only quotes and backslashes need escaping.
+void WriteJsonString(std::ostream& os, const std::string& str) {
+  os << '"';
+  for (char c : str) {
+    if ((c == '"') || (c == '\\')) {
+      os << '\\';
+    }
+    os << c;
+  }
+  os << '"';
+}
+
+}  // namespace
+
+namespace BenchmarkUtils {
+
+int64_t NowUs() noexcept {
+  static const Clock::time_point epoch = Clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                               epoch)
+      .count();
+}
+
+std::string CurrentBenchmarkName() {
+  const ::testing::TestInfo* const info =
+      ::testing::UnitTest::GetInstance()->current_test_info();
+  if (!info) {
+    return {};
+  }
+  std::string name = info->test_case_name();
+  // Remove the empty instantiation prefix of value-parameterized tests
+  if (!name.empty() && (name[0] == '/')) {
+    name.erase(0, 1);
+  }
+  name += '.';
+  name += info->name();
+  return name;
+}
+
+LatencyStats::Summary LatencyStats::Summarize() const {
+  Summary summary{};
+  if (values_.empty()) {
+    return summary;
+  }
+  std::vector<double> sorted(values_);
+  std::sort(sorted.begin(), sorted.end());
+  summary.count = sorted.size();
+  summary.min_ms = sorted.front();
+  summary.max_ms = sorted.back();
+  summary.mean_ms =
+      std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+  summary.p50_ms = Percentile(sorted, 0.50);
+  summary.p95_ms = Percentile(sorted, 0.95);
+  summary.p99_ms = Percentile(sorted, 0.99);
+  return summary;
+}
+
+Results& Results::Instance() {
+  static Results instance;
+  return instance;
+}
+
+void Results::Record(const std::string& benchmark,
+                     const std::string& metric,
+                     double value,
+                     const char* unit) {
+  entries_.push_back(Entry{benchmark, metric, unit, value});
+}
+
+void Results::RecordLatency(const std::string& benchmark,
+                            const std::string& metric,
+                            const LatencyStats& stats) {
+  const LatencyStats::Summary summary = stats.Summarize();
+  Record(benchmark, metric + "_count", static_cast<double>(summary.count),
+         "count");
+  Record(benchmark, metric + "_min", summary.min_ms, "ms");
+  Record(benchmark, metric + "_mean", summary.mean_ms, "ms");
+  Record(benchmark, metric + "_p50", summary.p50_ms, "ms");
+  Record(benchmark, metric + "_p95", summary.p95_ms, "ms");
+  Record(benchmark, metric + "_p99", summary.p99_ms, "ms");
+  Record(benchmark, metric + "_max", summary.max_ms, "ms");
+}
+
+bool Results::WriteJson(const std::string& path) const {
+  std::ofstream os(path, std::ios::out | std::ios::trunc);
+  if (!os) {
+    return false;
+  }
+  os.precision(6);
+  os << std::fixed;
+  os << "{\n  \"version\": 1,\n  \"results\": [";
+  bool first = true;
+  for (auto&& entry : entries_) {
+    os << (first ? "\n" : ",\n") << "    {\"benchmark\": ";
+    WriteJsonString(os, entry.benchmark);
+    os << ", \"metric\": ";
+    WriteJsonString(os, entry.metric);
+    os << ", \"unit\": ";
+    WriteJsonString(os, entry.unit);
+    // JSON has no representation for NaN or infinity.
+    os << ", \"value\": " << (std::isfinite(entry.value) ? entry.value : 0.0)
+       << "}";
+    first = false;
+  }
+  os << "\n  ]\n}\n";
+  return static_cast<bool>(os);
+}
+
+}  // namespace BenchmarkUtils
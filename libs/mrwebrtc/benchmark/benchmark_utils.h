@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace BenchmarkUtils {
+
+using Clock = std::chrono::steady_clock;
+
+/// Number of microseconds elapsed since an arbitrary process-wide epoch. All
+/// peers of a loopback benchmark run in the same process, so values produced
+/// by this function on the sending side can be compared directly with values
+/// produced on the receiving side.
+int64_t NowUs() noexcept;
+
+/// Name of the currently running benchmark, as "<suite>.<name>" with any
+/// value-parameterized suffix, used as the benchmark key in the results.
+std::string CurrentBenchmarkName();
+
+/// Collection of latency samples, in milliseconds, summarized into order
+/// statistics once the measurement is done.
+class LatencyStats {
+ public:
+  void Add(double value_ms) { values_.push_back(value_ms); }
+  size_t count() const noexcept { return values_.size(); }
+
+  struct Summary {
+    size_t count{0};
+    double min_ms{0.0};
+    double mean_ms{0.0};
+    double p50_ms{0.0};
+    double p95_ms{0.0};
+    double p99_ms{0.0};
+    double max_ms{0.0};
+  };
+
+  /// Compute the summary of all samples added so far.
+  Summary Summarize() const;
+
+ private:
+  std::vector<double> values_;
+};
+
+/// Process-wide collector of benchmark results, written as a single JSON
+/// document at the end of the run. Each result is a named scalar metric
+/// attached to a benchmark, which makes it easy to track regressions by
+/// diffing two result files or loading them into any JSON-aware tool.
+///
+/// Results are recorded from the test thread only, once a measurement is
+/// complete, so this class is not thread-safe.
+class Results {
+ public:
+  static Results& Instance();
+
+  /// Record a single scalar |value| expressed in |unit| for the metric
+  /// |metric| of the benchmark |benchmark|.
+  void Record(const std::string& benchmark,
+              const std::string& metric,
+              double value,
+              const char* unit);
+
+  /// Record all order statistics of |stats| for the metric |metric| of the
+  /// benchmark |benchmark|, as "<metric>_p50" etc.
+  void RecordLatency(const std::string& benchmark,
+                     const std::string& metric,
+                     const LatencyStats& stats);
+
+  /// Write all results recorded so far as JSON into the file at |path|.
+  /// Return |true| on success.
+  bool WriteJson(const std::string& path) const;
+
+ private:
+  struct Entry {
+    std::string benchmark;
+    std::string metric;
+    std::string unit;
+    double value;
+  };
+  std::vector<Entry> entries_;
+};
+
+}  // namespace BenchmarkUtils
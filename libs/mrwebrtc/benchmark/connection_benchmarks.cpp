@@ -0,0 +1,109 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <memory>
+#include <vector>
+
+#include "interop_api.h"
+
+#include "benchmark_utils.h"
+#include "test_utils.h"
+
+using namespace BenchmarkUtils;
+
+namespace {
+
+class ConnectionBenchmarks
+    : public TestUtils::TestBase,
+      public testing::WithParamInterface<mrsSdpSemantic> {};
+
+/// Number of connections established to compute the statistics.
+constexpr int kIterationCount = 20;
+
+/// Number of pairs of connections torn down at once by the teardown
+/// benchmarks, and number of times the teardown is measured.
+constexpr int kTeardownPairCount = 20;
+constexpr int kTeardownIterationCount = 3;
+
+/// Establish |kTeardownPairCount| local connections.
+void ConnectPairs(const mrsPeerConnectionConfiguration& pc_config,
+                  std::vector<std::unique_ptr<LocalPeerPairRaii>>& pairs) {
+  for (int i = 0; i < kTeardownPairCount; ++i) {
+    pairs.push_back(std::make_unique<LocalPeerPairRaii>(pc_config));
+    LocalPeerPairRaii& pair = *pairs.back();
+    ASSERT_NE(nullptr, pair.pc1());
+    ASSERT_NE(nullptr, pair.pc2());
+    pair.ConnectAndWait();
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  }
+}
+
+}  // namespace
+
+INSTANTIATE_TEST_CASE_P(,
+                        ConnectionBenchmarks,
+                        testing::ValuesIn(TestUtils::TestSemantics),
+                        TestUtils::SdpSemanticToString);
+
+TEST_P(ConnectionBenchmarks, Setup) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LatencyStats create_stats;
+  LatencyStats connect_stats;
+  for (int i = 0; i < kIterationCount; ++i) {
+    const int64_t start_us = NowUs();
+    LocalPeerPairRaii pair(pc_config);
+    ASSERT_NE(nullptr, pair.pc1());
+    ASSERT_NE(nullptr, pair.pc2());
+    const int64_t created_us = NowUs();
+    pair.ConnectAndWait();
+    const int64_t connected_us = NowUs();
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+    create_stats.Add((created_us - start_us) / 1000.0);
+    connect_stats.Add((connected_us - created_us) / 1000.0);
+  }
+  const std::string name = CurrentBenchmarkName();
+  Results::Instance().RecordLatency(name, "create", create_stats);
+  Results::Instance().RecordLatency(name, "connect", connect_stats);
+}
+
+TEST_P(ConnectionBenchmarks, TeardownSequential) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LatencyStats close_stats;
+  for (int i = 0; i < kTeardownIterationCount; ++i) {
+    std::vector<std::unique_ptr<LocalPeerPairRaii>> pairs;
+    ASSERT_NO_FATAL_FAILURE(ConnectPairs(pc_config, pairs));
+    const int64_t start_us = NowUs();
+    for (auto&& pair : pairs) {
+      ASSERT_EQ(Result::kSuccess, mrsPeerConnectionClose(pair->pc1()));
+      ASSERT_EQ(Result::kSuccess, mrsPeerConnectionClose(pair->pc2()));
+    }
+    close_stats.Add((NowUs() - start_us) / 1000.0);
+  }
+  Results::Instance().RecordLatency(CurrentBenchmarkName(), "close_all",
+                                    close_stats);
+}
+
+TEST_P(ConnectionBenchmarks, TeardownBulk) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  mrsCloseAllConfig config{};
+  config.timeout_ms = 0;  // measure the full teardown
+  config.suppress_callbacks = mrsBool::kTrue;
+  LatencyStats close_stats;
+  for (int i = 0; i < kTeardownIterationCount; ++i) {
+    std::vector<std::unique_ptr<LocalPeerPairRaii>> pairs;
+    ASSERT_NO_FATAL_FAILURE(ConnectPairs(pc_config, pairs));
+    const int64_t start_us = NowUs();
+    uint32_t pending_count = 0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsCloseAllPeerConnections(&config, &pending_count));
+    close_stats.Add((NowUs() - start_us) / 1000.0);
+    ASSERT_EQ(0u, pending_count);
+  }
+  Results::Instance().RecordLatency(CurrentBenchmarkName(), "close_all",
+                                    close_stats);
+}
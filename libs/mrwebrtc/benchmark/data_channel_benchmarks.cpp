@@ -0,0 +1,193 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <atomic>
+#include <thread>
+
+#include "data_channel_interop.h"
+#include "interop_api.h"
+
+#include "benchmark_utils.h"
+#include "test_utils.h"
+
+using namespace BenchmarkUtils;
+
+namespace {
+
+class DataChannelBenchmarks : public TestUtils::TestBase,
+                              public testing::WithParamInterface<uint32_t> {};
+
+/// Message sizes, in bytes, each benchmark is run with.
+constexpr uint32_t kMessageSizes[] = {16, 256, 1024, 4096, 16384};
+
+/// Number of ping messages sent one at a time to measure latency.
+constexpr int kLatencyMessageCount = 200;
+
+/// Total number of bytes streamed to measure throughput.
+constexpr uint64_t kThroughputTotalBytes = 32 * 1024 * 1024;
+
+/// Buffering watermarks used to throttle the sender during throughput
+/// measurements, to stay well below the internal buffer capacity which
+/// otherwise forcibly closes the channel when full.
+constexpr uint64_t kHighWatermark = 4 * 1024 * 1024;
+constexpr uint64_t kLowWatermark = 1 * 1024 * 1024;
+
+/// Data channel endpoint tracking received messages and buffering state.
+struct Endpoint {
+  mrsDataChannelHandle handle{};
+  Event opened;
+  std::atomic<uint64_t> buffered_bytes{0};
+  std::atomic<uint64_t> received_bytes{0};
+  std::atomic<uint64_t> received_count{0};
+  std::function<void(const void*, uint64_t)> on_message;
+
+  void Register() {
+    mrsDataChannelCallbacks callbacks{};
+    callbacks.message_callback = &Endpoint::StaticMessageCallback;
+    callbacks.message_user_data = this;
+    callbacks.buffering_callback = &Endpoint::StaticBufferingCallback;
+    callbacks.buffering_user_data = this;
+    callbacks.state_callback = &Endpoint::StaticStateCallback;
+    callbacks.state_user_data = this;
+    mrsDataChannelRegisterCallbacks(handle, &callbacks);
+  }
+
+  void Unregister() {
+    mrsDataChannelCallbacks callbacks{};
+    mrsDataChannelRegisterCallbacks(handle, &callbacks);
+  }
+
+  static void MRS_CALL StaticMessageCallback(void* user_data,
+                                             const void* data,
+                                             const uint64_t size) noexcept {
+    auto ep = static_cast<Endpoint*>(user_data);
+    ep->received_bytes += size;
+    ++ep->received_count;
+    if (ep->on_message) {
+      ep->on_message(data, size);
+    }
+  }
+
+  static void MRS_CALL
+  StaticBufferingCallback(void* user_data,
+                          const uint64_t /*previous*/,
+                          const uint64_t current,
+                          const uint64_t /*limit*/) noexcept {
+    static_cast<Endpoint*>(user_data)->buffered_bytes = current;
+  }
+
+  static void MRS_CALL StaticStateCallback(void* user_data,
+                                           int32_t state,
+                                           int32_t /*id*/) noexcept {
+    if (state == 1) {  // kOpen
+      static_cast<Endpoint*>(user_data)->opened.Set();
+    }
+  }
+};
+
+/// Write the current time into the first bytes of |msg|, if large enough.
+void StampMessage(std::vector<uint8_t>& msg) {
+  const int64_t now_us = NowUs();
+  memcpy(msg.data(), &now_us, std::min(msg.size(), sizeof(now_us)));
+}
+
+/// Read back the time stamped with |StampMessage()|.
+int64_t ReadStamp(const void* data, uint64_t size) {
+  int64_t stamp_us = 0;
+  memcpy(&stamp_us, data, std::min<size_t>((size_t)size, sizeof(stamp_us)));
+  return stamp_us;
+}
+
+/// Open a reliable ordered out-of-band data channel between the two peers of
+/// |pair|, and connect them.
+void OpenChannel(LocalPeerPairRaii& pair, Endpoint& ep1, Endpoint& ep2) {
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "benchmark";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &ep1.handle));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &ep2.handle));
+  ep1.Register();
+  ep2.Register();
+  pair.ConnectAndWait();
+  ASSERT_TRUE(ep1.opened.WaitFor(60s));
+  ASSERT_TRUE(ep2.opened.WaitFor(60s));
+}
+
+}  // namespace
+
+INSTANTIATE_TEST_CASE_P(,
+                        DataChannelBenchmarks,
+                        testing::ValuesIn(kMessageSizes));
+
+TEST_P(DataChannelBenchmarks, Latency) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  LocalPeerPairRaii pair(pc_config);
+  Endpoint ep1, ep2;
+  OpenChannel(pair, ep1, ep2);
+
+  // Send one message at a time, so that latency is not skewed by queuing.
+  LatencyStats stats;
+  Event ev_received;
+  ep2.on_message = [&stats, &ev_received](const void* data, uint64_t size) {
+    stats.Add((NowUs() - ReadStamp(data, size)) / 1000.0);
+    ev_received.Set();
+  };
+  std::vector<uint8_t> msg(GetParam(), 0x5A);
+  for (int i = 0; i < kLatencyMessageCount; ++i) {
+    ev_received.Reset();
+    StampMessage(msg);
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelSendMessage(ep1.handle, msg.data(), msg.size()));
+    ASSERT_TRUE(ev_received.WaitFor(5s));
+  }
+
+  ep1.Unregister();
+  ep2.Unregister();
+  Results::Instance().RecordLatency(CurrentBenchmarkName(), "latency", stats);
+}
+
+TEST_P(DataChannelBenchmarks, Throughput) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  LocalPeerPairRaii pair(pc_config);
+  Endpoint ep1, ep2;
+  OpenChannel(pair, ep1, ep2);
+
+  const uint64_t msg_size = GetParam();
+  const uint64_t msg_count = kThroughputTotalBytes / msg_size;
+  Event ev_all_received;
+  ep2.on_message = [&ep2, &ev_all_received, msg_count](const void*, uint64_t) {
+    if (ep2.received_count == msg_count) {
+      ev_all_received.Set();
+    }
+  };
+
+  std::vector<uint8_t> msg(msg_size, 0x5A);
+  const int64_t start_us = NowUs();
+  for (uint64_t i = 0; i < msg_count; ++i) {
+    if (ep1.buffered_bytes > kHighWatermark) {
+      while (ep1.buffered_bytes > kLowWatermark) {
+        std::this_thread::sleep_for(1ms);
+      }
+    }
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelSendMessage(ep1.handle, msg.data(), msg.size()));
+  }
+  ASSERT_TRUE(ev_all_received.WaitFor(120s));
+  const int64_t elapsed_us = NowUs() - start_us;
+
+  ep1.Unregister();
+  ep2.Unregister();
+  ASSERT_EQ(msg_count * msg_size, ep2.received_bytes);
+  const double elapsed_s = elapsed_us / 1e6;
+  const std::string name = CurrentBenchmarkName();
+  Results::Instance().Record(name, "throughput",
+                             ep2.received_bytes / elapsed_s, "bytes/s");
+  Results::Instance().Record(name, "message_rate", msg_count / elapsed_s,
+                             "messages/s");
+}
@@ -0,0 +1,361 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#include "audio_frame.h"
+#include "encoded_frame_recorder_interop.h"
+#include "interop_api.h"
+#include "local_audio_track_interop.h"
+#include "local_video_track_interop.h"
+#include "remote_audio_track_interop.h"
+#include "remote_video_track_interop.h"
+#include "transceiver_interop.h"
+
+#include "benchmark_utils.h"
+#include "test_utils.h"
+
+using namespace BenchmarkUtils;
+
+namespace {
+
+class MediaBenchmarks : public TestUtils::TestBase,
+                        public testing::WithParamInterface<mrsSdpSemantic> {};
+
+// PeerConnectionVideoTrackAddedCallback
+using VideoTrackAddedCallback =
+    InteropCallback<const mrsRemoteVideoTrackAddedInfo*>;
+
+// PeerConnectionI420VideoFrameCallback
+using I420VideoFrameCallback = InteropCallback<const I420AVideoFrame&>;
+
+// PeerConnectionAudioTrackAddedCallback
+using AudioTrackAddedCallback =
+    InteropCallback<const mrsRemoteAudioTrackAddedInfo*>;
+
+// PeerConnectionAudioFrameCallback
+using AudioFrameCallback = InteropCallback<const AudioFrame&>;
+
+/// Duration of the media streaming phase of each benchmark.
+constexpr auto kStreamingDuration = 10s;
+
+/// Interval between two synthetic audio pulses. This must be larger than the
+/// expected audio path latency, to unambiguously pair remote pulses with the
+/// local ones.
+constexpr uint32_t kAudioPulsePeriodMs = 1000;
+
+/// Detector for the onset of synthetic audio pulses, which are separated by
+/// pure silence on the sender side. The threshold is well above the noise
+/// introduced by the codec on silence, and well below the pulse amplitude.
+class PulseOnsetDetector {
+ public:
+  /// Process the next audio frame, and return |true| if a pulse starts in it.
+  bool Process(const AudioFrame& frame) {
+    constexpr int16_t kThreshold = 4096;
+    if (frame.bits_per_sample_ != 16) {
+      return false;
+    }
+    const int16_t* samples = static_cast<const int16_t*>(frame.data_);
+    const uint32_t count = frame.sample_count_ * frame.channel_count_;
+    bool loud = false;
+    for (uint32_t i = 0; i < count; ++i) {
+      if ((samples[i] > kThreshold) || (samples[i] < -kThreshold)) {
+        loud = true;
+        break;
+      }
+    }
+    const bool onset = (loud && !in_pulse_);
+    in_pulse_ = loud;
+    return onset;
+  }
+
+ private:
+  bool in_pulse_ = true;  // ignore a pulse already started on first frame
+};
+
+}  // namespace
+
+INSTANTIATE_TEST_CASE_P(,
+                        MediaBenchmarks,
+                        testing::ValuesIn(TestUtils::TestSemantics),
+                        TestUtils::SdpSemanticToString);
+
+TEST_P(MediaBenchmarks, VideoLatency) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 320;
+    config.height = 240;
+    config.framerate = 30.0;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(
+                  &config, "benchmark_video_track", &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  // Frames are delivered sequentially on the decoder thread, so the stats are
+  // only accessed by one thread at a time until unregistered.
+  LatencyStats stats;
+  uint32_t frame_count = 0;
+  uint32_t corrupted_count = 0;
+  I420VideoFrameCallback i420cb = [&](const I420AVideoFrame& frame) {
+    ++frame_count;
+    mrsSyntheticVideoFrameMarker marker{};
+    if (mrsSyntheticVideoFrameReadMarker(&frame, &marker) !=
+        Result::kSuccess) {
+      ++corrupted_count;
+      return;
+    }
+    stats.Add(marker.age_us / 1000.0);
+  };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, CB(i420cb));
+
+  Event ev;
+  ev.WaitFor(kStreamingDuration);
+
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, nullptr,
+                                                nullptr);
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  mrsLocalVideoTrackRemoveRef(track_handle1);
+
+  ASSERT_LT(0u, stats.count()) << "No valid frame received";
+  const std::string name = CurrentBenchmarkName();
+  Results::Instance().RecordLatency(name, "glass_to_glass", stats);
+  const double duration_s =
+      std::chrono::duration<double>(kStreamingDuration).count();
+  Results::Instance().Record(name, "framerate", frame_count / duration_s,
+                             "fps");
+  Results::Instance().Record(name, "corrupted_frames", corrupted_count,
+                             "count");
+}
+
+TEST_P(MediaBenchmarks, RecorderThroughput) {
+  constexpr int kStreamCount = 4;
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Record each video transceiver of #2 into its own file as soon as it is
+  // created, so that all streams are recorded from their first key frame.
+  std::mutex mutex;
+  std::vector<mrsEncodedFrameRecorderHandle> recorders;
+  std::vector<std::string> paths;
+  InteropCallback<const mrsTransceiverAddedInfo*> transceiver_added2_cb =
+      [&](const mrsTransceiverAddedInfo* info) {
+        if (info->media_kind != mrsMediaKind::kVideo) {
+          return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        paths.push_back("mrwebrtc_benchmark_recording_" +
+                        std::to_string(paths.size()) + ".ivf");
+        mrsEncodedFrameRecorderConfig config{};
+        config.path = paths.back().c_str();
+        mrsEncodedFrameRecorderHandle handle{};
+        ASSERT_EQ(Result::kSuccess, mrsEncodedFrameRecorderCreate(
+                                        info->transceiver_handle, &config,
+                                        &handle));
+        recorders.push_back(handle);
+      };
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(),
+                                                    CB(transceiver_added2_cb));
+
+  std::vector<mrsLocalVideoTrackHandle> tracks;
+  for (int i = 0; i < kStreamCount; ++i) {
+    mrsTransceiverHandle transceiver_handle{};
+    const std::string name = "video_transceiver_" + std::to_string(i);
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = name.c_str();
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+    mrsLocalVideoTrackHandle track_handle{};
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 640;
+    config.height = 480;
+    config.framerate = 30.0;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(
+                  &config, "benchmark_video_track", &track_handle));
+    ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                    transceiver_handle, track_handle));
+    tracks.push_back(track_handle);
+  }
+
+  pair.ConnectAndWait();
+
+  Event ev;
+  ev.WaitFor(kStreamingDuration);
+
+  // Stopping drains the write queues, so the statistics are final.
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(), nullptr,
+                                                    nullptr);
+  mrsEncodedFrameRecorderStats total{};
+  for (mrsEncodedFrameRecorderHandle handle : recorders) {
+    ASSERT_EQ(Result::kSuccess, mrsEncodedFrameRecorderStop(handle));
+    mrsEncodedFrameRecorderStats stats{};
+    ASSERT_EQ(Result::kSuccess,
+              mrsEncodedFrameRecorderGetStats(handle, &stats));
+    total.frames_written += stats.frames_written;
+    total.bytes_written += stats.bytes_written;
+    total.frames_dropped += stats.frames_dropped;
+    total.peak_queued_bytes =
+        std::max(total.peak_queued_bytes, stats.peak_queued_bytes);
+    mrsEncodedFrameRecorderRemoveRef(handle);
+  }
+  for (const std::string& path : paths) {
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+  }
+
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  for (mrsLocalVideoTrackHandle handle : tracks) {
+    mrsLocalVideoTrackRemoveRef(handle);
+  }
+
+  ASSERT_EQ(kStreamCount, (int)recorders.size());
+  ASSERT_LT(0u, total.frames_written) << "No frame recorded";
+  const std::string name = CurrentBenchmarkName();
+  const double duration_s =
+      std::chrono::duration<double>(kStreamingDuration).count();
+  Results::Instance().Record(name, "frames_written", total.frames_written,
+                             "count");
+  Results::Instance().Record(name, "frames_dropped", total.frames_dropped,
+                             "count");
+  Results::Instance().Record(name, "peak_queued_bytes",
+                             total.peak_queued_bytes, "bytes");
+  Results::Instance().Record(name, "write_throughput",
+                             total.bytes_written / duration_s / 1024.0,
+                             "KiB/s");
+}
+
+// The synthetic audio source requires no capture device, but remote audio
+// frames are only delivered while the audio device module is playing out.
+#if !defined(MRSW_EXCLUDE_DEVICE_TESTS)
+
+TEST_P(MediaBenchmarks, AudioLatency) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteAudioTrackHandle audio_track2{};
+  Event track_added2_ev;
+  AudioTrackAddedCallback track_added2_cb =
+      [&audio_track2,
+       &track_added2_ev](const mrsRemoteAudioTrackAddedInfo* info) {
+        audio_track2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  mrsTransceiverHandle audio_transceiver1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "audio_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kAudio;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &audio_transceiver1));
+  }
+
+  // Send periodic pulses, whose onsets are detected both when generated on
+  // the local track and when received on the remote track.
+  mrsLocalAudioTrackHandle audio_track1{};
+  {
+    mrsSyntheticAudioTrackInitConfig config{};
+    config.waveform = mrsSyntheticAudioWaveform::kPulse;
+    config.frequency_hz = 1000.0;
+    config.period_ms = kAudioPulsePeriodMs;
+    config.pulse_duration_ms = 50;
+    config.amplitude = 0.8;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalAudioTrackCreateSynthetic(
+                  &config, "benchmark_audio_track", &audio_track1));
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalAudioTrack(audio_transceiver1, audio_track1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, audio_track2);
+
+  // Each callback runs on a single thread, so the detectors need no locking.
+  // Remote onsets are paired with the latest local one; onsets further apart
+  // than a pulse period cannot be paired and are counted as lost.
+  std::atomic<int64_t> local_onset_us{0};
+  PulseOnsetDetector local_detector;
+  AudioFrameCallback audio1_cb = [&](const AudioFrame& frame) {
+    if (local_detector.Process(frame)) {
+      local_onset_us = NowUs();
+    }
+  };
+  mrsLocalAudioTrackRegisterFrameCallback(audio_track1, CB(audio1_cb));
+
+  LatencyStats stats;
+  uint32_t lost_count = 0;
+  PulseOnsetDetector remote_detector;
+  AudioFrameCallback audio2_cb = [&](const AudioFrame& frame) {
+    if (!remote_detector.Process(frame)) {
+      return;
+    }
+    const int64_t onset_us = local_onset_us.load();
+    const int64_t latency_us = NowUs() - onset_us;
+    if ((onset_us == 0) || (latency_us >= kAudioPulsePeriodMs * 1000)) {
+      ++lost_count;
+      return;
+    }
+    stats.Add(latency_us / 1000.0);
+  };
+  mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, CB(audio2_cb));
+
+  Event ev;
+  ev.WaitFor(kStreamingDuration);
+
+  mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, nullptr, nullptr);
+  mrsLocalAudioTrackRegisterFrameCallback(audio_track1, nullptr, nullptr);
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  mrsLocalAudioTrackRemoveRef(audio_track1);
+
+  ASSERT_LT(0u, stats.count()) << "No audio pulse received";
+  const std::string name = CurrentBenchmarkName();
+  Results::Instance().RecordLatency(name, "path_latency", stats);
+  Results::Instance().Record(name, "lost_pulses", lost_count, "count");
+}
+
+#endif  // MRSW_EXCLUDE_DEVICE_TESTS
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+/// Configuration of an encoded frame recorder.
+struct mrsEncodedFrameRecorderConfig {
+  /// Path of the IVF file to write. The key frame index is written next to
+  /// it, in a file with the same path followed by ".idx". Existing files are
+  /// overwritten.
+  const char* path{nullptr};
+
+  /// Maximum size of the encoded frames queued for writing, in bytes. Frames
+  /// received while the queue is full are dropped, and so are the following
+  /// delta frames until the next key frame, to keep the file decodable.
+  uint32_t max_queued_bytes{16 * 1024 * 1024};
+
+  /// Interval between two flushes of the file to disk, in milliseconds. Each
+  /// flush appends the new key frames to the index, and updates the frame
+  /// count of the file header, so that a file interrupted by a crash is still
+  /// readable and seekable up to the last flush. Zero disables the periodic
+  /// flushes, and the file is only finalized when the recorder stops.
+  uint32_t index_flush_interval_ms{1000};
+};
+
+/// Statistics of an encoded frame recorder.
+struct mrsEncodedFrameRecorderStats {
+  /// Number of frames written to the file.
+  uint64_t frames_written;
+
+  /// Number of key frames written to the file, and to the index.
+  uint64_t key_frames_written;
+
+  /// Number of bytes of frame payload written to the file.
+  uint64_t bytes_written;
+
+  /// Number of frames dropped because the write queue was full, or because
+  /// they depended on a dropped frame.
+  uint64_t frames_dropped;
+
+  /// Peak size of the write queue, in bytes.
+  uint64_t peak_queued_bytes;
+};
+
+/// Create a recorder writing the encoded video frames received by a video
+/// transceiver into an IVF file, without decoding them. Frames are written
+/// asynchronously on a dedicated thread. Recording starts immediately, and
+/// the first frame written is the first key frame received. VP8, VP9 and
+/// H.264 are supported.
+///
+/// The recorder uses the encoded frame tap of the transceiver; see
+/// |mrsTransceiverRegisterEncodedFrameCallback()| for its requirements.
+MRS_API mrsResult MRS_CALL mrsEncodedFrameRecorderCreate(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsEncodedFrameRecorderConfig* config,
+    mrsEncodedFrameRecorderHandle* recorder_handle_out) noexcept;
+
+/// Add a reference to the native object associated with the given handle.
+MRS_API void MRS_CALL
+mrsEncodedFrameRecorderAddRef(mrsEncodedFrameRecorderHandle handle) noexcept;
+
+/// Remove a reference from the native object associated with the given handle.
+/// The recorder is stopped when the last reference is removed.
+MRS_API void MRS_CALL mrsEncodedFrameRecorderRemoveRef(
+    mrsEncodedFrameRecorderHandle handle) noexcept;
+
+/// Stop recording, write all the queued frames, and finalize and close the
+/// file and its index. Stopping a stopped recorder has no effect.
+MRS_API mrsResult MRS_CALL
+mrsEncodedFrameRecorderStop(mrsEncodedFrameRecorderHandle handle) noexcept;
+
+/// Get the current statistics of the recorder.
+MRS_API mrsResult MRS_CALL mrsEncodedFrameRecorderGetStats(
+    mrsEncodedFrameRecorderHandle handle,
+    mrsEncodedFrameRecorderStats* stats_out) noexcept;
+
+}  // extern "C"
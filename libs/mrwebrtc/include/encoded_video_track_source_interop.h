@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+/// Configuration for creating an encoded video track source.
+struct mrsEncodedVideoTrackSourceInitConfig {
+  /// SDP name of the codec of the access units pushed to the source, one of
+  /// "VP8", "VP9" or "H264". H.264 access units must be in Annex B format.
+  const char* codec_name{nullptr};
+
+  /// Optional name of the source, for logging and debugging.
+  const char* name{nullptr};
+};
+
+/// Already-encoded video access unit pushed to an encoded video track source.
+struct mrsEncodedVideoFrame {
+  /// Encoded payload of the frame. This is copied during the push, so only
+  /// needs to be valid during the call.
+  const uint8_t* data{nullptr};
+  uint32_t size{0};
+
+  /// Resolution of the encoded frame, in pixels.
+  uint32_t width{0};
+  uint32_t height{0};
+
+  /// Whether the frame is a key frame, decodable independently of any previous
+  /// frame.
+  mrsBool is_key_frame{mrsBool::kFalse};
+
+  /// Capture time of the frame, in microseconds, on the same monotonic clock
+  /// as the rest of the library, or zero to use the time of the push.
+  int64_t timestamp_us{0};
+};
+
+/// Configuration of the shared encoder of an encoded video track source
+/// created from a local video track.
+struct mrsSharedVideoEncoderConfig {
+  /// SDP name of the codec of the encoder, one of "VP8", "VP9" or "H264".
+  const char* codec_name{nullptr};
+
+  /// Optional name of the source, for logging and debugging.
+  const char* name{nullptr};
+
+  /// Target bitrate of the encoder, in kilobits per second. This is shared by
+  /// all the peers receiving the stream, so it is not adapted to the
+  /// bandwidth estimated for each of them.
+  uint32_t bitrate_kbps{1000};
+
+  /// Maximum frame rate of the encoder, in frames per second.
+  uint32_t max_framerate{30};
+
+  /// Minimum interval between two key frames forced by the requests of the
+  /// peers, in milliseconds. Requests received in between are aggregated into
+  /// a single key frame at the end of the interval.
+  uint32_t min_key_frame_interval_ms{500};
+};
+
+/// Callback invoked when the encoded video track source needs a key frame.
+using mrsEncodedVideoTrackSourceKeyFrameRequestedCallback =
+    void(MRS_CALL*)(void* user_data);
+
+/// Add a reference to the native object associated with the given handle.
+MRS_API void MRS_CALL mrsEncodedVideoTrackSourceAddRef(
+    mrsEncodedVideoTrackSourceHandle handle) noexcept;
+
+/// Remove a reference from the native object associated with the given handle.
+MRS_API void MRS_CALL mrsEncodedVideoTrackSourceRemoveRef(
+    mrsEncodedVideoTrackSourceHandle handle) noexcept;
+
+/// Create a video track source accepting already-encoded access units, which
+/// are sent without being re-encoded. This allows relaying or streaming
+/// recorded content to any number of peers at virtually no CPU cost. The
+/// source can be used by several local video tracks, created with
+/// |mrsLocalVideoTrackCreateFromEncodedSource()|.
+///
+/// The access units must use the codec negotiated by the transceivers sending
+/// them, which can be enforced with |mrsTransceiverSetCodecPreferences()|.
+/// Raw frames still go through the regular encoder, so a disabled track keeps
+/// sending encoded black frames.
+MRS_API mrsResult MRS_CALL mrsEncodedVideoTrackSourceCreate(
+    const mrsEncodedVideoTrackSourceInitConfig* config,
+    mrsEncodedVideoTrackSourceHandle* source_handle_out) noexcept;
+
+/// Create an encoded video track source fed by a shared encoder, which encodes
+/// the frames of the given local video track once, however many peers they
+/// are sent to. The source can then be used by several local video tracks,
+/// created with |mrsLocalVideoTrackCreateFromEncodedSource()|, and added to
+/// any number of peer connections whose transceivers negotiate the codec of
+/// the encoder; see |mrsTransceiverSetCodecPreferences()|. The key frame
+/// requests of all the peers are aggregated into a single key frame.
+///
+/// The source keeps a reference to |track_handle| until it is destroyed. The
+/// track does not need to be added to any peer connection.
+MRS_API mrsResult MRS_CALL mrsEncodedVideoTrackSourceCreateFromTrack(
+    mrsLocalVideoTrackHandle track_handle,
+    const mrsSharedVideoEncoderConfig* config,
+    mrsEncodedVideoTrackSourceHandle* source_handle_out) noexcept;
+
+/// Push an encoded access unit to all the video tracks using the source. Delta
+/// frames pushed before the first key frame are rejected with
+/// |mrsResult::kInvalidOperation|.
+MRS_API mrsResult MRS_CALL mrsEncodedVideoTrackSourcePushFrame(
+    mrsEncodedVideoTrackSourceHandle source_handle,
+    const mrsEncodedVideoFrame* frame) noexcept;
+
+/// Register a callback invoked when a key frame is needed, typically when a new
+/// peer starts receiving the stream or recovers from a packet loss. Until the
+/// next key frame is pushed, delta frames are not sent to that peer. The
+/// callback is invoked from the WebRTC encoder threads.
+MRS_API void MRS_CALL
+mrsEncodedVideoTrackSourceRegisterKeyFrameRequestedCallback(
+    mrsEncodedVideoTrackSourceHandle source_handle,
+    mrsEncodedVideoTrackSourceKeyFrameRequestedCallback callback,
+    void* user_data) noexcept;
+
+}  // extern "C"
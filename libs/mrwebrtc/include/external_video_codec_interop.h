@@ -0,0 +1,177 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "encoded_video_track_source_interop.h"
+#include "interop_api.h"
+
+extern "C" {
+
+/// Opaque handle to an encoder or decoder instance created by an external
+/// video codec.
+using mrsExternalVideoCodecInstance = void*;
+
+/// Settings of an external video encoder instance, derived from the negotiated
+/// codec and the send encoding parameters.
+struct mrsExternalVideoEncoderSettings {
+  /// Resolution of the frames to encode, in pixels.
+  uint32_t width{0};
+  uint32_t height{0};
+
+  /// Maximum frame rate of the stream, in frames per second.
+  uint32_t max_framerate{0};
+
+  /// Initial, minimum and maximum target bitrates, in kilobits per second.
+  uint32_t start_bitrate_kbps{0};
+  uint32_t min_bitrate_kbps{0};
+  uint32_t max_bitrate_kbps{0};
+
+  /// Number of CPU cores the encoder is allowed to use.
+  uint32_t number_of_cores{1};
+};
+
+/// Settings of an external video decoder instance.
+struct mrsExternalVideoDecoderSettings {
+  /// Expected resolution of the decoded frames, in pixels, or zero if unknown.
+  uint32_t width{0};
+  uint32_t height{0};
+
+  /// Number of CPU cores the decoder is allowed to use.
+  uint32_t number_of_cores{1};
+};
+
+/// Properties of an external video codec, reported to the WebRTC engine.
+struct mrsExternalVideoCodecInfo {
+  /// The codec is hardware-accelerated. WebRTC uses this as a hint to tune
+  /// its quality scaling and CPU overuse detection.
+  mrsBool is_hardware_accelerated{mrsBool::kFalse};
+};
+
+/// Callback provided by the library to an external encoder for delivering an
+/// encoded access unit. The frame data is copied during the call.
+using mrsExternalVideoEncoderOutputCallback =
+    mrsResult(MRS_CALL*)(void* context, const mrsEncodedVideoFrame* frame);
+
+/// Callback provided by the library to an external decoder for delivering a
+/// decoded frame. The frame data is copied during the call, and the alpha
+/// plane, if any, is ignored.
+using mrsExternalVideoDecoderOutputCallback =
+    mrsResult(MRS_CALL*)(void* context, const mrsI420AVideoFrame* frame);
+
+/// Create a new encoder instance for the codec. Return NULL on failure, in
+/// which case the built-in encoder is used instead.
+using mrsExternalVideoEncoderCreateCallback =
+    mrsExternalVideoCodecInstance(MRS_CALL*)(void* user_data);
+
+/// Destroy an encoder instance created by the create callback.
+using mrsExternalVideoEncoderDestroyCallback =
+    void(MRS_CALL*)(void* user_data, mrsExternalVideoCodecInstance encoder);
+
+/// (Re)initialize an encoder instance with new settings. This can be called
+/// several times during the lifetime of the encoder, for example when the
+/// resolution changes.
+using mrsExternalVideoEncoderInitCallback = mrsResult(MRS_CALL*)(
+    void* user_data,
+    mrsExternalVideoCodecInstance encoder,
+    const mrsExternalVideoEncoderSettings* settings);
+
+/// Encode a raw frame, and deliver the resulting access units, if any, by
+/// calling |output| with |output_context| before returning. Encoders which do
+/// not produce a frame for every input, for example to respect their bitrate
+/// budget, can deliver nothing. H.264 access units must be in Annex B format.
+using mrsExternalVideoEncoderEncodeCallback =
+    mrsResult(MRS_CALL*)(void* user_data,
+                         mrsExternalVideoCodecInstance encoder,
+                         const mrsI420AVideoFrame* frame,
+                         mrsBool force_key_frame,
+                         mrsExternalVideoEncoderOutputCallback output,
+                         void* output_context);
+
+/// Update the target bitrate and frame rate of an encoder instance.
+using mrsExternalVideoEncoderSetRatesCallback =
+    mrsResult(MRS_CALL*)(void* user_data,
+                         mrsExternalVideoCodecInstance encoder,
+                         uint32_t bitrate_kbps,
+                         uint32_t framerate);
+
+/// Query the properties of the codec. Optional.
+using mrsExternalVideoCodecQueryInfoCallback =
+    void(MRS_CALL*)(void* user_data, mrsExternalVideoCodecInfo* info);
+
+/// Create a new decoder instance for the codec. Return NULL on failure, in
+/// which case the built-in decoder is used instead.
+using mrsExternalVideoDecoderCreateCallback =
+    mrsExternalVideoCodecInstance(MRS_CALL*)(void* user_data);
+
+/// Destroy a decoder instance created by the create callback.
+using mrsExternalVideoDecoderDestroyCallback =
+    void(MRS_CALL*)(void* user_data, mrsExternalVideoCodecInstance decoder);
+
+/// Initialize a decoder instance.
+using mrsExternalVideoDecoderInitCallback = mrsResult(MRS_CALL*)(
+    void* user_data,
+    mrsExternalVideoCodecInstance decoder,
+    const mrsExternalVideoDecoderSettings* settings);
+
+/// Decode an access unit, and deliver the resulting frame, if any, by calling
+/// |output| with |output_context| before returning.
+using mrsExternalVideoDecoderDecodeCallback =
+    mrsResult(MRS_CALL*)(void* user_data,
+                         mrsExternalVideoCodecInstance decoder,
+                         const mrsEncodedVideoFrame* frame,
+                         mrsExternalVideoDecoderOutputCallback output,
+                         void* output_context);
+
+/// Table of callbacks implementing an external video encoder. All callbacks
+/// except |query_info| are mandatory. The callbacks of an encoder instance are
+/// invoked from a single WebRTC encoder thread at a time, but different
+/// instances can be used concurrently.
+struct mrsExternalVideoEncoderCallbacks {
+  mrsExternalVideoEncoderCreateCallback create{};
+  mrsExternalVideoEncoderDestroyCallback destroy{};
+  mrsExternalVideoEncoderInitCallback init{};
+  mrsExternalVideoEncoderEncodeCallback encode{};
+  mrsExternalVideoEncoderSetRatesCallback set_rates{};
+  mrsExternalVideoCodecQueryInfoCallback query_info{};
+  void* user_data{};
+};
+
+/// Table of callbacks implementing an external video decoder. All callbacks
+/// are mandatory. The callbacks of a decoder instance are invoked from a
+/// single WebRTC decoder thread at a time, but different instances can be used
+/// concurrently.
+struct mrsExternalVideoDecoderCallbacks {
+  mrsExternalVideoDecoderCreateCallback create{};
+  mrsExternalVideoDecoderDestroyCallback destroy{};
+  mrsExternalVideoDecoderInitCallback init{};
+  mrsExternalVideoDecoderDecodeCallback decode{};
+  void* user_data{};
+};
+
+/// Register an external encoder for the video codec with the given SDP name,
+/// for example "VP8", "VP9" or "H264", replacing the built-in encoder of that
+/// codec. Codecs without external encoder keep using the built-in one. Passing
+/// NULL callbacks removes the registration of the codec. The optional
+/// |sdp_format_parameters| are the SDP format parameters advertised for the
+/// codec if it has no built-in encoder, as a list of "key=value" separated by
+/// semicolons, for example "packetization-mode=1;profile-level-id=42e01f".
+///
+/// Registrations are only taken into account when the library initializes,
+/// so this returns |mrsResult::kInvalidOperation| if the library is already
+/// initialized. External codecs are not supported on UWP, which returns
+/// |mrsResult::kUnsupported|.
+MRS_API mrsResult MRS_CALL mrsRegisterExternalVideoEncoder(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoEncoderCallbacks* callbacks) noexcept;
+
+/// Register an external decoder for the video codec with the given SDP name,
+/// replacing the built-in decoder of that codec. This behaves like
+/// |mrsRegisterExternalVideoEncoder()|.
+MRS_API mrsResult MRS_CALL mrsRegisterExternalVideoDecoder(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoDecoderCallbacks* callbacks) noexcept;
+
+}  // extern "C"
@@ -41,10 +41,23 @@ MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromArgb32Callback(
     void* user_data,
     mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept;
 
+/// Create a custom video track source external to the implementation. This
+/// allows feeding into WebRTC frames from any source, including generated or
+/// synthetic frames, for example for testing. The frame is provided from a
+/// callback as an NV12-encoded buffer, which is kept in NV12 until consumed in
+/// another format, so NV12 frame callbacks receive it without conversion. This
+/// returns a handle to a newly allocated object, which must be released once
+/// not used anymore with |mrsExternalVideoTrackSourceRemoveRef()|.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromNv12Callback(
+    mrsRequestExternalNv12VideoFrameCallback callback,
+    void* user_data,
+    mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept;
+
 /// Callback from the wrapper layer indicating that the wrapper has finished
 /// creation, and it is safe to start sending frame requests to it. This needs
-/// to be called after |mrsExternalVideoTrackSourceCreateFromI420ACallback()| or
-/// |mrsExternalVideoTrackSourceCreateFromArgb32Callback()| to finish the
+/// to be called after |mrsExternalVideoTrackSourceCreateFromI420ACallback()|,
+/// |mrsExternalVideoTrackSourceCreateFromArgb32Callback()| or
+/// |mrsExternalVideoTrackSourceCreateFromNv12Callback()| to finish the
 /// creation of the video track source and allow it to start capturing.
 MRS_API void MRS_CALL mrsExternalVideoTrackSourceFinishCreation(
     mrsExternalVideoTrackSourceHandle source_handle) noexcept;
@@ -64,6 +77,13 @@ mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
     int64_t timestamp_ms,
     const mrsArgb32VideoFrame* frame_view) noexcept;
 
+/// Complete a video frame request with a provided NV12 video frame.
+MRS_API mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteNv12FrameRequest(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const mrsNv12VideoFrame* frame_view) noexcept;
+
 /// Irreversibly stop the video source frame production and shutdown the video
 /// source.
 MRS_API void MRS_CALL mrsExternalVideoTrackSourceShutdown(
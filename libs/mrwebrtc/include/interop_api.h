@@ -20,6 +20,27 @@ enum class mrsBool : int32_t { kTrue = -1, kFalse = 0 };
 /// Report live objects to debug output, and return the number of live objects.
 MRS_API uint32_t MRS_CALL mrsReportLiveObjects() noexcept;
 
+/// Type of the objects tracked by the library.
+enum class mrsObjectType : int32_t {
+  kPeerConnection = 0,
+  kLocalAudioTrack = 1,
+  kLocalVideoTrack = 2,
+  kExternalVideoTrackSource = 3,
+  kEncodedVideoTrackSource = 4,
+  kRemoteAudioTrack = 5,
+  kRemoteVideoTrack = 6,
+  kDataChannel = 7,
+  kAudioTransceiver = 8,
+  kVideoTransceiver = 9,
+  kEncodedFrameRecorder = 10,
+};
+
+/// Get the number of live objects of the given type, without reporting them to
+/// debug output. Return 0 if the library is not initialized or if |type| is
+/// invalid. The count can be outdated as soon as the call returns if other
+/// threads add or remove objects.
+MRS_API uint32_t MRS_CALL mrsGetLiveObjectCount(mrsObjectType type) noexcept;
+
 /// Global MixedReality-WebRTC library shutdown options.
 enum class mrsShutdownOptions : uint32_t {
   kNone = 0,
@@ -52,10 +73,39 @@ mrsSetShutdownOptions(mrsShutdownOptions options) noexcept;
 
 /// Forcefully shutdown the library and release all resources (as possible), and
 /// terminate the WebRTC threads to allow the shared module to be unloaded. This
+/// also destroys the log sinks still alive, invalidating their handles. This
 /// is a last-resort measure for exceptional situations like unit testing where
 /// loss of data is acceptable.
 MRS_API void MRS_CALL mrsForceShutdown() noexcept;
 
+/// Configuration of |mrsCloseAllPeerConnections()|.
+struct mrsCloseAllConfig {
+  /// Maximum number of peer connections closed at the same time, or zero to
+  /// use the number of CPU cores.
+  uint32_t max_parallelism{0};
+
+  /// Maximum time to wait for all peer connections to be closed, in
+  /// milliseconds, or zero to wait without limit.
+  uint32_t timeout_ms{5000};
+
+  /// Do not invoke the track removed and data channel removed callbacks of the
+  /// peer connections while closing them. This avoids calling back into the
+  /// application for objects it is about to release anyway.
+  mrsBool suppress_callbacks{mrsBool::kFalse};
+};
+
+/// Close all the peer connections alive concurrently on several threads, as
+/// with |mrsPeerConnectionClose()|, for example to quickly shut down the
+/// library before releasing all objects. If |config| is NULL, the default
+/// configuration is used. Peer connections still closing once the timeout
+/// expires continue to be closed in the background, and their number is
+/// returned in |pending_count| if not NULL. |mrsForceShutdown()| waits for them
+/// to be closed before terminating the WebRTC threads. Calling
+/// |mrsPeerConnectionClose()| on one of them waits until it is closed.
+MRS_API mrsResult MRS_CALL
+mrsCloseAllPeerConnections(const mrsCloseAllConfig* config,
+                           uint32_t* pending_count) noexcept;
+
 /// Opaque enumerator type.
 struct mrsEnumerator;
 
@@ -76,6 +126,10 @@ struct mrsRemoteVideoTrackConfig;
 struct mrsDataChannelConfig;
 struct mrsDataChannelCallbacks;
 
+// Handles to native interop objects are opaque values, not pointers. Once the
+// object they reference is destroyed, a handle becomes stale and API functions
+// reject it with |mrsResult::kInvalidNativeHandle|.
+
 /// Opaque handle to a native PeerConnection interop object.
 using mrsPeerConnectionHandle = void*;
 
@@ -103,6 +157,12 @@ using mrsDataChannelHandle = void*;
 /// Opaque handle to a native ExternalVideoTrackSource interop object.
 using mrsExternalVideoTrackSourceHandle = void*;
 
+/// Opaque handle to a native EncodedVideoTrackSource interop object.
+using mrsEncodedVideoTrackSourceHandle = void*;
+
+/// Opaque handle to a native EncodedFrameRecorder interop object.
+using mrsEncodedFrameRecorderHandle = void*;
+
 //
 // Video capture enumeration
 //
@@ -328,6 +388,15 @@ using mrsI420AVideoFrame = Microsoft::MixedReality::WebRTC::I420AVideoFrame;
 using mrsI420AVideoFrameCallback =
     void(MRS_CALL*)(void* user_data, const mrsI420AVideoFrame& frame);
 
+using mrsNv12VideoFrame = Microsoft::MixedReality::WebRTC::Nv12VideoFrame;
+
+/// Callback fired when a local or remote (depending on use) video frame is
+/// available to be consumed by the caller, usually for display.
+/// The video frame is encoded in NV12 biplanar format. Frames produced in NV12
+/// are passed through without any conversion.
+using mrsNv12VideoFrameCallback =
+    void(MRS_CALL*)(void* user_data, const mrsNv12VideoFrame& frame);
+
 using mrsArgb32VideoFrame = Microsoft::MixedReality::WebRTC::Argb32VideoFrame;
 
 /// Callback fired when a local or remote (depending on use) video frame is
@@ -336,6 +405,51 @@ using mrsArgb32VideoFrame = Microsoft::MixedReality::WebRTC::Argb32VideoFrame;
 using mrsArgb32VideoFrameCallback =
     void(MRS_CALL*)(void* user_data, const mrsArgb32VideoFrame& frame);
 
+/// Pixel format of the frames delivered to a video frame callback, which
+/// identifies that callback on a video track.
+enum class mrsVideoFrameFormat : int32_t {
+  /// Frames delivered to the |mrsI420AVideoFrameCallback| callback.
+  kI420A = 0,
+
+  /// Frames delivered to the |mrsNv12VideoFrameCallback| callback.
+  kNv12 = 1,
+
+  /// Frames delivered to the |mrsArgb32VideoFrameCallback| callback.
+  kArgb32 = 2,
+};
+
+/// Crop and scale applied to the frames delivered to a video frame callback.
+/// The frame is cropped then scaled before being converted to the format of
+/// the callback, so small outputs only pay for a small conversion. Each field
+/// must not exceed 16384 pixels.
+struct mrsVideoFrameScaling {
+  /// Left edge of the crop rectangle, in pixels. This is rounded down to an
+  /// even value to keep the chroma planes aligned.
+  uint32_t crop_x{0};
+
+  /// Top edge of the crop rectangle, in pixels. This is rounded down to an
+  /// even value to keep the chroma planes aligned.
+  uint32_t crop_y{0};
+
+  /// Width of the crop rectangle, in pixels, or zero to keep the full frame.
+  /// The rectangle is clipped to the frame.
+  uint32_t crop_width{0};
+
+  /// Height of the crop rectangle, in pixels, or zero to keep the full frame.
+  /// The rectangle is clipped to the frame.
+  uint32_t crop_height{0};
+
+  /// Width of the delivered frames, in pixels. If zero, this is derived from
+  /// |target_height| to keep the aspect ratio of the crop rectangle, capped
+  /// to 16384 pixels, or is the crop width if both are zero.
+  uint32_t target_width{0};
+
+  /// Height of the delivered frames, in pixels. If zero, this is derived from
+  /// |target_width| to keep the aspect ratio of the crop rectangle, capped to
+  /// 16384 pixels, or is the crop height if both are zero.
+  uint32_t target_height{0};
+};
+
 using mrsAudioFrame = Microsoft::MixedReality::WebRTC::AudioFrame;
 
 /// Callback fired when a local or remote (depending on use) audio frame is
@@ -553,6 +667,36 @@ enum class mrsTransceiverOptDirection : int32_t {
 /// Media kind for tracks and transceivers.
 enum class mrsMediaKind : uint32_t { kAudio = 0, kVideo = 1 };
 
+/// Parameters of a single encoding of the RTP sender of a transceiver. Video
+/// transceivers can have multiple encodings, each sending a simulcast layer of
+/// the same source at a different resolution and/or bitrate.
+struct mrsSendEncodingParameters {
+  /// RTP stream identifier (RID) of the encoding, which identifies the
+  /// simulcast layer in SDP. This must be a non-empty alphanumeric string,
+  /// unique among the encodings of the sender, when the sender has multiple
+  /// encodings, and is optional otherwise. The RID cannot be changed once the
+  /// transceiver is created.
+  const char* rid{nullptr};
+
+  /// Factor by which the resolution of the source is divided in each
+  /// dimension for this encoding. Must be greater than or equal to 1.0, or
+  /// zero to let the implementation decide.
+  double scale_resolution_down_by{0.0};
+
+  /// Maximum bitrate of the encoding, in bits per second, or zero for no limit
+  /// other than the bandwidth estimation.
+  uint32_t max_bitrate_bps{0};
+
+  /// Maximum framerate of the encoding, in frames per second, or zero for no
+  /// limit other than the framerate of the source.
+  uint32_t max_framerate{0};
+
+  /// Whether the encoding is currently sent. Inactive encodings keep their
+  /// simulcast layer negotiated, but do not consume any encoding or network
+  /// resource.
+  mrsBool active{mrsBool::kTrue};
+};
+
 /// Configuration for creating a new transceiver.
 struct mrsTransceiverInitConfig {
   /// Optional name of the transceiver. This must be a valid SDP token; see
@@ -572,6 +716,15 @@ struct mrsTransceiverInitConfig {
 
   /// Optional user data.
   void* user_data{nullptr};
+
+  /// Optional array of |send_encoding_count| encodings of the RTP sender, or
+  /// null for a single encoding with default parameters. Multiple encodings
+  /// enable simulcast, and are only supported for video transceivers with the
+  /// Unified Plan SDP semantic.
+  const mrsSendEncodingParameters* send_encodings{nullptr};
+
+  /// Number of elements in the |send_encodings| array.
+  uint32_t send_encoding_count{0};
 };
 
 using mrsRequestExternalI420AVideoFrameCallback =
@@ -586,6 +739,12 @@ using mrsRequestExternalArgb32VideoFrameCallback =
                          uint32_t request_id,
                          int64_t timestamp_ms);
 
+using mrsRequestExternalNv12VideoFrameCallback =
+    mrsResult(MRS_CALL*)(void* user_data,
+                         mrsExternalVideoTrackSourceHandle source_handle,
+                         uint32_t request_id,
+                         int64_t timestamp_ms);
+
 /// Configuration for creating a new transceiver interop wrapper when the
 /// implementation initiates the creating, generally as a result of applying a
 /// remote description.
@@ -778,6 +937,9 @@ struct SdpFilter {
 /// the input message, one way to ensure this function doesn't fail is to pass
 /// an output buffer as large as the input message.
 ///
+/// For per-transceiver codec selection without rewriting the SDP message, see
+/// |mrsTransceiverSetCodecPreferences()|.
+///
 /// |message| SDP message string to deserialize.
 /// |audio_codec_name| Optional SDP name of the audio codec to
 /// force if supported, or nullptr or empty string to leave unmodified.
@@ -938,6 +1100,60 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
                          mrsStatsReportGetObjectCallback callback,
                          void* user_data);
 
+/// Snapshot of all the simple stats objects of a stats report, extracted in a
+/// single pass by |mrsStatsReportGetSnapshot()|. Each stats type is stored in
+/// a caller-provided array of the given capacity, so that no allocation is
+/// performed by the implementation, and the same snapshot storage can be
+/// reused between calls.
+///
+/// For each stats type, |xxx_count| is set on output to the total number of
+/// objects of that type found in the report. This can be larger than
+/// |xxx_capacity|, in which case only the first |xxx_capacity| objects are
+/// written, and the caller can grow its arrays for the next call. Passing a
+/// NULL array with a zero capacity skips a type entirely.
+///
+/// The |track_identifier| strings point to memory owned by the stats report,
+/// and are valid until the report is released with |mrsStatsReportRemoveRef()|.
+struct mrsStatsSnapshot {
+  /// Timestamp of the stats report, in microseconds.
+  int64_t timestamp_us;
+
+  mrsDataChannelStats* data_channel_stats;
+  uint32_t data_channel_stats_capacity;
+  uint32_t data_channel_stats_count;
+
+  mrsAudioSenderStats* audio_sender_stats;
+  uint32_t audio_sender_stats_capacity;
+  uint32_t audio_sender_stats_count;
+
+  mrsAudioReceiverStats* audio_receiver_stats;
+  uint32_t audio_receiver_stats_capacity;
+  uint32_t audio_receiver_stats_count;
+
+  mrsVideoSenderStats* video_sender_stats;
+  uint32_t video_sender_stats_capacity;
+  uint32_t video_sender_stats_count;
+
+  mrsVideoReceiverStats* video_receiver_stats;
+  uint32_t video_receiver_stats_capacity;
+  uint32_t video_receiver_stats_count;
+
+  mrsTransportStats* transport_stats;
+  uint32_t transport_stats_capacity;
+  uint32_t transport_stats_count;
+};
+
+/// Extract all the simple stats objects of a stats report into the
+/// caller-provided |snapshot|, walking the report only once. Sender and
+/// receiver stats are built from each RTP stream and its associated track
+/// stats. This returns the same objects as calling |mrsStatsReportGetObjects()|
+/// for each stats type, without any string dispatch or temporary allocation,
+/// except that tracks without an RTP stream, like tracks not sending or
+/// receiving yet, are not reported as sender or receiver stats.
+MRS_API mrsResult MRS_CALL
+mrsStatsReportGetSnapshot(mrsStatsReportHandle report_handle,
+                          mrsStatsSnapshot* snapshot) noexcept;
+
 /// Release a stats report.
 MRS_API mrsResult MRS_CALL
 mrsStatsReportRemoveRef(mrsStatsReportHandle stats_report);
@@ -13,6 +13,54 @@ extern "C" {
 /// audio track.
 struct mrsLocalAudioTrackInitConfig {};
 
+/// Waveform generated by a synthetic audio track source.
+enum class mrsSyntheticAudioWaveform : int32_t {
+  /// Continuous sine tone at |frequency_hz|.
+  kTone = 0,
+
+  /// Linear frequency sweep from |frequency_hz| to |end_frequency_hz| over
+  /// |period_ms|, repeated indefinitely.
+  kChirp = 1,
+
+  /// Sine tone bursts at |frequency_hz| of |pulse_duration_ms|, starting every
+  /// |period_ms|, separated by silence. The sharp onset of each burst is easy
+  /// to detect on the receiving side, to measure end-to-end audio latency.
+  kPulse = 2,
+};
+
+/// Configuration for creating a local audio track from a synthetic audio
+/// source generating samples programmatically, without any capture device.
+struct mrsSyntheticAudioTrackInitConfig {
+  /// Waveform to generate.
+  mrsSyntheticAudioWaveform waveform = mrsSyntheticAudioWaveform::kTone;
+
+  /// Sampling rate, in Hertz. Must be one of 8000, 16000, 32000, or 48000.
+  uint32_t sample_rate_hz = 48000;
+
+  /// Number of interleaved channels, all carrying the same signal. Must be 1
+  /// or 2.
+  uint32_t channel_count = 1;
+
+  /// Frequency of the tone and pulses, and start frequency of the chirp, in
+  /// Hertz. Must be positive and less than half the sampling rate.
+  double frequency_hz = 440.0;
+
+  /// End frequency of the chirp, in Hertz. Must be positive and less than half
+  /// the sampling rate. Ignored for other waveforms.
+  double end_frequency_hz = 4000.0;
+
+  /// Duration of a chirp sweep, or interval between two pulses, in
+  /// milliseconds. Must be a non-zero multiple of 10. Ignored for tones.
+  uint32_t period_ms = 1000;
+
+  /// Duration of each pulse, in milliseconds. Must be non-zero and not greater
+  /// than |period_ms|. Ignored for other waveforms.
+  uint32_t pulse_duration_ms = 50;
+
+  /// Peak amplitude of the signal, in ]0:1] relative to the full scale.
+  double amplitude = 0.5;
+};
+
 /// Add a reference to the native object associated with the given handle.
 MRS_API void MRS_CALL
 mrsLocalAudioTrackAddRef(mrsLocalAudioTrackHandle handle) noexcept;
@@ -28,6 +76,18 @@ MRS_API mrsResult MRS_CALL mrsLocalAudioTrackCreateFromDevice(
     const char* track_name,
     mrsLocalAudioTrackHandle* track_handle_out) noexcept;
 
+/// Create a new local audio track backed by a synthetic audio source, which
+/// generates audio frames of 10 ms programmatically. This requires no capture
+/// device, and is typically used for testing and benchmarking.
+///
+/// Note that the audio engine still records from the audio capture device, if
+/// any, and sends those samples interleaved with the synthetic ones. For clean
+/// measurements, use this on machines without an audio capture device.
+MRS_API mrsResult MRS_CALL mrsLocalAudioTrackCreateSynthetic(
+    const mrsSyntheticAudioTrackInitConfig* config,
+    const char* track_name,
+    mrsLocalAudioTrackHandle* track_handle_out) noexcept;
+
 /// Register a custom callback to be called when the local audio track captured
 /// a frame.
 MRS_API void MRS_CALL
@@ -61,6 +61,75 @@ struct mrsLocalVideoTrackFromExternalSourceInitConfig {
   const char* track_name;
 };
 
+/// Pattern drawn by a synthetic video track source.
+enum class mrsSyntheticVideoPattern : int32_t {
+  /// Vertical color bars, with a white square moving horizontally.
+  kColorBars = 0,
+
+  /// Diagonal luma gradient scrolling by a fixed amount every frame.
+  kMovingGradient = 1,
+
+  /// Pseudo-random luma and chroma noise, seeded with the frame number. This
+  /// is the worst case for most video encoders, and is useful to saturate the
+  /// encoding pipeline.
+  kNoise = 2,
+};
+
+/// Configuration for creating a local video track from a synthetic video
+/// source generating frames programmatically, without any capture device.
+/// The content of the frames is a deterministic function of the frame number,
+/// except for the timestamp of the optional frame marker.
+struct mrsSyntheticVideoTrackInitConfig {
+  /// Frame width, in pixels. Must be a non-zero multiple of 2.
+  uint32_t width = 640;
+
+  /// Frame height, in pixels. Must be a non-zero multiple of 2.
+  uint32_t height = 480;
+
+  /// Framerate, in frames per second (FPS). Must be in ]0:120].
+  double framerate = 30.0;
+
+  /// Pattern drawn in each frame.
+  mrsSyntheticVideoPattern pattern = mrsSyntheticVideoPattern::kColorBars;
+
+  /// Embed in the top quarter of each frame a marker encoding the frame number
+  /// and the frame generation time, which can be decoded on the receiving side
+  /// with |mrsSyntheticVideoFrameReadMarker()|.
+  mrsBool embed_marker = mrsBool::kTrue;
+};
+
+/// Marker embedded into a frame produced by a synthetic video source.
+struct mrsSyntheticVideoFrameMarker {
+  /// Zero-based number of the frame since the source started.
+  uint32_t frame_number;
+
+  /// Time the frame was generated at, in microseconds, truncated to 32 bits.
+  /// This uses the same monotonic clock as the rest of the library.
+  uint32_t timestamp_us;
+
+  /// Time elapsed between the frame generation and the decoding of the marker,
+  /// in microseconds. This is only meaningful if the marker is decoded in the
+  /// same process which generated the frame, for example in loopback tests.
+  uint32_t age_us;
+};
+
+/// Preference for degrading the video sent by a local video track when the
+/// encoder is constrained by bandwidth or CPU usage.
+enum class mrsDegradationPreference : int32_t {
+  /// Let the implementation decide. This currently maintains the framerate of
+  /// camera content.
+  kDefault = 0,
+
+  /// Reduce the resolution to maintain the framerate, for fluid content with
+  /// motion. This sets the track content hint to "motion".
+  kMaintainFramerate = 1,
+
+  /// Reduce the framerate to maintain the resolution, for detailed content
+  /// like text or screen captures. This sets the track content hint to
+  /// "detail".
+  kMaintainResolution = 2,
+};
+
 /// Add a reference to the native object associated with the given handle.
 MRS_API void MRS_CALL
 mrsLocalVideoTrackAddRef(mrsLocalVideoTrackHandle handle) noexcept;
@@ -82,6 +151,32 @@ MRS_API mrsResult MRS_CALL mrsLocalVideoTrackCreateFromExternalSource(
     const mrsLocalVideoTrackFromExternalSourceInitConfig* config,
     mrsLocalVideoTrackHandle* track_handle_out) noexcept;
 
+/// Create a new local video track using an encoded video track source, whose
+/// access units are sent without being re-encoded. Several tracks can share
+/// the same source, for example to send the same content to several peers.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackCreateFromEncodedSource(
+    mrsEncodedVideoTrackSourceHandle source_handle,
+    const char* track_name,
+    mrsLocalVideoTrackHandle* track_handle_out) noexcept;
+
+/// Create a new local video track backed by a synthetic video source, which
+/// generates frames programmatically. This requires no capture device, and is
+/// typically used for testing and benchmarking. The source is owned by the
+/// track, and stops when the track is destroyed.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackCreateSynthetic(
+    const mrsSyntheticVideoTrackInitConfig* config,
+    const char* track_name,
+    mrsLocalVideoTrackHandle* track_handle_out) noexcept;
+
+/// Decode the marker embedded by a synthetic video source into |frame|, for
+/// example on a frame received from a remote video track. The frame can have a
+/// different resolution than the one generated, as long as its aspect ratio is
+/// preserved. Return |mrsResult::kNotFound| if the frame contains no valid
+/// marker.
+MRS_API mrsResult MRS_CALL
+mrsSyntheticVideoFrameReadMarker(const mrsI420AVideoFrame* frame,
+                                 mrsSyntheticVideoFrameMarker* marker) noexcept;
+
 /// Register a custom callback to be called when the local video track captured
 /// a frame. The captured frames is passed to the registered callback in I420
 /// encoding.
@@ -98,6 +193,23 @@ MRS_API void MRS_CALL mrsLocalVideoTrackRegisterArgb32FrameCallback(
     mrsArgb32VideoFrameCallback callback,
     void* user_data) noexcept;
 
+/// Register a custom callback to be called when the local video track captured
+/// a frame. The captured frames is passed to the registered callback in NV12
+/// encoding, without conversion if the source produces NV12 frames.
+MRS_API void MRS_CALL mrsLocalVideoTrackRegisterNv12FrameCallback(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept;
+
+/// Crop and scale the frames passed to the frame callback of the given format
+/// registered on a local video track, or pass full frames again if |scaling|
+/// is NULL. Frames are scaled in I420 into pooled buffers before conversion to
+/// the format of the callback, so the alpha plane of I420A frames is dropped.
+MRS_API mrsResult MRS_CALL
+mrsLocalVideoTrackSetFrameScaling(mrsLocalVideoTrackHandle track_handle,
+                                  mrsVideoFrameFormat format,
+                                  const mrsVideoFrameScaling* scaling) noexcept;
+
 /// Enable or disable a local video track. Enabled tracks output their media
 /// content as usual. Disabled track output some void media content (black video
 /// frames, silent audio frames). Enabling/disabling a track is a lightweight
@@ -110,4 +222,40 @@ mrsLocalVideoTrackSetEnabled(mrsLocalVideoTrackHandle track_handle,
 MRS_API mrsBool MRS_CALL
 mrsLocalVideoTrackIsEnabled(mrsLocalVideoTrackHandle track_handle) noexcept;
 
+/// Get the current parameters of the send encodings of the RTP sender the
+/// local video track is attached to. On input |*count| is the capacity of the
+/// |encodings| array, and on output the number of encodings of the sender. If
+/// the capacity is too small, no encoding is written and the function returns
+/// |mrsResult::kInvalidParameter|; passing a null array with a zero capacity
+/// queries the number of encodings. The |rid| field of the returned encodings
+/// is always NULL. The track must be attached to a transceiver, otherwise this
+/// returns |mrsResult::kInvalidOperation|.
+MRS_API mrsResult MRS_CALL
+mrsLocalVideoTrackGetSendEncodings(mrsLocalVideoTrackHandle track_handle,
+                                   mrsSendEncodingParameters* encodings,
+                                   uint32_t* count) noexcept;
+
+/// Change the parameters of the send encoding at index |index| of the RTP
+/// sender the local video track is attached to, without renegotiating. This
+/// allows trading resolution for framerate or bitrate on a live stream. A
+/// non-null |rid| must match the RID of the encoding. The other encodings, if
+/// any, are left unchanged.
+MRS_API mrsResult MRS_CALL
+mrsLocalVideoTrackSetSendEncoding(
+    mrsLocalVideoTrackHandle track_handle,
+    uint32_t index,
+    const mrsSendEncodingParameters* encoding) noexcept;
+
+/// Set the preference for degrading the video sent by the local video track
+/// when the encoder is constrained. This applies to all senders of the track,
+/// without renegotiating.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackSetDegradationPreference(
+    mrsLocalVideoTrackHandle track_handle,
+    mrsDegradationPreference preference) noexcept;
+
+/// Get the preference for degrading the video sent by the local video track.
+MRS_API mrsResult MRS_CALL mrsLocalVideoTrackGetDegradationPreference(
+    mrsLocalVideoTrackHandle track_handle,
+    mrsDegradationPreference* preference_out) noexcept;
+
 }  // extern "C"
@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "export.h"
+#include "interop_api.h"
+
+extern "C" {
+
+/// Severity of a log message, from the most to the least verbose.
+enum class mrsLogSeverity : int32_t {
+  kVerbose = 0,
+  kInfo = 1,
+  kWarning = 2,
+  kError = 3,
+};
+
+/// Log message delivered to a log sink. The strings are only valid for the
+/// duration of the callback, and must be copied to be used afterward.
+struct mrsLogMessage {
+  /// Time at which the message was logged, in microseconds on the monotonic
+  /// clock of the library.
+  int64_t timestamp_us;
+
+  /// Severity of the message.
+  mrsLogSeverity severity;
+
+  /// Tag of the message, which is the name of the source file the message
+  /// was logged from, like "peer_connection.cpp", or an empty string if
+  /// unknown.
+  const char* tag;
+
+  /// Text of the message, without the source location prefix.
+  const char* message;
+};
+
+/// Callback invoked on the delivery thread of a log sink for each message.
+using mrsLogMessageCallback = void(MRS_CALL*)(void* user_data,
+                                              const mrsLogMessage* message);
+
+/// Configuration of a log sink.
+struct mrsLogSinkConfig {
+  /// Minimum severity of the messages delivered to the sink.
+  mrsLogSeverity min_severity{mrsLogSeverity::kInfo};
+
+  /// Optional semicolon-separated list of tag prefixes, like
+  /// "peer_connection;data_channel". If not NULL or empty, only the messages
+  /// whose tag starts with one of the prefixes are delivered.
+  const char* tag_filter{nullptr};
+
+  /// Capacity of the queue of messages waiting for delivery, rounded up to the
+  /// next power of two. Messages logged while the queue is full are dropped,
+  /// and the number of messages dropped is reported by a warning message
+  /// delivered once the queue has room again.
+  uint32_t queue_capacity{1024};
+};
+
+/// Opaque handle to a log sink. Handles are never reused, so the handle of a
+/// destroyed sink is rejected with |mrsResult::kInvalidNativeHandle|.
+using mrsLogSinkHandle = void*;
+
+/// Create a log sink receiving the messages logged by the library and by
+/// WebRTC. Logging threads only filter and enqueue messages, without blocking,
+/// and the messages are delivered to |callback| on a dedicated thread of the
+/// sink, in the order they were enqueued. If |config| is NULL, the default
+/// configuration is used. The sink must be destroyed with
+/// |mrsLogSinkDestroy()|, or is destroyed by |mrsForceShutdown()|.
+MRS_API mrsResult MRS_CALL mrsLogSinkCreate(const mrsLogSinkConfig* config,
+                                            mrsLogMessageCallback callback,
+                                            void* user_data,
+                                            mrsLogSinkHandle* handle) noexcept;
+
+/// Get the total number of messages dropped by a log sink because its queue
+/// was full.
+MRS_API mrsResult MRS_CALL
+mrsLogSinkGetDroppedCount(mrsLogSinkHandle handle, uint64_t* count) noexcept;
+
+/// Destroy a log sink. The messages already enqueued are delivered before this
+/// returns, and no callback is invoked afterward. This cannot be called from
+/// the callback of the sink itself, and returns |mrsResult::kInvalidOperation|
+/// in that case.
+MRS_API mrsResult MRS_CALL mrsLogSinkDestroy(mrsLogSinkHandle handle) noexcept;
+
+}  // extern "C"
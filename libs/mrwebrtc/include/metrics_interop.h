@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "export.h"
+#include "interop_api.h"
+
+extern "C" {
+
+/// Take a snapshot of the metrics of the library, as a null-terminated JSON
+/// string. The snapshot contains a "counters" object mapping each counter name
+/// to its value, and a "histograms" object mapping each latency histogram name
+/// to an object with the "count" and "sum" of the recorded values, their
+/// "p50", "p90" and "p99" quantiles, and the non-empty "buckets" as pairs of
+/// [lower bound, count]. Latencies are in microseconds. Metrics are recorded
+/// continuously, with a negligible overhead, from the start of the process or
+/// the last call to |mrsMetricsReset()|.
+///
+/// |buffer| Output buffer of capacity *|buffer_size|, which can be NULL if
+/// *|buffer_size| is zero.
+/// |buffer_size| Pointer to the buffer capacity on input, modified on output
+/// with the size of the snapshot, including the null terminator. If the buffer
+/// is too small this returns |mrsResult::kInvalidParameter|, and the call can
+/// be repeated with a buffer of that size.
+MRS_API mrsResult MRS_CALL
+mrsMetricsGetSnapshot(char* buffer, uint64_t* buffer_size) noexcept;
+
+/// Reset all the metrics of the library to zero.
+MRS_API void MRS_CALL mrsMetricsReset() noexcept;
+
+}  // extern "C"
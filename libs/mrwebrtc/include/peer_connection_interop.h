@@ -71,6 +71,97 @@ mrsPeerConnectionAddTransceiver(mrsPeerConnectionHandle peer_handle,
                                 const mrsTransceiverInitConfig* config,
                                 mrsTransceiverHandle* handle) noexcept;
 
+/// Create a batch of |count| new transceivers attached to the given peer
+/// connection, from the array of configurations |configs|, and write their
+/// handles in order into the array |handles| of |count| elements. This is
+/// more efficient than calling |mrsPeerConnectionAddTransceiver()| repeatedly,
+/// and raises a single renegotiation needed event for the entire batch. The
+/// transceiver added callback is still invoked once per transceiver.
+///
+/// The transceiver names and send encodings of all configurations are
+/// validated before any transceiver is created, so invalid values there fail
+/// the call without creating any transceiver. Other errors can occur while
+/// creating a transceiver, for example if the media kind is invalid or if the
+/// peer connection is closed concurrently. In that case the batch stops at the
+/// failing transceiver, and the transceivers created before it remain attached
+/// to the peer connection. On error |handles| contains the handles of those
+/// transceivers already created, if any, followed by NULL handles.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionAddTransceivers(mrsPeerConnectionHandle peer_handle,
+                                 const mrsTransceiverInitConfig* configs,
+                                 uint32_t count,
+                                 mrsTransceiverHandle* handles) noexcept;
+
+//
+// Stats sampler
+//
+
+/// Configuration of the periodic stats sampler of a peer connection.
+struct mrsStatsSamplerConfig {
+  /// Interval between two consecutive stats reports, in milliseconds.
+  int32_t interval_ms{1000};
+
+  /// Number of samples kept in the ring buffer. Once full, each new sample
+  /// overwrites the oldest one.
+  int32_t capacity{60};
+};
+
+/// Single sample of the periodic stats sampler, containing the rates computed
+/// between two consecutive stats reports. Rates are aggregated over all the
+/// RTP streams of the same media kind and direction.
+struct mrsStatsSample {
+  /// Monotonically increasing sample index, starting at zero when the sampler
+  /// is created. This allows detecting gaps and already-read samples.
+  uint64_t sequence_number;
+
+  /// Timestamp of the stats report the sample was computed from, in
+  /// microseconds.
+  int64_t timestamp_us;
+
+  /// Duration covered by the sample, in microseconds.
+  int64_t interval_us;
+
+  double audio_send_bitrate_bps;
+  double audio_receive_bitrate_bps;
+  double video_send_bitrate_bps;
+  double video_receive_bitrate_bps;
+
+  /// Fraction of inbound packets lost during the interval, in [0:1].
+  double audio_packet_loss_rate;
+  double video_packet_loss_rate;
+
+  /// Average inbound jitter at the end of the interval, in seconds.
+  double audio_jitter_s;
+  double video_jitter_s;
+
+  /// Number of video frames encoded and decoded per second.
+  double video_send_framerate;
+  double video_receive_framerate;
+};
+
+/// Start sampling stats periodically on the WebRTC signaling thread, and store
+/// the computed rates into a ring buffer readable with
+/// |mrsPeerConnectionReadStatsSamples()|. If a sampler is already running, it
+/// is replaced by a new one with the new configuration, and previous samples
+/// are discarded.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionStartStatsSampler(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsStatsSamplerConfig* config) noexcept;
+
+/// Stop the periodic stats sampler, if running. Samples already collected can
+/// still be read until the sampler is started again.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionStopStatsSampler(mrsPeerConnectionHandle peer_handle) noexcept;
+
+/// Copy the most recent stats samples, oldest first, into the caller-provided
+/// |samples| array of |capacity| elements. On return |count_out| contains the
+/// number of samples copied. This does not block on the signaling thread.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionReadStatsSamples(mrsPeerConnectionHandle peer_handle,
+                                  mrsStatsSample* samples,
+                                  uint32_t capacity,
+                                  uint32_t* count_out) noexcept;
+
 #if 0 // WIP
 /// Experimental. Render or not remote audio tracks from a peer connection on
 /// the system audio device.
@@ -8,6 +8,30 @@
 
 extern "C" {
 
+/// Delivery priority of a remote video track, which allows skipping the
+/// frame delivery work for streams which are not displayed.
+enum class mrsRemoteVideoTrackPriority : int32_t {
+  /// Deliver all frames to the registered frame callbacks. This is the
+  /// default.
+  kNormal = 0,
+
+  /// Deliver at most 5 frames per second to the registered frame callbacks,
+  /// for example for thumbnails. Other frames are dropped before any format
+  /// conversion.
+  kLow = 1,
+
+  /// Deliver no frame to the registered frame callbacks, and stop decoding the
+  /// video stream. The stream is still received, but its encoded frames are
+  /// dropped before the decoder. When the priority is raised again, decoding
+  /// resumes with the next key frame, which is requested from the sender.
+  /// The decoder of the stream is only known once it decoded a frame, so a
+  /// track paused before receiving any frame keeps decoding until resumed;
+  /// its frames are still not delivered. On UWP, the decoders cannot be
+  /// paused, so frames are only not delivered. A frame already in flight when
+  /// pausing may still reach the track, and is dropped.
+  kPaused = 2,
+};
+
 /// Assign some opaque user data to the remote video track. The implementation
 /// will store the pointer in the remote video track object and not touch it. It
 /// can be retrieved with |mrsRemoteVideoTrackGetUserData()| at any point during
@@ -38,6 +62,22 @@ MRS_API void MRS_CALL mrsRemoteVideoTrackRegisterArgb32FrameCallback(
     mrsArgb32VideoFrameCallback callback,
     void* user_data) noexcept;
 
+/// Register a custom callback to be called when the remote video track received
+/// a frame. The received frames is passed to the registered callback in NV12
+/// encoding.
+MRS_API void MRS_CALL mrsRemoteVideoTrackRegisterNv12FrameCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept;
+
+/// Crop and scale the frames passed to the frame callback of the given format
+/// registered on a remote video track, or pass full frames again if |scaling|
+/// is NULL. See |mrsLocalVideoTrackSetFrameScaling()| for details.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackSetFrameScaling(
+    mrsRemoteVideoTrackHandle track_handle,
+    mrsVideoFrameFormat format,
+    const mrsVideoFrameScaling* scaling) noexcept;
+
 /// Enable or disable a remote video track. Enabled tracks output their media
 /// content as usual. Disabled tracks output some void media content (black
 /// video frames, silent audio frames). Enabling/disabling a track is a
@@ -51,4 +91,19 @@ mrsRemoteVideoTrackSetEnabled(mrsRemoteVideoTrackHandle track_handle,
 MRS_API mrsBool MRS_CALL
 mrsRemoteVideoTrackIsEnabled(mrsRemoteVideoTrackHandle track_handle) noexcept;
 
+/// Set the delivery priority of a remote video track. Pausing the track also
+/// stops decoding its stream, see |mrsRemoteVideoTrackPriority::kPaused|, but
+/// the frames are still received. To also save the bandwidth of a stream not
+/// displayed for a long time, the application can ask the remote peer to
+/// deactivate its send encoding with |mrsLocalVideoTrackSetSendEncoding()|.
+MRS_API mrsResult MRS_CALL
+mrsRemoteVideoTrackSetPriority(mrsRemoteVideoTrackHandle track_handle,
+                               mrsRemoteVideoTrackPriority priority) noexcept;
+
+/// Get the delivery priority of a remote video track.
+/// See |mrsRemoteVideoTrackSetPriority()|.
+MRS_API mrsResult MRS_CALL mrsRemoteVideoTrackGetPriority(
+    mrsRemoteVideoTrackHandle track_handle,
+    mrsRemoteVideoTrackPriority* priority_out) noexcept;
+
 }  // extern "C"
@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "export.h"
+#include "interop_api.h"
+
+extern "C" {
+
+/// Configuration of the trace recording.
+struct mrsTracingConfig {
+  /// Capacity of the ring buffer of each thread, in number of events. Once the
+  /// buffer of a thread is full, the oldest events of that thread are
+  /// overwritten by the new ones. Each event uses 48 bytes on 64-bit
+  /// platforms.
+  uint32_t events_per_thread{16384};
+};
+
+/// Start recording trace events from the instrumented code paths of the
+/// library, such as frame callbacks, data channel messages and signaling. Any
+/// event previously recorded is discarded. If |config| is NULL, the default
+/// configuration is used. The trace points have a negligible cost while
+/// recording is stopped, and can be removed entirely by compiling the library
+/// with |MRS_DISABLE_TRACING| defined, in which case this returns
+/// |mrsResult::kUnsupported|.
+MRS_API mrsResult MRS_CALL
+mrsTracingStart(const mrsTracingConfig* config) noexcept;
+
+/// Stop recording trace events. The events recorded so far are kept until
+/// recording starts again, and can be written with |mrsTracingWriteJson()|.
+MRS_API mrsResult MRS_CALL mrsTracingStop() noexcept;
+
+/// Write the recorded trace events to the file at the given path, in the JSON
+/// trace event format of Chrome, which can be opened with chrome://tracing or
+/// the Perfetto UI. Recording must be stopped before writing the events, and
+/// this returns |mrsResult::kInvalidOperation| otherwise.
+MRS_API mrsResult MRS_CALL mrsTracingWriteJson(const char* path) noexcept;
+
+}  // extern "C"
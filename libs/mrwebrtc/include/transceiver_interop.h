@@ -45,6 +45,29 @@ MRS_API mrsResult MRS_CALL
 mrsTransceiverSetDirection(mrsTransceiverHandle transceiver_handle,
                            mrsTransceiverDirection new_direction) noexcept;
 
+/// Set the codecs the transceiver is allowed to negotiate, as a
+/// semicolon-separated list of SDP codec names in decreasing order of
+/// preference, e.g. "H264;VP8". Codecs not listed are removed from the media
+/// line of the transceiver in the next local SDP offer or answer. A NULL or
+/// empty string restores the default codecs. This does not trigger any
+/// renegotiation by itself.
+/// Unlike |mrsSdpForceCodecs()|, this applies to a single transceiver and does
+/// not require intercepting and rewriting the SDP message.
+MRS_API mrsResult MRS_CALL
+mrsTransceiverSetCodecPreferences(mrsTransceiverHandle transceiver_handle,
+                                  const char* encoded_codec_names) noexcept;
+
+/// Change at runtime the parameters of the encodings of the RTP sender of the
+/// transceiver, without renegotiating. |encodings| is an array of |count|
+/// elements matching in order the encodings the transceiver was created with,
+/// or a single element if it was created without explicit encodings. The
+/// number of encodings and their RID cannot change; the |rid| field can be
+/// NULL, and otherwise must match the existing RID of the encoding.
+MRS_API mrsResult MRS_CALL mrsTransceiverSetSendEncodings(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsSendEncodingParameters* encodings,
+    uint32_t count) noexcept;
+
 /// Set the local audio track associated with this transceiver. This new track
 /// replaces the existing one, if any. This doesn't require any SDP
 /// renegotiation. This fails if the transceiver is a video transceiver.
@@ -83,4 +106,71 @@ MRS_API mrsResult MRS_CALL mrsTransceiverGetRemoteVideoTrack(
     mrsTransceiverHandle transceiver_handle,
     mrsRemoteVideoTrackHandle* track_handle_out) noexcept;
 
+/// Direction of an encoded frame intercepted on a transceiver.
+enum class mrsEncodedFrameDirection : int32_t {
+  /// Frame produced by the local encoder, about to be packetized and sent.
+  kSend = 0,
+
+  /// Frame received from the remote peer, about to be decoded.
+  kReceive = 1,
+};
+
+/// Type of an encoded frame intercepted on a transceiver.
+enum class mrsEncodedFrameType : int32_t {
+  /// The type is not known, for audio frames and unrecognized video codecs.
+  kUnknown = 0,
+
+  /// Video key frame, decodable independently of any previous frame.
+  kKey = 1,
+
+  /// Video delta frame, depending on previous frames.
+  kDelta = 2,
+};
+
+/// Encoded frame intercepted on a transceiver. The frame data is only valid
+/// during the callback.
+struct mrsEncodedFrameInfo {
+  mrsEncodedFrameDirection direction;
+  mrsMediaKind media_kind;
+
+  /// Frame type, determined from the bitstream for VP8, VP9 and H.264.
+  mrsEncodedFrameType frame_type;
+
+  /// SDP name of the negotiated codec, e.g. "VP8", or NULL if not known.
+  const char* codec_name;
+
+  /// SSRC of the RTP stream carrying the frame, for sent frames only.
+  uint32_t ssrc;
+
+  /// Contributing sources of the frame, for received frames only.
+  const uint32_t* csrcs;
+  uint32_t csrc_count;
+
+  /// Time the frame was intercepted, in microseconds, on the same monotonic
+  /// clock as the rest of the library.
+  int64_t timestamp_us;
+
+  /// Encoded payload of the frame, without any RTP header.
+  const uint8_t* data;
+  uint32_t size;
+};
+
+using mrsEncodedFrameCallback =
+    void(MRS_CALL*)(void* user_data, const mrsEncodedFrameInfo* frame);
+
+/// Register a callback invoked with the encoded frames sent and received by
+/// the transceiver, or unregister it with a NULL callback. Frames are passed
+/// through unmodified. The callback is invoked on the WebRTC encoder and
+/// receive threads, and must return quickly; frames sent and received are
+/// delivered sequentially.
+///
+/// The interception relies on the frame encryption hooks of the RTP sender and
+/// receiver, so is exclusive with end-to-end frame encryption. The callback
+/// should be registered before the transceiver is negotiated, as the hooks may
+/// only be applied to the media streams when they are created.
+MRS_API mrsResult MRS_CALL mrsTransceiverRegisterEncodedFrameCallback(
+    mrsTransceiverHandle transceiver_handle,
+    mrsEncodedFrameCallback callback,
+    void* user_data) noexcept;
+
 }  // extern "C"
@@ -0,0 +1,57 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "export.h"
+#include "interop_api.h"
+
+extern "C" {
+
+/// Trade-off between the CPU usage and the quality of a video encoder, like
+/// the speed presets of libvpx ("cpu_used"). Higher complexities spend more
+/// CPU to get a better quality at the same bitrate.
+enum class mrsVideoEncoderComplexity : int32_t {
+  /// Default complexity of the encoder, which is also the fastest.
+  kNormal = 0,
+  kHigh = 1,
+  kHigher = 2,
+
+  /// Slowest setting, for the best quality.
+  kMax = 3,
+};
+
+/// Threading configuration of the encoders of a video codec.
+struct mrsVideoEncoderThreadingConfig {
+  /// Number of CPU cores each encoder instance is allowed to use, which bounds
+  /// its number of threads. Zero lets WebRTC use all the cores of the machine.
+  /// The encoder may still use fewer threads for small resolutions.
+  uint32_t thread_count{0};
+
+  /// Complexity of the encoders. In the current version of WebRTC, only the
+  /// built-in VP8 encoder takes this into account.
+  mrsVideoEncoderComplexity complexity{mrsVideoEncoderComplexity::kNormal};
+};
+
+/// Set the threading configuration of the encoders of the video codec with the
+/// given SDP name, including external encoders, or the default configuration
+/// of all codecs without a configuration of their own if |codec_name| is NULL.
+/// Passing a NULL |config| removes the configuration. The configuration is
+/// applied the next time the library is initialized, so this returns
+/// |mrsResult::kInvalidOperation| if the library is already initialized.
+MRS_API mrsResult MRS_CALL mrsSetVideoEncoderThreadingConfig(
+    const char* codec_name,
+    const mrsVideoEncoderThreadingConfig* config) noexcept;
+
+/// Set the total number of encoder threads shared by all the video encoders
+/// of the process, or zero for no limit. Each encoder instance reserves its
+/// threads from this pool when it is initialized and returns them when it is
+/// released; once the pool is exhausted, new encoders are limited to a single
+/// thread. This allows multi-party hosts to bound the CPU usage of encoding,
+/// whatever the number of streams. The size is applied the next time the
+/// library is initialized, so this returns |mrsResult::kInvalidOperation| if
+/// the library is already initialized.
+MRS_API mrsResult MRS_CALL
+mrsSetVideoEncoderThreadPoolSize(uint32_t thread_count) noexcept;
+
+}  // extern "C"
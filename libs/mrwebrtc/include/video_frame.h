@@ -56,6 +56,36 @@ struct I420AVideoFrame {
   std::int32_t astride_;
 };
 
+/// View over an existing buffer representing a video frame encoded in NV12
+/// format, with a full-resolution Y plane followed by a half-resolution plane
+/// of interleaved U and V samples. This is the native output format of many
+/// hardware decoders and capture devices.
+struct Nv12VideoFrame {
+  /// Width of the video frame, in pixels.
+  std::uint32_t width_;
+
+  /// Height of the video frame, in pixels.
+  std::uint32_t height_;
+
+  /// Pointer to the raw contiguous memory block holding the Y plane data.
+  /// The size of the buffer is at least (|ystride_| * |height_|) bytes.
+  const void* ydata_;
+
+  /// Pointer to the raw contiguous memory block holding the interleaved UV
+  /// plane data. The size of the buffer is at least
+  /// (|uvstride_| * (|height_| + 1) / 2) bytes, due to chroma downsampling
+  /// compared to the Y plane.
+  const void* uvdata_;
+
+  /// Stride in bytes between two consecutive rows in the Y plane buffer.
+  /// This is always greater than or equal to |width_|.
+  std::int32_t ystride_;
+
+  /// Stride in bytes between two consecutive rows in the UV plane buffer.
+  /// This is always greater than or equal to (2 * ((|width_| + 1) / 2)).
+  std::int32_t uvstride_;
+};
+
 /// View over an existing buffer representing a video frame encoded in ARGB
 /// 32-bit-per-pixel format, in little endian order (B first, A last).
 struct Argb32VideoFrame {
@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "audio_frame_observer.h"
+#include "export.h"
+#include "interop_api.h"
+
+extern "C" {
+
+/// Kind of audio device module the library uses for audio capture and playout.
+enum class mrsAudioDeviceModuleKind : int32_t {
+  /// Audio device module of the platform, which opens the default capture and
+  /// playout devices of the system.
+  kPlatform = 0,
+
+  /// Virtual audio device module without any device I/O. The captured audio is
+  /// pushed by the application with |mrsVirtualAudioDevicePushCaptureFrame()|,
+  /// and the mixed playout audio is delivered to the callback registered with
+  /// |mrsVirtualAudioDeviceRegisterPlayoutCallback()|. This is intended for
+  /// headless servers without any sound device.
+  kVirtual = 1,
+};
+
+/// Clock driving the 10 ms capture and playout periods of the virtual audio
+/// device module.
+enum class mrsVirtualAudioClock : int32_t {
+  /// Real-time clock ticking every 10 ms on a dedicated thread.
+  kRealTime = 0,
+
+  /// No clock. The application runs each period by calling
+  /// |mrsVirtualAudioDeviceProcess()|, for example to process audio offline or
+  /// faster than real time.
+  kNone = 1,
+};
+
+/// Configuration of the audio device module of the library.
+struct mrsAudioDeviceModuleConfig {
+  /// Kind of audio device module to use.
+  mrsAudioDeviceModuleKind kind{mrsAudioDeviceModuleKind::kPlatform};
+
+  /// Clock of the virtual audio device module. Ignored for other kinds.
+  mrsVirtualAudioClock clock{mrsVirtualAudioClock::kRealTime};
+
+  /// Sampling rate of the virtual device, for both capture and playout, in Hz.
+  /// One of 8000, 16000, 32000, 44100 or 48000. Ignored for other kinds.
+  uint32_t sample_rate_hz{48000};
+
+  /// Number of channels of the virtual device, for both capture and playout;
+  /// either 1 (mono) or 2 (stereo). Ignored for other kinds.
+  uint32_t channel_count{1};
+};
+
+/// Select the audio device module the library uses the next time it is
+/// initialized. This returns |mrsResult::kInvalidOperation| if the library is
+/// already initialized, since the audio device module cannot be changed until
+/// the library shuts down. The virtual audio device module is not supported on
+/// UWP, which returns |mrsResult::kUnsupported|.
+MRS_API mrsResult MRS_CALL mrsSetAudioDeviceModuleConfig(
+    const mrsAudioDeviceModuleConfig* config) noexcept;
+
+/// Append some audio to the capture queue of the virtual audio device module,
+/// which is consumed 10 ms at a time as if it was recorded by a microphone.
+/// The frame must contain 16-bit samples with the sampling rate and channel
+/// count of the device. If the queue runs empty, silence is recorded instead.
+/// The queue holds up to 1 second of audio; older audio is discarded to make
+/// room for the new frame. This returns |mrsResult::kNotInitialized| if the
+/// library is not initialized or does not use the virtual audio device module.
+MRS_API mrsResult MRS_CALL
+mrsVirtualAudioDevicePushCaptureFrame(const mrsAudioFrame* frame) noexcept;
+
+/// Register a callback invoked every 10 ms with the mixed audio of all the
+/// remote audio tracks output to the device, or unregister it if |callback| is
+/// NULL. The callback is invoked from the clock thread, or for
+/// |mrsVirtualAudioClock::kNone| from the thread calling
+/// |mrsVirtualAudioDeviceProcess()|. The registration is lost when the library
+/// shuts down. This returns |mrsResult::kNotInitialized| if the library is not
+/// initialized or does not use the virtual audio device module.
+MRS_API mrsResult MRS_CALL
+mrsVirtualAudioDeviceRegisterPlayoutCallback(mrsAudioFrameCallback callback,
+                                             void* user_data) noexcept;
+
+/// Run |period_count| consecutive 10 ms capture and playout periods of the
+/// virtual audio device module synchronously on the calling thread. This is
+/// only valid with |mrsVirtualAudioClock::kNone|, and returns
+/// |mrsResult::kInvalidOperation| otherwise.
+MRS_API mrsResult MRS_CALL
+mrsVirtualAudioDeviceProcess(uint32_t period_count) noexcept;
+
+}  // extern "C"
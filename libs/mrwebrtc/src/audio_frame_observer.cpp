@@ -5,6 +5,7 @@
 #include "pch.h"
 
 #include "audio_frame_observer.h"
+#include "tracing.h"
 
 namespace Microsoft {
 namespace MixedReality {
@@ -21,6 +22,7 @@ void AudioFrameObserver::OnData(const void* audio_data,
                                 int sample_rate,
                                 size_t number_of_channels,
                                 size_t number_of_frames) noexcept {
+  MRS_TRACE_SCOPE_ARG("AudioFrameObserver::OnData", "frames", number_of_frames);
   std::lock_guard<std::mutex> lock(mutex_);
   if (!callback_) {
     return;
@@ -5,7 +5,10 @@
 #include "pch.h"
 
 #include "data_channel.h"
+#include "handle_table.h"
+#include "metrics.h"
 #include "peer_connection.h"
+#include "tracing.h"
 
 namespace {
 
@@ -31,7 +34,10 @@ namespace WebRTC {
 DataChannel::DataChannel(
     PeerConnection* owner,
     rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) noexcept
-    : owner_(owner), data_channel_(std::move(data_channel)) {
+    : owner_(owner),
+      data_channel_(std::move(data_channel)),
+      handle_(
+          HandleTable::Instance().Allocate(this, ObjectType::kDataChannel)) {
   RTC_CHECK(owner_);
   data_channel_->RegisterObserver(this);
 }
@@ -42,6 +48,7 @@ DataChannel::~DataChannel() {
     owner_->RemoveDataChannel(*this);
   }
   RTC_CHECK(!owner_);
+  HandleTable::Instance().Free(handle_);
 }
 
 str DataChannel::label() const {
@@ -71,12 +78,19 @@ size_t DataChannel::GetMaxBufferingSize() const noexcept {
 }
 
 bool DataChannel::Send(const void* data, size_t size) noexcept {
+  MRS_TRACE_SCOPE_ARG("DataChannel::Send", "size", size);
   if (data_channel_->buffered_amount() + size > GetMaxBufferingSize()) {
+    Metrics::Add(MetricCounter::kDataChannelMessagesDropped);
     return false;
   }
   rtc::CopyOnWriteBuffer bufferStorage((const char*)data, size);
   webrtc::DataBuffer buffer(bufferStorage, /* binary = */ true);
-  return data_channel_->Send(buffer);
+  if (!data_channel_->Send(buffer)) {
+    Metrics::Add(MetricCounter::kDataChannelMessagesDropped);
+    return false;
+  }
+  Metrics::Add(MetricCounter::kDataChannelMessagesSent);
+  return true;
 }
 
 void DataChannel::OnStateChange() noexcept {
@@ -109,6 +123,8 @@ void DataChannel::OnStateChange() noexcept {
 }
 
 void DataChannel::OnMessage(const webrtc::DataBuffer& buffer) noexcept {
+  MRS_TRACE_SCOPE_ARG("DataChannel::OnMessage", "size", buffer.data.size());
+  Metrics::Add(MetricCounter::kDataChannelMessagesReceived);
   std::lock_guard<std::mutex> lock(mutex_);
   if (message_callback_) {
     message_callback_(buffer.data.data(), buffer.data.size());
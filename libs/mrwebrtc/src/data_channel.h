@@ -73,6 +73,10 @@ class DataChannel : public webrtc::DataChannelObserver {
   /// Remove the data channel from its parent PeerConnection and close it.
   ~DataChannel() override;
 
+  /// Get the handle of the data channel for the interop API. The handle is
+  /// valid until the data channel is destroyed.
+  MRS_NODISCARD constexpr void* GetHandle() const noexcept { return handle_; }
+
   MRS_NODISCARD constexpr void* GetUserData() const noexcept {
     return user_data_;
   }
@@ -146,6 +150,9 @@ class DataChannel : public webrtc::DataChannelObserver {
   StateCallback state_callback_ RTC_GUARDED_BY(mutex_);
   std::mutex mutex_;
 
+  /// Handle of the data channel for the interop API.
+  void* const handle_;
+
   /// Opaque user data.
   void* user_data_{nullptr};
 };
@@ -0,0 +1,193 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "data_channel.h"
+#include "handle_table.h"
+#include "media/encoded_frame_recorder.h"
+#include "media/encoded_video_track_source.h"
+#include "media/external_video_track_source.h"
+#include "media/local_audio_track.h"
+#include "media/local_video_track.h"
+#include "media/remote_audio_track.h"
+#include "media/remote_video_track.h"
+#include "media/transceiver.h"
+#include "peer_connection.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace {
+
+/// Get the tracked object of one of the given types associated with a handle.
+template <typename T>
+T* FromTrackedObjectHandle(const void* handle, uint32_t type_mask) noexcept {
+  // Tracked objects register their |TrackedObject| base pointer.
+  void* const object = HandleTable::Instance().Lookup(handle, type_mask);
+  return static_cast<T*>(static_cast<TrackedObject*>(object));
+}
+
+}  // namespace
+
+HandleTable& HandleTable::Instance() noexcept {
+  static HandleTable* const instance = new HandleTable();
+  return *instance;
+}
+
+void* HandleTable::Allocate(void* object, ObjectType type) noexcept {
+  RTC_DCHECK(object);
+  uint32_t index;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_slots_.size() > kMinFreeSlots) {
+      index = free_slots_.front();
+      free_slots_.pop_front();
+    } else if (slot_count_ < kMaxSlots) {
+      index = slot_count_++;
+      const uint32_t chunk_index = (index >> kChunkBits);
+      if (!chunks_[chunk_index].load(std::memory_order_relaxed)) {
+        chunks_[chunk_index].store(new Slot[kChunkSize],
+                                   std::memory_order_release);
+      }
+    } else if (!free_slots_.empty()) {
+      index = free_slots_.front();
+      free_slots_.pop_front();
+    } else {
+      RTC_CHECK(false) << "Interop handle table is full.";
+      return nullptr;
+    }
+  }
+  Slot* const slot = GetSlot(index);
+  slot->type_bit.store(TypeBit(type), std::memory_order_relaxed);
+  slot->object.store(object, std::memory_order_release);
+  const uint32_t generation = slot->generation.load(std::memory_order_relaxed);
+  return reinterpret_cast<void*>(Encode(index, generation));
+}
+
+void HandleTable::Free(void* handle) noexcept {
+  const uintptr_t value = reinterpret_cast<uintptr_t>(handle);
+  RTC_DCHECK((value & kIndexMask) != 0);
+  const uint32_t index = static_cast<uint32_t>((value & kIndexMask) - 1);
+  Slot* const slot = GetSlot(index);
+  RTC_DCHECK(slot);
+  RTC_DCHECK(Encode(index, slot->generation.load()) == value);
+  // Invalidate the handle before releasing the object pointer, so that a stale
+  // handle never resolves to the next object stored in the slot.
+  slot->generation.fetch_add(1, std::memory_order_acq_rel);
+  slot->object.store(nullptr, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_slots_.push_back(index);
+}
+
+void* HandleTable::Lookup(const void* handle,
+                          uint32_t type_mask) const noexcept {
+  const uintptr_t value = reinterpret_cast<uintptr_t>(handle);
+  if ((value & kIndexMask) == 0) {
+    return nullptr;
+  }
+  const uint32_t index = static_cast<uint32_t>((value & kIndexMask) - 1);
+  Slot* const slot = GetSlot(index);
+  if (!slot) {
+    return nullptr;
+  }
+  void* const object = slot->object.load(std::memory_order_acquire);
+  const uint32_t type_bit = slot->type_bit.load(std::memory_order_relaxed);
+  const uint32_t generation = slot->generation.load(std::memory_order_acquire);
+  if ((Encode(index, generation) != value) || !(type_bit & type_mask)) {
+    return nullptr;
+  }
+  return object;
+}
+
+uintptr_t HandleTable::Encode(uint32_t index, uint32_t generation) noexcept {
+  // Keep as many generation bits as fit in a pointer; on 32-bit platforms the
+  // high bits of the generation are truncated.
+  return (static_cast<uintptr_t>(generation) << kIndexBits) |
+         static_cast<uintptr_t>(index + 1);
+}
+
+HandleTable::Slot* HandleTable::GetSlot(uint32_t index) const noexcept {
+  const uint32_t chunk_index = (index >> kChunkBits);
+  if (chunk_index >= kMaxChunks) {
+    return nullptr;
+  }
+  Slot* const chunk = chunks_[chunk_index].load(std::memory_order_acquire);
+  if (!chunk) {
+    return nullptr;
+  }
+  return &chunk[index & (kChunkSize - 1)];
+}
+
+template <>
+PeerConnection* FromHandle<PeerConnection>(const void* handle) noexcept {
+  return FromTrackedObjectHandle<PeerConnection>(
+      handle, HandleTable::TypeBit(ObjectType::kPeerConnection));
+}
+
+template <>
+DataChannel* FromHandle<DataChannel>(const void* handle) noexcept {
+  // Data channels are not tracked objects, and register themselves directly.
+  return static_cast<DataChannel*>(HandleTable::Instance().Lookup(
+      handle, HandleTable::TypeBit(ObjectType::kDataChannel)));
+}
+
+template <>
+Transceiver* FromHandle<Transceiver>(const void* handle) noexcept {
+  // The API doesn't differentiate between audio and video transceivers.
+  return FromTrackedObjectHandle<Transceiver>(
+      handle, HandleTable::TypeBit(ObjectType::kAudioTransceiver) |
+                  HandleTable::TypeBit(ObjectType::kVideoTransceiver));
+}
+
+template <>
+LocalAudioTrack* FromHandle<LocalAudioTrack>(const void* handle) noexcept {
+  return FromTrackedObjectHandle<LocalAudioTrack>(
+      handle, HandleTable::TypeBit(ObjectType::kLocalAudioTrack));
+}
+
+template <>
+LocalVideoTrack* FromHandle<LocalVideoTrack>(const void* handle) noexcept {
+  return FromTrackedObjectHandle<LocalVideoTrack>(
+      handle, HandleTable::TypeBit(ObjectType::kLocalVideoTrack));
+}
+
+template <>
+RemoteAudioTrack* FromHandle<RemoteAudioTrack>(const void* handle) noexcept {
+  return FromTrackedObjectHandle<RemoteAudioTrack>(
+      handle, HandleTable::TypeBit(ObjectType::kRemoteAudioTrack));
+}
+
+template <>
+RemoteVideoTrack* FromHandle<RemoteVideoTrack>(const void* handle) noexcept {
+  return FromTrackedObjectHandle<RemoteVideoTrack>(
+      handle, HandleTable::TypeBit(ObjectType::kRemoteVideoTrack));
+}
+
+template <>
+ExternalVideoTrackSource* FromHandle<ExternalVideoTrackSource>(
+    const void* handle) noexcept {
+  return FromTrackedObjectHandle<ExternalVideoTrackSource>(
+      handle, HandleTable::TypeBit(ObjectType::kExternalVideoTrackSource));
+}
+
+template <>
+EncodedVideoTrackSource* FromHandle<EncodedVideoTrackSource>(
+    const void* handle) noexcept {
+  return FromTrackedObjectHandle<EncodedVideoTrackSource>(
+      handle, HandleTable::TypeBit(ObjectType::kEncodedVideoTrackSource));
+}
+
+template <>
+EncodedFrameRecorder* FromHandle<EncodedFrameRecorder>(
+    const void* handle) noexcept {
+  return FromTrackedObjectHandle<EncodedFrameRecorder>(
+      handle, HandleTable::TypeBit(ObjectType::kEncodedFrameRecorder));
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+#include "tracked_object.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Table of the handles given to the interop API in place of raw object
+/// pointers. A handle encodes the index of a slot of the table and the
+/// generation of that slot when the handle was allocated. Freeing a handle
+/// bumps the generation of its slot, so that any copy of the handle still held
+/// by the caller is detected as stale and rejected instead of dereferencing a
+/// destroyed object. Lookups are lock-free and O(1).
+///
+/// This only detects handles used after their object was destroyed. Using a
+/// handle concurrently with the destruction of its object remains a usage
+/// error of the API.
+class HandleTable {
+ public:
+  /// Get the singleton instance of the table. The table is never destroyed, as
+  /// objects can be released during static deinitializing of the process.
+  static HandleTable& Instance() noexcept;
+
+  /// Allocate a new handle for the given object of the given type. The handle
+  /// is never NULL.
+  void* Allocate(void* object, ObjectType type) noexcept;
+
+  /// Free a handle allocated with |Allocate()|, invalidating it.
+  void Free(void* handle) noexcept;
+
+  /// Get the object associated with the given handle, or NULL if the handle is
+  /// NULL, stale, or not associated with an object of one of the types in the
+  /// given type mask.
+  void* Lookup(const void* handle, uint32_t type_mask) const noexcept;
+
+  /// Get the bit of the given object type in the type mask of |Lookup()|.
+  static constexpr uint32_t TypeBit(ObjectType type) noexcept {
+    return (1u << static_cast<int>(type));
+  }
+
+ private:
+  /// Number of bits of the handle encoding the slot index. The rest of the bits
+  /// encode the slot generation, which on 32-bit platforms therefore wraps
+  /// around after 4096 reuses of the same slot.
+  static constexpr int kIndexBits = 20;
+  static constexpr uintptr_t kIndexMask = (uintptr_t{1} << kIndexBits) - 1;
+
+  /// Slots are allocated by chunks, which are never freed, so that lookups can
+  /// access the slots without locking.
+  static constexpr int kChunkBits = 10;
+  static constexpr uint32_t kChunkSize = (1u << kChunkBits);
+  static constexpr uint32_t kMaxChunks = (1u << (kIndexBits - kChunkBits));
+
+  /// Maximum number of slots. Handles encode |index + 1| so that a valid
+  /// handle is never NULL, which leaves room for one slot less than the index
+  /// bits can represent.
+  static constexpr uint32_t kMaxSlots = static_cast<uint32_t>(kIndexMask);
+
+  /// Minimum number of freed slots waiting to be reused before a slot is
+  /// actually reused, to delay generation wrap-around.
+  static constexpr size_t kMinFreeSlots = 1024;
+
+  struct Slot {
+    std::atomic<uint32_t> generation{0};
+    std::atomic<void*> object{nullptr};
+    std::atomic<uint32_t> type_bit{0};
+  };
+
+  HandleTable() = default;
+
+  static uintptr_t Encode(uint32_t index, uint32_t generation) noexcept;
+  Slot* GetSlot(uint32_t index) const noexcept;
+
+  std::atomic<Slot*> chunks_[kMaxChunks]{};
+
+  /// Protect allocation and release of the slots.
+  std::mutex mutex_;
+  uint32_t slot_count_{0};
+  std::deque<uint32_t> free_slots_;
+};
+
+class PeerConnection;
+class DataChannel;
+class Transceiver;
+class LocalAudioTrack;
+class LocalVideoTrack;
+class RemoteAudioTrack;
+class RemoteVideoTrack;
+class ExternalVideoTrackSource;
+class EncodedVideoTrackSource;
+class EncodedFrameRecorder;
+
+/// Get the object associated with an interop handle, or NULL if the handle is
+/// NULL, stale, or associated with an object of another type.
+template <typename T>
+T* FromHandle(const void* handle) noexcept;
+
+template <>
+PeerConnection* FromHandle<PeerConnection>(const void* handle) noexcept;
+template <>
+DataChannel* FromHandle<DataChannel>(const void* handle) noexcept;
+template <>
+Transceiver* FromHandle<Transceiver>(const void* handle) noexcept;
+template <>
+LocalAudioTrack* FromHandle<LocalAudioTrack>(const void* handle) noexcept;
+template <>
+LocalVideoTrack* FromHandle<LocalVideoTrack>(const void* handle) noexcept;
+template <>
+RemoteAudioTrack* FromHandle<RemoteAudioTrack>(const void* handle) noexcept;
+template <>
+RemoteVideoTrack* FromHandle<RemoteVideoTrack>(const void* handle) noexcept;
+template <>
+ExternalVideoTrackSource* FromHandle<ExternalVideoTrackSource>(
+    const void* handle) noexcept;
+template <>
+EncodedVideoTrackSource* FromHandle<EncodedVideoTrackSource>(
+    const void* handle) noexcept;
+template <>
+EncodedFrameRecorder* FromHandle<EncodedFrameRecorder>(
+    const void* handle) noexcept;
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -8,20 +8,21 @@
 #include "callback.h"
 #include "data_channel.h"
 #include "data_channel_interop.h"
+#include "handle_table.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
 
 MRS_API void MRS_CALL
 mrsDataChannelSetUserData(mrsDataChannelHandle handle,
                                void* user_data) noexcept {
-  if (auto data_channel = static_cast<DataChannel*>(handle)) {
+  if (auto data_channel = FromHandle<DataChannel>(handle)) {
     data_channel->SetUserData(user_data);
   }
 }
 
 MRS_API void* MRS_CALL
 mrsDataChannelGetUserData(mrsDataChannelHandle handle) noexcept {
-  if (auto data_channel = static_cast<DataChannel*>(handle)) {
+  if (auto data_channel = FromHandle<DataChannel>(handle)) {
     return data_channel->GetUserData();
   }
   return nullptr;
@@ -30,7 +31,7 @@ mrsDataChannelGetUserData(mrsDataChannelHandle handle) noexcept {
 void MRS_CALL mrsDataChannelRegisterCallbacks(
     mrsDataChannelHandle handle,
     const mrsDataChannelCallbacks* callbacks) noexcept {
-  if (auto data_channel = static_cast<DataChannel*>(handle)) {
+  if (auto data_channel = FromHandle<DataChannel>(handle)) {
     data_channel->SetMessageCallback(Callback<const void*, const uint64_t>{
         callbacks->message_callback, callbacks->message_user_data});
     data_channel->SetBufferingCallback(
@@ -45,7 +46,7 @@ mrsResult MRS_CALL
 mrsDataChannelSendMessage(mrsDataChannelHandle dataChannelHandle,
                           const void* data,
                           uint64_t size) noexcept {
-  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  auto data_channel = FromHandle<DataChannel>(dataChannelHandle);
   if (!data_channel) {
     return Result::kInvalidNativeHandle;
   }
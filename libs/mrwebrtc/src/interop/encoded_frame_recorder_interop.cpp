@@ -0,0 +1,79 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "encoded_frame_recorder_interop.h"
+#include "handle_table.h"
+#include "interop/global_factory.h"
+#include "media/encoded_frame_recorder.h"
+#include "media/transceiver.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsEncodedFrameRecorderCreate(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsEncodedFrameRecorderConfig* config,
+    mrsEncodedFrameRecorderHandle* recorder_handle_out) noexcept {
+  if (!config || !recorder_handle_out) {
+    return Result::kInvalidParameter;
+  }
+  *recorder_handle_out = nullptr;
+  auto transceiver = FromHandle<Transceiver>(transceiver_handle);
+  if (!transceiver) {
+    return Result::kInvalidNativeHandle;
+  }
+  auto result = EncodedFrameRecorder::Create(
+      GlobalFactory::InstancePtr(), RefPtr<Transceiver>(transceiver), *config);
+  if (!result.ok()) {
+    return result.error().result();
+  }
+  *recorder_handle_out = result.value().release()->GetHandle();
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsEncodedFrameRecorderAddRef(
+    mrsEncodedFrameRecorderHandle handle) noexcept {
+  if (auto recorder = FromHandle<EncodedFrameRecorder>(handle)) {
+    recorder->AddRef();
+  } else {
+    RTC_LOG(LS_WARNING)
+        << "Trying to add reference to NULL EncodedFrameRecorder object.";
+  }
+}
+
+void MRS_CALL mrsEncodedFrameRecorderRemoveRef(
+    mrsEncodedFrameRecorderHandle handle) noexcept {
+  if (auto recorder = FromHandle<EncodedFrameRecorder>(handle)) {
+    recorder->RemoveRef();
+  } else {
+    RTC_LOG(LS_WARNING) << "Trying to remove reference from NULL "
+                           "EncodedFrameRecorder object.";
+  }
+}
+
+mrsResult MRS_CALL
+mrsEncodedFrameRecorderStop(mrsEncodedFrameRecorderHandle handle) noexcept {
+  auto recorder = FromHandle<EncodedFrameRecorder>(handle);
+  if (!recorder) {
+    return Result::kInvalidNativeHandle;
+  }
+  recorder->Stop();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsEncodedFrameRecorderGetStats(
+    mrsEncodedFrameRecorderHandle handle,
+    mrsEncodedFrameRecorderStats* stats_out) noexcept {
+  auto recorder = FromHandle<EncodedFrameRecorder>(handle);
+  if (!recorder) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!stats_out) {
+    return Result::kInvalidParameter;
+  }
+  *stats_out = recorder->GetStats();
+  return Result::kSuccess;
+}
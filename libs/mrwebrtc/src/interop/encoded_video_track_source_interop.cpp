@@ -0,0 +1,106 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "encoded_video_track_source_interop.h"
+#include "handle_table.h"
+#include "interop/global_factory.h"
+#include "media/encoded_video_track_source.h"
+#include "media/local_video_track.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+void MRS_CALL mrsEncodedVideoTrackSourceAddRef(
+    mrsEncodedVideoTrackSourceHandle handle) noexcept {
+  if (auto source = FromHandle<EncodedVideoTrackSource>(handle)) {
+    source->AddRef();
+  } else {
+    RTC_LOG(LS_WARNING)
+        << "Trying to add reference to NULL EncodedVideoTrackSource object.";
+  }
+}
+
+void MRS_CALL mrsEncodedVideoTrackSourceRemoveRef(
+    mrsEncodedVideoTrackSourceHandle handle) noexcept {
+  if (auto source = FromHandle<EncodedVideoTrackSource>(handle)) {
+    source->RemoveRef();
+  } else {
+    RTC_LOG(LS_WARNING) << "Trying to remove reference from NULL "
+                           "EncodedVideoTrackSource object.";
+  }
+}
+
+mrsResult MRS_CALL mrsEncodedVideoTrackSourceCreate(
+    const mrsEncodedVideoTrackSourceInitConfig* config,
+    mrsEncodedVideoTrackSourceHandle* source_handle_out) noexcept {
+  if (!config || !source_handle_out) {
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+#if defined(WINUWP)
+  // The video encoder factory is created by the UWP wrapper, and cannot be
+  // wrapped with the passthrough encoder factory.
+  RTC_LOG(LS_ERROR) << "Encoded video track sources are not supported on UWP.";
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  const Result result = EncodedVideoTrackSource::ValidateConfig(*config);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  RefPtr<EncodedVideoTrackSource> source =
+      new EncodedVideoTrackSource(GlobalFactory::InstancePtr(), *config);
+  *source_handle_out = source.release()->GetHandle();
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+mrsResult MRS_CALL mrsEncodedVideoTrackSourceCreateFromTrack(
+    mrsLocalVideoTrackHandle track_handle,
+    const mrsSharedVideoEncoderConfig* config,
+    mrsEncodedVideoTrackSourceHandle* source_handle_out) noexcept {
+  if (!track_handle) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!config || !source_handle_out) {
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+#if defined(WINUWP)
+  RTC_LOG(LS_ERROR) << "Encoded video track sources are not supported on UWP.";
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  RefPtr<LocalVideoTrack> track(FromHandle<LocalVideoTrack>(track_handle));
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  auto result = EncodedVideoTrackSource::CreateFromTrack(
+      GlobalFactory::InstancePtr(), std::move(track), *config);
+  if (!result.ok()) {
+    return result.error().result();
+  }
+  *source_handle_out = result.value().release()->GetHandle();
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+mrsResult MRS_CALL mrsEncodedVideoTrackSourcePushFrame(
+    mrsEncodedVideoTrackSourceHandle source_handle,
+    const mrsEncodedVideoFrame* frame) noexcept {
+  auto source = FromHandle<EncodedVideoTrackSource>(source_handle);
+  if (!source || !frame) {
+    return Result::kInvalidParameter;
+  }
+  return source->PushFrame(*frame);
+}
+
+void MRS_CALL mrsEncodedVideoTrackSourceRegisterKeyFrameRequestedCallback(
+    mrsEncodedVideoTrackSourceHandle source_handle,
+    mrsEncodedVideoTrackSourceKeyFrameRequestedCallback callback,
+    void* user_data) noexcept {
+  if (auto source = FromHandle<EncodedVideoTrackSource>(source_handle)) {
+    source->SetKeyFrameRequestedCallback({callback, user_data});
+  }
+}
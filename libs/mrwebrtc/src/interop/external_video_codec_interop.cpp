@@ -0,0 +1,27 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "external_video_codec_interop.h"
+#include "interop/global_factory.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsRegisterExternalVideoEncoder(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoEncoderCallbacks* callbacks) noexcept {
+  return GlobalFactory::RegisterExternalVideoEncoder(
+      codec_name, sdp_format_parameters, callbacks);
+}
+
+mrsResult MRS_CALL mrsRegisterExternalVideoDecoder(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoDecoderCallbacks* callbacks) noexcept {
+  return GlobalFactory::RegisterExternalVideoDecoder(
+      codec_name, sdp_format_parameters, callbacks);
+}
@@ -7,6 +7,7 @@
 
 #include "callback.h"
 #include "external_video_track_source_interop.h"
+#include "handle_table.h"
 #include "interop/global_factory.h"
 #include "media/external_video_track_source.h"
 
@@ -14,7 +15,7 @@ using namespace Microsoft::MixedReality::WebRTC;
 
 void MRS_CALL mrsExternalVideoTrackSourceAddRef(
     mrsExternalVideoTrackSourceHandle handle) noexcept {
-  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+  if (auto track = FromHandle<ExternalVideoTrackSource>(handle)) {
     track->AddRef();
   } else {
     RTC_LOG(LS_WARNING)
@@ -24,7 +25,7 @@ void MRS_CALL mrsExternalVideoTrackSourceAddRef(
 
 void MRS_CALL mrsExternalVideoTrackSourceRemoveRef(
     mrsExternalVideoTrackSourceHandle handle) noexcept {
-  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+  if (auto track = FromHandle<ExternalVideoTrackSource>(handle)) {
     track->RemoveRef();
   } else {
     RTC_LOG(LS_WARNING) << "Trying to remove reference from NULL "
@@ -46,7 +47,7 @@ mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromI420ACallback(
   if (!track_source) {
     return Result::kUnknownError;
   }
-  *source_handle_out = track_source.release();
+  *source_handle_out = track_source.release()->GetHandle();
   return Result::kSuccess;
 }
 
@@ -64,13 +65,31 @@ mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromArgb32Callback(
   if (!track_source) {
     return Result::kUnknownError;
   }
-  *source_handle_out = track_source.release();
+  *source_handle_out = track_source.release()->GetHandle();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCreateFromNv12Callback(
+    mrsRequestExternalNv12VideoFrameCallback callback,
+    void* user_data,
+    mrsExternalVideoTrackSourceHandle* source_handle_out) noexcept {
+  if (!source_handle_out) {
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+  RefPtr<ExternalVideoTrackSource> track_source =
+      detail::ExternalVideoTrackSourceCreateFromNv12(
+          GlobalFactory::InstancePtr(), callback, user_data);
+  if (!track_source) {
+    return Result::kUnknownError;
+  }
+  *source_handle_out = track_source.release()->GetHandle();
   return Result::kSuccess;
 }
 
 void MRS_CALL mrsExternalVideoTrackSourceFinishCreation(
     mrsExternalVideoTrackSourceHandle source_handle) noexcept {
-  if (auto source = static_cast<ExternalVideoTrackSource*>(source_handle)) {
+  if (auto source = FromHandle<ExternalVideoTrackSource>(source_handle)) {
     source->FinishCreation();
   }
 }
@@ -83,7 +102,7 @@ mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteI420AFrameRequest(
   if (!frame_view) {
     return Result::kInvalidParameter;
   }
-  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+  if (auto track = FromHandle<ExternalVideoTrackSource>(handle)) {
     return track->CompleteRequest(request_id, timestamp_ms, *frame_view);
   }
   return mrsResult::kInvalidNativeHandle;
@@ -97,7 +116,21 @@ mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
   if (!frame_view) {
     return Result::kInvalidParameter;
   }
-  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+  if (auto track = FromHandle<ExternalVideoTrackSource>(handle)) {
+    return track->CompleteRequest(request_id, timestamp_ms, *frame_view);
+  }
+  return mrsResult::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteNv12FrameRequest(
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const mrsNv12VideoFrame* frame_view) noexcept {
+  if (!frame_view) {
+    return Result::kInvalidParameter;
+  }
+  if (auto track = FromHandle<ExternalVideoTrackSource>(handle)) {
     return track->CompleteRequest(request_id, timestamp_ms, *frame_view);
   }
   return mrsResult::kInvalidNativeHandle;
@@ -105,7 +138,7 @@ mrsResult MRS_CALL mrsExternalVideoTrackSourceCompleteArgb32FrameRequest(
 
 void MRS_CALL mrsExternalVideoTrackSourceShutdown(
     mrsExternalVideoTrackSourceHandle handle) noexcept {
-  if (auto track = static_cast<ExternalVideoTrackSource*>(handle)) {
+  if (auto track = FromHandle<ExternalVideoTrackSource>(handle)) {
     track->Shutdown();
   }
 }
@@ -133,7 +166,7 @@ struct I420AInteropVideoSource : I420AExternalVideoSource {
 
   Result FrameRequested(I420AVideoFrameRequest& frame_request) override {
     assert(track_source_);
-    return callback_(track_source_, frame_request.request_id_,
+    return callback_(track_source_->GetHandle(), frame_request.request_id_,
                      frame_request.timestamp_ms_);
   }
 };
@@ -159,7 +192,33 @@ struct Argb32InteropVideoSource : Argb32ExternalVideoSource {
 
   Result FrameRequested(Argb32VideoFrameRequest& frame_request) override {
     assert(track_source_);
-    return callback_(track_source_, frame_request.request_id_,
+    return callback_(track_source_->GetHandle(), frame_request.request_id_,
+                     frame_request.timestamp_ms_);
+  }
+};
+
+/// Adapter for a an interop-based NV12 custom video source.
+struct Nv12InteropVideoSource : Nv12ExternalVideoSource {
+  using callback_type = RetCallback<mrsResult,
+                                    mrsExternalVideoTrackSourceHandle,
+                                    uint32_t,
+                                    int64_t>;
+
+  /// Interop callback to generate frames.
+  callback_type callback_;
+
+  /// External video track source to deliver the frames to.
+  /// Note that this is a "weak" pointer to avoid a circular reference to the
+  /// video track source owning it.
+  ExternalVideoTrackSource* track_source_{};
+
+  Nv12InteropVideoSource(mrsRequestExternalNv12VideoFrameCallback callback,
+                         void* user_data)
+      : callback_({callback, user_data}) {}
+
+  Result FrameRequested(Nv12VideoFrameRequest& frame_request) override {
+    assert(track_source_);
+    return callback_(track_source_->GetHandle(), frame_request.request_id_,
                      frame_request.timestamp_ms_);
   }
 };
@@ -209,6 +268,25 @@ RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateFromArgb32(
   return track_source;
 }
 
+RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateFromNv12(
+    RefPtr<GlobalFactory> global_factory,
+    mrsRequestExternalNv12VideoFrameCallback callback,
+    void* user_data) {
+  RefPtr<Nv12InteropVideoSource> custom_source =
+      new Nv12InteropVideoSource(callback, user_data);
+  if (!custom_source) {
+    return {};
+  }
+  RefPtr<ExternalVideoTrackSource> track_source =
+      ExternalVideoTrackSource::createFromNv12(std::move(global_factory),
+                                               custom_source);
+  if (!track_source) {
+    return {};
+  }
+  custom_source->track_source_ = track_source.get();
+  return track_source;
+}
+
 }  // namespace detail
 }  // namespace WebRTC
 }  // namespace MixedReality
@@ -7,11 +7,19 @@
 
 #include "interop/global_factory.h"
 #include "media/local_video_track.h"
+#include "media/passthrough_video_encoder_factory.h"
+#include "media/pausable_video_decoder_factory.h"
 #include "peer_connection.h"
 #include "rtc_base/refcountedobject.h"
+#include "rtc_base/stringutils.h"
+#include "tracing.h"
 #include "utils.h"
 
+#include <algorithm>
+#include <condition_variable>
 #include <exception>
+#include <system_error>
+#include <thread>
 
 namespace {
 
@@ -30,6 +38,8 @@ absl::string_view ObjectTypeToString(ObjectType type) {
       return "LocalVideoTrack";
     case ObjectType::kExternalVideoTrackSource:
       return "ExternalVideoTrackSource";
+    case ObjectType::kEncodedVideoTrackSource:
+      return "EncodedVideoTrackSource";
     case ObjectType::kRemoteAudioTrack:
       return "RemoteAudioTrack";
     case ObjectType::kRemoteVideoTrack:
@@ -40,6 +50,8 @@ absl::string_view ObjectTypeToString(ObjectType type) {
       return "AudioTransceiver";
     case ObjectType::kVideoTransceiver:
       return "VideoTransceiver";
+    case ObjectType::kEncodedFrameRecorder:
+      return "EncodedFrameRecorder";
     default:
       RTC_NOTREACHED();
       return "<UnknownObjectType>";
@@ -65,6 +77,41 @@ std::string ObjectToString(TrackedObject* obj) {
   return builder.str();
 }
 
+/// State of a bulk close, shared between the caller of
+/// |GlobalFactory::CloseAllPeerConnections()| and the threads closing the
+/// peer connections, which can outlive the call if it times out.
+struct BulkCloseState {
+  std::vector<RefPtr<PeerConnection>> peers_;
+  bool invoke_callbacks_{true};
+
+  /// Index of the next peer connection to close.
+  std::atomic<size_t> next_index_{0};
+
+  std::mutex mutex_;
+  std::condition_variable closed_cv_;
+  size_t closed_count_ RTC_GUARDED_BY(mutex_){0};
+};
+
+/// Close the peer connections of a bulk close until none is left.
+void RunBulkClose(std::shared_ptr<BulkCloseState> state) noexcept {
+  for (;;) {
+    const size_t index =
+        state->next_index_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= state->peers_.size()) {
+      return;
+    }
+    // Release the peer connection as soon as it is closed, which destroys it
+    // if the application already released it.
+    state->peers_[index]->Close(state->invoke_callbacks_);
+    state->peers_[index] = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex_);
+      ++state->closed_count_;
+    }
+    state->closed_cv_.notify_all();
+  }
+}
+
 }  // namespace
 
 namespace Microsoft {
@@ -81,6 +128,14 @@ uint32_t GlobalFactory::StaticReportLiveObjects() noexcept {
   return 0;
 }
 
+uint32_t GlobalFactory::StaticGetLiveObjectCount(ObjectType type) noexcept {
+  RefPtr<GlobalFactory> factory(InstancePtrIfExist());
+  if (factory) {
+    return factory->GetLiveObjectCount(type);
+  }
+  return 0;
+}
+
 mrsShutdownOptions GlobalFactory::GetShutdownOptions() noexcept {
   GlobalFactory* const factory = GetInstance();
   std::lock_guard<std::recursive_mutex> lock(factory->mutex_);
@@ -96,8 +151,180 @@ void GlobalFactory::SetShutdownOptions(mrsShutdownOptions options) noexcept {
   factory->shutdown_options_ = options;
 }
 
+Result GlobalFactory::SetAudioDeviceModuleConfig(
+    const mrsAudioDeviceModuleConfig& config) noexcept {
+  switch (config.kind) {
+    case mrsAudioDeviceModuleKind::kPlatform:
+      break;
+    case mrsAudioDeviceModuleKind::kVirtual: {
+#if defined(WINUWP)
+      RTC_LOG(LS_ERROR) << "The virtual audio device module is not supported "
+                           "on UWP.";
+      return Result::kUnsupported;
+#else   // defined(WINUWP)
+      const Result result = VirtualAudioDeviceModule::ValidateConfig(config);
+      if (result != Result::kSuccess) {
+        return result;
+      }
+#endif  // defined(WINUWP)
+    } break;
+    default:
+      RTC_LOG(LS_ERROR) << "Unknown audio device module kind "
+                        << (int)config.kind << ".";
+      return Result::kInvalidParameter;
+  }
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot change the audio device module while the "
+                         "library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  factory->audio_device_config_ = config;
+  return Result::kSuccess;
+}
+
+Result GlobalFactory::RegisterExternalVideoEncoder(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoEncoderCallbacks* callbacks) noexcept {
+#if defined(WINUWP)
+  RTC_LOG(LS_ERROR) << "External video codecs are not supported on UWP.";
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  if (IsStringNullOrEmpty(codec_name)) {
+    return Result::kInvalidParameter;
+  }
+  ExternalVideoEncoderRegistration reg;
+  if (callbacks) {
+    auto result = CreateExternalVideoEncoderRegistration(
+        codec_name, sdp_format_parameters, *callbacks);
+    if (!result.ok()) {
+      return result.error().result();
+    }
+    reg = std::move(result.value());
+  }
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot register an external video encoder while the "
+                         "library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  auto& encoders = factory->external_video_encoders_;
+  encoders.erase(std::remove_if(encoders.begin(), encoders.end(),
+                                [codec_name](const auto& other) {
+                                  return (_stricmp(other.codec_name.c_str(),
+                                                   codec_name) == 0);
+                                }),
+                 encoders.end());
+  if (callbacks) {
+    encoders.push_back(std::move(reg));
+  }
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+Result GlobalFactory::RegisterExternalVideoDecoder(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoDecoderCallbacks* callbacks) noexcept {
+#if defined(WINUWP)
+  RTC_LOG(LS_ERROR) << "External video codecs are not supported on UWP.";
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  if (IsStringNullOrEmpty(codec_name)) {
+    return Result::kInvalidParameter;
+  }
+  ExternalVideoDecoderRegistration reg;
+  if (callbacks) {
+    auto result = CreateExternalVideoDecoderRegistration(
+        codec_name, sdp_format_parameters, *callbacks);
+    if (!result.ok()) {
+      return result.error().result();
+    }
+    reg = std::move(result.value());
+  }
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot register an external video decoder while the "
+                         "library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  auto& decoders = factory->external_video_decoders_;
+  decoders.erase(std::remove_if(decoders.begin(), decoders.end(),
+                                [codec_name](const auto& other) {
+                                  return (_stricmp(other.codec_name.c_str(),
+                                                   codec_name) == 0);
+                                }),
+                 decoders.end());
+  if (callbacks) {
+    decoders.push_back(std::move(reg));
+  }
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+Result GlobalFactory::SetVideoEncoderThreadingConfig(
+    const char* codec_name,
+    const mrsVideoEncoderThreadingConfig* config) noexcept {
+#if defined(WINUWP)
+  RTC_LOG(LS_ERROR) << "Video encoder threading configuration is not "
+                       "supported on UWP.";
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  if (config && ((config->complexity < mrsVideoEncoderComplexity::kNormal) ||
+                 (config->complexity > mrsVideoEncoderComplexity::kMax))) {
+    RTC_LOG(LS_ERROR) << "Invalid video encoder complexity "
+                      << (int)config->complexity << ".";
+    return Result::kInvalidParameter;
+  }
+  const std::string name(codec_name ? codec_name : "");
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot change the video encoder threading "
+                         "configuration while the library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  auto& overrides = factory->video_encoder_threading_;
+  overrides.erase(std::remove_if(overrides.begin(), overrides.end(),
+                                 [&name](const auto& other) {
+                                   return (_stricmp(other.codec_name.c_str(),
+                                                    name.c_str()) == 0);
+                                 }),
+                  overrides.end());
+  if (config) {
+    overrides.push_back(VideoEncoderThreadingOverride{name, *config});
+  }
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
+Result GlobalFactory::SetVideoEncoderThreadPoolSize(
+    uint32_t thread_count) noexcept {
+#if defined(WINUWP)
+  RTC_LOG(LS_ERROR) << "Video encoder thread pool is not supported on UWP.";
+  return Result::kUnsupported;
+#else   // defined(WINUWP)
+  GlobalFactory* const factory = GetInstance();
+  std::lock_guard<std::mutex> lock(factory->init_mutex_);
+  if (factory->peer_factory_) {
+    RTC_LOG(LS_ERROR) << "Cannot change the video encoder thread pool while "
+                         "the library is initialized.";
+    return Result::kInvalidOperation;
+  }
+  factory->video_encoder_thread_pool_size_ = thread_count;
+  return Result::kSuccess;
+#endif  // defined(WINUWP)
+}
+
 void GlobalFactory::ForceShutdown() noexcept {
   GlobalFactory* const factory = GetInstance();
+  // Peer connections still closing would otherwise have their WebRTC threads
+  // torn down in the middle of |PeerConnection::Close()|.
+  factory->JoinBulkCloseThreads();
   std::lock_guard<std::mutex> lock(factory->init_mutex_);
   if (!factory->peer_factory_) {
     return;
@@ -161,6 +388,14 @@ RefPtr<GlobalFactory> GlobalFactory::GetInstancePtrImpl(
 }
 
 GlobalFactory::~GlobalFactory() {
+  {
+    // Do not join threads from the static destructor, which runs while the
+    // module is unloaded and can deadlock on the loader lock.
+    std::lock_guard<std::mutex> lock(bulk_close_mutex_);
+    for (auto&& thread : bulk_close_threads_) {
+      thread.detach();
+    }
+  }
   std::lock_guard<std::mutex> lock(init_mutex_);
   ShutdownImplNoLock(ShutdownAction::kFromObjectDestructor);
 }
@@ -182,31 +417,129 @@ rtc::Thread* GlobalFactory::GetWorkerThread() const noexcept {
 #endif  // defined(WINUWP)
 }
 
-void GlobalFactory::AddObject(TrackedObject* obj) noexcept {
-  try {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    RTC_DCHECK(std::find(alive_objects_.begin(), alive_objects_.end(), obj) ==
-               alive_objects_.end());
-    alive_objects_.push_back(obj);
-  } catch (...) {
+rtc::Thread* GlobalFactory::GetSignalingThread() const noexcept {
+  // This only requires init_mutex_ read lock, which must be acquired to access
+  // the singleton instance.
+#if defined(WINUWP)
+  return impl_->signalingThread.get();
+#else   // defined(WINUWP)
+  return signaling_thread_.get();
+#endif  // defined(WINUWP)
+}
+
+std::unique_ptr<webrtc::VideoEncoder> GlobalFactory::CreateVideoEncoder(
+    const webrtc::SdpVideoFormat& format) {
+  // Unlike the threads, the factory is not kept alive by the reference the
+  // caller holds on the factory, since it can be reset by a forced shutdown.
+  // The encoder factory does not call back into the global factory, so this
+  // cannot deadlock.
+  std::lock_guard<std::mutex> lock(init_mutex_);
+  if (!video_encoder_factory_) {
+    return nullptr;
   }
+  return video_encoder_factory_->CreateVideoEncoder(format);
+}
+
+void GlobalFactory::AddObject(TrackedObject* obj) noexcept {
+  alive_objects_.Add(obj);
 }
 
 void GlobalFactory::RemoveObject(TrackedObject* obj) noexcept {
+  alive_objects_.Remove(obj);
+}
+
+uint32_t GlobalFactory::ReportLiveObjects() {
+  return ReportLiveObjectsNoLock();
+}
+
+uint32_t GlobalFactory::CloseAllPeerConnections(
+    const mrsCloseAllConfig& config) noexcept {
   try {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    auto it = std::find(alive_objects_.begin(), alive_objects_.end(), obj);
-    if (it != alive_objects_.end()) {
-      alive_objects_.erase(it);
+    auto state = std::make_shared<BulkCloseState>();
+    state->invoke_callbacks_ = (config.suppress_callbacks != mrsBool::kTrue);
+
+    // Collect the peer connections under the registry locks, but only those
+    // whose reference count did not reach zero already, since the others are
+    // being destroyed. They are released outside of the locks, as destroying
+    // them unregisters them from the registry.
+    state->peers_.reserve(
+        alive_objects_.GetCount(ObjectType::kPeerConnection));
+    alive_objects_.ForEach([&state](TrackedObject* obj) {
+      if ((obj->GetObjectType() == ObjectType::kPeerConnection) &&
+          obj->TryAddRef()) {
+        state->peers_.emplace_back(static_cast<PeerConnection*>(obj),
+                                   DontAddRef{});
+      }
+    });
+    const size_t peer_count = state->peers_.size();
+    if (peer_count == 0) {
+      return 0;
+    }
+    MRS_TRACE_SCOPE_ARG("GlobalFactory::CloseAllPeerConnections", "count",
+                        peer_count);
+
+    // Closing a peer connection synchronously hops to the signaling and worker
+    // threads several times, so closing several of them concurrently overlaps
+    // those hops, even though each step is serialized on the WebRTC threads.
+    size_t thread_count = config.max_parallelism;
+    if (thread_count == 0) {
+      thread_count = std::max(std::thread::hardware_concurrency(), 1u);
     }
+    thread_count = std::min(thread_count, peer_count);
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+      try {
+        threads.emplace_back(&RunBulkClose, state);
+      } catch (const std::system_error& e) {
+        RTC_LOG(LS_WARNING) << "Failed to start a thread to close peer "
+                               "connections: "
+                            << e.what();
+        if (i == 0) {
+          // Close all the peer connections on the calling thread instead.
+          RunBulkClose(state);
+        }
+        break;
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(state->mutex_);
+    auto all_closed = [&state, peer_count]() {
+      return (state->closed_count_ == peer_count);
+    };
+    if (config.timeout_ms == 0) {
+      state->closed_cv_.wait(lock, all_closed);
+    } else {
+      state->closed_cv_.wait_for(
+          lock, std::chrono::milliseconds(config.timeout_ms), all_closed);
+    }
+    const uint32_t pending_count =
+        static_cast<uint32_t>(peer_count - state->closed_count_);
+    lock.unlock();
+    if (pending_count > 0) {
+      RTC_LOG(LS_WARNING) << "Timed out after " << config.timeout_ms
+                          << " ms while closing all peer connections; "
+                          << pending_count << " out of " << peer_count
+                          << " are still closing.";
+      // Keep track of the threads still closing, for |ForceShutdown()| to wait
+      // for them before tearing down the WebRTC threads.
+      std::lock_guard<std::mutex> threads_lock(bulk_close_mutex_);
+      for (auto&& thread : threads) {
+        bulk_close_threads_.push_back(std::move(thread));
+      }
+    } else {
+      // All the peer connections are closed, so the threads are exiting.
+      for (auto&& thread : threads) {
+        thread.join();
+      }
+    }
+    return pending_count;
+  } catch (const std::exception& e) {
+    RTC_LOG(LS_ERROR) << "Failed to close all peer connections: " << e.what();
   } catch (...) {
+    RTC_LOG(LS_ERROR) << "Failed to close all peer connections.";
   }
-}
-
-uint32_t GlobalFactory::ReportLiveObjects() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  ReportLiveObjectsNoLock();
-  return static_cast<uint32_t>(alive_objects_.size());
+  return 0;
 }
 
 #if defined(WINUWP)
@@ -298,16 +631,41 @@ mrsResult GlobalFactory::InitializeImplNoLock() {
                              signaling_thread_.get());
   signaling_thread_->Start();
 
+  // Let WebRTC create the platform audio device module unless the virtual
+  // one is selected.
+  if (audio_device_config_.kind == mrsAudioDeviceModuleKind::kVirtual) {
+    virtual_audio_device_ =
+        VirtualAudioDeviceModule::Create(audio_device_config_);
+  }
+
+  rtc::scoped_refptr<VideoEncoderThreadPool> video_encoder_thread_pool =
+      VideoEncoderThreadPool::Create(video_encoder_thread_pool_size_);
+  video_encoder_factory_ = absl::make_unique<ThreadPoolVideoEncoderFactory>(
+      video_encoder_threading_, video_encoder_thread_pool,
+      absl::make_unique<ExternalVideoEncoderFactory>(
+          external_video_encoders_,
+          absl::make_unique<webrtc::InternalEncoderFactory>()));
+
   peer_factory_ = webrtc::CreatePeerConnectionFactory(
       network_thread_.get(), worker_thread_.get(), signaling_thread_.get(),
-      nullptr, webrtc::CreateBuiltinAudioEncoderFactory(),
+      virtual_audio_device_, webrtc::CreateBuiltinAudioEncoderFactory(),
       webrtc::CreateBuiltinAudioDecoderFactory(),
       std::unique_ptr<webrtc::VideoEncoderFactory>(
-          new webrtc::MultiplexEncoderFactory(
-              absl::make_unique<webrtc::InternalEncoderFactory>())),
+          new PassthroughVideoEncoderFactory(
+              absl::make_unique<webrtc::MultiplexEncoderFactory>(
+                  absl::make_unique<ThreadPoolVideoEncoderFactory>(
+                      video_encoder_threading_, video_encoder_thread_pool,
+                      absl::make_unique<ExternalVideoEncoderFactory>(
+                          external_video_encoders_,
+                          absl::make_unique<
+                              webrtc::InternalEncoderFactory>()))))),
       std::unique_ptr<webrtc::VideoDecoderFactory>(
-          new webrtc::MultiplexDecoderFactory(
-              absl::make_unique<webrtc::InternalDecoderFactory>())),
+          new PausableVideoDecoderFactory(
+              absl::make_unique<webrtc::MultiplexDecoderFactory>(
+                  absl::make_unique<ExternalVideoDecoderFactory>(
+                      external_video_decoders_,
+                      absl::make_unique<
+                          webrtc::InternalDecoderFactory>())))),
       custom_audio_mixer_, nullptr);
 #endif  // defined(WINUWP)
   return (peer_factory_.get() != nullptr ? Result::kSuccess
@@ -349,7 +707,7 @@ bool GlobalFactory::ShutdownImplNoLock(ShutdownAction shutdown_action) {
 
     // Clear debug infos and references. This leaks objects, but at least won't
     // interact with future uses.
-    alive_objects_.clear();
+    alive_objects_.Clear();
     ref_count_.store(0, std::memory_order_release);  // see "load acquire" above
   }
 
@@ -358,6 +716,8 @@ bool GlobalFactory::ShutdownImplNoLock(ShutdownAction shutdown_action) {
 #if defined(WINUWP)
   impl_ = nullptr;
 #else   // defined(WINUWP)
+  virtual_audio_device_ = nullptr;
+  video_encoder_factory_.reset();
   network_thread_.reset();
   worker_thread_.reset();
   signaling_thread_.reset();
@@ -365,15 +725,32 @@ bool GlobalFactory::ShutdownImplNoLock(ShutdownAction shutdown_action) {
   return true;
 }
 
-void GlobalFactory::ReportLiveObjectsNoLock() {
-  RTC_LOG(LS_INFO) << "mr-webrtc alive objects report for "
-                   << alive_objects_.size() << " objects:";
+void GlobalFactory::JoinBulkCloseThreads() noexcept {
+  std::vector<std::thread> threads;
+  {
+    std::lock_guard<std::mutex> lock(bulk_close_mutex_);
+    threads.swap(bulk_close_threads_);
+  }
+  for (auto&& thread : threads) {
+    // A peer connection callback invoked while closing may force the shutdown
+    // from a thread of the bulk close itself, which cannot join itself.
+    if (thread.get_id() == std::this_thread::get_id()) {
+      thread.detach();
+    } else {
+      thread.join();
+    }
+  }
+}
+
+uint32_t GlobalFactory::ReportLiveObjectsNoLock() {
+  RTC_LOG(LS_INFO) << "mr-webrtc alive objects report for ~"
+                   << alive_objects_.GetTotalCount() << " objects:";
   int i = 0;
-  for (auto&& obj : alive_objects_) {
+  return alive_objects_.ForEach([&i](TrackedObject* obj) {
     RTC_LOG(LS_INFO) << "[" << i << "] " << ObjectToString(obj) << " [~"
                      << obj->GetApproxRefCount() << " ref(s)]";
     ++i;
-  }
+  });
 }
 
 }  // namespace WebRTC
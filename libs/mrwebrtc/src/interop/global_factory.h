@@ -3,7 +3,14 @@
 
 #pragma once
 
+#include <thread>
+#include <vector>
+
 #include "export.h"
+#include "live_object_registry.h"
+#include "media/external_video_codec_factory.h"
+#include "media/video_encoder_thread_pool.h"
+#include "media/virtual_audio_device_module.h"
 #include "peer_connection.h"
 #include "utils.h"
 
@@ -30,6 +37,11 @@ class GlobalFactory {
   /// returns 0. This is multithread-safe.
   static uint32_t StaticReportLiveObjects() noexcept;
 
+  /// Get the number of live objects of the given type at the time of the call.
+  /// If the library is not initialized, this function returns 0. This is
+  /// multithread-safe.
+  static uint32_t StaticGetLiveObjectCount(ObjectType type) noexcept;
+
   /// Get the library shutdown options. This function does not initialize the
   /// library, but will store the options for a future initializing. Conversely,
   /// if the library is already initialized then the options are set
@@ -42,13 +54,51 @@ class GlobalFactory {
   /// immediately. This is multithread-safe.
   static void SetShutdownOptions(mrsShutdownOptions options) noexcept;
 
+  /// Set the configuration of the audio device module used the next time the
+  /// library initializes. This fails with |Result::kInvalidOperation| if the
+  /// library is already initialized. This is multithread-safe.
+  static Result SetAudioDeviceModuleConfig(
+      const mrsAudioDeviceModuleConfig& config) noexcept;
+
+  /// Register an external video encoder used the next time the library
+  /// initializes, replacing any previous registration for the same codec, or
+  /// remove the registration of the codec if |callbacks| is NULL. This fails
+  /// with |Result::kInvalidOperation| if the library is already initialized.
+  /// This is multithread-safe.
+  static Result RegisterExternalVideoEncoder(
+      const char* codec_name,
+      const char* sdp_format_parameters,
+      const mrsExternalVideoEncoderCallbacks* callbacks) noexcept;
+
+  /// Register an external video decoder, like |RegisterExternalVideoEncoder()|.
+  static Result RegisterExternalVideoDecoder(
+      const char* codec_name,
+      const char* sdp_format_parameters,
+      const mrsExternalVideoDecoderCallbacks* callbacks) noexcept;
+
+  /// Set the threading configuration of the encoders of a video codec, or the
+  /// default one if |codec_name| is NULL, used the next time the library
+  /// initializes. A NULL |config| removes the configuration. This fails with
+  /// |Result::kInvalidOperation| if the library is already initialized.
+  /// This is multithread-safe.
+  static Result SetVideoEncoderThreadingConfig(
+      const char* codec_name,
+      const mrsVideoEncoderThreadingConfig* config) noexcept;
+
+  /// Set the size of the process-wide pool of encoder threads used the next
+  /// time the library initializes, or zero for no limit. This fails with
+  /// |Result::kInvalidOperation| if the library is already initialized.
+  /// This is multithread-safe.
+  static Result SetVideoEncoderThreadPoolSize(uint32_t thread_count) noexcept;
+
   /// Force-shutdown the library if it is initialized, or does nothing
   /// otherwise. This call will terminate the WebRTC threads, therefore will
   /// prevent any dispatched call to a WebRTC object from completing. However,
   /// by shutting down the threads it will allow unloading the current module
   /// (DLL), so is recommended to call manually at the end of the process when
   /// WebRTC objects are not in use anymore but before static deinitializing.
-  /// This is multithread-safe.
+  /// This first waits for the peer connections still closing in the background
+  /// after |CloseAllPeerConnections()| timed out. This is multithread-safe.
   static void ForceShutdown() noexcept;
 
   /// Attempt to shutdown the library if no tracked object is alive anymore.
@@ -110,6 +160,10 @@ class GlobalFactory {
   /// initialized.
   rtc::Thread* GetWorkerThread() const noexcept;
 
+  /// Get the WebRTC signaling thread, or NULL if the library is not
+  /// initialized.
+  rtc::Thread* GetSignalingThread() const noexcept;
+
   /// Add to the global factory collection a tracked object whose lifetime is
   /// monitored (via the library reference count) to know when it is safe to
   /// shutdown the library and terminate the WebRTC threads. This is generally
@@ -127,6 +181,20 @@ class GlobalFactory {
   /// outdated as soon as the call returns if other threads add/remove objects.
   uint32_t ReportLiveObjects();
 
+  /// Get the number of live objects of the given type. This does not lock, and
+  /// the result can be outdated as soon as the call returns.
+  uint32_t GetLiveObjectCount(ObjectType type) const noexcept {
+    return alive_objects_.GetCount(type);
+  }
+
+  /// Close all the peer connections alive concurrently on up to
+  /// |config.max_parallelism| threads, and wait for them to be closed for at
+  /// most |config.timeout_ms|. Return the number of peer connections still
+  /// closing when the call returns, which continue to be closed in the
+  /// background until they are all closed or |ForceShutdown()| is called,
+  /// which waits for them.
+  uint32_t CloseAllPeerConnections(const mrsCloseAllConfig& config) noexcept;
+
 #if defined(WINUWP)
   using WebRtcFactoryPtr =
       std::shared_ptr<wrapper::impl::org::webRtc::WebRtcFactory>;
@@ -138,6 +206,19 @@ class GlobalFactory {
     return custom_audio_mixer_;
   }
 
+  /// Get the virtual audio device module, or NULL if the library does not use
+  /// it.
+  rtc::scoped_refptr<VirtualAudioDeviceModule> virtual_audio_device() const {
+    return virtual_audio_device_;
+  }
+
+  /// Create a video encoder for the given format outside of any peer
+  /// connection, with the same external encoders and threading configuration
+  /// as the encoders of the peer connections. Return NULL if the format is not
+  /// supported or the library is not initialized.
+  std::unique_ptr<webrtc::VideoEncoder> CreateVideoEncoder(
+      const webrtc::SdpVideoFormat& format);
+
  private:
   friend struct std::default_delete<GlobalFactory>;
 
@@ -172,7 +253,13 @@ class GlobalFactory {
   /// down.
   bool ShutdownImplNoLock(ShutdownAction shutdown_action);
 
-  void ReportLiveObjectsNoLock();
+  /// Log all live objects without acquiring |mutex_|, and return their count.
+  uint32_t ReportLiveObjectsNoLock();
+
+  /// Wait for the threads of the bulk closes which timed out to finish closing
+  /// their peer connections. This must be called without |init_mutex_|, since
+  /// those threads can release the last reference to the library.
+  void JoinBulkCloseThreads() noexcept;
 
  private:
   /// Mutex for multithread-safe factory initializing and shutdown.
@@ -223,11 +310,43 @@ class GlobalFactory {
   mrsShutdownOptions shutdown_options_ RTC_GUARDED_BY(mutex_) =
       mrsShutdownOptions::kDefault;
 
-  /// Collection of all tracked objects alive. This is solely used to display a
-  /// debugging report with |ReportLiveObjects()|.
-  std::vector<TrackedObject*> alive_objects_ RTC_GUARDED_BY(mutex_);
+  /// Registry of all tracked objects alive, for the debugging report of
+  /// |ReportLiveObjects()| and the live object counts. This has its own locks
+  /// and does not require |mutex_|.
+  LiveObjectRegistry alive_objects_;
+
+  /// Mutex for |bulk_close_threads_|.
+  std::mutex bulk_close_mutex_;
+
+  /// Threads of the bulk closes which timed out, still closing peer
+  /// connections in the background.
+  std::vector<std::thread> bulk_close_threads_
+      RTC_GUARDED_BY(bulk_close_mutex_);
 
   rtc::scoped_refptr<ToggleAudioMixer> custom_audio_mixer_;
+
+  /// Configuration of the audio device module for the next initializing.
+  mrsAudioDeviceModuleConfig audio_device_config_ RTC_GUARDED_BY(init_mutex_);
+
+  /// Virtual audio device module, if selected by |audio_device_config_| when
+  /// the library was initialized.
+  rtc::scoped_refptr<VirtualAudioDeviceModule> virtual_audio_device_;
+
+  /// External video encoders and decoders for the next initializing.
+  std::vector<ExternalVideoEncoderRegistration> external_video_encoders_
+      RTC_GUARDED_BY(init_mutex_);
+  std::vector<ExternalVideoDecoderRegistration> external_video_decoders_
+      RTC_GUARDED_BY(init_mutex_);
+
+  /// Threading configuration of the video encoders for the next initializing.
+  std::vector<VideoEncoderThreadingOverride> video_encoder_threading_
+      RTC_GUARDED_BY(init_mutex_);
+  uint32_t video_encoder_thread_pool_size_ RTC_GUARDED_BY(init_mutex_){0};
+
+  /// Factory of the encoders created outside of the peer connections, sharing
+  /// the thread pool of the encoders of the peer connection factory.
+  std::unique_ptr<webrtc::VideoEncoderFactory> video_encoder_factory_
+      RTC_GUARDED_BY(init_mutex_);
 };
 
 }  // namespace WebRTC
@@ -10,10 +10,12 @@
 #include "data_channel.h"
 #include "data_channel_interop.h"
 #include "external_video_track_source_interop.h"
+#include "handle_table.h"
 #include "interop/global_factory.h"
 #include "interop_api.h"
 #include "local_audio_track_interop.h"
 #include "local_video_track_interop.h"
+#include "log_sink.h"
 #include "media/external_video_track_source_impl.h"
 #include "media/local_audio_track.h"
 #include "media/local_video_track.h"
@@ -313,6 +315,20 @@ uint32_t MRS_CALL mrsReportLiveObjects() noexcept {
   return GlobalFactory::StaticReportLiveObjects();
 }
 
+uint32_t MRS_CALL mrsGetLiveObjectCount(mrsObjectType type) noexcept {
+  static_assert((int)mrsObjectType::kPeerConnection ==
+                    (int)ObjectType::kPeerConnection,
+                "");
+  static_assert((int)mrsObjectType::kEncodedFrameRecorder ==
+                    (int)ObjectType::kEncodedFrameRecorder,
+                "");
+  if ((type < mrsObjectType::kPeerConnection) ||
+      (type > mrsObjectType::kEncodedFrameRecorder)) {
+    return 0;
+  }
+  return GlobalFactory::StaticGetLiveObjectCount(static_cast<ObjectType>(type));
+}
+
 mrsShutdownOptions MRS_CALL mrsGetShutdownOptions() noexcept {
   return GlobalFactory::GetShutdownOptions();
 }
@@ -323,6 +339,24 @@ void MRS_CALL mrsSetShutdownOptions(mrsShutdownOptions options) noexcept {
 
 void MRS_CALL mrsForceShutdown() noexcept {
   GlobalFactory::ForceShutdown();
+  DestroyAllLogSinks();
+}
+
+mrsResult MRS_CALL
+mrsCloseAllPeerConnections(const mrsCloseAllConfig* config,
+                           uint32_t* pending_count) noexcept {
+  const mrsCloseAllConfig default_config{};
+  uint32_t pending = 0;
+  // Don't initialize the library if not already initialized, since there is
+  // no peer connection to close in that case.
+  if (RefPtr<GlobalFactory> factory = GlobalFactory::InstancePtrIfExist()) {
+    pending = factory->CloseAllPeerConnections(config ? *config
+                                                      : default_config);
+  }
+  if (pending_count) {
+    *pending_count = pending;
+  }
+  return Result::kSuccess;
 }
 
 void MRS_CALL mrsCloseEnum(mrsEnumHandle* handleRef) noexcept {
@@ -570,7 +604,7 @@ mrsPeerConnectionCreate(const mrsPeerConnectionConfiguration* config,
   if (!result.ok()) {
     return result.error().result();
   }
-  *peer_handle_out = (mrsPeerConnectionHandle)result.value().release();
+  *peer_handle_out = result.value().release()->GetHandle();
   return Result::kSuccess;
 }
 
@@ -578,7 +612,7 @@ void MRS_CALL mrsPeerConnectionRegisterConnectedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionConnectedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterConnectedCallback(Callback<>{callback, user_data});
   }
 }
@@ -587,7 +621,7 @@ void MRS_CALL mrsPeerConnectionRegisterLocalSdpReadytoSendCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionLocalSdpReadytoSendCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterLocalSdpReadytoSendCallback(
         Callback<mrsSdpMessageType, const char*>{callback, user_data});
   }
@@ -597,7 +631,7 @@ void MRS_CALL mrsPeerConnectionRegisterIceCandidateReadytoSendCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionIceCandidateReadytoSendCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterIceCandidateReadytoSendCallback(
         Callback<const mrsIceCandidate*>{callback, user_data});
   }
@@ -607,7 +641,7 @@ void MRS_CALL mrsPeerConnectionRegisterIceStateChangedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionIceStateChangedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterIceStateChangedCallback(
         Callback<mrsIceConnectionState>{callback, user_data});
   }
@@ -617,7 +651,7 @@ void MRS_CALL mrsPeerConnectionRegisterRenegotiationNeededCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionRenegotiationNeededCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterRenegotiationNeededCallback(Callback<>{callback, user_data});
   }
 }
@@ -626,7 +660,7 @@ void MRS_CALL mrsPeerConnectionRegisterAudioTrackAddedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionAudioTrackAddedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterAudioTrackAddedCallback(
         Callback<const mrsRemoteAudioTrackAddedInfo*>{callback, user_data});
   }
@@ -636,7 +670,7 @@ void MRS_CALL mrsPeerConnectionRegisterAudioTrackRemovedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionAudioTrackRemovedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterAudioTrackRemovedCallback(
         Callback<mrsRemoteAudioTrackHandle, mrsTransceiverHandle>{callback,
                                                                   user_data});
@@ -647,7 +681,7 @@ void MRS_CALL mrsPeerConnectionRegisterVideoTrackAddedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionVideoTrackAddedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterVideoTrackAddedCallback(
         Callback<const mrsRemoteVideoTrackAddedInfo*>{callback, user_data});
   }
@@ -657,7 +691,7 @@ void MRS_CALL mrsPeerConnectionRegisterVideoTrackRemovedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionVideoTrackRemovedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterVideoTrackRemovedCallback(
         Callback<mrsRemoteVideoTrackHandle, mrsTransceiverHandle>{callback,
                                                                   user_data});
@@ -668,7 +702,7 @@ void MRS_CALL mrsPeerConnectionRegisterDataChannelAddedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionDataChannelAddedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterDataChannelAddedCallback(
         Callback<const mrsDataChannelAddedInfo*>{callback, user_data});
   }
@@ -678,7 +712,7 @@ void MRS_CALL mrsPeerConnectionRegisterDataChannelRemovedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionDataChannelRemovedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterDataChannelRemovedCallback(
         Callback<mrsDataChannelHandle>{callback, user_data});
   }
@@ -723,7 +757,7 @@ mrsResult MRS_CALL mrsLocalAudioTrackCreateFromDevice(
   // Create the audio track wrapper
   RefPtr<LocalAudioTrack> track =
       new LocalAudioTrack(std::move(global_factory), std::move(audio_track));
-  *track_handle_out = track.release();
+  *track_handle_out = track.release()->GetHandle();
   return Result::kSuccess;
 }
 
@@ -800,7 +834,7 @@ mrsResult MRS_CALL mrsLocalVideoTrackCreateFromDevice(
   // Create the video track wrapper
   RefPtr<LocalVideoTrack> track =
       new LocalVideoTrack(std::move(global_factory), std::move(video_track));
-  *track_handle_out = track.release();
+  *track_handle_out = track.release()->GetHandle();
   return Result::kSuccess;
 }
 
@@ -814,7 +848,7 @@ mrsResult MRS_CALL mrsPeerConnectionAddDataChannel(
     return Result::kInvalidParameter;
   }
   *data_channel_handle_out = nullptr;
-  auto peer = static_cast<PeerConnection*>(peer_handle);
+  auto peer = FromHandle<PeerConnection>(peer_handle);
   if (!peer) {
     return Result::kInvalidNativeHandle;
   }
@@ -824,7 +858,7 @@ mrsResult MRS_CALL mrsPeerConnectionAddDataChannel(
   ErrorOr<std::shared_ptr<DataChannel>> data_channel =
       peer->AddDataChannel(config->id, label, ordered, reliable);
   if (data_channel.ok()) {
-    *data_channel_handle_out = data_channel.value().operator->();
+    *data_channel_handle_out = data_channel.value()->GetHandle();
   }
   return data_channel.error().result();
 }
@@ -832,11 +866,11 @@ mrsResult MRS_CALL mrsPeerConnectionAddDataChannel(
 mrsResult MRS_CALL mrsPeerConnectionRemoveDataChannel(
     mrsPeerConnectionHandle peer_handle,
     mrsDataChannelHandle data_channel_handle) noexcept {
-  auto peer = static_cast<PeerConnection*>(peer_handle);
+  auto peer = FromHandle<PeerConnection>(peer_handle);
   if (!peer) {
     return Result::kInvalidNativeHandle;
   }
-  auto data_channel = static_cast<DataChannel*>(data_channel_handle);
+  auto data_channel = FromHandle<DataChannel>(data_channel_handle);
   if (!data_channel) {
     return Result::kInvalidNativeHandle;
   }
@@ -852,7 +886,7 @@ mrsPeerConnectionAddIceCandidate(mrsPeerConnectionHandle peer_handle,
       (candidate->sdp_mline_index < 0)) {
     return mrsResult::kInvalidParameter;
   }
-  auto const peer = static_cast<PeerConnection*>(peer_handle);
+  auto const peer = FromHandle<PeerConnection>(peer_handle);
   if (!peer) {
     return Result::kInvalidNativeHandle;
   }
@@ -865,7 +899,7 @@ mrsPeerConnectionAddIceCandidate(mrsPeerConnectionHandle peer_handle,
 
 mrsResult MRS_CALL
 mrsPeerConnectionCreateOffer(mrsPeerConnectionHandle peer_handle) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     return (peer->CreateOffer() ? Result::kSuccess : Result::kUnknownError);
   }
   return Result::kInvalidNativeHandle;
@@ -873,7 +907,7 @@ mrsPeerConnectionCreateOffer(mrsPeerConnectionHandle peer_handle) noexcept {
 
 mrsResult MRS_CALL
 mrsPeerConnectionCreateAnswer(mrsPeerConnectionHandle peer_handle) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     return (peer->CreateAnswer() ? Result::kSuccess : Result::kUnknownError);
   }
   return Result::kInvalidNativeHandle;
@@ -884,7 +918,7 @@ mrsPeerConnectionSetBitrate(mrsPeerConnectionHandle peer_handle,
                             int min_bitrate_bps,
                             int start_bitrate_bps,
                             int max_bitrate_bps) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     BitrateSettings settings{};
     if (min_bitrate_bps >= 0) {
       settings.min_bitrate_bps = min_bitrate_bps;
@@ -909,7 +943,7 @@ mrsResult MRS_CALL mrsPeerConnectionSetRemoteDescriptionAsync(
   if (IsStringNullOrEmpty(sdp)) {
     return mrsResult::kInvalidParameter;
   }
-  auto peer = static_cast<PeerConnection*>(peer_handle);
+  auto peer = FromHandle<PeerConnection>(peer_handle);
   if (!peer) {
     return Result::kInvalidNativeHandle;
   }
@@ -924,7 +958,7 @@ mrsResult MRS_CALL mrsPeerConnectionSetRemoteDescriptionAsync(
 
 mrsResult MRS_CALL
 mrsPeerConnectionClose(mrsPeerConnectionHandle peer_handle) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->Close();
     return Result::kSuccess;
   }
@@ -1028,7 +1062,7 @@ mrsResult MRS_CALL mrsPeerConnectionGetSimpleStats(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionGetSimpleStatsCallback callback,
     void* user_data) {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     struct Collector : webrtc::RTCStatsCollectorCallback {
       Collector(mrsPeerConnectionGetSimpleStatsCallback callback,
                 void* user_data)
@@ -1073,6 +1107,84 @@ T GetValueIfDefined(const webrtc::RTCStatsMember<T>& member) {
   return member.is_defined() ? *member : 0;
 }
 
+void GetTrackValues(mrsAudioSenderStats& lhs,
+                    const webrtc::RTCMediaStreamTrackStats& rhs) {
+  lhs.track_stats_timestamp_us = rhs.timestamp_us();
+  lhs.track_identifier = rhs.track_identifier->c_str();
+  lhs.audio_level = GetValueIfDefined(rhs.audio_level);
+  lhs.total_audio_energy = *rhs.total_audio_energy;
+  lhs.total_samples_duration = *rhs.total_samples_duration;
+}
+
+void GetTrackValues(mrsAudioReceiverStats& lhs,
+                    const webrtc::RTCMediaStreamTrackStats& rhs) {
+  lhs.track_stats_timestamp_us = rhs.timestamp_us();
+  lhs.track_identifier = rhs.track_identifier->c_str();
+  // This seems to be undefined in some not well specified cases.
+  lhs.audio_level = GetValueIfDefined(rhs.audio_level);
+  lhs.total_audio_energy = *rhs.total_audio_energy;
+  lhs.total_samples_received = GetValueIfDefined(rhs.total_samples_received);
+  lhs.total_samples_duration = *rhs.total_samples_duration;
+}
+
+void GetTrackValues(mrsVideoSenderStats& lhs,
+                    const webrtc::RTCMediaStreamTrackStats& rhs) {
+  lhs.track_stats_timestamp_us = rhs.timestamp_us();
+  lhs.track_identifier = rhs.track_identifier->c_str();
+  lhs.frames_sent = GetValueIfDefined(rhs.frames_sent);
+  lhs.huge_frames_sent = GetValueIfDefined(rhs.huge_frames_sent);
+}
+
+void GetTrackValues(mrsVideoReceiverStats& lhs,
+                    const webrtc::RTCMediaStreamTrackStats& rhs) {
+  lhs.track_stats_timestamp_us = rhs.timestamp_us();
+  lhs.track_identifier = rhs.track_identifier->c_str();
+  lhs.frames_received = GetValueIfDefined(rhs.frames_received);
+  lhs.frames_dropped = GetValueIfDefined(rhs.frames_dropped);
+}
+
+mrsDataChannelStats GetDataChannelValues(
+    const webrtc::RTCDataChannelStats& dc_stats) {
+  return {dc_stats.timestamp_us(),     *dc_stats.datachannelid,
+          *dc_stats.messages_sent,     *dc_stats.bytes_sent,
+          *dc_stats.messages_received, *dc_stats.bytes_received};
+}
+
+mrsTransportStats GetTransportValues(
+    const webrtc::RTCTransportStats& tr_stats) {
+  return {tr_stats.timestamp_us(), *tr_stats.bytes_sent,
+          *tr_stats.bytes_received};
+}
+
+/// Get the track stats associated with an RTP stream, or |nullptr| if the RTP
+/// stream has no track. This uses the report's own index by stats ID instead
+/// of a linear search.
+const webrtc::RTCMediaStreamTrackStats* GetRtpStreamTrackStats(
+    const webrtc::RTCStatsReport& report,
+    const webrtc::RTCRTPStreamStats& rtp_stats) {
+  if (!rtp_stats.track_id.is_defined()) {
+    return nullptr;
+  }
+  const webrtc::RTCStats* const stats = report.Get(*rtp_stats.track_id);
+  if (!stats || (stats->type() != webrtc::RTCMediaStreamTrackStats::kType)) {
+    return nullptr;
+  }
+  return &stats->cast_to<webrtc::RTCMediaStreamTrackStats>();
+}
+
+/// Return the next free slot of a snapshot array, or |nullptr| if the array is
+/// full. The count is incremented in all cases, to report to the caller the
+/// total number of objects found.
+template <class T>
+T* NextSnapshotSlot(T* array, uint32_t capacity, uint32_t& count) {
+  const uint32_t index = count++;
+  if (index < capacity) {
+    array[index] = T{};
+    return &array[index];
+  }
+  return nullptr;
+}
+
 }  // namespace
 
 mrsResult MRS_CALL
@@ -1088,11 +1200,8 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
   if (!strcmp(stats_type, "DataChannelStats")) {
     for (auto&& stats : *report) {
       if (!strcmp(stats.type(), "data-channel")) {
-        const auto& dc_stats = stats.cast_to<webrtc::RTCDataChannelStats>();
-        mrsDataChannelStats simple_stats{
-            dc_stats.timestamp_us(),     *dc_stats.datachannelid,
-            *dc_stats.messages_sent,     *dc_stats.bytes_sent,
-            *dc_stats.messages_received, *dc_stats.bytes_received};
+        mrsDataChannelStats simple_stats = GetDataChannelValues(
+            stats.cast_to<webrtc::RTCDataChannelStats>());
         (*callback)(user_data, &simple_stats);
       }
     }
@@ -1116,12 +1225,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
         if (*track_stats.kind == "audio") {
           if (!(*track_stats.remote_source)) {
             auto& dest_stats = FindOrInsert(pending_stats, track_stats.id());
-            dest_stats.track_stats_timestamp_us = track_stats.timestamp_us();
-            dest_stats.track_identifier = track_stats.track_identifier->c_str();
-            dest_stats.audio_level = GetValueIfDefined(track_stats.audio_level);
-            dest_stats.total_audio_energy = *track_stats.total_audio_energy;
-            dest_stats.total_samples_duration =
-                *track_stats.total_samples_duration;
+            GetTrackValues(dest_stats, track_stats);
           }
         }
       }
@@ -1147,15 +1251,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
         if (*track_stats.kind == "audio") {
           if (*track_stats.remote_source) {
             auto& dest_stats = FindOrInsert(pending_stats, track_stats.id());
-            dest_stats.track_stats_timestamp_us = track_stats.timestamp_us();
-            dest_stats.track_identifier = track_stats.track_identifier->c_str();
-            // This seems to be undefined in some not well specified cases.
-            dest_stats.audio_level = GetValueIfDefined(track_stats.audio_level);
-            dest_stats.total_audio_energy = *track_stats.total_audio_energy;
-            dest_stats.total_samples_received =
-                GetValueIfDefined(track_stats.total_samples_received);
-            dest_stats.total_samples_duration =
-                *track_stats.total_samples_duration;
+            GetTrackValues(dest_stats, track_stats);
           }
         }
       }
@@ -1184,11 +1280,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
         if (*track_stats.kind == "video") {
           if (!(*track_stats.remote_source)) {
             auto& dest_stats = FindOrInsert(pending_stats, track_stats.id());
-            dest_stats.track_stats_timestamp_us = track_stats.timestamp_us();
-            dest_stats.track_identifier = track_stats.track_identifier->c_str();
-            dest_stats.frames_sent = GetValueIfDefined(track_stats.frames_sent);
-            dest_stats.huge_frames_sent =
-                GetValueIfDefined(track_stats.huge_frames_sent);
+            GetTrackValues(dest_stats, track_stats);
           }
         }
       }
@@ -1215,12 +1307,7 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
         if (*track_stats.kind == "video") {
           if (*track_stats.remote_source) {
             auto& dest_stats = FindOrInsert(pending_stats, track_stats.id());
-            dest_stats.track_stats_timestamp_us = track_stats.timestamp_us();
-            dest_stats.track_identifier = track_stats.track_identifier->c_str();
-            dest_stats.frames_received =
-                GetValueIfDefined(track_stats.frames_received);
-            dest_stats.frames_dropped =
-                GetValueIfDefined(track_stats.frames_dropped);
+            GetTrackValues(dest_stats, track_stats);
           }
         }
       }
@@ -1231,10 +1318,8 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
   } else if (!strcmp(stats_type, "TransportStats")) {
     for (auto&& stats : *report) {
       if (!strcmp(stats.type(), "transport")) {
-        const auto& dc_stats = stats.cast_to<webrtc::RTCTransportStats>();
-        mrsTransportStats simple_stats{dc_stats.timestamp_us(),
-                                       *dc_stats.bytes_sent,
-                                       *dc_stats.bytes_received};
+        mrsTransportStats simple_stats =
+            GetTransportValues(stats.cast_to<webrtc::RTCTransportStats>());
         (*callback)(user_data, &simple_stats);
       }
     }
@@ -1242,6 +1327,97 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
   return Result::kSuccess;
 }
 
+mrsResult MRS_CALL
+mrsStatsReportGetSnapshot(mrsStatsReportHandle report_handle,
+                          mrsStatsSnapshot* snapshot) noexcept {
+  if (!report_handle) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!snapshot) {
+    return Result::kInvalidParameter;
+  }
+  auto report = static_cast<const webrtc::RTCStatsReport*>(report_handle);
+  mrsStatsSnapshot& snap = *snapshot;
+  snap.timestamp_us = report->timestamp_us();
+  snap.data_channel_stats_count = 0;
+  snap.audio_sender_stats_count = 0;
+  snap.audio_receiver_stats_count = 0;
+  snap.video_sender_stats_count = 0;
+  snap.video_receiver_stats_count = 0;
+  snap.transport_stats_count = 0;
+
+  // Single pass over the report. The stats type is dispatched by comparing
+  // pointers, since |RTCStats::type()| always returns the static |kType|
+  // string of the most derived stats class.
+  for (auto&& stats : *report) {
+    const char* const type = stats.type();
+    if (type == webrtc::RTCOutboundRTPStreamStats::kType) {
+      const auto& ortp_stats =
+          stats.cast_to<webrtc::RTCOutboundRTPStreamStats>();
+      // Removing a track will leave a "trackless" RTP stream. Ignore it.
+      const webrtc::RTCMediaStreamTrackStats* const track_stats =
+          GetRtpStreamTrackStats(*report, ortp_stats);
+      if (!track_stats) {
+        continue;
+      }
+      if (*ortp_stats.kind == webrtc::RTCMediaStreamTrackKind::kAudio) {
+        if (auto dest = NextSnapshotSlot(snap.audio_sender_stats,
+                                         snap.audio_sender_stats_capacity,
+                                         snap.audio_sender_stats_count)) {
+          GetCommonValues(*dest, ortp_stats);
+          GetTrackValues(*dest, *track_stats);
+        }
+      } else {
+        if (auto dest = NextSnapshotSlot(snap.video_sender_stats,
+                                         snap.video_sender_stats_capacity,
+                                         snap.video_sender_stats_count)) {
+          GetCommonValues(*dest, ortp_stats);
+          dest->frames_encoded = *ortp_stats.frames_encoded;
+          GetTrackValues(*dest, *track_stats);
+        }
+      }
+    } else if (type == webrtc::RTCInboundRTPStreamStats::kType) {
+      const auto& irtp_stats =
+          stats.cast_to<webrtc::RTCInboundRTPStreamStats>();
+      const webrtc::RTCMediaStreamTrackStats* const track_stats =
+          GetRtpStreamTrackStats(*report, irtp_stats);
+      if (!track_stats) {
+        continue;
+      }
+      if (*irtp_stats.kind == webrtc::RTCMediaStreamTrackKind::kAudio) {
+        if (auto dest = NextSnapshotSlot(snap.audio_receiver_stats,
+                                         snap.audio_receiver_stats_capacity,
+                                         snap.audio_receiver_stats_count)) {
+          GetCommonValues(*dest, irtp_stats);
+          GetTrackValues(*dest, *track_stats);
+        }
+      } else {
+        if (auto dest = NextSnapshotSlot(snap.video_receiver_stats,
+                                         snap.video_receiver_stats_capacity,
+                                         snap.video_receiver_stats_count)) {
+          GetCommonValues(*dest, irtp_stats);
+          dest->frames_decoded = *irtp_stats.frames_decoded;
+          GetTrackValues(*dest, *track_stats);
+        }
+      }
+    } else if (type == webrtc::RTCDataChannelStats::kType) {
+      if (auto dest = NextSnapshotSlot(snap.data_channel_stats,
+                                       snap.data_channel_stats_capacity,
+                                       snap.data_channel_stats_count)) {
+        *dest =
+            GetDataChannelValues(stats.cast_to<webrtc::RTCDataChannelStats>());
+      }
+    } else if (type == webrtc::RTCTransportStats::kType) {
+      if (auto dest = NextSnapshotSlot(snap.transport_stats,
+                                       snap.transport_stats_capacity,
+                                       snap.transport_stats_count)) {
+        *dest = GetTransportValues(stats.cast_to<webrtc::RTCTransportStats>());
+      }
+    }
+  }
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL mrsStatsReportRemoveRef(mrsStatsReportHandle stats_report) {
   if (auto rep = static_cast<const webrtc::RTCStatsReport*>(stats_report)) {
     rep->Release();
@@ -5,14 +5,18 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include "handle_table.h"
+#include "interop/global_factory.h"
 #include "local_audio_track_interop.h"
 #include "media/local_audio_track.h"
+#include "media/synthetic_audio_source.h"
+#include "utils.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
 
 void MRS_CALL
 mrsLocalAudioTrackAddRef(mrsLocalAudioTrackHandle handle) noexcept {
-  if (auto track = static_cast<LocalAudioTrack*>(handle)) {
+  if (auto track = FromHandle<LocalAudioTrack>(handle)) {
     track->AddRef();
   } else {
     RTC_LOG(LS_WARNING)
@@ -22,7 +26,7 @@ mrsLocalAudioTrackAddRef(mrsLocalAudioTrackHandle handle) noexcept {
 
 void MRS_CALL
 mrsLocalAudioTrackRemoveRef(mrsLocalAudioTrackHandle handle) noexcept {
-  if (auto track = static_cast<LocalAudioTrack*>(handle)) {
+  if (auto track = FromHandle<LocalAudioTrack>(handle)) {
     track->RemoveRef();
   } else {
     RTC_LOG(LS_WARNING) << "Trying to remove reference from NULL "
@@ -32,11 +36,56 @@ mrsLocalAudioTrackRemoveRef(mrsLocalAudioTrackHandle handle) noexcept {
 
 // mrsLocalAudioTrackCreateFromDevice -> interop_api.cpp
 
+mrsResult MRS_CALL mrsLocalAudioTrackCreateSynthetic(
+    const mrsSyntheticAudioTrackInitConfig* config,
+    const char* track_name,
+    mrsLocalAudioTrackHandle* track_handle_out) noexcept {
+  if (IsStringNullOrEmpty(track_name)) {
+    RTC_LOG(LS_ERROR) << "Invalid empty local audio track name.";
+    return Result::kInvalidParameter;
+  }
+  if (!config) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL synthetic audio configuration.";
+    return Result::kInvalidParameter;
+  }
+  if (!track_handle_out) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL local audio track handle.";
+    return Result::kInvalidParameter;
+  }
+  *track_handle_out = nullptr;
+
+  const Result result = SyntheticAudioSource::ValidateConfig(*config);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+
+  RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
+  auto pc_factory = global_factory->GetPeerConnectionFactory();
+  if (!pc_factory) {
+    return Result::kInvalidOperation;
+  }
+
+  // Create the audio track, which keeps the source alive
+  rtc::scoped_refptr<webrtc::AudioTrackInterface> audio_track =
+      pc_factory->CreateAudioTrack(track_name,
+                                   SyntheticAudioSource::Create(*config));
+  if (!audio_track) {
+    RTC_LOG(LS_ERROR) << "Failed to create local audio track.";
+    return Result::kUnknownError;
+  }
+
+  // Create the audio track wrapper
+  RefPtr<LocalAudioTrack> track =
+      new LocalAudioTrack(std::move(global_factory), std::move(audio_track));
+  *track_handle_out = track.release()->GetHandle();
+  return Result::kSuccess;
+}
+
 void MRS_CALL
 mrsLocalAudioTrackRegisterFrameCallback(mrsLocalAudioTrackHandle trackHandle,
                                         mrsAudioFrameCallback callback,
                                         void* user_data) noexcept {
-  if (auto track = static_cast<LocalAudioTrack*>(trackHandle)) {
+  if (auto track = FromHandle<LocalAudioTrack>(trackHandle)) {
     track->SetCallback(AudioFrameReadyCallback{callback, user_data});
   }
 }
@@ -44,7 +93,7 @@ mrsLocalAudioTrackRegisterFrameCallback(mrsLocalAudioTrackHandle trackHandle,
 mrsResult MRS_CALL
 mrsLocalAudioTrackSetEnabled(mrsLocalAudioTrackHandle track_handle,
                              mrsBool enabled) noexcept {
-  auto track = static_cast<LocalAudioTrack*>(track_handle);
+  auto track = FromHandle<LocalAudioTrack>(track_handle);
   if (!track) {
     return Result::kInvalidParameter;
   }
@@ -54,7 +103,7 @@ mrsLocalAudioTrackSetEnabled(mrsLocalAudioTrackHandle track_handle,
 
 mrsBool MRS_CALL
 mrsLocalAudioTrackIsEnabled(mrsLocalAudioTrackHandle track_handle) noexcept {
-  auto track = static_cast<LocalAudioTrack*>(track_handle);
+  auto track = FromHandle<LocalAudioTrack>(track_handle);
   if (!track) {
     return mrsBool::kFalse;
   }
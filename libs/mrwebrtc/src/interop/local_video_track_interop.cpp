@@ -5,17 +5,22 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include <algorithm>
+
 #include "global_factory.h"
+#include "handle_table.h"
 #include "local_video_track_interop.h"
+#include "media/encoded_video_track_source.h"
 #include "media/external_video_track_source_impl.h"
 #include "media/local_video_track.h"
+#include "media/synthetic_video_source.h"
 #include "utils.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
 
 void MRS_CALL
 mrsLocalVideoTrackAddRef(mrsLocalVideoTrackHandle handle) noexcept {
-  if (auto track = static_cast<LocalVideoTrack*>(handle)) {
+  if (auto track = FromHandle<LocalVideoTrack>(handle)) {
     track->AddRef();
   } else {
     RTC_LOG(LS_WARNING)
@@ -25,7 +30,7 @@ mrsLocalVideoTrackAddRef(mrsLocalVideoTrackHandle handle) noexcept {
 
 void MRS_CALL
 mrsLocalVideoTrackRemoveRef(mrsLocalVideoTrackHandle handle) noexcept {
-  if (auto track = static_cast<LocalVideoTrack*>(handle)) {
+  if (auto track = FromHandle<LocalVideoTrack>(handle)) {
     track->RemoveRef();
   } else {
     RTC_LOG(LS_WARNING) << "Trying to remove reference from NULL "
@@ -43,11 +48,12 @@ mrsResult MRS_CALL mrsLocalVideoTrackCreateFromExternalSource(
   }
   *track_handle_out = nullptr;
 
-  auto track_source =
-      static_cast<detail::ExternalVideoTrackSourceImpl*>(config->source_handle);
-  if (!track_source) {
+  auto source = FromHandle<ExternalVideoTrackSource>(config->source_handle);
+  if (!source) {
     return Result::kInvalidNativeHandle;
   }
+  auto track_source =
+      static_cast<detail::ExternalVideoTrackSourceImpl*>(source);
 
   std::string track_name_str;
   if (!IsStringNullOrEmpty(config->track_name)) {
@@ -74,7 +80,117 @@ mrsResult MRS_CALL mrsLocalVideoTrackCreateFromExternalSource(
   // Create the video track wrapper
   RefPtr<LocalVideoTrack> track =
       new LocalVideoTrack(std::move(global_factory), std::move(video_track));
-  *track_handle_out = track.release();
+  *track_handle_out = track.release()->GetHandle();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackCreateFromEncodedSource(
+    mrsEncodedVideoTrackSourceHandle source_handle,
+    const char* track_name,
+    mrsLocalVideoTrackHandle* track_handle_out) noexcept {
+  if (IsStringNullOrEmpty(track_name)) {
+    RTC_LOG(LS_ERROR) << "Invalid empty local video track name.";
+    return Result::kInvalidParameter;
+  }
+  if (!track_handle_out) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL local video track handle.";
+    return Result::kInvalidParameter;
+  }
+  *track_handle_out = nullptr;
+  auto source = FromHandle<EncodedVideoTrackSource>(source_handle);
+  if (!source) {
+    return Result::kInvalidNativeHandle;
+  }
+
+  RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
+  auto pc_factory = global_factory->GetPeerConnectionFactory();
+  if (!pc_factory) {
+    return Result::kInvalidOperation;
+  }
+
+  // The video track keeps the core source alive, even if the source wrapper
+  // is destroyed.
+  rtc::scoped_refptr<webrtc::VideoTrackInterface> video_track =
+      pc_factory->CreateVideoTrack(track_name, source->impl());
+  if (!video_track) {
+    return Result::kUnknownError;
+  }
+
+  RefPtr<LocalVideoTrack> track =
+      new LocalVideoTrack(std::move(global_factory), std::move(video_track));
+  *track_handle_out = track.release()->GetHandle();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackCreateSynthetic(
+    const mrsSyntheticVideoTrackInitConfig* config,
+    const char* track_name,
+    mrsLocalVideoTrackHandle* track_handle_out) noexcept {
+  if (IsStringNullOrEmpty(track_name)) {
+    RTC_LOG(LS_ERROR) << "Invalid empty local video track name.";
+    return Result::kInvalidParameter;
+  }
+  if (!config) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL synthetic video configuration.";
+    return Result::kInvalidParameter;
+  }
+  if (!track_handle_out) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL local video track handle.";
+    return Result::kInvalidParameter;
+  }
+  *track_handle_out = nullptr;
+
+  const Result result = SyntheticVideoSource::ValidateConfig(*config);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+
+  RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
+  auto pc_factory = global_factory->GetPeerConnectionFactory();
+  if (!pc_factory) {
+    return Result::kInvalidOperation;
+  }
+
+  // Create the synthetic source, pulled by an external video track source at
+  // the configured framerate.
+  RefPtr<SyntheticVideoSource> synthetic_source =
+      new SyntheticVideoSource(*config);
+  const int frame_interval_ms = synthetic_source->GetFrameIntervalMs();
+  RefPtr<ExternalVideoTrackSource> track_source =
+      ExternalVideoTrackSource::createFromI420A(
+          global_factory, std::move(synthetic_source), frame_interval_ms);
+  if (!track_source) {
+    return Result::kUnknownError;
+  }
+  auto track_source_impl =
+      static_cast<detail::ExternalVideoTrackSourceImpl*>(track_source.get());
+  track_source_impl->SetName(track_name);
+  track_source->FinishCreation();
+
+  rtc::scoped_refptr<webrtc::VideoTrackInterface> video_track =
+      pc_factory->CreateVideoTrack(track_name, track_source_impl->impl());
+  if (!video_track) {
+    track_source->Shutdown();
+    return Result::kUnknownError;
+  }
+
+  // Create the video track wrapper, which owns the track source
+  RefPtr<LocalVideoTrack> track =
+      new LocalVideoTrack(std::move(global_factory), std::move(video_track),
+                          std::move(track_source));
+  *track_handle_out = track.release()->GetHandle();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsSyntheticVideoFrameReadMarker(
+    const mrsI420AVideoFrame* frame,
+    mrsSyntheticVideoFrameMarker* marker) noexcept {
+  if (!frame || !marker) {
+    return Result::kInvalidParameter;
+  }
+  if (!SyntheticVideoSource::ReadMarker(*frame, marker)) {
+    return Result::kNotFound;
+  }
   return Result::kSuccess;
 }
 
@@ -82,7 +198,7 @@ void MRS_CALL mrsLocalVideoTrackRegisterI420AFrameCallback(
     mrsLocalVideoTrackHandle trackHandle,
     mrsI420AVideoFrameCallback callback,
     void* user_data) noexcept {
-  if (auto track = static_cast<LocalVideoTrack*>(trackHandle)) {
+  if (auto track = FromHandle<LocalVideoTrack>(trackHandle)) {
     track->SetCallback(I420AFrameReadyCallback{callback, user_data});
   }
 }
@@ -91,15 +207,35 @@ void MRS_CALL mrsLocalVideoTrackRegisterArgb32FrameCallback(
     mrsLocalVideoTrackHandle trackHandle,
     mrsArgb32VideoFrameCallback callback,
     void* user_data) noexcept {
-  if (auto track = static_cast<LocalVideoTrack*>(trackHandle)) {
+  if (auto track = FromHandle<LocalVideoTrack>(trackHandle)) {
     track->SetCallback(Argb32FrameReadyCallback{callback, user_data});
   }
 }
 
+void MRS_CALL mrsLocalVideoTrackRegisterNv12FrameCallback(
+    mrsLocalVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept {
+  if (auto track = FromHandle<LocalVideoTrack>(trackHandle)) {
+    track->SetCallback(Nv12FrameReadyCallback{callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackSetFrameScaling(
+    mrsLocalVideoTrackHandle track_handle,
+    mrsVideoFrameFormat format,
+    const mrsVideoFrameScaling* scaling) noexcept {
+  auto track = FromHandle<LocalVideoTrack>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->SetScaling(format, scaling);
+}
+
 mrsResult MRS_CALL
 mrsLocalVideoTrackSetEnabled(mrsLocalVideoTrackHandle track_handle,
                              mrsBool enabled) noexcept {
-  auto track = static_cast<LocalVideoTrack*>(track_handle);
+  auto track = FromHandle<LocalVideoTrack>(track_handle);
   if (!track) {
     return Result::kInvalidParameter;
   }
@@ -109,9 +245,75 @@ mrsLocalVideoTrackSetEnabled(mrsLocalVideoTrackHandle track_handle,
 
 mrsBool MRS_CALL
 mrsLocalVideoTrackIsEnabled(mrsLocalVideoTrackHandle track_handle) noexcept {
-  auto track = static_cast<LocalVideoTrack*>(track_handle);
+  auto track = FromHandle<LocalVideoTrack>(track_handle);
   if (!track) {
     return mrsBool::kFalse;
   }
   return (track->IsEnabled() ? mrsBool::kTrue : mrsBool::kFalse);
 }
+
+mrsResult MRS_CALL
+mrsLocalVideoTrackGetSendEncodings(mrsLocalVideoTrackHandle track_handle,
+                                   mrsSendEncodingParameters* encodings,
+                                   uint32_t* count) noexcept {
+  auto track = FromHandle<LocalVideoTrack>(track_handle);
+  if (!track || !count || (!encodings && (*count > 0))) {
+    return Result::kInvalidParameter;
+  }
+  std::vector<mrsSendEncodingParameters> current;
+  const Result result = track->GetSendEncodings(current);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  const uint32_t capacity = *count;
+  *count = static_cast<uint32_t>(current.size());
+  if (current.size() > capacity) {
+    return (encodings ? Result::kInvalidParameter : Result::kSuccess);
+  }
+  std::copy(current.begin(), current.end(), encodings);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsLocalVideoTrackSetSendEncoding(
+    mrsLocalVideoTrackHandle track_handle,
+    uint32_t index,
+    const mrsSendEncodingParameters* encoding) noexcept {
+  auto track = FromHandle<LocalVideoTrack>(track_handle);
+  if (!track || !encoding) {
+    return Result::kInvalidParameter;
+  }
+  return track->SetSendEncoding(index, *encoding);
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackSetDegradationPreference(
+    mrsLocalVideoTrackHandle track_handle,
+    mrsDegradationPreference preference) noexcept {
+  auto track = FromHandle<LocalVideoTrack>(track_handle);
+  if (!track) {
+    return Result::kInvalidParameter;
+  }
+  switch (preference) {
+    case mrsDegradationPreference::kDefault:
+    case mrsDegradationPreference::kMaintainFramerate:
+    case mrsDegradationPreference::kMaintainResolution:
+      break;
+    default:
+      RTC_LOG(LS_ERROR) << "Unknown degradation preference "
+                        << (int)preference << ".";
+      return Result::kInvalidParameter;
+  }
+  track->SetDegradationPreference(preference);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLocalVideoTrackGetDegradationPreference(
+    mrsLocalVideoTrackHandle track_handle,
+    mrsDegradationPreference* preference_out) noexcept {
+  auto track = FromHandle<LocalVideoTrack>(track_handle);
+  if (!track || !preference_out) {
+    return Result::kInvalidParameter;
+  }
+  *preference_out = track->GetDegradationPreference();
+  return Result::kSuccess;
+}
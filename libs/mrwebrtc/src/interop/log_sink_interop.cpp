@@ -0,0 +1,142 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "log_sink.h"
+#include "log_sink_interop.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+namespace {
+
+/// Log sinks currently alive, by identifier. The handle of a sink is its
+/// identifier, not its address, and identifiers are never reused, so that a
+/// destroyed or invalid handle is safely rejected even after the memory of its
+/// sink was reused by a new sink.
+struct LogSinkList {
+  std::mutex mutex_;
+  std::unordered_map<uintptr_t, std::unique_ptr<LogSink>> sinks_;
+
+  /// Identifier of the next sink created. Zero is never used, so that a handle
+  /// is never NULL. This only wraps around on 32-bit platforms, after about
+  /// four billion sinks were created.
+  uintptr_t next_id_{1};
+};
+
+/// Get the list of live sinks. The list is intentionally leaked, so that the
+/// delivery threads of the remaining sinks are never joined from a static
+/// destructor while the module is unloaded under the loader lock. Those sinks
+/// are instead stopped by |mrsForceShutdown()|.
+LogSinkList& GetLogSinkList() {
+  static LogSinkList* const list = new LogSinkList();
+  return *list;
+}
+
+uintptr_t HandleToId(mrsLogSinkHandle handle) noexcept {
+  return reinterpret_cast<uintptr_t>(handle);
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void DestroyAllLogSinks() noexcept {
+  std::vector<std::unique_ptr<LogSink>> sinks;
+  {
+    LogSinkList& list = GetLogSinkList();
+    std::lock_guard<std::mutex> lock(list.mutex_);
+    // A sink cannot be stopped from its own delivery thread, so keep it alive.
+    for (auto it = list.sinks_.begin(); it != list.sinks_.end();) {
+      if (it->second->IsDeliveryThread()) {
+        ++it;
+      } else {
+        sinks.push_back(std::move(it->second));
+        it = list.sinks_.erase(it);
+      }
+    }
+  }
+  // Stop outside the lock, like |mrsLogSinkDestroy()|.
+  for (auto&& sink : sinks) {
+    sink->Stop();
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+mrsResult MRS_CALL mrsLogSinkCreate(const mrsLogSinkConfig* config,
+                                    mrsLogMessageCallback callback,
+                                    void* user_data,
+                                    mrsLogSinkHandle* handle) noexcept {
+  if (!handle) {
+    return Result::kInvalidParameter;
+  }
+  *handle = nullptr;
+  const mrsLogSinkConfig default_config{};
+  if (!config) {
+    config = &default_config;
+  }
+  if (!callback || (config->queue_capacity == 0) ||
+      (config->min_severity < mrsLogSeverity::kVerbose) ||
+      (config->min_severity > mrsLogSeverity::kError)) {
+    return Result::kInvalidParameter;
+  }
+  auto sink = std::make_unique<LogSink>(
+      *config, LogSink::MessageCallback{callback, user_data});
+  sink->Start();
+  LogSinkList& list = GetLogSinkList();
+  std::lock_guard<std::mutex> lock(list.mutex_);
+  uintptr_t id = list.next_id_++;
+  if (id == 0) {
+    id = list.next_id_++;
+  }
+  *handle = reinterpret_cast<mrsLogSinkHandle>(id);
+  list.sinks_.emplace(id, std::move(sink));
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLogSinkGetDroppedCount(mrsLogSinkHandle handle,
+                                             uint64_t* count) noexcept {
+  if (!count) {
+    return Result::kInvalidParameter;
+  }
+  LogSinkList& list = GetLogSinkList();
+  std::lock_guard<std::mutex> lock(list.mutex_);
+  auto it = list.sinks_.find(HandleToId(handle));
+  if (it == list.sinks_.end()) {
+    return Result::kInvalidNativeHandle;
+  }
+  *count = it->second->GetDroppedCount();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsLogSinkDestroy(mrsLogSinkHandle handle) noexcept {
+  std::unique_ptr<LogSink> sink;
+  {
+    LogSinkList& list = GetLogSinkList();
+    std::lock_guard<std::mutex> lock(list.mutex_);
+    auto it = list.sinks_.find(HandleToId(handle));
+    if (it == list.sinks_.end()) {
+      return Result::kInvalidNativeHandle;
+    }
+    if (it->second->IsDeliveryThread()) {
+      return Result::kInvalidOperation;
+    }
+    sink = std::move(it->second);
+    list.sinks_.erase(it);
+  }
+  // Stop outside the lock, since the callback can call into the sink API
+  // while the remaining messages are delivered.
+  sink->Stop();
+  return Result::kSuccess;
+}
@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "metrics.h"
+#include "metrics_interop.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsMetricsGetSnapshot(char* buffer,
+                                         uint64_t* buffer_size) noexcept {
+  if (!buffer_size || (!buffer && (*buffer_size > 0))) {
+    return Result::kInvalidParameter;
+  }
+  const std::string snapshot = Metrics::GetSnapshotJson();
+  const size_t capacity = static_cast<size_t>(*buffer_size);
+  const size_t size = snapshot.size();
+  *buffer_size = size + 1;
+  if (capacity < size + 1) {
+    return Result::kInvalidParameter;
+  }
+  memcpy(buffer, snapshot.c_str(), size);
+  buffer[size] = '\0';
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsMetricsReset() noexcept {
+  Metrics::Reset();
+}
@@ -5,6 +5,7 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include "handle_table.h"
 #include "interop/global_factory.h"
 #include "media/audio_track_read_buffer.h"
 #include "media/transceiver.h"
@@ -14,7 +15,7 @@
 using namespace Microsoft::MixedReality::WebRTC;
 
 void MRS_CALL mrsPeerConnectionAddRef(mrsPeerConnectionHandle handle) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(handle)) {
+  if (auto peer = FromHandle<PeerConnection>(handle)) {
     peer->AddRef();
   } else {
     RTC_LOG(LS_WARNING)
@@ -24,7 +25,7 @@ void MRS_CALL mrsPeerConnectionAddRef(mrsPeerConnectionHandle handle) noexcept {
 
 void MRS_CALL
 mrsPeerConnectionRemoveRef(mrsPeerConnectionHandle handle) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(handle)) {
+  if (auto peer = FromHandle<PeerConnection>(handle)) {
     peer->RemoveRef();
   } else {
     RTC_LOG(LS_WARNING)
@@ -36,7 +37,7 @@ void MRS_CALL mrsPeerConnectionRegisterTransceiverAddedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionTransceiverAddedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterTransceiverAddedCallback(
         Callback<const mrsTransceiverAddedInfo*>{callback, user_data});
   }
@@ -46,7 +47,7 @@ void MRS_CALL mrsPeerConnectionRegisterIceGatheringStateChangedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionIceGatheringStateChangedCallback callback,
     void* user_data) noexcept {
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     peer->RegisterIceGatheringStateChangedCallback(
         Callback<mrsIceGatheringState>{callback, user_data});
   }
@@ -60,7 +61,7 @@ mrsPeerConnectionAddTransceiver(mrsPeerConnectionHandle peer_handle,
     return Result::kInvalidParameter;
   }
   *handle = nullptr;
-  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
     ErrorOr<Transceiver*> result = peer->AddTransceiver(*config);
     if (result.ok()) {
       *handle = result.value()->GetHandle();
@@ -71,6 +72,66 @@ mrsPeerConnectionAddTransceiver(mrsPeerConnectionHandle peer_handle,
   return Result::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL
+mrsPeerConnectionAddTransceivers(mrsPeerConnectionHandle peer_handle,
+                                 const mrsTransceiverInitConfig* configs,
+                                 uint32_t count,
+                                 mrsTransceiverHandle* handles) noexcept {
+  if ((count > 0) && (!configs || !handles)) {
+    return Result::kInvalidParameter;
+  }
+  std::fill_n(handles, count, nullptr);
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
+    std::vector<Transceiver*> transceivers;
+    Error result = peer->AddTransceivers(configs, count, transceivers);
+    for (size_t i = 0; i < transceivers.size(); ++i) {
+      handles[i] = transceivers[i]->GetHandle();
+    }
+    return result.result();
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsPeerConnectionStartStatsSampler(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsStatsSamplerConfig* config) noexcept {
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  if ((config->interval_ms <= 0) || (config->capacity <= 0)) {
+    return Result::kOutOfRange;
+  }
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
+    return peer->StartStatsSampler(*config);
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsPeerConnectionStopStatsSampler(
+    mrsPeerConnectionHandle peer_handle) noexcept {
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
+    peer->StopStatsSampler();
+    return Result::kSuccess;
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionReadStatsSamples(mrsPeerConnectionHandle peer_handle,
+                                  mrsStatsSample* samples,
+                                  uint32_t capacity,
+                                  uint32_t* count_out) noexcept {
+  if (!count_out || (!samples && (capacity > 0))) {
+    return Result::kInvalidParameter;
+  }
+  *count_out = 0;
+  if (auto peer = FromHandle<PeerConnection>(peer_handle)) {
+    *count_out = peer->ReadStatsSamples(samples, capacity);
+    return Result::kSuccess;
+  }
+  return Result::kInvalidNativeHandle;
+}
+
 #if 0  // WIP
 mrsResult MRS_CALL
 mrsPeerConnectionRenderRemoteAudio(mrsPeerConnectionHandle peerHandle,
@@ -80,7 +141,7 @@ mrsPeerConnectionRenderRemoteAudio(mrsPeerConnectionHandle peerHandle,
                          "not supported on UWP";
   return Result::kUnsupported;
 #else
-  if (auto peer = static_cast<PeerConnection*>(peerHandle)) {
+  if (auto peer = FromHandle<PeerConnection>(peerHandle)) {
     peer->RenderRemoteAudioTrack(render);
   }
   return Result::kSuccess;
@@ -92,7 +153,7 @@ mrsAudioTrackReadBufferCreate(mrsPeerConnectionHandle peerHandle,
                               int bufferMs,
                               AudioTrackReadBufferHandle* audioBufferOut) {
   *audioBufferOut = nullptr;
-  if (auto peer = static_cast<PeerConnection*>(peerHandle)) {
+  if (auto peer = FromHandle<PeerConnection>(peerHandle)) {
     *audioBufferOut = new AudioTrackReadBuffer(peer, bufferMs);
     return Result::kSuccess;
   }
@@ -5,6 +5,7 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include "handle_table.h"
 #include "media/remote_audio_track.h"
 #include "remote_audio_track_interop.h"
 
@@ -13,14 +14,14 @@ using namespace Microsoft::MixedReality::WebRTC;
 MRS_API void MRS_CALL
 mrsRemoteAudioTrackSetUserData(mrsRemoteAudioTrackHandle handle,
                                void* user_data) noexcept {
-  if (auto track = static_cast<RemoteAudioTrack*>(handle)) {
+  if (auto track = FromHandle<RemoteAudioTrack>(handle)) {
     track->SetUserData(user_data);
   }
 }
 
 MRS_API void* MRS_CALL
 mrsRemoteAudioTrackGetUserData(mrsRemoteAudioTrackHandle handle) noexcept {
-  if (auto track = static_cast<RemoteAudioTrack*>(handle)) {
+  if (auto track = FromHandle<RemoteAudioTrack>(handle)) {
     return track->GetUserData();
   }
   return nullptr;
@@ -30,7 +31,7 @@ void MRS_CALL
 mrsRemoteAudioTrackRegisterFrameCallback(mrsRemoteAudioTrackHandle trackHandle,
                                          mrsAudioFrameCallback callback,
                                          void* user_data) noexcept {
-  if (auto track = static_cast<RemoteAudioTrack*>(trackHandle)) {
+  if (auto track = FromHandle<RemoteAudioTrack>(trackHandle)) {
     track->SetCallback(AudioFrameReadyCallback{callback, user_data});
   }
 }
@@ -38,7 +39,7 @@ mrsRemoteAudioTrackRegisterFrameCallback(mrsRemoteAudioTrackHandle trackHandle,
 mrsResult MRS_CALL
 mrsRemoteAudioTrackSetEnabled(mrsRemoteAudioTrackHandle track_handle,
                               mrsBool enabled) noexcept {
-  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  auto track = FromHandle<RemoteAudioTrack>(track_handle);
   if (!track) {
     return Result::kInvalidParameter;
   }
@@ -48,7 +49,7 @@ mrsRemoteAudioTrackSetEnabled(mrsRemoteAudioTrackHandle track_handle,
 
 mrsBool MRS_CALL
 mrsRemoteAudioTrackIsEnabled(mrsRemoteAudioTrackHandle track_handle) noexcept {
-  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  auto track = FromHandle<RemoteAudioTrack>(track_handle);
   if (!track) {
     return mrsBool::kFalse;
   }
@@ -58,14 +59,14 @@ mrsRemoteAudioTrackIsEnabled(mrsRemoteAudioTrackHandle track_handle) noexcept {
 void MRS_CALL
 mrsRemoteAudioTrackOutputToDevice(mrsRemoteAudioTrackHandle track_handle,
     bool output) noexcept {
-  if (auto track = static_cast<RemoteAudioTrack*>(track_handle)) {
+  if (auto track = FromHandle<RemoteAudioTrack>(track_handle)) {
       track->OutputToDevice(output);
   }
 }
 
 mrsBool MRS_CALL mrsRemoteAudioTrackIsOutputToDevice(
     mrsRemoteAudioTrackHandle track_handle) noexcept {
-  if (auto track = static_cast<const RemoteAudioTrack*>(track_handle)) {
+  if (auto track = FromHandle<RemoteAudioTrack>(track_handle)) {
     return track->IsOutputToDevice() ? mrsBool::kTrue : mrsBool::kFalse;
   }
   return mrsBool::kFalse;
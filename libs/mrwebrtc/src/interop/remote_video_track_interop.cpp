@@ -5,6 +5,7 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include "handle_table.h"
 #include "media/remote_video_track.h"
 #include "remote_video_track_interop.h"
 
@@ -13,14 +14,14 @@ using namespace Microsoft::MixedReality::WebRTC;
 MRS_API void MRS_CALL
 mrsRemoteVideoTrackSetUserData(mrsRemoteVideoTrackHandle handle,
                                void* user_data) noexcept {
-  if (auto track = static_cast<RemoteVideoTrack*>(handle)) {
+  if (auto track = FromHandle<RemoteVideoTrack>(handle)) {
     track->SetUserData(user_data);
   }
 }
 
 MRS_API void* MRS_CALL
 mrsRemoteVideoTrackGetUserData(mrsRemoteVideoTrackHandle handle) noexcept {
-  if (auto track = static_cast<RemoteVideoTrack*>(handle)) {
+  if (auto track = FromHandle<RemoteVideoTrack>(handle)) {
     return track->GetUserData();
   }
   return nullptr;
@@ -30,7 +31,7 @@ void MRS_CALL mrsRemoteVideoTrackRegisterI420AFrameCallback(
     mrsRemoteVideoTrackHandle trackHandle,
     mrsI420AVideoFrameCallback callback,
     void* user_data) noexcept {
-  if (auto track = static_cast<RemoteVideoTrack*>(trackHandle)) {
+  if (auto track = FromHandle<RemoteVideoTrack>(trackHandle)) {
     track->SetCallback(I420AFrameReadyCallback{callback, user_data});
   }
 }
@@ -39,15 +40,35 @@ void MRS_CALL mrsRemoteVideoTrackRegisterArgb32FrameCallback(
     mrsRemoteVideoTrackHandle trackHandle,
     mrsArgb32VideoFrameCallback callback,
     void* user_data) noexcept {
-  if (auto track = static_cast<RemoteVideoTrack*>(trackHandle)) {
+  if (auto track = FromHandle<RemoteVideoTrack>(trackHandle)) {
     track->SetCallback(Argb32FrameReadyCallback{callback, user_data});
   }
 }
 
+void MRS_CALL mrsRemoteVideoTrackRegisterNv12FrameCallback(
+    mrsRemoteVideoTrackHandle trackHandle,
+    mrsNv12VideoFrameCallback callback,
+    void* user_data) noexcept {
+  if (auto track = FromHandle<RemoteVideoTrack>(trackHandle)) {
+    track->SetCallback(Nv12FrameReadyCallback{callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackSetFrameScaling(
+    mrsRemoteVideoTrackHandle track_handle,
+    mrsVideoFrameFormat format,
+    const mrsVideoFrameScaling* scaling) noexcept {
+  auto track = FromHandle<RemoteVideoTrack>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->SetScaling(format, scaling);
+}
+
 mrsResult MRS_CALL
 mrsRemoteVideoTrackSetEnabled(mrsRemoteVideoTrackHandle track_handle,
                               mrsBool enabled) noexcept {
-  auto track = static_cast<RemoteVideoTrack*>(track_handle);
+  auto track = FromHandle<RemoteVideoTrack>(track_handle);
   if (!track) {
     return Result::kInvalidParameter;
   }
@@ -57,9 +78,33 @@ mrsRemoteVideoTrackSetEnabled(mrsRemoteVideoTrackHandle track_handle,
 
 mrsBool MRS_CALL
 mrsRemoteVideoTrackIsEnabled(mrsRemoteVideoTrackHandle track_handle) noexcept {
-  auto track = static_cast<RemoteVideoTrack*>(track_handle);
+  auto track = FromHandle<RemoteVideoTrack>(track_handle);
   if (!track) {
     return mrsBool::kFalse;
   }
   return (track->IsEnabled() ? mrsBool::kTrue : mrsBool::kFalse);
 }
+
+mrsResult MRS_CALL
+mrsRemoteVideoTrackSetPriority(mrsRemoteVideoTrackHandle track_handle,
+                               mrsRemoteVideoTrackPriority priority) noexcept {
+  auto track = FromHandle<RemoteVideoTrack>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  return track->SetPriority(priority);
+}
+
+mrsResult MRS_CALL mrsRemoteVideoTrackGetPriority(
+    mrsRemoteVideoTrackHandle track_handle,
+    mrsRemoteVideoTrackPriority* priority_out) noexcept {
+  auto track = FromHandle<RemoteVideoTrack>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!priority_out) {
+    return Result::kInvalidParameter;
+  }
+  *priority_out = track->GetPriority();
+  return Result::kSuccess;
+}
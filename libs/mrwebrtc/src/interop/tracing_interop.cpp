@@ -0,0 +1,24 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "tracing.h"
+#include "tracing_interop.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsTracingStart(const mrsTracingConfig* config) noexcept {
+  const mrsTracingConfig default_config{};
+  return Tracing::Start(config ? *config : default_config);
+}
+
+mrsResult MRS_CALL mrsTracingStop() noexcept {
+  return Tracing::Stop();
+}
+
+mrsResult MRS_CALL mrsTracingWriteJson(const char* path) noexcept {
+  return Tracing::WriteJson(path);
+}
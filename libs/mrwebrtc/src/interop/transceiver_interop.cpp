@@ -5,25 +5,27 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include "handle_table.h"
 #include "media/local_audio_track.h"
 #include "media/local_video_track.h"
 #include "media/remote_audio_track.h"
 #include "media/remote_video_track.h"
 #include "media/transceiver.h"
 #include "transceiver_interop.h"
+#include "utils.h"
 
 using namespace Microsoft::MixedReality::WebRTC;
 
 MRS_API void MRS_CALL mrsTransceiverSetUserData(mrsTransceiverHandle handle,
                                                 void* user_data) noexcept {
-  if (auto transceiver = static_cast<Transceiver*>(handle)) {
+  if (auto transceiver = FromHandle<Transceiver>(handle)) {
     transceiver->SetUserData(user_data);
   }
 }
 
 MRS_API void* MRS_CALL
 mrsTransceiverGetUserData(mrsTransceiverHandle handle) noexcept {
-  if (auto transceiver = static_cast<Transceiver*>(handle)) {
+  if (auto transceiver = FromHandle<Transceiver>(handle)) {
     return transceiver->GetUserData();
   }
   return nullptr;
@@ -33,7 +35,7 @@ void MRS_CALL mrsTransceiverRegisterAssociatedCallback(
     mrsTransceiverHandle handle,
     mrsTransceiverAssociatedCallback callback,
     void* user_data) noexcept {
-  if (auto transceiver = static_cast<Transceiver*>(handle)) {
+  if (auto transceiver = FromHandle<Transceiver>(handle)) {
     transceiver->RegisterAssociatedCallback(
         Transceiver::AssociatedCallback{callback, user_data});
   }
@@ -43,46 +45,98 @@ void MRS_CALL mrsTransceiverRegisterStateUpdatedCallback(
     mrsTransceiverHandle handle,
     mrsTransceiverStateUpdatedCallback callback,
     void* user_data) noexcept {
-  if (auto transceiver = static_cast<Transceiver*>(handle)) {
+  if (auto transceiver = FromHandle<Transceiver>(handle)) {
     transceiver->RegisterStateUpdatedCallback(
         Transceiver::StateUpdatedCallback{callback, user_data});
   }
 }
 
+mrsResult MRS_CALL mrsTransceiverRegisterEncodedFrameCallback(
+    mrsTransceiverHandle transceiver_handle,
+    mrsEncodedFrameCallback callback,
+    void* user_data) noexcept {
+  if (auto transceiver = FromHandle<Transceiver>(transceiver_handle)) {
+    transceiver->RegisterEncodedFrameCallback(
+        Transceiver::EncodedFrameCallback{callback, user_data});
+    return Result::kSuccess;
+  }
+  return Result::kInvalidNativeHandle;
+}
+
 mrsResult MRS_CALL
 mrsTransceiverSetDirection(mrsTransceiverHandle transceiver_handle,
                            mrsTransceiverDirection new_direction) noexcept {
-  if (auto transceiver = static_cast<Transceiver*>(transceiver_handle)) {
+  if (auto transceiver = FromHandle<Transceiver>(transceiver_handle)) {
     return transceiver->SetDirection(new_direction);
   }
   return Result::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL
+mrsTransceiverSetCodecPreferences(mrsTransceiverHandle transceiver_handle,
+                                  const char* encoded_codec_names) noexcept {
+  if (auto transceiver = FromHandle<Transceiver>(transceiver_handle)) {
+    std::vector<std::string> codec_names;
+    if (!IsStringNullOrEmpty(encoded_codec_names)) {
+      rtc::split(encoded_codec_names, ';', &codec_names);
+    }
+    return transceiver->SetCodecPreferences(std::move(codec_names));
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsTransceiverSetSendEncodings(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsSendEncodingParameters* encodings,
+    uint32_t count) noexcept {
+  if (!encodings || (count == 0)) {
+    return Result::kInvalidParameter;
+  }
+  if (auto transceiver = FromHandle<Transceiver>(transceiver_handle)) {
+    return transceiver->SetSendEncodings(encodings, count);
+  }
+  return Result::kInvalidNativeHandle;
+}
+
 mrsResult MRS_CALL mrsTransceiverSetLocalAudioTrack(
     mrsTransceiverHandle transceiver_handle,
     mrsLocalAudioTrackHandle track_handle) noexcept {
-  if (!transceiver_handle) {
+  auto transceiver = FromHandle<Transceiver>(transceiver_handle);
+  if (!transceiver) {
     return Result::kInvalidNativeHandle;
   }
-  auto transceiver = static_cast<Transceiver*>(transceiver_handle);
   if (transceiver->GetMediaKind() != mrsMediaKind::kAudio) {
     return Result::kInvalidMediaKind;
   }
-  auto track = static_cast<LocalAudioTrack*>(track_handle);
+  // Only a NULL track handle clears the track; a stale one is an error.
+  LocalAudioTrack* track = nullptr;
+  if (track_handle) {
+    track = FromHandle<LocalAudioTrack>(track_handle);
+    if (!track) {
+      return Result::kInvalidNativeHandle;
+    }
+  }
   return transceiver->SetLocalTrack(track);
 }
 
 mrsResult MRS_CALL mrsTransceiverSetLocalVideoTrack(
     mrsTransceiverHandle transceiver_handle,
     mrsLocalVideoTrackHandle track_handle) noexcept {
-  if (!transceiver_handle) {
+  auto transceiver = FromHandle<Transceiver>(transceiver_handle);
+  if (!transceiver) {
     return Result::kInvalidNativeHandle;
   }
-  auto transceiver = static_cast<Transceiver*>(transceiver_handle);
   if (transceiver->GetMediaKind() != mrsMediaKind::kVideo) {
     return Result::kInvalidMediaKind;
   }
-  auto track = static_cast<LocalVideoTrack*>(track_handle);
+  // Only a NULL track handle clears the track; a stale one is an error.
+  LocalVideoTrack* track = nullptr;
+  if (track_handle) {
+    track = FromHandle<LocalVideoTrack>(track_handle);
+    if (!track) {
+      return Result::kInvalidNativeHandle;
+    }
+  }
   return transceiver->SetLocalTrack(track);
 }
 
@@ -92,11 +146,12 @@ mrsResult MRS_CALL mrsTransceiverGetLocalAudioTrack(
   if (!track_handle_out) {
     return Result::kInvalidParameter;
   }
-  if (auto transceiver = static_cast<Transceiver*>(transceiver_handle)) {
+  if (auto transceiver = FromHandle<Transceiver>(transceiver_handle)) {
     if (transceiver->GetMediaKind() != mrsMediaKind::kAudio) {
       return Result::kInvalidMediaKind;
     }
-    *track_handle_out = transceiver->GetLocalAudioTrack().get();
+    auto track = transceiver->GetLocalAudioTrack();
+    *track_handle_out = (track ? track->GetHandle() : nullptr);
     return Result::kSuccess;
   }
   return Result::kInvalidNativeHandle;
@@ -108,11 +163,12 @@ mrsResult MRS_CALL mrsTransceiverGetLocalVideoTrack(
   if (!track_handle_out) {
     return Result::kInvalidParameter;
   }
-  if (auto transceiver = static_cast<Transceiver*>(transceiver_handle)) {
+  if (auto transceiver = FromHandle<Transceiver>(transceiver_handle)) {
     if (transceiver->GetMediaKind() != mrsMediaKind::kVideo) {
       return Result::kInvalidMediaKind;
     }
-    *track_handle_out = transceiver->GetLocalVideoTrack().get();
+    auto track = transceiver->GetLocalVideoTrack();
+    *track_handle_out = (track ? track->GetHandle() : nullptr);
     return Result::kSuccess;
   }
   return Result::kInvalidNativeHandle;
@@ -124,11 +180,12 @@ mrsResult MRS_CALL mrsTransceiverGetRemoteAudioTrack(
   if (!track_handle_out) {
     return Result::kInvalidParameter;
   }
-  if (auto transceiver = static_cast<Transceiver*>(transceiver_handle)) {
+  if (auto transceiver = FromHandle<Transceiver>(transceiver_handle)) {
     if (transceiver->GetMediaKind() != mrsMediaKind::kAudio) {
       return Result::kInvalidMediaKind;
     }
-    *track_handle_out = transceiver->GetRemoteAudioTrack().get();
+    auto track = transceiver->GetRemoteAudioTrack();
+    *track_handle_out = (track ? track->GetHandle() : nullptr);
     return Result::kSuccess;
   }
   return Result::kInvalidNativeHandle;
@@ -140,11 +197,12 @@ mrsResult MRS_CALL mrsTransceiverGetRemoteVideoTrack(
   if (!track_handle_out) {
     return Result::kInvalidParameter;
   }
-  if (auto transceiver = static_cast<Transceiver*>(transceiver_handle)) {
+  if (auto transceiver = FromHandle<Transceiver>(transceiver_handle)) {
     if (transceiver->GetMediaKind() != mrsMediaKind::kVideo) {
       return Result::kInvalidMediaKind;
     }
-    *track_handle_out = transceiver->GetRemoteVideoTrack().get();
+    auto track = transceiver->GetRemoteVideoTrack();
+    *track_handle_out = (track ? track->GetHandle() : nullptr);
     return Result::kSuccess;
   }
   return Result::kInvalidNativeHandle;
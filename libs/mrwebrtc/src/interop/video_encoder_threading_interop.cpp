@@ -0,0 +1,22 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "interop/global_factory.h"
+#include "video_encoder_threading_interop.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsSetVideoEncoderThreadingConfig(
+    const char* codec_name,
+    const mrsVideoEncoderThreadingConfig* config) noexcept {
+  return GlobalFactory::SetVideoEncoderThreadingConfig(codec_name, config);
+}
+
+mrsResult MRS_CALL
+mrsSetVideoEncoderThreadPoolSize(uint32_t thread_count) noexcept {
+  return GlobalFactory::SetVideoEncoderThreadPoolSize(thread_count);
+}
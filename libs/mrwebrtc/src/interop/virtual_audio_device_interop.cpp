@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "interop/global_factory.h"
+#include "media/virtual_audio_device_module.h"
+#include "virtual_audio_device_interop.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+namespace {
+
+/// Get the virtual audio device module of the library, or NULL if the library
+/// is not initialized or does not use the virtual audio device module. The
+/// library can shut down once the returned reference is released.
+rtc::scoped_refptr<VirtualAudioDeviceModule> GetVirtualAudioDevice() {
+  RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtrIfExist());
+  if (!global_factory) {
+    return nullptr;
+  }
+  return global_factory->virtual_audio_device();
+}
+
+}  // namespace
+
+mrsResult MRS_CALL mrsSetAudioDeviceModuleConfig(
+    const mrsAudioDeviceModuleConfig* config) noexcept {
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  return GlobalFactory::SetAudioDeviceModuleConfig(*config);
+}
+
+mrsResult MRS_CALL
+mrsVirtualAudioDevicePushCaptureFrame(const mrsAudioFrame* frame) noexcept {
+  if (!frame) {
+    return Result::kInvalidParameter;
+  }
+  auto device = GetVirtualAudioDevice();
+  if (!device) {
+    return Result::kNotInitialized;
+  }
+  return device->PushCaptureFrame(*frame);
+}
+
+mrsResult MRS_CALL
+mrsVirtualAudioDeviceRegisterPlayoutCallback(mrsAudioFrameCallback callback,
+                                             void* user_data) noexcept {
+  auto device = GetVirtualAudioDevice();
+  if (!device) {
+    return Result::kNotInitialized;
+  }
+  device->SetPlayoutCallback(AudioFrameReadyCallback{callback, user_data});
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsVirtualAudioDeviceProcess(uint32_t period_count) noexcept {
+  auto device = GetVirtualAudioDevice();
+  if (!device) {
+    return Result::kNotInitialized;
+  }
+  return device->Process(period_count);
+}
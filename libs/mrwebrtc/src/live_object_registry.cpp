@@ -0,0 +1,93 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "live_object_registry.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+void LiveObjectRegistry::Add(TrackedObject* obj) noexcept {
+  RTC_DCHECK(obj);
+  const int shard_index = GetShardIndex(obj);
+  Shard& shard = shards_[shard_index];
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    RTC_DCHECK(obj->live_shard_ < 0);
+    obj->live_shard_ = shard_index;
+    obj->prev_live_ = nullptr;
+    obj->next_live_ = shard.head_;
+    if (shard.head_) {
+      shard.head_->prev_live_ = obj;
+    }
+    shard.head_ = obj;
+  }
+  counts_[static_cast<int>(obj->GetObjectType())].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void LiveObjectRegistry::Remove(TrackedObject* obj) noexcept {
+  RTC_DCHECK(obj);
+  Shard& shard = shards_[GetShardIndex(obj)];
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    if (obj->live_shard_ < 0) {
+      return;  // cleared
+    }
+    if (obj->prev_live_) {
+      obj->prev_live_->next_live_ = obj->next_live_;
+    } else {
+      RTC_DCHECK(shard.head_ == obj);
+      shard.head_ = obj->next_live_;
+    }
+    if (obj->next_live_) {
+      obj->next_live_->prev_live_ = obj->prev_live_;
+    }
+    obj->prev_live_ = nullptr;
+    obj->next_live_ = nullptr;
+    obj->live_shard_ = -1;
+  }
+  counts_[static_cast<int>(obj->GetObjectType())].fetch_sub(
+      1, std::memory_order_relaxed);
+}
+
+void LiveObjectRegistry::Clear() noexcept {
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    TrackedObject* obj = shard.head_;
+    while (obj) {
+      TrackedObject* const next = obj->next_live_;
+      counts_[static_cast<int>(obj->GetObjectType())].fetch_sub(
+          1, std::memory_order_relaxed);
+      obj->prev_live_ = nullptr;
+      obj->next_live_ = nullptr;
+      obj->live_shard_ = -1;
+      obj = next;
+    }
+    shard.head_ = nullptr;
+  }
+}
+
+uint32_t LiveObjectRegistry::GetTotalCount() const noexcept {
+  uint32_t count = 0;
+  for (auto&& type_count : counts_) {
+    count += type_count.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+int LiveObjectRegistry::GetShardIndex(const TrackedObject* obj) noexcept {
+  // Discard the low bits, which are mostly constant due to allocation
+  // alignment, and fold some higher bits to spread objects of the same size
+  // allocated next to each other.
+  const uintptr_t value = reinterpret_cast<uintptr_t>(obj) >> 4;
+  return static_cast<int>((value ^ (value >> 8)) % kShardCount);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "tracked_object.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Registry of all the tracked objects alive, used for debugging reports and
+/// for per-type live object counts. Objects are linked into one of several
+/// intrusive lists (shards) selected from their address, each with its own
+/// lock, so that adding and removing objects is O(1) and objects of different
+/// peer connections rarely contend on the same lock. Counts are maintained
+/// separately with atomics, and can be read without locking.
+class LiveObjectRegistry {
+ public:
+  /// Add a tracked object to the registry. The object must not be already
+  /// registered.
+  void Add(TrackedObject* obj) noexcept;
+
+  /// Remove a tracked object from the registry. This is a no-op if the object
+  /// is not registered, for example after |Clear()|.
+  void Remove(TrackedObject* obj) noexcept;
+
+  /// Unregister all objects without destroying them.
+  void Clear() noexcept;
+
+  /// Get the number of live objects of the given type. This does not lock,
+  /// and the result can be outdated as soon as the call returns.
+  uint32_t GetCount(ObjectType type) const noexcept {
+    return counts_[static_cast<int>(type)].load(std::memory_order_relaxed);
+  }
+
+  /// Get the total number of live objects. This does not lock, and the result
+  /// can be outdated as soon as the call returns.
+  uint32_t GetTotalCount() const noexcept;
+
+  /// Invoke the given function on each registered object, and return the
+  /// number of objects visited. Each shard is locked while its objects are
+  /// visited, so the function must not add or remove objects.
+  template <typename Func>
+  uint32_t ForEach(Func&& func) const {
+    uint32_t count = 0;
+    for (const Shard& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex_);
+      for (TrackedObject* obj = shard.head_; obj; obj = obj->next_live_) {
+        func(obj);
+        ++count;
+      }
+    }
+    return count;
+  }
+
+ private:
+  static constexpr int kShardCount = 16;
+  static constexpr int kObjectTypeCount =
+      static_cast<int>(ObjectType::kEncodedFrameRecorder) + 1;
+
+  /// Intrusive list of objects, aligned to avoid false sharing between the
+  /// locks of different shards.
+  struct alignas(64) Shard {
+    mutable std::mutex mutex_;
+    TrackedObject* head_ RTC_GUARDED_BY(mutex_){nullptr};
+  };
+
+  static int GetShardIndex(const TrackedObject* obj) noexcept;
+
+  Shard shards_[kShardCount];
+  std::atomic<uint32_t> counts_[kObjectTypeCount]{};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
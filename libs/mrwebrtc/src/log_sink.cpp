@@ -0,0 +1,275 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+
+#include "rtc_base/strings/string_builder.h"
+#include "rtc_base/timeutils.h"
+
+#include "log_sink.h"
+#include "utils.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace {
+
+constexpr uint32_t kMaxQueueCapacity = (1u << 20);
+
+rtc::LoggingSeverity ToRtcSeverity(mrsLogSeverity severity) noexcept {
+  switch (severity) {
+    case mrsLogSeverity::kVerbose:
+      return rtc::LS_VERBOSE;
+    case mrsLogSeverity::kWarning:
+      return rtc::LS_WARNING;
+    case mrsLogSeverity::kError:
+      return rtc::LS_ERROR;
+    case mrsLogSeverity::kInfo:
+    default:
+      return rtc::LS_INFO;
+  }
+}
+
+uint64_t RoundUpToPowerOfTwo(uint32_t value) noexcept {
+  uint64_t result = 2;
+  while (result < std::min(value, kMaxQueueCapacity)) {
+    result <<= 1;
+  }
+  return result;
+}
+
+/// Split a message formatted by |rtc::LogMessage| into its tag, the name of
+/// the source file from the "(file.cc:123): " location prefix, and its text
+/// without that prefix nor the trailing newline. The location may be preceded
+/// by a "[timestamp] " and a "[thread] " prefix, which are discarded too.
+void SplitMessage(const std::string& msg,
+                  std::string& tag,
+                  std::string& text) {
+  size_t begin = 0;
+  while ((begin < msg.size()) && (msg[begin] == '[')) {
+    const size_t end = msg.find("] ", begin);
+    if (end == std::string::npos) {
+      break;
+    }
+    begin = end + 2;
+  }
+  if ((begin < msg.size()) && (msg[begin] == '(')) {
+    const size_t end = msg.find("): ", begin);
+    const size_t colon =
+        (end != std::string::npos ? msg.rfind(':', end) : std::string::npos);
+    if ((colon != std::string::npos) && (colon > begin + 1) &&
+        (msg.find(' ', begin) > colon)) {
+      tag.assign(msg, begin + 1, colon - begin - 1);
+      begin = end + 3;
+    }
+  }
+  size_t end = msg.size();
+  while ((end > begin) && ((msg[end - 1] == '\n') || (msg[end - 1] == '\r'))) {
+    --end;
+  }
+  text.assign(msg, begin, end - begin);
+}
+
+}  // namespace
+
+LogSink::LogSink(const mrsLogSinkConfig& config, MessageCallback callback)
+    : min_severity_(config.min_severity),
+      callback_(callback),
+      mask_(RoundUpToPowerOfTwo(config.queue_capacity) - 1),
+      wake_event_(/* manual_reset = */ false,
+                  /* initially_signaled = */ false) {
+  if (!IsStringNullOrEmpty(config.tag_filter)) {
+    const char* begin = config.tag_filter;
+    while (*begin != '\0') {
+      const char* end = begin;
+      while ((*end != '\0') && (*end != ';')) {
+        ++end;
+      }
+      if (end > begin) {
+        tag_prefixes_.emplace_back(begin, end);
+      }
+      begin = (*end == ';' ? end + 1 : end);
+    }
+  }
+  const uint64_t capacity = mask_ + 1;
+  slots_ = std::make_unique<Slot[]>(static_cast<size_t>(capacity));
+  for (uint64_t i = 0; i < capacity; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+LogSink::~LogSink() {
+  Stop();
+}
+
+void LogSink::Start() {
+  RTC_DCHECK(!thread_.joinable());
+  thread_ = std::thread(&LogSink::Run, this);
+  thread_id_ = thread_.get_id();
+  for (int severity = static_cast<int>(mrsLogSeverity::kError);
+       severity >= static_cast<int>(min_severity_); --severity) {
+    const auto level = static_cast<mrsLogSeverity>(severity);
+    streams_.push_back(std::make_unique<LevelStream>(*this, level));
+    rtc::LogMessage::AddLogToStream(streams_.back().get(),
+                                    ToRtcSeverity(level));
+  }
+}
+
+void LogSink::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  RTC_DCHECK(!IsDeliveryThread());
+  // Once removed, WebRTC doesn't call the sink anymore, so all the messages
+  // are already enqueued.
+  for (auto&& stream : streams_) {
+    rtc::LogMessage::RemoveLogToStream(stream.get());
+  }
+  stopping_.store(true, std::memory_order_release);
+  wake_event_.Set();
+  thread_.join();
+}
+
+void LogSink::OnStreamMessage(const std::string& msg,
+                              mrsLogSeverity severity) noexcept {
+  // The streams of a message are called from the most to the least severe,
+  // and every message reaches the least severe stream last. So a stream of a
+  // lower level than the last one called for the same message object is
+  // called again for that message.
+  const bool same_message =
+      (&msg == last_message_) && (severity < last_severity_);
+  last_message_ = &msg;
+  last_severity_ = severity;
+  if (!same_message) {
+    Enqueue(msg, severity);
+  }
+}
+
+void LogSink::Enqueue(const std::string& msg,
+                      mrsLogSeverity severity) noexcept {
+  try {
+    Entry entry;
+    entry.timestamp_us = rtc::TimeMicros();
+    entry.severity = severity;
+    SplitMessage(msg, entry.tag, entry.message);
+    if (!tag_prefixes_.empty()) {
+      bool matched = false;
+      for (auto&& prefix : tag_prefixes_) {
+        if (entry.tag.compare(0, prefix.size(), prefix) == 0) {
+          matched = true;
+          break;
+        }
+      }
+      if (!matched) {
+        return;
+      }
+    }
+    if (!TryPush(entry)) {
+      dropped_count_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  } catch (...) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  // Only signal the event if the delivery thread was not already woken up.
+  // The release of the exchange makes the entry visible to the delivery
+  // thread when it resets the flag.
+  if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+    wake_event_.Set();
+  }
+}
+
+bool LogSink::TryPush(Entry& entry) noexcept {
+  uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &slots_[pos & mask_];
+    const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const int64_t diff = static_cast<int64_t>(sequence - pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the entry of the previous lap, so the queue is
+      // full.
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->entry.timestamp_us = entry.timestamp_us;
+  slot->entry.severity = entry.severity;
+  slot->entry.tag.swap(entry.tag);
+  slot->entry.message.swap(entry.message);
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool LogSink::TryPop(Entry& entry) noexcept {
+  Slot& slot = slots_[dequeue_pos_ & mask_];
+  const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+  if (static_cast<int64_t>(sequence - (dequeue_pos_ + 1)) < 0) {
+    return false;
+  }
+  entry.timestamp_us = slot.entry.timestamp_us;
+  entry.severity = slot.entry.severity;
+  entry.tag.swap(slot.entry.tag);
+  entry.message.swap(slot.entry.message);
+  slot.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  ++dequeue_pos_;
+  return true;
+}
+
+void LogSink::Drain(Entry& entry) {
+  mrsLogMessage message{};
+  while (TryPop(entry)) {
+    message.timestamp_us = entry.timestamp_us;
+    message.severity = entry.severity;
+    message.tag = entry.tag.c_str();
+    message.message = entry.message.c_str();
+    callback_(&message);
+  }
+
+  // Report the messages dropped since the last report, now that the queue
+  // has room again.
+  const uint64_t dropped = dropped_count_.load(std::memory_order_relaxed);
+  if (dropped > reported_dropped_count_) {
+    rtc::StringBuilder builder;
+    builder << "Dropped " << (dropped - reported_dropped_count_)
+            << " log messages because the queue of the log sink was full.";
+    const std::string text = builder.Release();
+    message.timestamp_us = rtc::TimeMicros();
+    message.severity = mrsLogSeverity::kWarning;
+    message.tag = "log_sink.cpp";
+    message.message = text.c_str();
+    callback_(&message);
+    reported_dropped_count_ = dropped;
+  }
+}
+
+void LogSink::Run() {
+  Entry entry;
+  for (;;) {
+    // Reset the flag before draining, so that any entry enqueued after the
+    // drain signals the event again.
+    wake_pending_.exchange(false, std::memory_order_acq_rel);
+    const bool stopping = stopping_.load(std::memory_order_acquire);
+    Drain(entry);
+    if (stopping) {
+      break;
+    }
+    wake_event_.Wait(rtc::Event::kForever);
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
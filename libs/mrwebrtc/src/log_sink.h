@@ -0,0 +1,160 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rtc_base/event.h"
+#include "rtc_base/logging.h"
+
+#include "callback.h"
+#include "log_sink_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Log sink filtering the messages of WebRTC on the logging thread, and
+/// delivering them to a user callback on a dedicated thread.
+///
+/// Logging threads enqueue messages into a bounded lock-free queue, without
+/// ever blocking on the delivery thread nor on the user callback. If the queue
+/// is full, the message is dropped and counted instead.
+///
+/// WebRTC only reports the severity of the messages to its log streams on
+/// Android, so the sink registers one stream per severity level it accepts,
+/// from the most to the least severe. WebRTC calls the streams of a message in
+/// registration order, so the first stream of the sink called for a message
+/// has the severity of that message, and the next ones are skipped.
+class LogSink {
+ public:
+  using MessageCallback = Callback<const mrsLogMessage*>;
+
+  LogSink(const mrsLogSinkConfig& config, MessageCallback callback);
+
+  /// Stop the sink if not already stopped.
+  ~LogSink();
+
+  /// Start the delivery thread and register the sink with WebRTC.
+  void Start();
+
+  /// Unregister the sink from WebRTC, deliver the messages already enqueued,
+  /// and stop the delivery thread. This must not be called from the delivery
+  /// thread.
+  void Stop();
+
+  /// Check whether the calling thread is the delivery thread of this sink.
+  bool IsDeliveryThread() const noexcept {
+    return (std::this_thread::get_id() == thread_id_);
+  }
+
+  /// Get the total number of messages dropped because the queue was full.
+  uint64_t GetDroppedCount() const noexcept {
+    return dropped_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /// Log stream registered with WebRTC for a single severity level.
+  class LevelStream : public rtc::LogSink {
+   public:
+    LevelStream(LogSink& sink, mrsLogSeverity severity)
+        : sink_(sink), severity_(severity) {}
+    void OnLogMessage(const std::string& msg,
+                      rtc::LoggingSeverity /*severity*/,
+                      const char* /*tag*/) override {
+      sink_.OnStreamMessage(msg, severity_);
+    }
+    void OnLogMessage(const std::string& msg) override {
+      sink_.OnStreamMessage(msg, severity_);
+    }
+
+   private:
+    LogSink& sink_;
+    const mrsLogSeverity severity_;
+  };
+
+  /// Message waiting in the queue.
+  struct Entry {
+    int64_t timestamp_us{0};
+    mrsLogSeverity severity{mrsLogSeverity::kInfo};
+    std::string tag;
+    std::string message;
+  };
+
+  /// Slot of the queue. The sequence number tells whether the slot is free for
+  /// the producer of a given position, or holds the entry for the consumer of
+  /// that position, as in the bounded MPMC queue of Dmitry Vyukov.
+  struct Slot {
+    std::atomic<uint64_t> sequence{0};
+    Entry entry;
+  };
+
+  /// Handle a message received by the stream of the given severity level,
+  /// skipping the messages already received by a stream of a higher level.
+  void OnStreamMessage(const std::string& msg,
+                       mrsLogSeverity severity) noexcept;
+
+  /// Parse, filter and enqueue a message logged by WebRTC.
+  void Enqueue(const std::string& msg, mrsLogSeverity severity) noexcept;
+
+  /// Try to enqueue an entry, or return false if the queue is full.
+  bool TryPush(Entry& entry) noexcept;
+
+  /// Try to dequeue an entry, or return false if the queue is empty. Only the
+  /// delivery thread calls this.
+  bool TryPop(Entry& entry) noexcept;
+
+  /// Deliver all the entries currently in the queue.
+  void Drain(Entry& entry);
+
+  /// Main function of the delivery thread.
+  void Run();
+
+  const mrsLogSeverity min_severity_;
+  MessageCallback callback_;
+
+  /// Streams registered with WebRTC, from the most to the least severe.
+  std::vector<std::unique_ptr<LevelStream>> streams_;
+
+  /// Last message received by the streams, and the severity of the last
+  /// stream which received it. WebRTC calls the streams under its logging
+  /// lock, which serializes the accesses to these. The message is only
+  /// compared by address, to recognize the calls for the same message.
+  const std::string* last_message_{nullptr};
+  mrsLogSeverity last_severity_{mrsLogSeverity::kVerbose};
+
+  /// Tag prefixes of the filter, or empty to accept all tags.
+  std::vector<std::string> tag_prefixes_;
+
+  std::unique_ptr<Slot[]> slots_;
+  const uint64_t mask_;
+  alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+  alignas(64) uint64_t dequeue_pos_{0};
+
+  std::atomic<uint64_t> dropped_count_{0};
+
+  /// Number of dropped messages already reported by a warning message.
+  uint64_t reported_dropped_count_{0};
+
+  /// Wake-up event of the delivery thread. Producers only signal it when
+  /// |wake_pending_| is not already set, to avoid a syscall per message.
+  rtc::Event wake_event_;
+  std::atomic_bool wake_pending_{false};
+
+  std::atomic_bool stopping_{false};
+  std::thread thread_;
+  std::thread::id thread_id_;
+};
+
+/// Stop and destroy the log sinks not destroyed yet by |mrsLogSinkDestroy()|,
+/// except the sink whose callback is calling this, if any.
+void DestroyAllLogSinks() noexcept;
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
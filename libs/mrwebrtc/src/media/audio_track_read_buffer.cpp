@@ -6,6 +6,7 @@
 #include "audio_frame.h"
 #include "audio_frame_observer.h"
 #include "audio_track_read_buffer.h"
+#include "metrics.h"
 #include "peer_connection.h"
 
 namespace Microsoft {
@@ -168,6 +169,7 @@ void AudioTrackReadBuffer::Read(int sampleRate,
         std::unique_lock<std::mutex> lock(frames_mutex_);
         if (frames_.empty()) {  // no more input! fill with sin wave
           lock.unlock();
+          Metrics::Add(MetricCounter::kAudioReadUnderruns);
           constexpr float freq = 2 * 222 * float(M_PI);
           for (int i = 0; i < dstLen; ++i) {
             dst[i] = 0.15f * sinf((freq * (sinwave_iter_ + i)) /
@@ -0,0 +1,416 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "media/base/mediaconstants.h"
+
+#include "media/encoded_frame_recorder.h"
+#include "media/transceiver.h"
+#include "utils.h"
+
+namespace {
+
+/// Message ID for writing the queued frames.
+constexpr uint32_t kMsgWrite = 0;
+
+/// Message ID for the periodic flush of the file and its index.
+constexpr uint32_t kMsgFlush = 1;
+
+/// Size of the IVF file header, in bytes.
+constexpr size_t kIvfFileHeaderSize = 32;
+
+/// Size of the IVF frame header, made of the 32-bit frame size and the 64-bit
+/// presentation timestamp, in bytes.
+constexpr size_t kIvfFrameHeaderSize = 12;
+
+/// Offset of the 32-bit frame count in the IVF file header.
+constexpr long kIvfFrameCountOffset = 24;
+
+/// Magic starting the index file, which includes a format version.
+constexpr char kIndexMagic[8] = {'M', 'R', 'S', 'I', 'V', 'F', 'X', '1'};
+
+/// Size of an index record, in bytes.
+constexpr size_t kIndexRecordSize = 24;
+
+void SetLE16(uint8_t* out, uint16_t value) {
+  out[0] = static_cast<uint8_t>(value);
+  out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void SetLE32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+void SetLE64(uint8_t* out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+/// Get the IVF four-character code of a codec from its SDP name, or null if
+/// the codec cannot be recorded.
+const char* GetIvfFourcc(const char* codec_name) {
+  if (_stricmp(codec_name, cricket::kVp8CodecName) == 0) {
+    return "VP80";
+  }
+  if (_stricmp(codec_name, cricket::kVp9CodecName) == 0) {
+    return "VP90";
+  }
+  if (_stricmp(codec_name, cricket::kH264CodecName) == 0) {
+    return "H264";
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+Result EncodedFrameRecorder::ValidateConfig(
+    const mrsEncodedFrameRecorderConfig& config) {
+  if (IsStringNullOrEmpty(config.path)) {
+    RTC_LOG(LS_ERROR) << "Invalid empty path for encoded frame recorder.";
+    return Result::kInvalidParameter;
+  }
+  if (config.max_queued_bytes == 0) {
+    RTC_LOG(LS_ERROR) << "Invalid zero queue size for encoded frame recorder.";
+    return Result::kOutOfRange;
+  }
+  return Result::kSuccess;
+}
+
+ErrorOr<RefPtr<EncodedFrameRecorder>> EncodedFrameRecorder::Create(
+    RefPtr<GlobalFactory> global_factory,
+    RefPtr<Transceiver> transceiver,
+    const mrsEncodedFrameRecorderConfig& config) {
+  if (transceiver->GetMediaKind() != mrsMediaKind::kVideo) {
+    RTC_LOG(LS_ERROR) << "Cannot record non-video transceiver "
+                      << transceiver->GetName().c_str() << ".";
+    return Error(Result::kInvalidMediaKind);
+  }
+  Result result = ValidateConfig(config);
+  if (result != Result::kSuccess) {
+    return Error(result);
+  }
+  RefPtr<EncodedFrameRecorder> recorder = new EncodedFrameRecorder(
+      std::move(global_factory), std::move(transceiver), config);
+  result = recorder->Start();
+  if (result != Result::kSuccess) {
+    return Error(result);
+  }
+  return recorder;
+}
+
+EncodedFrameRecorder::EncodedFrameRecorder(
+    RefPtr<GlobalFactory> global_factory,
+    RefPtr<Transceiver> transceiver,
+    const mrsEncodedFrameRecorderConfig& config)
+    : TrackedObject(std::move(global_factory),
+                    ObjectType::kEncodedFrameRecorder),
+      path_(config.path),
+      max_queued_bytes_(config.max_queued_bytes),
+      flush_interval_ms_(config.index_flush_interval_ms),
+      transceiver_(std::move(transceiver)),
+      thread_(rtc::Thread::Create()) {
+  thread_->SetName("EncodedFrameRecorder thread", this);
+  thread_->Start();
+}
+
+EncodedFrameRecorder::~EncodedFrameRecorder() {
+  Stop();
+}
+
+Result EncodedFrameRecorder::Start() {
+  file_ = fopen(path_.c_str(), "wb");
+  if (!file_) {
+    RTC_LOG(LS_ERROR) << "Failed to open " << path_.c_str()
+                      << " for recording.";
+    return Result::kInvalidParameter;
+  }
+  const std::string index_path = path_ + ".idx";
+  index_file_ = fopen(index_path.c_str(), "wb");
+  if (!index_file_ ||
+      (fwrite(kIndexMagic, 1, sizeof(kIndexMagic), index_file_) !=
+       sizeof(kIndexMagic))) {
+    RTC_LOG(LS_ERROR) << "Failed to open " << index_path.c_str()
+                      << " for recording.";
+    return Result::kInvalidParameter;
+  }
+
+  // The files are only accessed by the writer thread from now on.
+  if (flush_interval_ms_ > 0) {
+    thread_->PostDelayed(RTC_FROM_HERE, static_cast<int>(flush_interval_ms_),
+                         this, kMsgFlush);
+  }
+  transceiver_->AddEncodedFrameSink(this);
+  return Result::kSuccess;
+}
+
+void EncodedFrameRecorder::Stop() noexcept {
+  RefPtr<Transceiver> transceiver;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+      return;
+    }
+    stopped_ = true;
+    transceiver = std::move(transceiver_);
+  }
+
+  // Once the sink is removed no frame can be queued anymore, so the queue can
+  // be drained for the last time.
+  if (transceiver) {
+    transceiver->RemoveEncodedFrameSink(this);
+  }
+  thread_->Invoke<void>(RTC_FROM_HERE, [this]() {
+    WriteQueuedFrames();
+    CloseFiles();
+  });
+  thread_->Stop();
+}
+
+mrsEncodedFrameRecorderStats EncodedFrameRecorder::GetStats() const noexcept {
+  mrsEncodedFrameRecorderStats stats{};
+  stats.frames_written = frames_written_.load();
+  stats.key_frames_written = key_frames_written_.load();
+  stats.bytes_written = bytes_written_.load();
+  stats.frames_dropped = frames_dropped_.load();
+  stats.peak_queued_bytes = peak_queued_bytes_.load();
+  return stats;
+}
+
+void EncodedFrameRecorder::OnEncodedFrame(
+    const mrsEncodedFrameInfo& frame) noexcept {
+  if ((frame.direction != mrsEncodedFrameDirection::kReceive) ||
+      (frame.media_kind != mrsMediaKind::kVideo) || !frame.data ||
+      (frame.size == 0)) {
+    return;
+  }
+  const bool is_key_frame = (frame.frame_type == mrsEncodedFrameType::kKey);
+  const char* codec_name = (frame.codec_name ? frame.codec_name : "");
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stopped_) {
+    return;
+  }
+
+  // Start recording on the first key frame, which determines the codec of the
+  // file, since IVF cannot hold frames of different codecs.
+  if (codec_name_.empty()) {
+    if (!is_key_frame || (codec_name[0] == '\0')) {
+      return;
+    }
+    codec_name_ = codec_name;
+    fourcc_ = GetIvfFourcc(codec_name);
+    if (!fourcc_) {
+      RTC_LOG(LS_ERROR) << "Cannot record frames of unsupported codec "
+                        << codec_name << " to " << path_.c_str() << ".";
+    }
+  }
+  if (!fourcc_) {
+    return;
+  }
+  if (_stricmp(codec_name, codec_name_.c_str()) != 0) {
+    ++frames_dropped_;
+    waiting_for_key_frame_ = true;
+    return;
+  }
+
+  // Delta frames cannot be decoded without the frames they depend on, so after
+  // any drop skip all frames until the next key frame.
+  if (waiting_for_key_frame_ && !is_key_frame) {
+    ++frames_dropped_;
+    return;
+  }
+  if (queued_bytes_ + frame.size > max_queued_bytes_) {
+    ++frames_dropped_;
+    waiting_for_key_frame_ = true;
+    return;
+  }
+  waiting_for_key_frame_ = false;
+
+  QueuedFrame queued_frame;
+  queued_frame.data.assign(frame.data, frame.data + frame.size);
+  queued_frame.timestamp_us = frame.timestamp_us;
+  queued_frame.is_key_frame = is_key_frame;
+  queue_.push_back(std::move(queued_frame));
+  queued_bytes_ += frame.size;
+  if (queued_bytes_ > peak_queued_bytes_.load()) {
+    peak_queued_bytes_ = queued_bytes_;
+  }
+
+  // Post a single write message for any number of queued frames, so that a
+  // slow disk does not also flood the message queue of the writer thread.
+  if (!write_pending_) {
+    write_pending_ = true;
+    thread_->Post(RTC_FROM_HERE, this, kMsgWrite);
+  }
+}
+
+void EncodedFrameRecorder::OnMessage(rtc::Message* msg) {
+  RTC_DCHECK(thread_->IsCurrent());
+  switch (msg->message_id) {
+    case kMsgWrite:
+      WriteQueuedFrames();
+      break;
+    case kMsgFlush:
+      Flush();
+      thread_->PostDelayed(RTC_FROM_HERE, static_cast<int>(flush_interval_ms_),
+                           this, kMsgFlush);
+      break;
+    default:
+      RTC_NOTREACHED();
+      break;
+  }
+}
+
+void EncodedFrameRecorder::WriteQueuedFrames() {
+  RTC_DCHECK(thread_->IsCurrent());
+  for (;;) {
+    QueuedFrame frame;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (queue_.empty()) {
+        write_pending_ = false;
+        return;
+      }
+      frame = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    WriteFrame(frame.data, frame.timestamp_us, frame.is_key_frame);
+    {
+      // Account for the frame until written, to bound the memory used by the
+      // frames in flight and not only by the queued ones.
+      std::lock_guard<std::mutex> lock(mutex_);
+      queued_bytes_ -= frame.data.size();
+    }
+  }
+}
+
+bool EncodedFrameRecorder::WriteHeader(
+    const std::vector<uint8_t>& first_frame) {
+  RTC_DCHECK(thread_->IsCurrent());
+  std::string codec_name;
+  const char* fourcc;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    codec_name = codec_name_;
+    fourcc = fourcc_;
+  }
+  int width = 0;
+  int height = 0;
+  EncodedFrameTap::GetVideoKeyFrameSize(codec_name, first_frame.data(),
+                                        first_frame.size(), width, height);
+
+  // The timebase is 1/1000000, so timestamps are in microseconds.
+  uint8_t header[kIvfFileHeaderSize]{};
+  memcpy(header, "DKIF", 4);
+  SetLE16(header + 4, 0);  // version
+  SetLE16(header + 6, static_cast<uint16_t>(kIvfFileHeaderSize));
+  memcpy(header + 8, fourcc, 4);
+  SetLE16(header + 12, static_cast<uint16_t>(width));
+  SetLE16(header + 14, static_cast<uint16_t>(height));
+  SetLE32(header + 16, 1000000);  // timebase denominator
+  SetLE32(header + 20, 1);        // timebase numerator
+  SetLE32(header + kIvfFrameCountOffset, 0);
+  if (fwrite(header, 1, sizeof(header), file_) != sizeof(header)) {
+    return false;
+  }
+  file_offset_ = kIvfFileHeaderSize;
+  header_written_ = true;
+  return true;
+}
+
+void EncodedFrameRecorder::WriteFrame(const std::vector<uint8_t>& data,
+                                      int64_t timestamp_us,
+                                      bool is_key_frame) {
+  RTC_DCHECK(thread_->IsCurrent());
+  if (!file_) {
+    // Closed after a write error
+    ++frames_dropped_;
+    return;
+  }
+  if (!header_written_) {
+    if (!WriteHeader(data)) {
+      RTC_LOG(LS_ERROR) << "Failed to write to " << path_.c_str()
+                        << ", recording stopped.";
+      CloseFiles();
+      ++frames_dropped_;
+      return;
+    }
+    first_timestamp_us_ = timestamp_us;
+  }
+  const int64_t pts_us = timestamp_us - first_timestamp_us_;
+  uint8_t header[kIvfFrameHeaderSize];
+  SetLE32(header, static_cast<uint32_t>(data.size()));
+  SetLE64(header + 4, static_cast<uint64_t>(pts_us));
+  if ((fwrite(header, 1, sizeof(header), file_) != sizeof(header)) ||
+      (fwrite(data.data(), 1, data.size(), file_) != data.size())) {
+    RTC_LOG(LS_ERROR) << "Failed to write to " << path_.c_str()
+                      << ", recording stopped.";
+    CloseFiles();
+    ++frames_dropped_;
+    return;
+  }
+  if (is_key_frame) {
+    pending_index_.push_back(IndexEntry{file_offset_, pts_us, frame_count_});
+    ++key_frames_written_;
+  }
+  file_offset_ += kIvfFrameHeaderSize + data.size();
+  ++frame_count_;
+  ++frames_written_;
+  bytes_written_ += data.size();
+}
+
+void EncodedFrameRecorder::Flush() {
+  RTC_DCHECK(thread_->IsCurrent());
+  if (!file_ || !index_file_) {
+    return;
+  }
+  for (const IndexEntry& entry : pending_index_) {
+    uint8_t record[kIndexRecordSize]{};
+    SetLE64(record, entry.offset);
+    SetLE64(record + 8, static_cast<uint64_t>(entry.pts_us));
+    SetLE32(record + 16, entry.frame_index);
+    fwrite(record, 1, sizeof(record), index_file_);
+  }
+  pending_index_.clear();
+  fflush(index_file_);
+
+  // Update the frame count in place, then resume writing at the end of file.
+  if (header_written_) {
+    fpos_t end;
+    if (fgetpos(file_, &end) == 0) {
+      uint8_t count[4];
+      SetLE32(count, frame_count_);
+      fseek(file_, kIvfFrameCountOffset, SEEK_SET);
+      fwrite(count, 1, sizeof(count), file_);
+      fsetpos(file_, &end);
+    }
+  }
+  fflush(file_);
+}
+
+void EncodedFrameRecorder::CloseFiles() {
+  RTC_DCHECK(thread_->IsCurrent());
+  Flush();
+  if (file_) {
+    fclose(file_);
+    file_ = nullptr;
+  }
+  if (index_file_) {
+    fclose(index_file_);
+    index_file_ = nullptr;
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,175 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/thread.h"
+
+#include "encoded_frame_recorder_interop.h"
+#include "media/encoded_frame_tap.h"
+#include "mrs_errors.h"
+#include "refptr.h"
+#include "tracked_object.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class Transceiver;
+
+/// Recorder writing the encoded video frames received by a transceiver into
+/// an IVF file, without decoding them, with a sidecar index of key frames.
+///
+/// Frames are copied by the encoded frame tap of the transceiver into a write
+/// queue bounded in size, and written on a dedicated thread, so that the disk
+/// latency does not stall the receive path. The file header and index are
+/// flushed periodically, so an interrupted recording is readable up to the
+/// last flush.
+///
+/// The index file starts with the 8-byte magic "MRSIVFX1", followed by one
+/// 24-byte record per key frame, each made of the little-endian 64-bit offset
+/// of the frame header in the IVF file, the 64-bit presentation timestamp in
+/// microseconds, and the 32-bit frame index, padded to 24 bytes.
+class EncodedFrameRecorder : public TrackedObject,
+                             public EncodedFrameSink,
+                             public rtc::MessageHandler {
+ public:
+  /// Check that the given configuration is valid for a recorder.
+  static Result ValidateConfig(const mrsEncodedFrameRecorderConfig& config);
+
+  /// Create a recorder for the video transceiver |transceiver|, open its files
+  /// and start recording.
+  static ErrorOr<RefPtr<EncodedFrameRecorder>> Create(
+      RefPtr<GlobalFactory> global_factory,
+      RefPtr<Transceiver> transceiver,
+      const mrsEncodedFrameRecorderConfig& config);
+
+  ~EncodedFrameRecorder() override;
+
+  std::string GetName() const override { return path_; }
+
+  /// Stop recording, write all queued frames, and finalize the files.
+  void Stop() noexcept;
+
+  /// Get the current statistics of the recorder.
+  mrsEncodedFrameRecorderStats GetStats() const noexcept;
+
+  //
+  // EncodedFrameSink
+  //
+
+  void OnEncodedFrame(const mrsEncodedFrameInfo& frame) noexcept override;
+
+  //
+  // MessageHandler
+  //
+
+  void OnMessage(rtc::Message* msg) override;
+
+ protected:
+  EncodedFrameRecorder(RefPtr<GlobalFactory> global_factory,
+                       RefPtr<Transceiver> transceiver,
+                       const mrsEncodedFrameRecorderConfig& config);
+
+  /// Open the IVF file and its index, and start the writer thread.
+  Result Start();
+
+  /// Write all the queued frames. Only called on |thread_|.
+  void WriteQueuedFrames();
+
+  /// Write the IVF file header, using the first frame of the recording to
+  /// determine the resolution. Only called on |thread_|.
+  bool WriteHeader(const std::vector<uint8_t>& first_frame);
+
+  /// Write a single frame. Only called on |thread_|.
+  void WriteFrame(const std::vector<uint8_t>& data,
+                  int64_t timestamp_us,
+                  bool is_key_frame);
+
+  /// Flush the frames to disk, append the new key frames to the index, and
+  /// update the frame count of the file header. Only called on |thread_|.
+  void Flush();
+
+  /// Flush and close the file and its index. Only called on |thread_|.
+  void CloseFiles();
+
+ private:
+  struct QueuedFrame {
+    std::vector<uint8_t> data;
+    int64_t timestamp_us;
+    bool is_key_frame;
+  };
+
+  /// Index entry of a key frame not flushed to the index file yet.
+  struct IndexEntry {
+    uint64_t offset;
+    int64_t pts_us;
+    uint32_t frame_index;
+  };
+
+  const std::string path_;
+  const uint32_t max_queued_bytes_;
+  const uint32_t flush_interval_ms_;
+
+  /// Transceiver the recorder is attached to, until stopped.
+  RefPtr<Transceiver> transceiver_;
+
+  /// Thread writing the frames to disk.
+  std::unique_ptr<rtc::Thread> thread_;
+
+  //
+  // Queue, shared by the receive path and the writer thread.
+  //
+
+  std::deque<QueuedFrame> queue_ RTC_GUARDED_BY(mutex_);
+  size_t queued_bytes_ RTC_GUARDED_BY(mutex_){0};
+
+  /// Whether a write message is pending on |thread_|.
+  bool write_pending_ RTC_GUARDED_BY(mutex_){false};
+
+  /// Whether delta frames are dropped until the next key frame, because no
+  /// key frame was received yet or because a frame was dropped.
+  bool waiting_for_key_frame_ RTC_GUARDED_BY(mutex_){true};
+
+  /// SDP name of the codec of the first key frame, which all frames must use.
+  std::string codec_name_ RTC_GUARDED_BY(mutex_);
+
+  /// IVF four-character code of |codec_name_|, or null if not supported.
+  const char* fourcc_ RTC_GUARDED_BY(mutex_){nullptr};
+
+  bool stopped_ RTC_GUARDED_BY(mutex_){false};
+  std::mutex mutex_;
+
+  //
+  // Writer state, only accessed on |thread_| once started.
+  //
+
+  FILE* file_{nullptr};
+  FILE* index_file_{nullptr};
+  bool header_written_{false};
+  uint64_t file_offset_{0};
+  uint32_t frame_count_{0};
+  int64_t first_timestamp_us_{0};
+  std::vector<IndexEntry> pending_index_;
+
+  //
+  // Statistics
+  //
+
+  std::atomic<uint64_t> frames_written_{0};
+  std::atomic<uint64_t> key_frames_written_{0};
+  std::atomic<uint64_t> bytes_written_{0};
+  std::atomic<uint64_t> frames_dropped_{0};
+  std::atomic<uint64_t> peak_queued_bytes_{0};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,352 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+
+#include "media/base/mediaconstants.h"
+#include "rtc_base/timeutils.h"
+
+#include "encoded_frame_tap.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Passthrough frame encryptor forwarding the encoded frames of an RTP sender
+/// to a tap.
+class SenderTap : public webrtc::FrameEncryptorInterface {
+ public:
+  explicit SenderTap(rtc::scoped_refptr<EncodedFrameTap> tap)
+      : tap_(std::move(tap)) {}
+
+  int Encrypt(cricket::MediaType /*media_type*/,
+              uint32_t ssrc,
+              rtc::ArrayView<const uint8_t> /*additional_data*/,
+              rtc::ArrayView<const uint8_t> frame,
+              rtc::ArrayView<uint8_t> encrypted_frame,
+              size_t* bytes_written) override {
+    if (encrypted_frame.size() < frame.size()) {
+      return -1;
+    }
+    tap_->OnFrame(mrsEncodedFrameDirection::kSend, ssrc, nullptr, frame);
+    memcpy(encrypted_frame.data(), frame.data(), frame.size());
+    *bytes_written = frame.size();
+    return 0;
+  }
+
+  size_t GetMaxCiphertextByteSize(cricket::MediaType /*media_type*/,
+                                  size_t frame_size) override {
+    return frame_size;
+  }
+
+ private:
+  rtc::scoped_refptr<EncodedFrameTap> tap_;
+};
+
+/// Passthrough frame decryptor forwarding the encoded frames of an RTP
+/// receiver to a tap.
+class ReceiverTap : public webrtc::FrameDecryptorInterface {
+ public:
+  explicit ReceiverTap(rtc::scoped_refptr<EncodedFrameTap> tap)
+      : tap_(std::move(tap)) {}
+
+  int Decrypt(cricket::MediaType /*media_type*/,
+              const std::vector<uint32_t>& csrcs,
+              rtc::ArrayView<const uint8_t> /*additional_data*/,
+              rtc::ArrayView<const uint8_t> encrypted_frame,
+              rtc::ArrayView<uint8_t> frame,
+              size_t* bytes_written) override {
+    if (frame.size() < encrypted_frame.size()) {
+      return -1;
+    }
+    tap_->OnFrame(mrsEncodedFrameDirection::kReceive, 0, &csrcs,
+                  encrypted_frame);
+    memcpy(frame.data(), encrypted_frame.data(), encrypted_frame.size());
+    *bytes_written = encrypted_frame.size();
+    return 0;
+  }
+
+  size_t GetMaxPlaintextByteSize(cricket::MediaType /*media_type*/,
+                                 size_t encrypted_frame_size) override {
+    return encrypted_frame_size;
+  }
+
+ private:
+  rtc::scoped_refptr<EncodedFrameTap> tap_;
+};
+
+/// Minimal MSB-first bit reader for parsing bitstream headers.
+class BitReader {
+ public:
+  BitReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  /// Read the next bit into |bit|, or return |false| if none is left.
+  bool ReadBit(uint32_t& bit) {
+    if (offset_ >= size_ * 8) {
+      return false;
+    }
+    bit = (data_[offset_ / 8] >> (7 - (offset_ % 8))) & 0x1;
+    ++offset_;
+    return true;
+  }
+
+  /// Read the next |count| bits, up to 32, into |value|, or return |false| if
+  /// not enough bits are left.
+  bool ReadBits(int count, uint32_t& value) {
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+      uint32_t bit;
+      if (!ReadBit(bit)) {
+        return false;
+      }
+      value = (value << 1) | bit;
+    }
+    return true;
+  }
+
+ private:
+  const uint8_t* const data_;
+  const size_t size_;
+  size_t offset_ = 0;
+};
+
+/// Parse the VP9 uncompressed header; see the VP9 bitstream specification,
+/// section 6.2.
+mrsEncodedFrameType GetVp9FrameType(const uint8_t* data, size_t size) {
+  BitReader reader(data, size);
+  uint32_t marker_hi, marker_lo, profile_lo, profile_hi;
+  if (!reader.ReadBit(marker_hi) || !reader.ReadBit(marker_lo) ||
+      (marker_hi != 1) || (marker_lo != 0) || !reader.ReadBit(profile_lo) ||
+      !reader.ReadBit(profile_hi)) {
+    return mrsEncodedFrameType::kUnknown;
+  }
+  uint32_t bit;
+  if ((profile_hi == 1) && (profile_lo == 1) && !reader.ReadBit(bit)) {
+    return mrsEncodedFrameType::kUnknown;  // reserved_zero
+  }
+  uint32_t show_existing_frame, frame_type;
+  if (!reader.ReadBit(show_existing_frame)) {
+    return mrsEncodedFrameType::kUnknown;
+  }
+  if (show_existing_frame) {
+    return mrsEncodedFrameType::kDelta;
+  }
+  if (!reader.ReadBit(frame_type)) {
+    return mrsEncodedFrameType::kUnknown;
+  }
+  return (frame_type == 0 ? mrsEncodedFrameType::kKey
+                          : mrsEncodedFrameType::kDelta);
+}
+
+/// Parse the resolution of a VP9 key frame from its uncompressed header; see
+/// the VP9 bitstream specification, sections 6.2 and 7.2.
+bool GetVp9KeyFrameSize(const uint8_t* data,
+                        size_t size,
+                        int& width,
+                        int& height) {
+  constexpr uint32_t kSyncCode = 0x498342;
+  constexpr uint32_t kColorSpaceRgb = 7;
+  BitReader reader(data, size);
+  uint32_t marker, profile_lo, profile_hi, bit;
+  if (!reader.ReadBits(2, marker) || (marker != 2) ||
+      !reader.ReadBit(profile_lo) || !reader.ReadBit(profile_hi)) {
+    return false;
+  }
+  const uint32_t profile = (profile_hi << 1) | profile_lo;
+  if ((profile == 3) && !reader.ReadBit(bit)) {
+    return false;  // reserved_zero
+  }
+  uint32_t show_existing_frame, frame_type, sync_code;
+  if (!reader.ReadBit(show_existing_frame) || show_existing_frame ||
+      !reader.ReadBit(frame_type) || (frame_type != 0) ||
+      !reader.ReadBit(bit) ||  // show_frame
+      !reader.ReadBit(bit) ||  // error_resilient_mode
+      !reader.ReadBits(24, sync_code) || (sync_code != kSyncCode)) {
+    return false;
+  }
+  // color_config()
+  if ((profile >= 2) && !reader.ReadBit(bit)) {
+    return false;  // ten_or_twelve_bit
+  }
+  uint32_t color_space;
+  if (!reader.ReadBits(3, color_space)) {
+    return false;
+  }
+  if (color_space != kColorSpaceRgb) {
+    if (!reader.ReadBit(bit)) {
+      return false;  // color_range
+    }
+    if ((profile == 1) || (profile == 3)) {
+      uint32_t subsampling;
+      if (!reader.ReadBits(3, subsampling)) {
+        return false;  // subsampling_x, subsampling_y, reserved_zero
+      }
+    }
+  } else if (((profile == 1) || (profile == 3)) && !reader.ReadBit(bit)) {
+    return false;  // reserved_zero
+  }
+  // frame_size()
+  uint32_t width_minus_1, height_minus_1;
+  if (!reader.ReadBits(16, width_minus_1) ||
+      !reader.ReadBits(16, height_minus_1)) {
+    return false;
+  }
+  width = static_cast<int>(width_minus_1) + 1;
+  height = static_cast<int>(height_minus_1) + 1;
+  return true;
+}
+
+/// Scan the NAL units of an H.264 access unit in Annex B format for an IDR
+/// slice.
+mrsEncodedFrameType GetH264FrameType(const uint8_t* data, size_t size) {
+  constexpr uint8_t kNaluTypeIdr = 5;
+  bool has_nalu = false;
+  for (size_t i = 0; i + 3 < size; ++i) {
+    if ((data[i] == 0) && (data[i + 1] == 0) && (data[i + 2] == 1)) {
+      has_nalu = true;
+      if ((data[i + 3] & 0x1F) == kNaluTypeIdr) {
+        return mrsEncodedFrameType::kKey;
+      }
+      i += 2;
+    }
+  }
+  return (has_nalu ? mrsEncodedFrameType::kDelta
+                   : mrsEncodedFrameType::kUnknown);
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+rtc::scoped_refptr<EncodedFrameTap> EncodedFrameTap::Create(
+    mrsMediaKind kind) {
+  return new rtc::RefCountedObject<EncodedFrameTap>(kind);
+}
+
+EncodedFrameTap::EncodedFrameTap(mrsMediaKind kind) : kind_(kind) {}
+
+void EncodedFrameTap::SetCallback(FrameCallback&& callback) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  callback_ = std::move(callback);
+}
+
+void EncodedFrameTap::AddSink(EncodedFrameSink* sink) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (std::find(sinks_.begin(), sinks_.end(), sink) == sinks_.end()) {
+    sinks_.push_back(sink);
+  }
+}
+
+void EncodedFrameTap::RemoveSink(EncodedFrameSink* sink) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sinks_.erase(std::remove(sinks_.begin(), sinks_.end(), sink), sinks_.end());
+}
+
+void EncodedFrameTap::SetCodecName(mrsEncodedFrameDirection direction,
+                                   std::string codec_name) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (direction == mrsEncodedFrameDirection::kSend) {
+    send_codec_name_ = std::move(codec_name);
+  } else {
+    receive_codec_name_ = std::move(codec_name);
+  }
+}
+
+rtc::scoped_refptr<webrtc::FrameEncryptorInterface>
+EncodedFrameTap::CreateSenderTap() {
+  return new rtc::RefCountedObject<SenderTap>(this);
+}
+
+rtc::scoped_refptr<webrtc::FrameDecryptorInterface>
+EncodedFrameTap::CreateReceiverTap() {
+  return new rtc::RefCountedObject<ReceiverTap>(this);
+}
+
+mrsEncodedFrameType EncodedFrameTap::GetVideoFrameType(
+    const std::string& codec_name,
+    const uint8_t* data,
+    size_t size) noexcept {
+  if (size == 0) {
+    return mrsEncodedFrameType::kUnknown;
+  }
+  if (_stricmp(codec_name.c_str(), cricket::kVp8CodecName) == 0) {
+    // RFC 6386 section 9.1, inverse key frame flag
+    return ((data[0] & 0x01) == 0 ? mrsEncodedFrameType::kKey
+                                  : mrsEncodedFrameType::kDelta);
+  }
+  if (_stricmp(codec_name.c_str(), cricket::kVp9CodecName) == 0) {
+    return GetVp9FrameType(data, size);
+  }
+  if (_stricmp(codec_name.c_str(), cricket::kH264CodecName) == 0) {
+    return GetH264FrameType(data, size);
+  }
+  return mrsEncodedFrameType::kUnknown;
+}
+
+bool EncodedFrameTap::GetVideoKeyFrameSize(const std::string& codec_name,
+                                           const uint8_t* data,
+                                           size_t size,
+                                           int& width,
+                                           int& height) noexcept {
+  if (_stricmp(codec_name.c_str(), cricket::kVp8CodecName) == 0) {
+    // RFC 6386 section 9.1, key frame start code followed by the 14-bit
+    // dimensions with their 2-bit scaling factors.
+    if ((size < 10) || ((data[0] & 0x01) != 0) || (data[3] != 0x9D) ||
+        (data[4] != 0x01) || (data[5] != 0x2A)) {
+      return false;
+    }
+    width = (data[6] | (data[7] << 8)) & 0x3FFF;
+    height = (data[8] | (data[9] << 8)) & 0x3FFF;
+    return true;
+  }
+  if (_stricmp(codec_name.c_str(), cricket::kVp9CodecName) == 0) {
+    return GetVp9KeyFrameSize(data, size, width, height);
+  }
+  return false;
+}
+
+void EncodedFrameTap::OnFrame(mrsEncodedFrameDirection direction,
+                              uint32_t ssrc,
+                              const std::vector<uint32_t>* csrcs,
+                              rtc::ArrayView<const uint8_t> frame) noexcept {
+  // Deliver under lock, so that once |SetCallback()| or |RemoveSink()|
+  // returns the previous callback or the sink is guaranteed not to be called
+  // anymore.
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!callback_ && sinks_.empty()) {
+    return;
+  }
+  const std::string& codec_name =
+      (direction == mrsEncodedFrameDirection::kSend ? send_codec_name_
+                                                    : receive_codec_name_);
+  mrsEncodedFrameInfo info{};
+  info.direction = direction;
+  info.media_kind = kind_;
+  info.frame_type =
+      (kind_ == mrsMediaKind::kVideo
+           ? GetVideoFrameType(codec_name, frame.data(), frame.size())
+           : mrsEncodedFrameType::kUnknown);
+  info.codec_name = (codec_name.empty() ? nullptr : codec_name.c_str());
+  info.ssrc = ssrc;
+  if (csrcs && !csrcs->empty()) {
+    info.csrcs = csrcs->data();
+    info.csrc_count = static_cast<uint32_t>(csrcs->size());
+  }
+  info.timestamp_us = rtc::TimeMicros();
+  info.data = frame.data();
+  info.size = static_cast<uint32_t>(frame.size());
+  callback_(&info);
+  for (EncodedFrameSink* sink : sinks_) {
+    sink->OnEncodedFrame(info);
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "api/crypto/framedecryptorinterface.h"
+#include "api/crypto/frameencryptorinterface.h"
+#include "rtc_base/refcount.h"
+
+#include "callback.h"
+#include "transceiver_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Internal consumer of the encoded frames of a tap, invoked in addition to the
+/// interop callback.
+class EncodedFrameSink {
+ public:
+  virtual ~EncodedFrameSink() = default;
+
+  /// Consume an encoded frame, whose data is only valid during the call. This
+  /// is invoked under the lock of the tap, so must return quickly.
+  virtual void OnEncodedFrame(const mrsEncodedFrameInfo& frame) noexcept = 0;
+};
+
+/// Interception point for the encoded frames sent and received by a
+/// transceiver, delivering them to an interop callback without altering them.
+///
+/// WebRTC M71 has no frame transformer API, so the tap is installed on the RTP
+/// sender and receiver as a passthrough frame encryptor and decryptor, which
+/// see the encoded payload of each frame before packetization and after
+/// depacketization respectively. The tap itself is shared by the transceiver
+/// and the media streams, which may outlive it.
+class EncodedFrameTap : public rtc::RefCountInterface {
+ public:
+  using FrameCallback = Callback<const mrsEncodedFrameInfo*>;
+
+  /// Create a new tap for a transceiver of media kind |kind|.
+  static rtc::scoped_refptr<EncodedFrameTap> Create(mrsMediaKind kind);
+
+  /// Register the callback invoked for each frame, or clear it with an empty
+  /// callback. Once this returns, the previous callback is guaranteed not to be
+  /// invoked anymore.
+  void SetCallback(FrameCallback&& callback) noexcept;
+
+  /// Add an internal sink receiving all the frames. Adding a sink twice has no
+  /// effect.
+  void AddSink(EncodedFrameSink* sink) noexcept;
+
+  /// Remove a sink added with |AddSink()|. Once this returns, the sink is
+  /// guaranteed not to be invoked anymore.
+  void RemoveSink(EncodedFrameSink* sink) noexcept;
+
+  /// Set the SDP name of the codec negotiated in direction |direction|, used
+  /// to determine the type of the video frames.
+  void SetCodecName(mrsEncodedFrameDirection direction,
+                    std::string codec_name) noexcept;
+
+  /// Create a frame encryptor forwarding to this tap, to install on an RTP
+  /// sender. The encryptor keeps the tap alive.
+  rtc::scoped_refptr<webrtc::FrameEncryptorInterface> CreateSenderTap();
+
+  /// Create a frame decryptor forwarding to this tap, to install on an RTP
+  /// receiver. The decryptor keeps the tap alive.
+  rtc::scoped_refptr<webrtc::FrameDecryptorInterface> CreateReceiverTap();
+
+  /// Determine the type of a video frame of codec |codec_name| by parsing the
+  /// start of its bitstream. Only VP8, VP9 and H.264 are recognized.
+  static mrsEncodedFrameType GetVideoFrameType(const std::string& codec_name,
+                                               const uint8_t* data,
+                                               size_t size) noexcept;
+
+  /// Get the resolution of a video key frame of codec |codec_name| by parsing
+  /// the start of its bitstream. Only VP8 and VP9 are recognized. Return
+  /// |false| if the resolution could not be determined.
+  static bool GetVideoKeyFrameSize(const std::string& codec_name,
+                                   const uint8_t* data,
+                                   size_t size,
+                                   int& width,
+                                   int& height) noexcept;
+
+  /// Deliver a frame to the registered callback, if any.
+  void OnFrame(mrsEncodedFrameDirection direction,
+               uint32_t ssrc,
+               const std::vector<uint32_t>* csrcs,
+               rtc::ArrayView<const uint8_t> frame) noexcept;
+
+ protected:
+  explicit EncodedFrameTap(mrsMediaKind kind);
+
+ private:
+  const mrsMediaKind kind_;
+
+  /// Interop callback invoked for each frame. Frames are delivered under lock,
+  /// which serializes the send and receive paths.
+  FrameCallback callback_ RTC_GUARDED_BY(mutex_);
+  std::vector<EncodedFrameSink*> sinks_ RTC_GUARDED_BY(mutex_);
+  std::string send_codec_name_ RTC_GUARDED_BY(mutex_);
+  std::string receive_codec_name_ RTC_GUARDED_BY(mutex_);
+  std::mutex mutex_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,131 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "media/base/mediaconstants.h"
+#include "rtc_base/timeutils.h"
+
+#include "encoded_video_track_source.h"
+#include "interop/global_factory.h"
+#include "local_video_track.h"
+#include "shared_video_encoder.h"
+#include "utils.h"
+
+namespace {
+
+/// Maximum resolution of an encoded frame, in pixels per side.
+constexpr uint32_t kMaxFrameSize = 16384;
+
+/// Forward the key frame requests of the senders to the shared encoder.
+void MRS_CALL OnEncoderKeyFrameRequested(void* user_data) {
+  using Microsoft::MixedReality::WebRTC::SharedVideoEncoder;
+  static_cast<SharedVideoEncoder*>(user_data)->RequestKeyFrame();
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+Result EncodedVideoTrackSource::ValidateConfig(
+    const mrsEncodedVideoTrackSourceInitConfig& config) {
+  if (IsStringNullOrEmpty(config.codec_name)) {
+    RTC_LOG(LS_ERROR) << "Invalid empty codec name for encoded video source.";
+    return Result::kInvalidParameter;
+  }
+  if ((_stricmp(config.codec_name, cricket::kVp8CodecName) != 0) &&
+      (_stricmp(config.codec_name, cricket::kVp9CodecName) != 0) &&
+      (_stricmp(config.codec_name, cricket::kH264CodecName) != 0)) {
+    RTC_LOG(LS_ERROR) << "Unsupported codec " << config.codec_name
+                      << " for encoded video source.";
+    return Result::kUnsupported;
+  }
+  return Result::kSuccess;
+}
+
+EncodedVideoTrackSource::EncodedVideoTrackSource(
+    RefPtr<GlobalFactory> global_factory,
+    const mrsEncodedVideoTrackSourceInitConfig& config)
+    : TrackedObject(std::move(global_factory),
+                    ObjectType::kEncodedVideoTrackSource),
+      adapter_(new rtc::RefCountedObject<detail::EncodedTrackSourceAdapter>()),
+      codec_type_(webrtc::PayloadStringToCodecType(config.codec_name)),
+      name_(IsStringNullOrEmpty(config.name) ? "encoded_video_source"
+                                             : config.name) {}
+
+EncodedVideoTrackSource::~EncodedVideoTrackSource() {
+  // The adapter may outlive this object, since the video tracks reference it.
+  adapter_->SetEncoderKeyFrameRequestedCallback({});
+  adapter_->SetKeyFrameRequestedCallback({});
+  encoder_.reset();
+}
+
+ErrorOr<RefPtr<EncodedVideoTrackSource>>
+EncodedVideoTrackSource::CreateFromTrack(
+    RefPtr<GlobalFactory> global_factory,
+    RefPtr<LocalVideoTrack> track,
+    const mrsSharedVideoEncoderConfig& config) {
+  const Result result = SharedVideoEncoder::ValidateConfig(config);
+  if (result != Result::kSuccess) {
+    return Error(result);
+  }
+  mrsEncodedVideoTrackSourceInitConfig source_config{};
+  source_config.codec_name = config.codec_name;
+  source_config.name = config.name;
+  RefPtr<EncodedVideoTrackSource> source =
+      new EncodedVideoTrackSource(global_factory, source_config);
+  auto encoder = SharedVideoEncoder::Create(*global_factory, std::move(track),
+                                            *source, config);
+  if (!encoder.ok()) {
+    return Error(encoder.error().result());
+  }
+  source->encoder_ = std::move(encoder.value());
+  source->adapter_->SetEncoderKeyFrameRequestedCallback(
+      {&OnEncoderKeyFrameRequested, source->encoder_.get()});
+  return source;
+}
+
+Result EncodedVideoTrackSource::PushFrame(
+    const mrsEncodedVideoFrame& frame) noexcept {
+  if (!frame.data || (frame.size == 0)) {
+    RTC_LOG(LS_ERROR) << "Invalid empty encoded video frame.";
+    return Result::kInvalidParameter;
+  }
+  if ((frame.width == 0) || (frame.width > kMaxFrameSize) ||
+      (frame.height == 0) || (frame.height > kMaxFrameSize)) {
+    RTC_LOG(LS_ERROR) << "Invalid encoded video frame resolution "
+                      << frame.width << "x" << frame.height << ".";
+    return Result::kOutOfRange;
+  }
+  const bool is_key_frame = (frame.is_key_frame != mrsBool::kFalse);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_key_frame && !has_key_frame_) {
+      RTC_LOG(LS_ERROR) << "Encoded video source " << name_.c_str()
+                        << " cannot start with a delta frame.";
+      return Result::kInvalidOperation;
+    }
+    has_key_frame_ = true;
+  }
+
+  // The buffer is shared by all the tracks and their senders, so the payload
+  // is copied once here, and not per peer.
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer(
+      new rtc::RefCountedObject<EncodedVideoFrameBuffer>(
+          codec_type_, static_cast<int>(frame.width),
+          static_cast<int>(frame.height), is_key_frame, frame.data, frame.size,
+          adapter_));
+  const int64_t timestamp_us =
+      (frame.timestamp_us != 0 ? frame.timestamp_us : rtc::TimeMicros());
+  adapter_->DispatchFrame(
+      webrtc::VideoFrame(buffer, webrtc::kVideoRotation_0, timestamp_us));
+  return Result::kSuccess;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include "media/base/adaptedvideotracksource.h"
+
+#include "callback.h"
+#include "encoded_video_track_source_interop.h"
+#include "media/passthrough_video_encoder_factory.h"
+#include "mrs_errors.h"
+#include "refptr.h"
+#include "tracked_object.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace detail {
+
+/// Adapter to bridge an encoded video track source to the underlying core
+/// implementation. Frames are dispatched as-is to the sinks, without the
+/// adaptation to the sink wants the base class performs for raw sources, since
+/// encoded frames cannot be scaled.
+class EncodedTrackSourceAdapter : public rtc::AdaptedVideoTrackSource,
+                                  public KeyFrameRequestSink {
+ public:
+  using KeyFrameRequestedCallback = Callback<>;
+
+  void DispatchFrame(const webrtc::VideoFrame& frame) { OnFrame(frame); }
+
+  void SetKeyFrameRequestedCallback(KeyFrameRequestedCallback&& callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = std::move(callback);
+  }
+
+  /// Set the callback of the shared encoder feeding the source, if any, which
+  /// is invoked in addition to the callback of the application.
+  void SetEncoderKeyFrameRequestedCallback(
+      KeyFrameRequestedCallback&& callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    encoder_callback_ = std::move(callback);
+  }
+
+  // KeyFrameRequestSink
+  void OnKeyFrameRequested() noexcept override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    encoder_callback_();
+    callback_();
+  }
+
+  // VideoTrackSourceInterface
+  bool is_screencast() const override { return false; }
+  absl::optional<bool> needs_denoising() const override { return false; }
+
+  // MediaSourceInterface
+  SourceState state() const override { return SourceState::kLive; }
+  bool remote() const override { return false; }
+
+ private:
+  KeyFrameRequestedCallback callback_ RTC_GUARDED_BY(mutex_);
+  KeyFrameRequestedCallback encoder_callback_ RTC_GUARDED_BY(mutex_);
+  std::mutex mutex_;
+};
+
+}  // namespace detail
+
+class LocalVideoTrack;
+class SharedVideoEncoder;
+
+/// Video track source accepting already-encoded access units, which are sent
+/// without being re-encoded by the passthrough encoder of each RTP sender the
+/// source is attached to, through any number of local video tracks.
+///
+/// The access units must use the codec negotiated by the transceivers; the
+/// passthrough encoders drop the frames of any other codec. The codec can be
+/// enforced with |Transceiver::SetCodecPreferences()|.
+class EncodedVideoTrackSource : public TrackedObject {
+ public:
+  /// Check that the given configuration is valid for an encoded source.
+  static Result ValidateConfig(
+      const mrsEncodedVideoTrackSourceInitConfig& config);
+
+  EncodedVideoTrackSource(RefPtr<GlobalFactory> global_factory,
+                          const mrsEncodedVideoTrackSourceInitConfig& config);
+  ~EncodedVideoTrackSource() override;
+
+  /// Create a source fed by a shared encoder, which encodes the frames of
+  /// |track| once for all the tracks using the source and their senders.
+  static ErrorOr<RefPtr<EncodedVideoTrackSource>> CreateFromTrack(
+      RefPtr<GlobalFactory> global_factory,
+      RefPtr<LocalVideoTrack> track,
+      const mrsSharedVideoEncoderConfig& config);
+
+  std::string GetName() const override { return name_; }
+
+  /// Push an encoded access unit to all the tracks using the source. Delta
+  /// frames pushed before the first key frame are rejected.
+  Result PushFrame(const mrsEncodedVideoFrame& frame) noexcept;
+
+  /// Register a callback invoked when a key frame is needed, for example when
+  /// a new peer starts receiving the stream, or recovers from packet loss.
+  void SetKeyFrameRequestedCallback(
+      detail::EncodedTrackSourceAdapter::KeyFrameRequestedCallback&&
+          callback) noexcept {
+    adapter_->SetKeyFrameRequestedCallback(std::move(callback));
+  }
+
+  webrtc::VideoTrackSourceInterface* impl() const { return adapter_; }
+
+ private:
+  rtc::scoped_refptr<detail::EncodedTrackSourceAdapter> adapter_;
+  const webrtc::VideoCodecType codec_type_;
+  const std::string name_;
+
+  /// Whether a key frame was pushed, after which delta frames are accepted.
+  bool has_key_frame_ RTC_GUARDED_BY(mutex_){false};
+  std::mutex mutex_;
+
+  /// Shared encoder feeding the source, if created from a local video track.
+  std::unique_ptr<SharedVideoEncoder> encoder_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,469 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+
+#include "api/video/i420_buffer.h"
+#include "api/video_codecs/video_decoder.h"
+#include "api/video_codecs/video_encoder.h"
+#include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/include/video_error_codes.h"
+#include "rtc_base/stringencode.h"
+#include "rtc_base/stringutils.h"
+
+#include "external_video_codec_factory.h"
+#include "passthrough_video_encoder_factory.h"
+#include "utils.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Parse a list of "key=value" SDP format parameters separated by semicolons.
+/// Return false if any parameter is malformed.
+bool ParseSdpFormatParameters(const char* str,
+                              webrtc::SdpVideoFormat::Parameters& params) {
+  if (!str) {
+    return true;
+  }
+  std::vector<std::string> tokens;
+  rtc::split(str, ';', &tokens);
+  for (std::string& token : tokens) {
+    token = rtc::string_trim(token);
+    if (token.empty()) {
+      continue;
+    }
+    const size_t pos = token.find('=');
+    if ((pos == 0) || (pos == std::string::npos)) {
+      return false;
+    }
+    params[rtc::string_trim(token.substr(0, pos))] =
+        rtc::string_trim(token.substr(pos + 1));
+  }
+  return true;
+}
+
+/// Check the codec name and parse the SDP format parameters of a registration.
+template <typename Callbacks>
+Result InitRegistration(const char* codec_name,
+                        const char* sdp_format_parameters,
+                        const Callbacks& callbacks,
+                        ExternalVideoCodecRegistration<Callbacks>& reg) {
+  if (IsStringNullOrEmpty(codec_name)) {
+    RTC_LOG(LS_ERROR) << "Invalid empty external video codec name.";
+    return Result::kInvalidParameter;
+  }
+  reg.codec_name = codec_name;
+  if (!ParseSdpFormatParameters(sdp_format_parameters, reg.parameters)) {
+    RTC_LOG(LS_ERROR) << "Invalid SDP format parameters \""
+                      << sdp_format_parameters
+                      << "\" for external video codec " << codec_name << ".";
+    return Result::kInvalidParameter;
+  }
+  reg.callbacks = callbacks;
+  return Result::kSuccess;
+}
+
+/// Find the registration of the given codec, or NULL if none.
+template <typename Registration>
+const Registration* FindRegistration(const std::vector<Registration>& regs,
+                                     const std::string& codec_name) {
+  for (const Registration& reg : regs) {
+    if (_stricmp(reg.codec_name.c_str(), codec_name.c_str()) == 0) {
+      return &reg;
+    }
+  }
+  return nullptr;
+}
+
+/// Append to |formats| the registered codecs missing from it.
+template <typename Registration>
+void AppendMissingFormats(const std::vector<Registration>& regs,
+                          std::vector<webrtc::SdpVideoFormat>& formats) {
+  for (const Registration& reg : regs) {
+    auto it = std::find_if(formats.begin(), formats.end(),
+                           [&reg](const webrtc::SdpVideoFormat& format) {
+                             return (_stricmp(format.name.c_str(),
+                                              reg.codec_name.c_str()) == 0);
+                           });
+    if (it == formats.end()) {
+      formats.emplace_back(reg.codec_name, reg.parameters);
+    }
+  }
+}
+
+/// Video encoder forwarding to an external encoder implemented by a table of
+/// interop callbacks.
+class ExternalVideoEncoder : public webrtc::VideoEncoder {
+ public:
+  ExternalVideoEncoder(webrtc::VideoCodecType codec_type,
+                       const mrsExternalVideoEncoderCallbacks& callbacks,
+                       mrsExternalVideoCodecInstance instance)
+      : codec_type_(codec_type), callbacks_(callbacks), instance_(instance) {}
+
+  ~ExternalVideoEncoder() override {
+    callbacks_.destroy(callbacks_.user_data, instance_);
+  }
+
+  int32_t InitEncode(const webrtc::VideoCodec* codec_settings,
+                     int32_t number_of_cores,
+                     size_t max_payload_size) override {
+    if (!codec_settings) {
+      return WEBRTC_VIDEO_CODEC_ERR_PARAMETER;
+    }
+    mrsExternalVideoEncoderSettings settings{};
+    settings.width = codec_settings->width;
+    settings.height = codec_settings->height;
+    settings.max_framerate = codec_settings->maxFramerate;
+    settings.start_bitrate_kbps = codec_settings->startBitrate;
+    settings.min_bitrate_kbps = codec_settings->minBitrate;
+    settings.max_bitrate_kbps = codec_settings->maxBitrate;
+    settings.number_of_cores = std::max(number_of_cores, 1);
+    if (callbacks_.init(callbacks_.user_data, instance_, &settings) !=
+        Result::kSuccess) {
+      return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+    initialized_ = true;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t RegisterEncodeCompleteCallback(
+      webrtc::EncodedImageCallback* callback) override {
+    callback_ = callback;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t Release() override {
+    initialized_ = false;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t Encode(const webrtc::VideoFrame& frame,
+                 const webrtc::CodecSpecificInfo* codec_specific_info,
+                 const std::vector<webrtc::FrameType>* frame_types) override {
+    if (!initialized_ || !callback_) {
+      return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
+    }
+    bool force_key_frame = false;
+    if (frame_types) {
+      for (webrtc::FrameType type : *frame_types) {
+        if (type == webrtc::kVideoFrameKey) {
+          force_key_frame = true;
+          break;
+        }
+      }
+    }
+    rtc::scoped_refptr<webrtc::I420BufferInterface> buffer =
+        frame.video_frame_buffer()->ToI420();
+    I420AVideoFrame input{};
+    input.width_ = buffer->width();
+    input.height_ = buffer->height();
+    input.ydata_ = buffer->DataY();
+    input.udata_ = buffer->DataU();
+    input.vdata_ = buffer->DataV();
+    input.adata_ = nullptr;
+    input.ystride_ = buffer->StrideY();
+    input.ustride_ = buffer->StrideU();
+    input.vstride_ = buffer->StrideV();
+    input.astride_ = 0;
+    current_frame_ = &frame;
+    const mrsResult result = callbacks_.encode(
+        callbacks_.user_data, instance_, &input,
+        force_key_frame ? mrsBool::kTrue : mrsBool::kFalse, &OnEncodedFrame,
+        this);
+    current_frame_ = nullptr;
+    return (result == Result::kSuccess ? WEBRTC_VIDEO_CODEC_OK
+                                       : WEBRTC_VIDEO_CODEC_ERROR);
+  }
+
+  int32_t SetChannelParameters(uint32_t /*packet_loss*/,
+                               int64_t /*rtt*/) override {
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t SetRateAllocation(const webrtc::VideoBitrateAllocation& allocation,
+                            uint32_t framerate) override {
+    if (callbacks_.set_rates(callbacks_.user_data, instance_,
+                             allocation.get_sum_kbps(),
+                             framerate) != Result::kSuccess) {
+      return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  const char* ImplementationName() const override { return "External"; }
+
+ protected:
+  /// Output callback passed to the external encoder, only valid during the
+  /// call to its encode callback.
+  static mrsResult MRS_CALL OnEncodedFrame(void* context,
+                                           const mrsEncodedVideoFrame* frame) {
+    auto encoder = static_cast<ExternalVideoEncoder*>(context);
+    if (!encoder || !encoder->current_frame_) {
+      return Result::kInvalidOperation;
+    }
+    if (!frame || !frame->data || (frame->size == 0)) {
+      return Result::kInvalidParameter;
+    }
+    const webrtc::VideoFrame& input = *encoder->current_frame_;
+    const int width = (frame->width > 0 ? frame->width : input.width());
+    const int height = (frame->height > 0 ? frame->height : input.height());
+    const int32_t ret = DeliverEncodedAccessUnit(
+        encoder->callback_, encoder->codec_type_, input, frame->data,
+        frame->size, width, height, frame->is_key_frame != mrsBool::kFalse);
+    return (ret == WEBRTC_VIDEO_CODEC_OK ? Result::kSuccess
+                                         : Result::kUnknownError);
+  }
+
+ private:
+  const webrtc::VideoCodecType codec_type_;
+  const mrsExternalVideoEncoderCallbacks callbacks_;
+  const mrsExternalVideoCodecInstance instance_;
+  webrtc::EncodedImageCallback* callback_{nullptr};
+  bool initialized_{false};
+
+  /// Raw frame being encoded, while the encode callback runs.
+  const webrtc::VideoFrame* current_frame_{nullptr};
+};
+
+/// Video decoder forwarding to an external decoder implemented by a table of
+/// interop callbacks.
+class ExternalVideoDecoder : public webrtc::VideoDecoder {
+ public:
+  ExternalVideoDecoder(const mrsExternalVideoDecoderCallbacks& callbacks,
+                       mrsExternalVideoCodecInstance instance)
+      : callbacks_(callbacks), instance_(instance) {}
+
+  ~ExternalVideoDecoder() override {
+    callbacks_.destroy(callbacks_.user_data, instance_);
+  }
+
+  int32_t InitDecode(const webrtc::VideoCodec* codec_settings,
+                     int32_t number_of_cores) override {
+    mrsExternalVideoDecoderSettings settings{};
+    if (codec_settings) {
+      settings.width = codec_settings->width;
+      settings.height = codec_settings->height;
+    }
+    settings.number_of_cores = std::max(number_of_cores, 1);
+    if (callbacks_.init(callbacks_.user_data, instance_, &settings) !=
+        Result::kSuccess) {
+      return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+    initialized_ = true;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t Decode(const webrtc::EncodedImage& input_image,
+                 bool missing_frames,
+                 const webrtc::CodecSpecificInfo* codec_specific_info,
+                 int64_t render_time_ms) override {
+    if (!initialized_ || !callback_) {
+      return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
+    }
+    if (!input_image._buffer || (input_image._length == 0)) {
+      return WEBRTC_VIDEO_CODEC_ERR_PARAMETER;
+    }
+    mrsEncodedVideoFrame frame{};
+    frame.data = input_image._buffer;
+    frame.size = static_cast<uint32_t>(input_image._length);
+    frame.width = input_image._encodedWidth;
+    frame.height = input_image._encodedHeight;
+    frame.is_key_frame = (input_image._frameType == webrtc::kVideoFrameKey
+                              ? mrsBool::kTrue
+                              : mrsBool::kFalse);
+    frame.timestamp_us = (render_time_ms >= 0 ? render_time_ms * 1000 : 0);
+    current_image_ = &input_image;
+    current_render_time_ms_ = render_time_ms;
+    const mrsResult result = callbacks_.decode(
+        callbacks_.user_data, instance_, &frame, &OnDecodedFrame, this);
+    current_image_ = nullptr;
+    return (result == Result::kSuccess ? WEBRTC_VIDEO_CODEC_OK
+                                       : WEBRTC_VIDEO_CODEC_ERROR);
+  }
+
+  int32_t RegisterDecodeCompleteCallback(
+      webrtc::DecodedImageCallback* callback) override {
+    callback_ = callback;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t Release() override {
+    initialized_ = false;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  const char* ImplementationName() const override { return "External"; }
+
+ protected:
+  /// Output callback passed to the external decoder, only valid during the
+  /// call to its decode callback.
+  static mrsResult MRS_CALL OnDecodedFrame(void* context,
+                                           const mrsI420AVideoFrame* frame) {
+    auto decoder = static_cast<ExternalVideoDecoder*>(context);
+    if (!decoder || !decoder->current_image_) {
+      return Result::kInvalidOperation;
+    }
+    if (!frame || !frame->ydata_ || !frame->udata_ || !frame->vdata_ ||
+        (frame->width_ == 0) || (frame->height_ == 0)) {
+      return Result::kInvalidParameter;
+    }
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer = webrtc::I420Buffer::Copy(
+        frame->width_, frame->height_,
+        static_cast<const uint8_t*>(frame->ydata_), frame->ystride_,
+        static_cast<const uint8_t*>(frame->udata_), frame->ustride_,
+        static_cast<const uint8_t*>(frame->vdata_), frame->vstride_);
+    const webrtc::EncodedImage& image = *decoder->current_image_;
+    webrtc::VideoFrame decoded(buffer, image.Timestamp(),
+                               decoder->current_render_time_ms_,
+                               image.rotation_);
+    decoder->callback_->Decoded(decoded);
+    return Result::kSuccess;
+  }
+
+ private:
+  const mrsExternalVideoDecoderCallbacks callbacks_;
+  const mrsExternalVideoCodecInstance instance_;
+  webrtc::DecodedImageCallback* callback_{nullptr};
+  bool initialized_{false};
+
+  /// Access unit being decoded, while the decode callback runs.
+  const webrtc::EncodedImage* current_image_{nullptr};
+  int64_t current_render_time_ms_{-1};
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+ErrorOr<ExternalVideoEncoderRegistration>
+CreateExternalVideoEncoderRegistration(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoEncoderCallbacks& callbacks) {
+  if (!callbacks.create || !callbacks.destroy || !callbacks.init ||
+      !callbacks.encode || !callbacks.set_rates) {
+    RTC_LOG(LS_ERROR) << "Missing mandatory external video encoder callback.";
+    return Error(Result::kInvalidParameter);
+  }
+  ExternalVideoEncoderRegistration reg;
+  const Result result =
+      InitRegistration(codec_name, sdp_format_parameters, callbacks, reg);
+  if (result != Result::kSuccess) {
+    return Error(result);
+  }
+  return std::move(reg);
+}
+
+ErrorOr<ExternalVideoDecoderRegistration>
+CreateExternalVideoDecoderRegistration(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoDecoderCallbacks& callbacks) {
+  if (!callbacks.create || !callbacks.destroy || !callbacks.init ||
+      !callbacks.decode) {
+    RTC_LOG(LS_ERROR) << "Missing mandatory external video decoder callback.";
+    return Error(Result::kInvalidParameter);
+  }
+  ExternalVideoDecoderRegistration reg;
+  const Result result =
+      InitRegistration(codec_name, sdp_format_parameters, callbacks, reg);
+  if (result != Result::kSuccess) {
+    return Error(result);
+  }
+  return std::move(reg);
+}
+
+ExternalVideoEncoderFactory::ExternalVideoEncoderFactory(
+    std::vector<ExternalVideoEncoderRegistration> encoders,
+    std::unique_ptr<webrtc::VideoEncoderFactory> factory)
+    : encoders_(std::move(encoders)), factory_(std::move(factory)) {}
+
+std::vector<webrtc::SdpVideoFormat>
+ExternalVideoEncoderFactory::GetSupportedFormats() const {
+  std::vector<webrtc::SdpVideoFormat> formats = factory_->GetSupportedFormats();
+  AppendMissingFormats(encoders_, formats);
+  return formats;
+}
+
+webrtc::VideoEncoderFactory::CodecInfo
+ExternalVideoEncoderFactory::QueryVideoEncoder(
+    const webrtc::SdpVideoFormat& format) const {
+  const ExternalVideoEncoderRegistration* reg = Find(format.name);
+  if (!reg) {
+    return factory_->QueryVideoEncoder(format);
+  }
+  CodecInfo info;
+  info.is_hardware_accelerated = false;
+  info.has_internal_source = false;
+  if (reg->callbacks.query_info) {
+    mrsExternalVideoCodecInfo external_info{};
+    reg->callbacks.query_info(reg->callbacks.user_data, &external_info);
+    info.is_hardware_accelerated =
+        (external_info.is_hardware_accelerated != mrsBool::kFalse);
+  }
+  return info;
+}
+
+std::unique_ptr<webrtc::VideoEncoder>
+ExternalVideoEncoderFactory::CreateVideoEncoder(
+    const webrtc::SdpVideoFormat& format) {
+  if (const ExternalVideoEncoderRegistration* reg = Find(format.name)) {
+    const mrsExternalVideoEncoderCallbacks& callbacks = reg->callbacks;
+    if (mrsExternalVideoCodecInstance instance =
+            callbacks.create(callbacks.user_data)) {
+      return absl::make_unique<ExternalVideoEncoder>(
+          webrtc::PayloadStringToCodecType(format.name), callbacks, instance);
+    }
+    RTC_LOG(LS_WARNING) << "Failed to create external " << format.name
+                        << " encoder; falling back to built-in encoder.";
+  }
+  return factory_->CreateVideoEncoder(format);
+}
+
+const ExternalVideoEncoderRegistration* ExternalVideoEncoderFactory::Find(
+    const std::string& codec_name) const {
+  return FindRegistration(encoders_, codec_name);
+}
+
+ExternalVideoDecoderFactory::ExternalVideoDecoderFactory(
+    std::vector<ExternalVideoDecoderRegistration> decoders,
+    std::unique_ptr<webrtc::VideoDecoderFactory> factory)
+    : decoders_(std::move(decoders)), factory_(std::move(factory)) {}
+
+std::vector<webrtc::SdpVideoFormat>
+ExternalVideoDecoderFactory::GetSupportedFormats() const {
+  std::vector<webrtc::SdpVideoFormat> formats = factory_->GetSupportedFormats();
+  AppendMissingFormats(decoders_, formats);
+  return formats;
+}
+
+std::unique_ptr<webrtc::VideoDecoder>
+ExternalVideoDecoderFactory::CreateVideoDecoder(
+    const webrtc::SdpVideoFormat& format) {
+  if (const ExternalVideoDecoderRegistration* reg = Find(format.name)) {
+    const mrsExternalVideoDecoderCallbacks& callbacks = reg->callbacks;
+    if (mrsExternalVideoCodecInstance instance =
+            callbacks.create(callbacks.user_data)) {
+      return absl::make_unique<ExternalVideoDecoder>(callbacks, instance);
+    }
+    RTC_LOG(LS_WARNING) << "Failed to create external " << format.name
+                        << " decoder; falling back to built-in decoder.";
+  }
+  return factory_->CreateVideoDecoder(format);
+}
+
+const ExternalVideoDecoderRegistration* ExternalVideoDecoderFactory::Find(
+    const std::string& codec_name) const {
+  return FindRegistration(decoders_, codec_name);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,106 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api/video_codecs/sdp_video_format.h"
+#include "api/video_codecs/video_decoder_factory.h"
+#include "api/video_codecs/video_encoder_factory.h"
+
+#include "external_video_codec_interop.h"
+#include "mrs_errors.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// External video codec registered through the interop API, implemented by
+/// the given table of callbacks.
+template <typename Callbacks>
+struct ExternalVideoCodecRegistration {
+  /// SDP name of the codec, compared case-insensitively.
+  std::string codec_name;
+
+  /// SDP format parameters advertised if the codec has no built-in
+  /// implementation.
+  webrtc::SdpVideoFormat::Parameters parameters;
+
+  Callbacks callbacks;
+};
+
+using ExternalVideoEncoderRegistration =
+    ExternalVideoCodecRegistration<mrsExternalVideoEncoderCallbacks>;
+using ExternalVideoDecoderRegistration =
+    ExternalVideoCodecRegistration<mrsExternalVideoDecoderCallbacks>;
+
+/// Check the given external encoder callbacks, and create a registration for
+/// them. |sdp_format_parameters| is optional.
+ErrorOr<ExternalVideoEncoderRegistration>
+CreateExternalVideoEncoderRegistration(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoEncoderCallbacks& callbacks);
+
+/// Check the given external decoder callbacks, and create a registration for
+/// them. |sdp_format_parameters| is optional.
+ErrorOr<ExternalVideoDecoderRegistration>
+CreateExternalVideoDecoderRegistration(
+    const char* codec_name,
+    const char* sdp_format_parameters,
+    const mrsExternalVideoDecoderCallbacks& callbacks);
+
+/// Video encoder factory creating the encoders of the codecs with an external
+/// implementation from their registration, and delegating the other codecs to
+/// a wrapped factory. If an external implementation fails to create an encoder
+/// the wrapped factory is used instead.
+class ExternalVideoEncoderFactory : public webrtc::VideoEncoderFactory {
+ public:
+  ExternalVideoEncoderFactory(
+      std::vector<ExternalVideoEncoderRegistration> encoders,
+      std::unique_ptr<webrtc::VideoEncoderFactory> factory);
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  CodecInfo QueryVideoEncoder(
+      const webrtc::SdpVideoFormat& format) const override;
+  std::unique_ptr<webrtc::VideoEncoder> CreateVideoEncoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  /// Find the external encoder of the given codec, or NULL if none.
+  const ExternalVideoEncoderRegistration* Find(
+      const std::string& codec_name) const;
+
+  const std::vector<ExternalVideoEncoderRegistration> encoders_;
+  std::unique_ptr<webrtc::VideoEncoderFactory> factory_;
+};
+
+/// Video decoder factory creating the decoders of the codecs with an external
+/// implementation from their registration, and delegating the other codecs to
+/// a wrapped factory. If an external implementation fails to create a decoder
+/// the wrapped factory is used instead.
+class ExternalVideoDecoderFactory : public webrtc::VideoDecoderFactory {
+ public:
+  ExternalVideoDecoderFactory(
+      std::vector<ExternalVideoDecoderRegistration> decoders,
+      std::unique_ptr<webrtc::VideoDecoderFactory> factory);
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  std::unique_ptr<webrtc::VideoDecoder> CreateVideoDecoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  /// Find the external decoder of the given codec, or NULL if none.
+  const ExternalVideoDecoderRegistration* Find(
+      const std::string& codec_name) const;
+
+  const std::vector<ExternalVideoDecoderRegistration> decoders_;
+  std::unique_ptr<webrtc::VideoDecoderFactory> factory_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -5,6 +5,8 @@
 
 #include "interop/global_factory.h"
 #include "media/external_video_track_source_impl.h"
+#include "tracing.h"
+#include "video_frame_observer.h"
 
 namespace {
 
@@ -39,6 +41,10 @@ class I420ABufferAdapter : public detail::BufferAdapter {
       const Argb32VideoFrame& /*frame_view*/) override {
     RTC_CHECK(false);
   }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const Nv12VideoFrame& /*frame_view*/) override {
+    RTC_CHECK(false);
+  }
 
  private:
   RefPtr<I420AExternalVideoSource> video_source_;
@@ -102,12 +108,47 @@ class Argb32BufferAdapter : public detail::BufferAdapter {
 
     return buffer;
   }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const Nv12VideoFrame& /*frame_view*/) override {
+    RTC_CHECK(false);
+  }
 
  private:
   RefPtr<Argb32ExternalVideoSource> video_source_;
   bool has_warned_ = false;
 };
 
+/// Buffer adapter for an NV12 video frame.
+class Nv12BufferAdapter : public detail::BufferAdapter {
+ public:
+  Nv12BufferAdapter(RefPtr<Nv12ExternalVideoSource> video_source)
+      : video_source_(std::move(video_source)) {}
+  Result RequestFrame(ExternalVideoTrackSource& track_source,
+                      std::uint32_t request_id,
+                      std::int64_t timestamp_ms) noexcept override {
+    // Request a single NV12 frame
+    Nv12VideoFrameRequest request{track_source, timestamp_ms, request_id};
+    return video_source_->FrameRequested(request);
+  }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const I420AVideoFrame& /*frame_view*/) override {
+    RTC_CHECK(false);
+  }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const Argb32VideoFrame& /*frame_view*/) override {
+    RTC_CHECK(false);
+  }
+  rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const Nv12VideoFrame& frame_view) override {
+    // Keep the frame in NV12, so that observers registered for NV12 receive it
+    // without conversion. Encoders convert it on their own when needed.
+    return Nv12Buffer::Copy(frame_view);
+  }
+
+ private:
+  RefPtr<Nv12ExternalVideoSource> video_source_;
+};
+
 }  // namespace
 
 namespace Microsoft {
@@ -119,9 +160,10 @@ constexpr const size_t kMaxPendingRequestCount = 64;
 
 RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceImpl::create(
     RefPtr<GlobalFactory> global_factory,
-    std::unique_ptr<BufferAdapter> adapter) {
-  auto source = new ExternalVideoTrackSourceImpl(std::move(global_factory),
-                                                 std::move(adapter));
+    std::unique_ptr<BufferAdapter> adapter,
+    int frame_interval_ms) {
+  auto source = new ExternalVideoTrackSourceImpl(
+      std::move(global_factory), std::move(adapter), frame_interval_ms);
   // Note: Video track sources always start already capturing; there is no
   // start/stop mechanism at the track level in WebRTC. A source is either being
   // initialized, or is already live. However because of wrappers and interop
@@ -131,11 +173,14 @@ RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceImpl::create(
 
 ExternalVideoTrackSourceImpl::ExternalVideoTrackSourceImpl(
     RefPtr<GlobalFactory> global_factory,
-    std::unique_ptr<BufferAdapter> adapter)
+    std::unique_ptr<BufferAdapter> adapter,
+    int frame_interval_ms)
     : ExternalVideoTrackSource(std::move(global_factory)),
       track_source_(new rtc::RefCountedObject<CustomTrackSourceAdapter>()),
       adapter_(std::forward<std::unique_ptr<BufferAdapter>>(adapter)),
-      capture_thread_(rtc::Thread::Create()) {
+      capture_thread_(rtc::Thread::Create()),
+      frame_interval_ms_(frame_interval_ms) {
+  RTC_CHECK(frame_interval_ms_ > 0);
   capture_thread_->SetName("ExternalVideoTrackSource capture thread", this);
 }
 
@@ -163,10 +208,11 @@ void ExternalVideoTrackSourceImpl::StartCapture() {
   capture_thread_->PostAt(RTC_FROM_HERE, now + 10, this, MSG_REQUEST_FRAME);
 }
 
-Result ExternalVideoTrackSourceImpl::CompleteRequest(
+template <typename FrameView>
+Result ExternalVideoTrackSourceImpl::CompleteRequestImpl(
     uint32_t request_id,
     int64_t timestamp_ms,
-    const I420AVideoFrame& frame_view) {
+    const FrameView& frame_view) {
   // Validate pending request ID and retrieve frame timestamp
   int64_t timestamp_ms_original = -1;
   {
@@ -204,39 +250,22 @@ Result ExternalVideoTrackSourceImpl::CompleteRequest(
 Result ExternalVideoTrackSourceImpl::CompleteRequest(
     uint32_t request_id,
     int64_t timestamp_ms,
-    const Argb32VideoFrame& frame_view) {
-  // Validate pending request ID and retrieve frame timestamp
-  int64_t timestamp_ms_original = -1;
-  {
-    rtc::CritScope lock(&request_lock_);
-    for (auto it = pending_requests_.begin(); it != pending_requests_.end();
-         ++it) {
-      if (it->first == request_id) {
-        timestamp_ms_original = it->second;
-        // Remove outdated requests, including current one
-        ++it;
-        pending_requests_.erase(pending_requests_.begin(), it);
-        break;
-      }
-    }
-    if (timestamp_ms_original < 0) {
-      return Result::kInvalidParameter;
-    }
-  }
+    const I420AVideoFrame& frame_view) {
+  return CompleteRequestImpl(request_id, timestamp_ms, frame_view);
+}
 
-  // Apply user override if any
-  if (timestamp_ms != timestamp_ms_original) {
-    timestamp_ms = timestamp_ms_original;
-  }
+Result ExternalVideoTrackSourceImpl::CompleteRequest(
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const Argb32VideoFrame& frame_view) {
+  return CompleteRequestImpl(request_id, timestamp_ms, frame_view);
+}
 
-  // Create and dispatch the video frame
-  webrtc::VideoFrame frame{
-      webrtc::VideoFrame::Builder()
-          .set_video_frame_buffer(adapter_->FillBuffer(frame_view))
-          .set_timestamp_ms(timestamp_ms)
-          .build()};
-  track_source_->DispatchFrame(frame);
-  return Result::kSuccess;
+Result ExternalVideoTrackSourceImpl::CompleteRequest(
+    uint32_t request_id,
+    int64_t timestamp_ms,
+    const Nv12VideoFrame& frame_view) {
+  return CompleteRequestImpl(request_id, timestamp_ms, frame_view);
 }
 
 void ExternalVideoTrackSourceImpl::StopCapture() {
@@ -254,6 +283,7 @@ void ExternalVideoTrackSourceImpl::Shutdown() noexcept {
 
 // Note - This is called on the capture thread only.
 void ExternalVideoTrackSourceImpl::OnMessage(rtc::Message* message) {
+  MRS_TRACE_SCOPE("ExternalVideoTrackSourceImpl::OnMessage");
   switch (message->message_id) {
     case MSG_REQUEST_FRAME:
       const int64_t now = rtc::TimeMillis();
@@ -274,10 +304,11 @@ void ExternalVideoTrackSourceImpl::OnMessage(rtc::Message* message) {
       }
       adapter_->RequestFrame(*this, request_id, now);
 
-      // Schedule a new request for 30ms from now
+      // Schedule a new request for one frame interval from now
       //< TODO - this is unreliable and prone to drifting; figure out something
       // better
-      capture_thread_->PostAt(RTC_FROM_HERE, now + 30, this, MSG_REQUEST_FRAME);
+      capture_thread_->PostAt(RTC_FROM_HERE, now + frame_interval_ms_, this,
+                              MSG_REQUEST_FRAME);
       break;
   }
 }
@@ -291,10 +322,12 @@ ExternalVideoTrackSource::ExternalVideoTrackSource(
 
 RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSource::createFromI420A(
     RefPtr<GlobalFactory> global_factory,
-    RefPtr<I420AExternalVideoSource> video_source) {
+    RefPtr<I420AExternalVideoSource> video_source,
+    int frame_interval_ms) {
   return detail::ExternalVideoTrackSourceImpl::create(
       std::move(global_factory),
-      std::make_unique<I420ABufferAdapter>(std::move(video_source)));
+      std::make_unique<I420ABufferAdapter>(std::move(video_source)),
+      frame_interval_ms);
 }
 
 RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSource::createFromArgb32(
@@ -305,6 +338,14 @@ RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSource::createFromArgb32(
       std::make_unique<Argb32BufferAdapter>(std::move(video_source)));
 }
 
+RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSource::createFromNv12(
+    RefPtr<GlobalFactory> global_factory,
+    RefPtr<Nv12ExternalVideoSource> video_source) {
+  return detail::ExternalVideoTrackSourceImpl::create(
+      std::move(global_factory),
+      std::make_unique<Nv12BufferAdapter>(std::move(video_source)));
+}
+
 Result I420AVideoFrameRequest::CompleteRequest(
     const I420AVideoFrame& frame_view) {
   auto impl =
@@ -319,6 +360,13 @@ Result Argb32VideoFrameRequest::CompleteRequest(
   return impl->CompleteRequest(request_id_, timestamp_ms_, frame_view);
 }
 
+Result Nv12VideoFrameRequest::CompleteRequest(
+    const Nv12VideoFrame& frame_view) {
+  auto impl =
+      static_cast<detail::ExternalVideoTrackSourceImpl*>(&track_source_);
+  return impl->CompleteRequest(request_id_, timestamp_ms_, frame_view);
+}
+
 }  // namespace WebRTC
 }  // namespace MixedReality
 }  // namespace Microsoft
@@ -15,6 +15,10 @@ namespace WebRTC {
 
 class ExternalVideoTrackSource;
 
+/// Default interval between two consecutive frame requests of an external
+/// video track source, in milliseconds.
+constexpr int kDefaultFrameRequestIntervalMs = 30;
+
 /// Frame request for an external video source producing video frames encoded in
 /// I420 format, with optional Alpha (opacity) plane.
 struct I420AVideoFrameRequest {
@@ -76,15 +80,43 @@ class Argb32ExternalVideoSource : public RefCountedBase {
   virtual Result FrameRequested(Argb32VideoFrameRequest& frame_request) = 0;
 };
 
+/// Frame request for an external video source producing video frames encoded in
+/// NV12 format.
+struct Nv12VideoFrameRequest {
+  /// Video track source the request is related to.
+  ExternalVideoTrackSource& track_source_;
+
+  /// Video frame timestamp, in milliseconds.
+  std::int64_t timestamp_ms_;
+
+  /// Unique identifier of the request.
+  const std::uint32_t request_id_;
+
+  /// Complete the request by making the track source consume the given video
+  /// frame and have it deliver the frame to all its video tracks.
+  Result CompleteRequest(const Nv12VideoFrame& frame_view);
+};
+
+/// Custom video source producing video frames encoded in NV12 format. The
+/// frames are kept in NV12 until a consumer needs another format.
+class Nv12ExternalVideoSource : public RefCountedBase {
+ public:
+  /// Produce a video frame for a request initiated by an external track source.
+  /// See |I420AExternalVideoSource::FrameRequested()| for details.
+  virtual Result FrameRequested(Nv12VideoFrameRequest& frame_request) = 0;
+};
+
 /// Video track source acting as an adapter for an external source of raw
 /// frames.
 class ExternalVideoTrackSource : public TrackedObject {
  public:
   /// Helper to create an external video track source from a custom I420A video
-  /// frame request callback.
+  /// frame request callback. Frames are requested every |frame_interval_ms|
+  /// milliseconds.
   static RefPtr<ExternalVideoTrackSource> createFromI420A(
       RefPtr<GlobalFactory> global_factory,
-      RefPtr<I420AExternalVideoSource> video_source);
+      RefPtr<I420AExternalVideoSource> video_source,
+      int frame_interval_ms = kDefaultFrameRequestIntervalMs);
 
   /// Helper to create an external video track source from a custom ARGB32 video
   /// frame request callback.
@@ -92,6 +124,12 @@ class ExternalVideoTrackSource : public TrackedObject {
       RefPtr<GlobalFactory> global_factory,
       RefPtr<Argb32ExternalVideoSource> video_source);
 
+  /// Helper to create an external video track source from a custom NV12 video
+  /// frame request callback.
+  static RefPtr<ExternalVideoTrackSource> createFromNv12(
+      RefPtr<GlobalFactory> global_factory,
+      RefPtr<Nv12ExternalVideoSource> video_source);
+
   /// Finish the creation of the video track source, and start capturing.
   /// See |mrsExternalVideoTrackSourceFinishCreation()| for details.
   virtual void FinishCreation() = 0;
@@ -114,6 +152,13 @@ class ExternalVideoTrackSource : public TrackedObject {
                                  int64_t timestamp_ms,
                                  const Argb32VideoFrame& frame) = 0;
 
+  /// Complete a given video frame request with the provided NV12 frame.
+  /// The caller must know the source expects an NV12 frame; there is no check
+  /// to confirm the source is NV12-based.
+  virtual Result CompleteRequest(uint32_t request_id,
+                                 int64_t timestamp_ms,
+                                 const Nv12VideoFrame& frame) = 0;
+
   /// Stop the video capture. This will stop producing video frames.
   virtual void StopCapture() = 0;
 
@@ -144,6 +189,13 @@ RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateFromArgb32(
     mrsRequestExternalArgb32VideoFrameCallback callback,
     void* user_data);
 
+/// Create an NV12 external video track source wrapping the given interop
+/// callback.
+RefPtr<ExternalVideoTrackSource> ExternalVideoTrackSourceCreateFromNv12(
+    RefPtr<GlobalFactory> global_factory,
+    mrsRequestExternalNv12VideoFrameCallback callback,
+    void* user_data);
+
 }  // namespace detail
 
 }  // namespace WebRTC
@@ -31,6 +31,8 @@ class BufferAdapter {
       const I420AVideoFrame& frame_view) = 0;
   virtual rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
       const Argb32VideoFrame& frame_view) = 0;
+  virtual rtc::scoped_refptr<webrtc::VideoFrameBuffer> FillBuffer(
+      const Nv12VideoFrame& frame_view) = 0;
 };
 
 /// Adapter to bridge a video track source to the underlying core
@@ -62,7 +64,8 @@ class ExternalVideoTrackSourceImpl : public ExternalVideoTrackSource,
 
   static RefPtr<ExternalVideoTrackSource> create(
       RefPtr<GlobalFactory> global_factory,
-      std::unique_ptr<BufferAdapter> adapter);
+      std::unique_ptr<BufferAdapter> adapter,
+      int frame_interval_ms = kDefaultFrameRequestIntervalMs);
 
   ~ExternalVideoTrackSourceImpl() override;
 
@@ -85,6 +88,11 @@ class ExternalVideoTrackSourceImpl : public ExternalVideoTrackSource,
                          int64_t timestamp_ms,
                          const Argb32VideoFrame& frame) override;
 
+  /// Complete a video frame request with a given NV12 video frame.
+  Result CompleteRequest(uint32_t request_id,
+                         int64_t timestamp_ms,
+                         const Nv12VideoFrame& frame) override;
+
   /// Stop the video capture. This will stop producing video frames.
   void StopCapture() override;
 
@@ -95,10 +103,18 @@ class ExternalVideoTrackSourceImpl : public ExternalVideoTrackSource,
 
  protected:
   ExternalVideoTrackSourceImpl(RefPtr<GlobalFactory> global_factory,
-                               std::unique_ptr<BufferAdapter> adapter);
+                               std::unique_ptr<BufferAdapter> adapter,
+                               int frame_interval_ms);
   // void Run(rtc::Thread* thread) override;
   void OnMessage(rtc::Message* message) override;
 
+  /// Complete a video frame request with a given video frame of any format
+  /// supported by the buffer adapter.
+  template <typename FrameView>
+  Result CompleteRequestImpl(uint32_t request_id,
+                             int64_t timestamp_ms,
+                             const FrameView& frame_view);
+
   rtc::scoped_refptr<CustomTrackSourceAdapter> track_source_;
 
   std::unique_ptr<BufferAdapter> adapter_;
@@ -114,6 +130,9 @@ class ExternalVideoTrackSourceImpl : public ExternalVideoTrackSource,
   /// Lock for frame requests.
   rtc::CriticalSection request_lock_;
 
+  /// Interval between two consecutive frame requests, in milliseconds.
+  const int frame_interval_ms_;
+
   /// Friendly track source name, for debugging.
   std::string name_;
 };
@@ -5,6 +5,7 @@
 
 #include "interop/global_factory.h"
 #include "local_video_track.h"
+#include "media/external_video_track_source.h"
 #include "peer_connection.h"
 
 namespace Microsoft {
@@ -24,6 +25,14 @@ LocalVideoTrack::LocalVideoTrack(
   track_->AddOrUpdateSink(this, sink_settings);
 }
 
+LocalVideoTrack::LocalVideoTrack(
+    RefPtr<GlobalFactory> global_factory,
+    rtc::scoped_refptr<webrtc::VideoTrackInterface> track,
+    RefPtr<ExternalVideoTrackSource> owned_source) noexcept
+    : LocalVideoTrack(std::move(global_factory), std::move(track)) {
+  owned_source_ = std::move(owned_source);
+}
+
 LocalVideoTrack::LocalVideoTrack(
     RefPtr<GlobalFactory> global_factory,
     PeerConnection& owner,
@@ -66,6 +75,81 @@ bool LocalVideoTrack::IsEnabled() const noexcept {
   return track_->enabled();
 }
 
+Result LocalVideoTrack::GetSendEncodings(
+    std::vector<mrsSendEncodingParameters>& encodings) const noexcept {
+  if (!transceiver_) {
+    RTC_LOG(LS_ERROR) << "Cannot get send encodings of local video track "
+                      << track_name_.c_str()
+                      << " not attached to any transceiver.";
+    return Result::kInvalidOperation;
+  }
+  return transceiver_->GetSendEncodings(encodings);
+}
+
+Result LocalVideoTrack::SetSendEncoding(
+    uint32_t index,
+    const mrsSendEncodingParameters& encoding) noexcept {
+  if (!transceiver_) {
+    RTC_LOG(LS_ERROR) << "Cannot set send encoding of local video track "
+                      << track_name_.c_str()
+                      << " not attached to any transceiver.";
+    return Result::kInvalidOperation;
+  }
+  std::vector<mrsSendEncodingParameters> encodings;
+  const Result result = transceiver_->GetSendEncodings(encodings);
+  if (result != Result::kSuccess) {
+    return result;
+  }
+  if (encodings.empty() && transceiver_->IsPlanB() && (index == 0)) {
+    // Saved and applied once the RTP sender is negotiated.
+    encodings.resize(1);
+  }
+  if (index >= encodings.size()) {
+    RTC_LOG(LS_ERROR) << "Invalid send encoding index " << index
+                      << " for local video track " << track_name_.c_str()
+                      << " with " << encodings.size() << " encodings.";
+    return (encodings.empty() ? Result::kInvalidOperation
+                              : Result::kOutOfRange);
+  }
+  // Returned encodings have no RID, so only the modified one is checked.
+  encodings[index] = encoding;
+  const uint32_t count = static_cast<uint32_t>(encodings.size());
+  return transceiver_->SetSendEncodings(encodings.data(), count);
+}
+
+void LocalVideoTrack::SetDegradationPreference(
+    mrsDegradationPreference preference) noexcept {
+  // WebRTC derives the degradation preference of the video send streams from
+  // the content hint of the track, and reconfigures them on change.
+  webrtc::VideoTrackInterface::ContentHint hint;
+  switch (preference) {
+    case mrsDegradationPreference::kMaintainFramerate:
+      hint = webrtc::VideoTrackInterface::ContentHint::kFluid;
+      break;
+    case mrsDegradationPreference::kMaintainResolution:
+      hint = webrtc::VideoTrackInterface::ContentHint::kDetailed;
+      break;
+    case mrsDegradationPreference::kDefault:
+    default:
+      hint = webrtc::VideoTrackInterface::ContentHint::kNone;
+      break;
+  }
+  track_->set_content_hint(hint);
+}
+
+mrsDegradationPreference LocalVideoTrack::GetDegradationPreference() const
+    noexcept {
+  switch (track_->content_hint()) {
+    case webrtc::VideoTrackInterface::ContentHint::kFluid:
+      return mrsDegradationPreference::kMaintainFramerate;
+    case webrtc::VideoTrackInterface::ContentHint::kDetailed:
+      return mrsDegradationPreference::kMaintainResolution;
+    case webrtc::VideoTrackInterface::ContentHint::kNone:
+    default:
+      return mrsDegradationPreference::kDefault;
+  }
+}
+
 webrtc::VideoTrackInterface* LocalVideoTrack::impl() const {
   return track_.get();
 }
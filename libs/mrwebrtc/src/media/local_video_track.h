@@ -5,6 +5,7 @@
 
 #include "callback.h"
 #include "interop_api.h"
+#include "local_video_track_interop.h"
 #include "media/media_track.h"
 #include "refptr.h"
 #include "tracked_object.h"
@@ -24,6 +25,7 @@ namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+class ExternalVideoTrackSource;
 class PeerConnection;
 class Transceiver;
 
@@ -45,6 +47,13 @@ class LocalVideoTrack : public VideoFrameObserver, public MediaTrack {
   LocalVideoTrack(RefPtr<GlobalFactory> global_factory,
                   rtc::scoped_refptr<webrtc::VideoTrackInterface> track) noexcept;
 
+  /// Constructor for a track not added to any peer connection, and owning the
+  /// external video track source it is created from. This keeps the source
+  /// alive, and therefore producing frames, for the lifetime of the track.
+  LocalVideoTrack(RefPtr<GlobalFactory> global_factory,
+                  rtc::scoped_refptr<webrtc::VideoTrackInterface> track,
+                  RefPtr<ExternalVideoTrackSource> owned_source) noexcept;
+
   /// Constructor for a track added to a peer connection.
   LocalVideoTrack(RefPtr<GlobalFactory> global_factory,
                   PeerConnection& owner,
@@ -70,6 +79,28 @@ class LocalVideoTrack : public VideoFrameObserver, public MediaTrack {
     return transceiver_;
   }
 
+  /// Get the current parameters of the send encodings of the RTP sender the
+  /// track is attached to. See |Transceiver::GetSendEncodings()|.
+  Result GetSendEncodings(
+      std::vector<mrsSendEncodingParameters>& encodings) const noexcept;
+
+  /// Change the parameters of the send encoding at index |index| of the RTP
+  /// sender the track is attached to, without renegotiating. The other
+  /// encodings are left unchanged.
+  Result SetSendEncoding(uint32_t index,
+                         const mrsSendEncodingParameters& encoding) noexcept;
+
+  /// Set the preference for degrading the video when the encoder is
+  /// constrained. This is implemented with the content hint of the track, so
+  /// applies to all its senders and persists when the track moves between
+  /// transceivers.
+  void SetDegradationPreference(mrsDegradationPreference preference) noexcept;
+
+  /// Get the preference for degrading the video when the encoder is
+  /// constrained. See |SetDegradationPreference()|.
+  MRS_NODISCARD mrsDegradationPreference GetDegradationPreference() const
+      noexcept;
+
   //
   // Advanced use
   //
@@ -111,6 +142,9 @@ class LocalVideoTrack : public VideoFrameObserver, public MediaTrack {
 
   /// Cached track name, to avoid dispatching on signaling thread.
   const std::string track_name_;
+
+  /// Optional external video track source owned by this track.
+  RefPtr<ExternalVideoTrackSource> owned_source_;
 };
 
 }  // namespace WebRTC
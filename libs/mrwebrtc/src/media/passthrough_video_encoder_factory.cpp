@@ -0,0 +1,315 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "api/video/i420_buffer.h"
+#include "api/video_codecs/video_encoder.h"
+#include "modules/include/module_common_types.h"
+#include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/include/video_error_codes.h"
+
+#include "passthrough_video_encoder_factory.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Set of all live encoded frame buffers, to identify them among other native
+/// buffers without relying on RTTI, which WebRTC is built without.
+std::unordered_set<const webrtc::VideoFrameBuffer*> s_encoded_buffers;
+std::mutex s_encoded_buffers_mutex;
+
+/// Fill |header| with the location of the NAL units of an H.264 access unit in
+/// Annex B format, excluding their start codes.
+void BuildH264Fragmentation(const uint8_t* data,
+                            size_t size,
+                            webrtc::RTPFragmentationHeader& header) {
+  std::vector<std::pair<size_t, size_t>> nalus;  // (offset, length)
+  for (size_t i = 0; i + 2 < size; ++i) {
+    if ((data[i] == 0) && (data[i + 1] == 0) && (data[i + 2] == 1)) {
+      if (!nalus.empty()) {
+        // A 4-byte start code has an extra leading zero byte, which belongs
+        // to neither unit.
+        const size_t end = ((i > 0) && (data[i - 1] == 0) ? i - 1 : i);
+        nalus.back().second = end - nalus.back().first;
+      }
+      nalus.emplace_back(i + 3, 0);
+      i += 2;
+    }
+  }
+  if (!nalus.empty()) {
+    nalus.back().second = size - nalus.back().first;
+  }
+  header.VerifyAndAllocateFragmentationHeader(nalus.size());
+  for (size_t i = 0; i < nalus.size(); ++i) {
+    header.fragmentationOffset[i] = nalus[i].first;
+    header.fragmentationLength[i] = nalus[i].second;
+  }
+}
+
+/// Encoder emitting the access units of encoded frames as-is, and delegating
+/// any raw frame to a wrapped encoder. Raw frames can still reach the encoder,
+/// for example the black frames sent by a disabled track.
+class PassthroughVideoEncoder : public webrtc::VideoEncoder {
+ public:
+  PassthroughVideoEncoder(webrtc::VideoCodecType codec_type,
+                          std::unique_ptr<webrtc::VideoEncoder> encoder)
+      : codec_type_(codec_type), encoder_(std::move(encoder)) {}
+
+  int32_t InitEncode(const webrtc::VideoCodec* codec_settings,
+                     int32_t number_of_cores,
+                     size_t max_payload_size) override {
+    // A new stream needs a key frame before any delta frame.
+    waiting_for_key_frame_ = true;
+    return encoder_->InitEncode(codec_settings, number_of_cores,
+                                max_payload_size);
+  }
+
+  int32_t RegisterEncodeCompleteCallback(
+      webrtc::EncodedImageCallback* callback) override {
+    callback_ = callback;
+    return encoder_->RegisterEncodeCompleteCallback(callback);
+  }
+
+  int32_t Release() override { return encoder_->Release(); }
+
+  int32_t Encode(const webrtc::VideoFrame& frame,
+                 const webrtc::CodecSpecificInfo* codec_specific_info,
+                 const std::vector<webrtc::FrameType>* frame_types) override {
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer =
+        frame.video_frame_buffer();
+    if (buffer->type() != webrtc::VideoFrameBuffer::Type::kNative) {
+      return encoder_->Encode(frame, codec_specific_info, frame_types);
+    }
+    const EncodedVideoFrameBuffer* encoded =
+        EncodedVideoFrameBuffer::FromBuffer(buffer.get());
+    if (!encoded) {
+      return encoder_->Encode(frame, codec_specific_info, frame_types);
+    }
+    return EncodePassthrough(frame, *encoded, frame_types);
+  }
+
+  int32_t SetChannelParameters(uint32_t packet_loss, int64_t rtt) override {
+    return encoder_->SetChannelParameters(packet_loss, rtt);
+  }
+
+  int32_t SetRateAllocation(const webrtc::VideoBitrateAllocation& allocation,
+                            uint32_t framerate) override {
+    return encoder_->SetRateAllocation(allocation, framerate);
+  }
+
+  ScalingSettings GetScalingSettings() const override {
+    // Encoded frames cannot be scaled, so disable quality scaling.
+    return ScalingSettings::kOff;
+  }
+
+  bool SupportsNativeHandle() const override { return true; }
+
+  const char* ImplementationName() const override { return "Passthrough"; }
+
+ protected:
+  int32_t EncodePassthrough(const webrtc::VideoFrame& frame,
+                            const EncodedVideoFrameBuffer& buffer,
+                            const std::vector<webrtc::FrameType>* frame_types) {
+    if (!callback_) {
+      return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
+    }
+    if (buffer.codec_type() != codec_type_) {
+      if (!codec_mismatch_logged_) {
+        RTC_LOG(LS_ERROR) << "Dropping encoded frames of codec type "
+                          << buffer.codec_type()
+                          << " on a stream negotiated with codec type "
+                          << codec_type_ << ".";
+        codec_mismatch_logged_ = true;
+      }
+      return WEBRTC_VIDEO_CODEC_OK;
+    }
+
+    // Forward key frame requests to the source, and drop delta frames until a
+    // key frame is received, since they cannot be decoded without it.
+    if (frame_types) {
+      for (webrtc::FrameType type : *frame_types) {
+        if (type == webrtc::kVideoFrameKey) {
+          waiting_for_key_frame_ = true;
+          break;
+        }
+      }
+    }
+    if (buffer.is_key_frame()) {
+      waiting_for_key_frame_ = false;
+      key_frame_requested_ = false;
+    } else if (waiting_for_key_frame_) {
+      if (!key_frame_requested_) {
+        if (KeyFrameRequestSink* sink = buffer.key_frame_request_sink()) {
+          sink->OnKeyFrameRequested();
+        }
+        key_frame_requested_ = true;
+      }
+      return WEBRTC_VIDEO_CODEC_OK;
+    }
+
+    const std::vector<uint8_t>& data = buffer.data();
+    return DeliverEncodedAccessUnit(callback_, codec_type_, frame, data.data(),
+                                    data.size(), buffer.width(),
+                                    buffer.height(), buffer.is_key_frame());
+  }
+
+ private:
+  const webrtc::VideoCodecType codec_type_;
+  std::unique_ptr<webrtc::VideoEncoder> encoder_;
+  webrtc::EncodedImageCallback* callback_{nullptr};
+
+  /// Delta frames are dropped until the next key frame. Only accessed on the
+  /// encoder thread, like all encoder methods.
+  bool waiting_for_key_frame_{true};
+
+  /// A key frame was requested from the source since the last key frame.
+  bool key_frame_requested_{false};
+
+  bool codec_mismatch_logged_{false};
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+EncodedVideoFrameBuffer::EncodedVideoFrameBuffer(
+    webrtc::VideoCodecType codec_type,
+    int width,
+    int height,
+    bool is_key_frame,
+    const uint8_t* data,
+    size_t size,
+    rtc::scoped_refptr<KeyFrameRequestSink> sink)
+    : codec_type_(codec_type),
+      width_(width),
+      height_(height),
+      is_key_frame_(is_key_frame),
+      data_(data, data + size),
+      sink_(std::move(sink)) {
+  std::lock_guard<std::mutex> lock(s_encoded_buffers_mutex);
+  s_encoded_buffers.insert(this);
+}
+
+EncodedVideoFrameBuffer::~EncodedVideoFrameBuffer() {
+  std::lock_guard<std::mutex> lock(s_encoded_buffers_mutex);
+  s_encoded_buffers.erase(this);
+}
+
+const EncodedVideoFrameBuffer* EncodedVideoFrameBuffer::FromBuffer(
+    const webrtc::VideoFrameBuffer* buffer) {
+  std::lock_guard<std::mutex> lock(s_encoded_buffers_mutex);
+  if (s_encoded_buffers.find(buffer) == s_encoded_buffers.end()) {
+    return nullptr;
+  }
+  return static_cast<const EncodedVideoFrameBuffer*>(buffer);
+}
+
+rtc::scoped_refptr<webrtc::I420BufferInterface>
+EncodedVideoFrameBuffer::ToI420() {
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      webrtc::I420Buffer::Create(width_, height_);
+  webrtc::I420Buffer::SetBlack(buffer);
+  return buffer;
+}
+
+int32_t DeliverEncodedAccessUnit(webrtc::EncodedImageCallback* callback,
+                                 webrtc::VideoCodecType codec_type,
+                                 const webrtc::VideoFrame& frame,
+                                 const uint8_t* data,
+                                 size_t size,
+                                 int width,
+                                 int height,
+                                 bool is_key_frame) {
+  // The encoded image does not own its data, which outlives this call.
+  webrtc::EncodedImage image(const_cast<uint8_t*>(data), size, size);
+  image._encodedWidth = width;
+  image._encodedHeight = height;
+  image.SetTimestamp(frame.timestamp());
+  image.ntp_time_ms_ = frame.ntp_time_ms();
+  image.capture_time_ms_ = frame.render_time_ms();
+  image.rotation_ = frame.rotation();
+  image._frameType =
+      (is_key_frame ? webrtc::kVideoFrameKey : webrtc::kVideoFrameDelta);
+  image._completeFrame = true;
+
+  webrtc::CodecSpecificInfo info;
+  info.codecType = codec_type;
+  webrtc::RTPFragmentationHeader fragmentation;
+  webrtc::RTPFragmentationHeader* fragmentation_ptr = nullptr;
+  switch (codec_type) {
+    case webrtc::kVideoCodecVP8:
+      info.codecSpecific.VP8.temporalIdx = webrtc::kNoTemporalIdx;
+      info.codecSpecific.VP8.keyIdx = webrtc::kNoKeyIdx;
+      break;
+    case webrtc::kVideoCodecVP9: {
+      webrtc::CodecSpecificInfoVP9& vp9 = info.codecSpecific.VP9;
+      vp9.first_frame_in_picture = true;
+      vp9.inter_pic_predicted = !is_key_frame;
+      vp9.temporal_idx = webrtc::kNoTemporalIdx;
+      vp9.spatial_idx = webrtc::kNoSpatialIdx;
+      vp9.num_spatial_layers = 1;
+      vp9.end_of_picture = true;
+      vp9.ss_data_available = is_key_frame;
+      if (vp9.ss_data_available) {
+        vp9.spatial_layer_resolution_present = true;
+        vp9.width[0] = width;
+        vp9.height[0] = height;
+        vp9.gof.SetGofInfoVP9(webrtc::kTemporalStructureMode1);
+      }
+    } break;
+    case webrtc::kVideoCodecH264:
+      info.codecSpecific.H264.packetization_mode =
+          webrtc::H264PacketizationMode::NonInterleaved;
+      BuildH264Fragmentation(data, size, fragmentation);
+      fragmentation_ptr = &fragmentation;
+      break;
+    default:
+      break;
+  }
+
+  const webrtc::EncodedImageCallback::Result result =
+      callback->OnEncodedImage(image, &info, fragmentation_ptr);
+  if (result.error != webrtc::EncodedImageCallback::Result::OK) {
+    return WEBRTC_VIDEO_CODEC_ERROR;
+  }
+  return WEBRTC_VIDEO_CODEC_OK;
+}
+
+PassthroughVideoEncoderFactory::PassthroughVideoEncoderFactory(
+    std::unique_ptr<webrtc::VideoEncoderFactory> factory)
+    : factory_(std::move(factory)) {}
+
+std::vector<webrtc::SdpVideoFormat>
+PassthroughVideoEncoderFactory::GetSupportedFormats() const {
+  return factory_->GetSupportedFormats();
+}
+
+webrtc::VideoEncoderFactory::CodecInfo
+PassthroughVideoEncoderFactory::QueryVideoEncoder(
+    const webrtc::SdpVideoFormat& format) const {
+  return factory_->QueryVideoEncoder(format);
+}
+
+std::unique_ptr<webrtc::VideoEncoder>
+PassthroughVideoEncoderFactory::CreateVideoEncoder(
+    const webrtc::SdpVideoFormat& format) {
+  std::unique_ptr<webrtc::VideoEncoder> encoder =
+      factory_->CreateVideoEncoder(format);
+  if (!encoder) {
+    return nullptr;
+  }
+  const webrtc::VideoCodecType codec_type =
+      webrtc::PayloadStringToCodecType(format.name);
+  return absl::make_unique<PassthroughVideoEncoder>(codec_type,
+                                                    std::move(encoder));
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
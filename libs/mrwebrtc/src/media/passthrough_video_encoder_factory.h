@@ -0,0 +1,98 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "api/video/video_frame.h"
+#include "api/video/video_frame_buffer.h"
+#include "api/video_codecs/video_encoder.h"
+#include "api/video_codecs/video_encoder_factory.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Receiver of the key frame requests issued by the passthrough encoders for
+/// the frames of an encoded video source.
+class KeyFrameRequestSink : public rtc::RefCountInterface {
+ public:
+  /// Request the source to produce a key frame as soon as possible.
+  virtual void OnKeyFrameRequested() noexcept = 0;
+};
+
+/// Native video frame buffer carrying an already-encoded access unit instead
+/// of raw pixels. Frames with such a buffer flow through the video track like
+/// any other frame, and are emitted as-is by the passthrough encoder.
+class EncodedVideoFrameBuffer : public webrtc::VideoFrameBuffer {
+ public:
+  EncodedVideoFrameBuffer(webrtc::VideoCodecType codec_type,
+                          int width,
+                          int height,
+                          bool is_key_frame,
+                          const uint8_t* data,
+                          size_t size,
+                          rtc::scoped_refptr<KeyFrameRequestSink> sink);
+  ~EncodedVideoFrameBuffer() override;
+
+  /// Get the encoded frame buffer |buffer| is, or NULL if it is not one.
+  static const EncodedVideoFrameBuffer* FromBuffer(
+      const webrtc::VideoFrameBuffer* buffer);
+
+  Type type() const override { return Type::kNative; }
+  int width() const override { return width_; }
+  int height() const override { return height_; }
+
+  /// Raw pixels are not available without decoding, so this returns a black
+  /// frame, for consumers like local previews which need one.
+  rtc::scoped_refptr<webrtc::I420BufferInterface> ToI420() override;
+
+  webrtc::VideoCodecType codec_type() const { return codec_type_; }
+  bool is_key_frame() const { return is_key_frame_; }
+  const std::vector<uint8_t>& data() const { return data_; }
+  KeyFrameRequestSink* key_frame_request_sink() const { return sink_.get(); }
+
+ private:
+  const webrtc::VideoCodecType codec_type_;
+  const int width_;
+  const int height_;
+  const bool is_key_frame_;
+  const std::vector<uint8_t> data_;
+  const rtc::scoped_refptr<KeyFrameRequestSink> sink_;
+};
+
+/// Deliver to |callback| an access unit encoded outside of the WebRTC encoders
+/// for the raw |frame|, along with the codec-specific information needed to
+/// packetize it. Return a WEBRTC_VIDEO_CODEC_* status code.
+int32_t DeliverEncodedAccessUnit(webrtc::EncodedImageCallback* callback,
+                                 webrtc::VideoCodecType codec_type,
+                                 const webrtc::VideoFrame& frame,
+                                 const uint8_t* data,
+                                 size_t size,
+                                 int width,
+                                 int height,
+                                 bool is_key_frame);
+
+/// Video encoder factory wrapping another factory, whose encoders emit the
+/// access units of |EncodedVideoFrameBuffer| frames without re-encoding them,
+/// and delegate any other frame to the wrapped encoder.
+class PassthroughVideoEncoderFactory : public webrtc::VideoEncoderFactory {
+ public:
+  explicit PassthroughVideoEncoderFactory(
+      std::unique_ptr<webrtc::VideoEncoderFactory> factory);
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  CodecInfo QueryVideoEncoder(
+      const webrtc::SdpVideoFormat& format) const override;
+  std::unique_ptr<webrtc::VideoEncoder> CreateVideoEncoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  std::unique_ptr<webrtc::VideoEncoderFactory> factory_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
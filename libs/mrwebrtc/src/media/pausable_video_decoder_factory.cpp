@@ -0,0 +1,192 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <unordered_map>
+
+#include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/include/video_error_codes.h"
+#include "rtc_base/refcountedobject.h"
+
+#include "pausable_video_decoder_factory.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Map of the last buffer decoded by each pausable decoder to the pause control
+/// of that decoder. The controls are not referenced by the map, each decoder
+/// removes its entry before releasing its own reference.
+std::unordered_map<const webrtc::VideoFrameBuffer*, VideoDecoderPauseControl*>
+    s_decoded_buffers;
+std::mutex s_decoded_buffers_mutex;
+
+/// Decoder wrapping another decoder, skipping the decoding of the encoded
+/// frames received while paused. This is also the callback of the wrapped
+/// decoder, to record which buffers it produced.
+class PausableVideoDecoder : public webrtc::VideoDecoder,
+                             public webrtc::DecodedImageCallback {
+ public:
+  explicit PausableVideoDecoder(std::unique_ptr<webrtc::VideoDecoder> decoder)
+      : decoder_(std::move(decoder)),
+        control_(new rtc::RefCountedObject<VideoDecoderPauseControl>()) {}
+
+  ~PausableVideoDecoder() override { control_->OnDecoderDestroyed(); }
+
+  int32_t InitDecode(const webrtc::VideoCodec* codec_settings,
+                     int32_t number_of_cores) override {
+    return decoder_->InitDecode(codec_settings, number_of_cores);
+  }
+
+  int32_t Decode(const webrtc::EncodedImage& input_image,
+                 bool missing_frames,
+                 const webrtc::CodecSpecificInfo* codec_specific_info,
+                 int64_t render_time_ms) override {
+    const bool is_key_frame =
+        (input_image._frameType == webrtc::kVideoFrameKey);
+    if (control_->ShouldDrop(is_key_frame)) {
+      // While paused, report success so that the receive stream does not flood
+      // the sender with key frame requests. Once resumed, the error makes the
+      // receive stream request the key frame the decoder is waiting for.
+      return (control_->IsPaused() ? WEBRTC_VIDEO_CODEC_OK
+                                   : WEBRTC_VIDEO_CODEC_ERROR);
+    }
+    return decoder_->Decode(input_image, missing_frames, codec_specific_info,
+                            render_time_ms);
+  }
+
+  int32_t RegisterDecodeCompleteCallback(
+      webrtc::DecodedImageCallback* callback) override {
+    callback_ = callback;
+    return decoder_->RegisterDecodeCompleteCallback(callback ? this : nullptr);
+  }
+
+  int32_t Release() override { return decoder_->Release(); }
+
+  bool PrefersLateDecoding() const override {
+    return decoder_->PrefersLateDecoding();
+  }
+
+  const char* ImplementationName() const override {
+    return decoder_->ImplementationName();
+  }
+
+  int32_t Decoded(webrtc::VideoFrame& decoded_image) override {
+    control_->OnDecoded(decoded_image.video_frame_buffer().get());
+    return callback_->Decoded(decoded_image);
+  }
+
+  int32_t Decoded(webrtc::VideoFrame& decoded_image,
+                  int64_t decode_time_ms) override {
+    control_->OnDecoded(decoded_image.video_frame_buffer().get());
+    return callback_->Decoded(decoded_image, decode_time_ms);
+  }
+
+  void Decoded(webrtc::VideoFrame& decoded_image,
+               absl::optional<int32_t> decode_time_ms,
+               absl::optional<uint8_t> qp) override {
+    control_->OnDecoded(decoded_image.video_frame_buffer().get());
+    callback_->Decoded(decoded_image, decode_time_ms, qp);
+  }
+
+  int32_t ReceivedDecodedReferenceFrame(const uint64_t picture_id) override {
+    return callback_->ReceivedDecodedReferenceFrame(picture_id);
+  }
+
+  int32_t ReceivedDecodedFrame(const uint64_t picture_id) override {
+    return callback_->ReceivedDecodedFrame(picture_id);
+  }
+
+ private:
+  std::unique_ptr<webrtc::VideoDecoder> decoder_;
+  rtc::scoped_refptr<VideoDecoderPauseControl> control_;
+  webrtc::DecodedImageCallback* callback_{nullptr};
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+rtc::scoped_refptr<VideoDecoderPauseControl>
+VideoDecoderPauseControl::FromBuffer(const webrtc::VideoFrameBuffer* buffer) {
+  std::lock_guard<std::mutex> lock(s_decoded_buffers_mutex);
+  auto it = s_decoded_buffers.find(buffer);
+  if (it == s_decoded_buffers.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void VideoDecoderPauseControl::SetPaused(bool paused) noexcept {
+  paused_.store(paused, std::memory_order_relaxed);
+}
+
+bool VideoDecoderPauseControl::ShouldDrop(bool is_key_frame) noexcept {
+  if (paused_.load(std::memory_order_relaxed)) {
+    // The frames skipped are missing from the references of the next delta
+    // frames, so decoding cannot resume before a key frame.
+    key_frame_required_.store(true, std::memory_order_relaxed);
+    return true;
+  }
+  if (key_frame_required_.load(std::memory_order_relaxed)) {
+    if (!is_key_frame) {
+      return true;
+    }
+    key_frame_required_.store(false, std::memory_order_relaxed);
+  }
+  return false;
+}
+
+void VideoDecoderPauseControl::OnDecoded(
+    const webrtc::VideoFrameBuffer* buffer) {
+  if (buffer == last_buffer_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(s_decoded_buffers_mutex);
+  auto it = s_decoded_buffers.find(last_buffer_);
+  if ((it != s_decoded_buffers.end()) && (it->second == this)) {
+    s_decoded_buffers.erase(it);
+  }
+  // Buffers are pooled and their memory reused, so a buffer of another decoder
+  // may have been at the same address; the last decoder wins.
+  s_decoded_buffers[buffer] = this;
+  last_buffer_ = buffer;
+}
+
+void VideoDecoderPauseControl::OnDecoderDestroyed() {
+  std::lock_guard<std::mutex> lock(s_decoded_buffers_mutex);
+  auto it = s_decoded_buffers.find(last_buffer_);
+  if ((it != s_decoded_buffers.end()) && (it->second == this)) {
+    s_decoded_buffers.erase(it);
+  }
+  last_buffer_ = nullptr;
+}
+
+PausableVideoDecoderFactory::PausableVideoDecoderFactory(
+    std::unique_ptr<webrtc::VideoDecoderFactory> factory)
+    : factory_(std::move(factory)) {}
+
+std::vector<webrtc::SdpVideoFormat>
+PausableVideoDecoderFactory::GetSupportedFormats() const {
+  return factory_->GetSupportedFormats();
+}
+
+std::unique_ptr<webrtc::VideoDecoder>
+PausableVideoDecoderFactory::CreateVideoDecoder(
+    const webrtc::SdpVideoFormat& format) {
+  std::unique_ptr<webrtc::VideoDecoder> decoder =
+      factory_->CreateVideoDecoder(format);
+  if (!decoder) {
+    return nullptr;
+  }
+  return std::make_unique<PausableVideoDecoder>(std::move(decoder));
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "api/video/video_frame_buffer.h"
+#include "api/video_codecs/video_decoder.h"
+#include "api/video_codecs/video_decoder_factory.h"
+#include "rtc_base/refcount.h"
+#include "rtc_base/scoped_ref_ptr.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Pause state of a decoder created by |PausableVideoDecoderFactory|, shared
+/// with the remote video track the decoder produces frames for, since either
+/// can be destroyed first.
+///
+/// While paused, the decoder drops the encoded frames without decoding them.
+/// Once resumed, it keeps dropping them until a key frame is received, and
+/// reports a decoding error for each of them, which makes the video receive
+/// stream request a key frame from the sender.
+class VideoDecoderPauseControl : public rtc::RefCountInterface {
+ public:
+  /// Find the pause control of the decoder which decoded a frame buffer, or
+  /// NULL if the buffer was not the last one produced by a pausable decoder.
+  static rtc::scoped_refptr<VideoDecoderPauseControl> FromBuffer(
+      const webrtc::VideoFrameBuffer* buffer);
+
+  /// Pause or resume the decoding.
+  void SetPaused(bool paused) noexcept;
+
+  /// Check whether the decoding is paused.
+  bool IsPaused() const noexcept {
+    return paused_.load(std::memory_order_relaxed);
+  }
+
+  /// Check whether an encoded frame must be dropped instead of being decoded,
+  /// and update the key frame requirement accordingly. Only the decoding
+  /// thread calls this.
+  bool ShouldDrop(bool is_key_frame) noexcept;
+
+  /// Record that |buffer| is the last buffer decoded, for |FromBuffer()| to
+  /// find this control from it.
+  void OnDecoded(const webrtc::VideoFrameBuffer* buffer);
+
+  /// Forget the last buffer decoded, when the decoder is destroyed.
+  void OnDecoderDestroyed();
+
+ protected:
+  ~VideoDecoderPauseControl() override = default;
+
+ private:
+  std::atomic_bool paused_{false};
+  std::atomic_bool key_frame_required_{false};
+
+  /// Last buffer decoded, only used as a key of the buffer registry.
+  const webrtc::VideoFrameBuffer* last_buffer_{nullptr};
+};
+
+/// Video decoder factory wrapping another factory, whose decoders can skip
+/// decoding while the remote video track they decode for is paused. See
+/// |VideoDecoderPauseControl|.
+class PausableVideoDecoderFactory : public webrtc::VideoDecoderFactory {
+ public:
+  explicit PausableVideoDecoderFactory(
+      std::unique_ptr<webrtc::VideoDecoderFactory> factory);
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  std::unique_ptr<webrtc::VideoDecoder> CreateVideoDecoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  std::unique_ptr<webrtc::VideoDecoderFactory> factory_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
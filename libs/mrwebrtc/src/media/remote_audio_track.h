@@ -68,13 +68,6 @@ class RemoteAudioTrack : public AudioFrameObserver, public MediaTrack {
   // Advanced use
   //
 
-  /// Get a handle to the remote audio track. This handle is valid until the
-  /// remote track is removed from the peer connection and destroyed, which is
-  /// signaled by the |TrackRemoved| event on the peer connection.
-  MRS_NODISCARD constexpr mrsRemoteAudioTrackHandle GetHandle() const noexcept {
-    return (mrsRemoteAudioTrackHandle)this;
-  }
-
   MRS_NODISCARD webrtc::AudioTrackInterface* impl() const;
   MRS_NODISCARD webrtc::RtpReceiverInterface* receiver() const;
 
@@ -3,10 +3,19 @@
 
 #include "pch.h"
 
+#include "rtc_base/timeutils.h"
+
 #include "interop/global_factory.h"
 #include "peer_connection.h"
 #include "remote_video_track.h"
 
+namespace {
+
+/// Minimum interval between two frames delivered at low priority.
+constexpr int64_t kLowPriorityFrameIntervalMs = 200;
+
+}  // namespace
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
@@ -49,6 +58,41 @@ void RemoteVideoTrack::SetEnabled(bool enabled) const noexcept {
   track_->set_enabled(enabled);
 }
 
+Result RemoteVideoTrack::SetPriority(
+    mrsRemoteVideoTrackPriority priority) noexcept {
+  switch (priority) {
+    case mrsRemoteVideoTrackPriority::kNormal:
+    case mrsRemoteVideoTrackPriority::kLow:
+    case mrsRemoteVideoTrackPriority::kPaused:
+      break;
+    default:
+      RTC_LOG(LS_ERROR) << "Unknown remote video track priority "
+                        << (int)priority << ".";
+      return Result::kInvalidParameter;
+  }
+  std::lock_guard<std::mutex> lock(priority_mutex_);
+  const mrsRemoteVideoTrackPriority old_priority = priority_.exchange(priority);
+  if (old_priority == priority) {
+    return Result::kSuccess;
+  }
+  next_delivery_time_ms_ = 0;
+  {
+    std::lock_guard<std::mutex> control_lock(decoder_control_mutex_);
+    if (decoder_control_) {
+      decoder_control_->SetPaused(priority ==
+                                  mrsRemoteVideoTrackPriority::kPaused);
+    }
+  }
+  if (priority == mrsRemoteVideoTrackPriority::kPaused) {
+    track_->RemoveSink(this);
+  } else if (old_priority == mrsRemoteVideoTrackPriority::kPaused) {
+    rtc::VideoSinkWants sink_settings{};
+    sink_settings.rotation_applied = true;
+    track_->AddOrUpdateSink(this, sink_settings);
+  }
+  return Result::kSuccess;
+}
+
 webrtc::VideoTrackInterface* RemoteVideoTrack::impl() const {
   return track_.get();
 }
@@ -57,6 +101,39 @@ webrtc::RtpReceiverInterface* RemoteVideoTrack::receiver() const {
   return receiver_.get();
 }
 
+void RemoteVideoTrack::OnFrame(const webrtc::VideoFrame& frame) noexcept {
+  // Find the decoder of the frame, which changes on renegotiation. Frames
+  // rotated for the track are new buffers not matching any decoder; keep the
+  // current one in that case.
+  if (rtc::scoped_refptr<VideoDecoderPauseControl> control =
+          VideoDecoderPauseControl::FromBuffer(
+              frame.video_frame_buffer().get())) {
+    std::lock_guard<std::mutex> control_lock(decoder_control_mutex_);
+    if (control != decoder_control_) {
+      control->SetPaused(priority_.load() ==
+                         mrsRemoteVideoTrackPriority::kPaused);
+      decoder_control_ = std::move(control);
+    }
+  }
+  switch (priority_.load()) {
+    case mrsRemoteVideoTrackPriority::kNormal:
+      break;
+    case mrsRemoteVideoTrackPriority::kLow: {
+      // Frames are delivered sequentially by the decoder, so only the priority
+      // change can race with this, and it only resets the delivery time.
+      const int64_t now_ms = rtc::TimeMillis();
+      if (now_ms < next_delivery_time_ms_.load()) {
+        return;
+      }
+      next_delivery_time_ms_ = now_ms + kLowPriorityFrameIntervalMs;
+    } break;
+    case mrsRemoteVideoTrackPriority::kPaused:
+      // Frame already in flight while detaching from the source
+      return;
+  }
+  VideoFrameObserver::OnFrame(frame);
+}
+
 void RemoteVideoTrack::OnTrackRemoved(PeerConnection& owner) {
   RTC_DCHECK(owner_ == &owner);
   RTC_DCHECK(receiver_ != nullptr);
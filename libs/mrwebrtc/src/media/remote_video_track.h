@@ -3,10 +3,15 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "callback.h"
 #include "interop_api.h"
 #include "media_track.h"
+#include "pausable_video_decoder_factory.h"
 #include "refptr.h"
+#include "remote_video_track_interop.h"
+#include "rtc_base/thread_annotations.h"
 #include "tracked_object.h"
 #include "video_frame_observer.h"
 
@@ -55,17 +60,25 @@ class RemoteVideoTrack : public VideoFrameObserver, public MediaTrack {
   /// See |SetEnabled(bool)|.
   MRS_NODISCARD bool IsEnabled() const noexcept;
 
+  /// Set the delivery priority of the track. A paused track stops the decoder
+  /// of its stream once it knows it, that is after the first frame decoded,
+  /// and is detached from its source, so the frames are not dispatched to it
+  /// at all. When resumed, the decoder waits for a key frame, requesting one
+  /// from the sender. A low priority track drops frames to keep below a fixed
+  /// framerate before delivering them to its callbacks, and therefore before
+  /// any format conversion, but still decodes all of them.
+  Result SetPriority(mrsRemoteVideoTrackPriority priority) noexcept;
+
+  /// Get the delivery priority of the track.
+  /// See |SetPriority()|.
+  MRS_NODISCARD mrsRemoteVideoTrackPriority GetPriority() const noexcept {
+    return priority_.load();
+  }
+
   //
   // Advanced use
   //
 
-  /// Get a handle to the remote video track. This handle is valid until the
-  /// remote track is removed from the peer connection and destroyed, which is
-  /// signaled by the |TrackRemoved| event on the peer connection.
-  MRS_NODISCARD constexpr mrsRemoteVideoTrackHandle GetHandle() const noexcept {
-    return (mrsRemoteVideoTrackHandle)this;
-  }
-
   MRS_NODISCARD webrtc::VideoTrackInterface* impl() const;
   MRS_NODISCARD webrtc::RtpReceiverInterface* receiver() const;
 
@@ -81,6 +94,10 @@ class RemoteVideoTrack : public VideoFrameObserver, public MediaTrack {
   // Automatically called - do not use.
   void OnTrackRemoved(PeerConnection& owner);
 
+ protected:
+  // VideoSinkInterface interface
+  void OnFrame(const webrtc::VideoFrame& frame) noexcept override;
+
  private:
   /// Underlying core implementation.
   rtc::scoped_refptr<webrtc::VideoTrackInterface> track_;
@@ -96,6 +113,28 @@ class RemoteVideoTrack : public VideoFrameObserver, public MediaTrack {
 
   /// Cached track name, to avoid dispatching on signaling thread.
   const std::string track_name_;
+
+  /// Delivery priority of the track.
+  std::atomic<mrsRemoteVideoTrackPriority> priority_{
+      mrsRemoteVideoTrackPriority::kNormal};
+
+  /// Earliest time the next frame can be delivered at low priority, in
+  /// milliseconds. Reset to zero when the priority changes, to deliver the
+  /// next frame immediately.
+  std::atomic<int64_t> next_delivery_time_ms_{0};
+
+  /// Mutex serializing the changes of priority, which attach the track to or
+  /// detach it from its source.
+  std::mutex priority_mutex_;
+
+  /// Pause control of the decoder producing the frames of the track, found
+  /// from the frames it decoded. NULL until the first frame is decoded.
+  rtc::scoped_refptr<VideoDecoderPauseControl> decoder_control_
+      RTC_GUARDED_BY(decoder_control_mutex_);
+
+  /// Mutex for the pause control of the decoder. This is never held while
+  /// calling into the track, which delivers the frames under its own lock.
+  std::mutex decoder_control_mutex_;
 };
 
 }  // namespace WebRTC
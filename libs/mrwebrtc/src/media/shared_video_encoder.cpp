@@ -0,0 +1,255 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+
+#include "api/video_codecs/sdp_video_format.h"
+#include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/include/video_error_codes.h"
+#include "rtc_base/timeutils.h"
+#include "system_wrappers/include/cpu_info.h"
+
+#include "interop/global_factory.h"
+#include "media/encoded_video_track_source.h"
+#include "media/local_video_track.h"
+#include "shared_video_encoder.h"
+
+namespace {
+
+/// Message ID for encoding the pending frame.
+constexpr uint32_t kMsgEncode = 0;
+
+/// Maximum size of the RTP payloads, like the one used by WebRTC for the
+/// encoders of its send streams.
+constexpr size_t kMaxPayloadSize = 1200;
+
+/// Maximum quantizer, like the default of WebRTC for its send streams.
+constexpr unsigned int kDefaultQpMax = 56;
+
+/// Minimum bitrate of the encoder, in kilobits per second.
+constexpr uint32_t kMinBitrateKbps = 30;
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+mrsResult SharedVideoEncoder::ValidateConfig(
+    const mrsSharedVideoEncoderConfig& config) {
+  mrsEncodedVideoTrackSourceInitConfig source_config{};
+  source_config.codec_name = config.codec_name;
+  const mrsResult result =
+      EncodedVideoTrackSource::ValidateConfig(source_config);
+  if (result != mrsResult::kSuccess) {
+    return result;
+  }
+  if (config.bitrate_kbps == 0) {
+    RTC_LOG(LS_ERROR) << "Invalid zero bitrate for shared video encoder.";
+    return mrsResult::kOutOfRange;
+  }
+  if (config.max_framerate == 0) {
+    RTC_LOG(LS_ERROR) << "Invalid zero framerate for shared video encoder.";
+    return mrsResult::kOutOfRange;
+  }
+  return mrsResult::kSuccess;
+}
+
+ErrorOr<std::unique_ptr<SharedVideoEncoder>> SharedVideoEncoder::Create(
+    GlobalFactory& global_factory,
+    RefPtr<LocalVideoTrack> track,
+    EncodedVideoTrackSource& output,
+    const mrsSharedVideoEncoderConfig& config) {
+  const mrsResult result = ValidateConfig(config);
+  if (result != mrsResult::kSuccess) {
+    return Error(result);
+  }
+  const webrtc::SdpVideoFormat format(config.codec_name);
+  std::unique_ptr<webrtc::VideoEncoder> encoder =
+      global_factory.CreateVideoEncoder(format);
+  if (!encoder) {
+    RTC_LOG(LS_ERROR) << "Failed to create " << config.codec_name
+                      << " encoder for shared video encoder.";
+    return Error(mrsResult::kUnsupported);
+  }
+  std::unique_ptr<SharedVideoEncoder> shared_encoder(new SharedVideoEncoder(
+      track, output, webrtc::PayloadStringToCodecType(config.codec_name),
+      std::move(encoder), config));
+  rtc::VideoSinkWants wants;
+  wants.rotation_applied = true;  // encoded frames are sent without rotation
+  track->impl()->AddOrUpdateSink(shared_encoder.get(), wants);
+  return std::move(shared_encoder);
+}
+
+SharedVideoEncoder::SharedVideoEncoder(
+    RefPtr<LocalVideoTrack> track,
+    EncodedVideoTrackSource& output,
+    webrtc::VideoCodecType codec_type,
+    std::unique_ptr<webrtc::VideoEncoder> encoder,
+    const mrsSharedVideoEncoderConfig& config)
+    : track_(std::move(track)),
+      output_(output),
+      codec_type_(codec_type),
+      bitrate_kbps_(config.bitrate_kbps),
+      max_framerate_(config.max_framerate),
+      min_key_frame_interval_ms_(config.min_key_frame_interval_ms),
+      thread_(rtc::Thread::Create()),
+      encoder_(std::move(encoder)) {
+  thread_->SetName("SharedVideoEncoder thread", this);
+  thread_->Start();
+}
+
+SharedVideoEncoder::~SharedVideoEncoder() {
+  // Stop receiving frames, then let the thread finish the frame it may be
+  // encoding, after which the encoder is not accessed concurrently anymore.
+  track_->impl()->RemoveSink(this);
+  thread_->Stop();
+  thread_.reset();
+  if (initialized_) {
+    encoder_->Release();
+  }
+}
+
+void SharedVideoEncoder::OnFrame(const webrtc::VideoFrame& frame) {
+  bool post;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    post = !pending_frame_.has_value();
+    pending_frame_ = frame;
+  }
+  // Post a single message for any number of frames, so that only the latest
+  // frame is encoded if the encoder falls behind.
+  if (post) {
+    thread_->Post(RTC_FROM_HERE, this, kMsgEncode);
+  }
+}
+
+webrtc::EncodedImageCallback::Result SharedVideoEncoder::OnEncodedImage(
+    const webrtc::EncodedImage& encoded_image,
+    const webrtc::CodecSpecificInfo* /*codec_specific_info*/,
+    const webrtc::RTPFragmentationHeader* /*fragmentation*/) {
+  RTC_DCHECK(thread_->IsCurrent());
+  const bool is_key_frame =
+      (encoded_image._frameType == webrtc::kVideoFrameKey);
+  if (is_key_frame) {
+    // Any request received so far is satisfied by this frame.
+    key_frame_requested_ = false;
+    last_key_frame_ms_ = rtc::TimeMillis();
+  }
+  mrsEncodedVideoFrame frame{};
+  frame.data = encoded_image._buffer;
+  frame.size = static_cast<uint32_t>(encoded_image._length);
+  frame.width = (encoded_image._encodedWidth > 0 ? encoded_image._encodedWidth
+                                                 : width_);
+  frame.height = (encoded_image._encodedHeight > 0
+                      ? encoded_image._encodedHeight
+                      : height_);
+  frame.is_key_frame = (is_key_frame ? mrsBool::kTrue : mrsBool::kFalse);
+  frame.timestamp_us = current_timestamp_us_;
+  if (output_.PushFrame(frame) != mrsResult::kSuccess) {
+    return webrtc::EncodedImageCallback::Result(
+        webrtc::EncodedImageCallback::Result::ERROR_SEND_FAILED);
+  }
+  return webrtc::EncodedImageCallback::Result(
+      webrtc::EncodedImageCallback::Result::OK);
+}
+
+void SharedVideoEncoder::OnMessage(rtc::Message* msg) {
+  RTC_DCHECK(thread_->IsCurrent());
+  switch (msg->message_id) {
+    case kMsgEncode:
+      EncodePendingFrame();
+      break;
+    default:
+      RTC_NOTREACHED();
+  }
+}
+
+void SharedVideoEncoder::EncodePendingFrame() {
+  RTC_DCHECK(thread_->IsCurrent());
+  absl::optional<webrtc::VideoFrame> frame;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame = std::move(pending_frame_);
+    pending_frame_.reset();
+  }
+  if (!frame) {
+    return;
+  }
+  if (!initialized_ || (frame->width() != width_) ||
+      (frame->height() != height_)) {
+    if (!InitEncoder(frame->width(), frame->height())) {
+      return;
+    }
+  }
+
+  // Aggregate all the key frame requests since the last key frame into a
+  // single key frame, no more often than the minimum interval. The first
+  // frame after initializing is always a key frame.
+  std::vector<webrtc::FrameType> frame_types{webrtc::kVideoFrameDelta};
+  if (key_frame_requested_ &&
+      (rtc::TimeMillis() - last_key_frame_ms_ >= min_key_frame_interval_ms_)) {
+    frame_types[0] = webrtc::kVideoFrameKey;
+  }
+  current_timestamp_us_ = frame->timestamp_us();
+  const int32_t ret = encoder_->Encode(*frame, nullptr, &frame_types);
+  if (ret != WEBRTC_VIDEO_CODEC_OK) {
+    RTC_LOG(LS_WARNING) << "Shared video encoder failed to encode frame: "
+                        << ret;
+  }
+}
+
+bool SharedVideoEncoder::InitEncoder(int width, int height) {
+  RTC_DCHECK(thread_->IsCurrent());
+  if (initialized_) {
+    encoder_->Release();
+    initialized_ = false;
+  }
+  webrtc::VideoCodec codec;
+  codec.codecType = codec_type_;
+  codec.width = static_cast<uint16_t>(width);
+  codec.height = static_cast<uint16_t>(height);
+  codec.startBitrate = bitrate_kbps_;
+  codec.minBitrate = std::min(kMinBitrateKbps, bitrate_kbps_);
+  codec.maxBitrate = bitrate_kbps_;
+  codec.maxFramerate = max_framerate_;
+  codec.qpMax = kDefaultQpMax;
+  codec.numberOfSimulcastStreams = 0;
+  codec.mode = webrtc::VideoCodecMode::kRealtimeVideo;
+  switch (codec_type_) {
+    case webrtc::kVideoCodecVP8:
+      *codec.VP8() = webrtc::VideoEncoder::GetDefaultVp8Settings();
+      break;
+    case webrtc::kVideoCodecVP9:
+      *codec.VP9() = webrtc::VideoEncoder::GetDefaultVp9Settings();
+      break;
+    case webrtc::kVideoCodecH264:
+      *codec.H264() = webrtc::VideoEncoder::GetDefaultH264Settings();
+      break;
+    default:
+      break;
+  }
+  const int number_of_cores = webrtc::CpuInfo::DetectNumberOfCores();
+  if (encoder_->InitEncode(&codec, number_of_cores, kMaxPayloadSize) !=
+      WEBRTC_VIDEO_CODEC_OK) {
+    RTC_LOG(LS_ERROR) << "Failed to initialize shared video encoder for "
+                      << width << "x" << height << " frames.";
+    return false;
+  }
+  encoder_->RegisterEncodeCompleteCallback(this);
+  webrtc::VideoBitrateAllocation allocation;
+  allocation.SetBitrate(0, 0, bitrate_kbps_ * 1000);
+  encoder_->SetRateAllocation(allocation, max_framerate_);
+  width_ = width;
+  height_ = height;
+  initialized_ = true;
+  return true;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
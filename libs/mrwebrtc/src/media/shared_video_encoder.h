@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "absl/types/optional.h"
+#include "api/video/video_frame.h"
+#include "api/video/video_sink_interface.h"
+#include "api/video_codecs/video_encoder.h"
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/thread.h"
+
+#include "encoded_video_track_source_interop.h"
+#include "mrs_errors.h"
+#include "refptr.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class EncodedVideoTrackSource;
+class GlobalFactory;
+class LocalVideoTrack;
+
+/// Encoder encoding the raw frames of a local video track once, and pushing
+/// the encoded frames to an encoded video track source, from which they fan
+/// out to any number of peer connections without being re-encoded.
+///
+/// Frames are encoded on a dedicated thread. If a frame arrives while the
+/// previous one is still waiting to be encoded, the previous one is dropped,
+/// so a slow encoder lowers the frame rate instead of accumulating latency.
+///
+/// The key frame requests of all the senders of the source are aggregated:
+/// any number of requests received before the next frame produce a single
+/// key frame, and key frames are forced at most once per minimum interval.
+class SharedVideoEncoder : public rtc::VideoSinkInterface<webrtc::VideoFrame>,
+                           public webrtc::EncodedImageCallback,
+                           public rtc::MessageHandler {
+ public:
+  /// Check that the given configuration is valid for a shared encoder. This
+  /// uses |mrsResult| since |Result| names the result type of the base
+  /// |webrtc::EncodedImageCallback| in the scope of this class.
+  static mrsResult ValidateConfig(const mrsSharedVideoEncoderConfig& config);
+
+  /// Create an encoder for the frames of |track|, pushing its output to
+  /// |output|, which must outlive the encoder.
+  static ErrorOr<std::unique_ptr<SharedVideoEncoder>> Create(
+      GlobalFactory& global_factory,
+      RefPtr<LocalVideoTrack> track,
+      EncodedVideoTrackSource& output,
+      const mrsSharedVideoEncoderConfig& config);
+
+  ~SharedVideoEncoder() override;
+
+  /// Request a key frame for the next encoded frame, subject to the minimum
+  /// interval between forced key frames. This can be called from any thread.
+  void RequestKeyFrame() noexcept { key_frame_requested_ = true; }
+
+  //
+  // VideoSinkInterface
+  //
+
+  void OnFrame(const webrtc::VideoFrame& frame) override;
+
+  //
+  // EncodedImageCallback
+  //
+
+  webrtc::EncodedImageCallback::Result OnEncodedImage(
+      const webrtc::EncodedImage& encoded_image,
+      const webrtc::CodecSpecificInfo* codec_specific_info,
+      const webrtc::RTPFragmentationHeader* fragmentation) override;
+
+  //
+  // MessageHandler
+  //
+
+  void OnMessage(rtc::Message* msg) override;
+
+ protected:
+  SharedVideoEncoder(RefPtr<LocalVideoTrack> track,
+                     EncodedVideoTrackSource& output,
+                     webrtc::VideoCodecType codec_type,
+                     std::unique_ptr<webrtc::VideoEncoder> encoder,
+                     const mrsSharedVideoEncoderConfig& config);
+
+  /// Encode the latest pending frame, if any.
+  void EncodePendingFrame();
+
+  /// (Re)initialize the encoder for the given resolution.
+  bool InitEncoder(int width, int height);
+
+ private:
+  RefPtr<LocalVideoTrack> track_;
+  EncodedVideoTrackSource& output_;
+  const webrtc::VideoCodecType codec_type_;
+  const uint32_t bitrate_kbps_;
+  const uint32_t max_framerate_;
+  const int64_t min_key_frame_interval_ms_;
+
+  /// Thread running the encoder. All the members below are only accessed on
+  /// that thread, except for the pending frame and the key frame request.
+  std::unique_ptr<rtc::Thread> thread_;
+
+  std::unique_ptr<webrtc::VideoEncoder> encoder_;
+  int width_{0};
+  int height_{0};
+  bool initialized_{false};
+
+  /// Capture timestamp of the frame being encoded.
+  int64_t current_timestamp_us_{0};
+
+  /// Time of the last key frame produced, in milliseconds.
+  int64_t last_key_frame_ms_{0};
+
+  /// Latest frame received and not encoded yet.
+  absl::optional<webrtc::VideoFrame> pending_frame_ RTC_GUARDED_BY(mutex_);
+  std::mutex mutex_;
+
+  std::atomic_bool key_frame_requested_{false};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,229 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "rtc_base/timeutils.h"
+
+#include "synthetic_audio_source.h"
+
+namespace {
+
+/// Message ID for the frame generation task.
+constexpr uint32_t kMsgGenerateFrame = 0;
+
+/// Duration of a single audio frame, in milliseconds, as expected by the audio
+/// engine.
+constexpr int kFrameDurationMs = 10;
+
+constexpr double kTwoPi = 6.283185307179586;
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+Result SyntheticAudioSource::ValidateConfig(
+    const mrsSyntheticAudioTrackInitConfig& config) {
+  switch (config.sample_rate_hz) {
+    case 8000:
+    case 16000:
+    case 32000:
+    case 48000:
+      break;
+    default:
+      RTC_LOG(LS_ERROR) << "Invalid synthetic audio sampling rate "
+                        << config.sample_rate_hz << " Hz.";
+      return Result::kOutOfRange;
+  }
+  if ((config.channel_count < 1) || (config.channel_count > 2)) {
+    RTC_LOG(LS_ERROR) << "Invalid synthetic audio channel count "
+                      << config.channel_count << ".";
+    return Result::kOutOfRange;
+  }
+  const double nyquist_hz = config.sample_rate_hz / 2.0;
+  if (!(config.frequency_hz > 0.0) || (config.frequency_hz >= nyquist_hz)) {
+    RTC_LOG(LS_ERROR) << "Invalid synthetic audio frequency "
+                      << config.frequency_hz << " Hz.";
+    return Result::kOutOfRange;
+  }
+  if (!(config.amplitude > 0.0) || (config.amplitude > 1.0)) {
+    RTC_LOG(LS_ERROR) << "Invalid synthetic audio amplitude "
+                      << config.amplitude << ".";
+    return Result::kOutOfRange;
+  }
+  switch (config.waveform) {
+    case mrsSyntheticAudioWaveform::kTone:
+      break;
+    case mrsSyntheticAudioWaveform::kChirp:
+      if (!(config.end_frequency_hz > 0.0) ||
+          (config.end_frequency_hz >= nyquist_hz)) {
+        RTC_LOG(LS_ERROR) << "Invalid synthetic audio chirp end frequency "
+                          << config.end_frequency_hz << " Hz.";
+        return Result::kOutOfRange;
+      }
+      // fall through
+    case mrsSyntheticAudioWaveform::kPulse:
+      if ((config.period_ms == 0) ||
+          (config.period_ms % kFrameDurationMs != 0)) {
+        RTC_LOG(LS_ERROR) << "Invalid synthetic audio period "
+                          << config.period_ms << " ms.";
+        return Result::kOutOfRange;
+      }
+      if ((config.waveform == mrsSyntheticAudioWaveform::kPulse) &&
+          ((config.pulse_duration_ms == 0) ||
+           (config.pulse_duration_ms > config.period_ms))) {
+        RTC_LOG(LS_ERROR) << "Invalid synthetic audio pulse duration "
+                          << config.pulse_duration_ms << " ms.";
+        return Result::kOutOfRange;
+      }
+      break;
+    default:
+      RTC_LOG(LS_ERROR) << "Unknown synthetic audio waveform "
+                        << (int)config.waveform << ".";
+      return Result::kInvalidParameter;
+  }
+  return Result::kSuccess;
+}
+
+rtc::scoped_refptr<SyntheticAudioSource> SyntheticAudioSource::Create(
+    const mrsSyntheticAudioTrackInitConfig& config) {
+  return new rtc::RefCountedObject<SyntheticAudioSource>(config);
+}
+
+SyntheticAudioSource::SyntheticAudioSource(
+    const mrsSyntheticAudioTrackInitConfig& config)
+    : waveform_(config.waveform),
+      sample_rate_hz_(static_cast<int>(config.sample_rate_hz)),
+      channel_count_(config.channel_count),
+      samples_per_frame_(config.sample_rate_hz * kFrameDurationMs / 1000),
+      frequency_hz_(config.frequency_hz),
+      end_frequency_hz_(config.end_frequency_hz),
+      period_samples_((uint64_t)config.period_ms * config.sample_rate_hz /
+                      1000),
+      pulse_samples_((uint64_t)config.pulse_duration_ms *
+                     config.sample_rate_hz / 1000),
+      amplitude_(config.amplitude),
+      thread_(rtc::Thread::Create()),
+      samples_(samples_per_frame_ * channel_count_) {
+  thread_->SetName("SyntheticAudioSource thread", this);
+  thread_->Start();
+  next_frame_time_ms_ = rtc::TimeMillis();
+  thread_->PostAt(RTC_FROM_HERE, next_frame_time_ms_, this, kMsgGenerateFrame);
+}
+
+SyntheticAudioSource::~SyntheticAudioSource() {
+  // Stop the thread before any member is destroyed, since it may be running
+  // |OnMessage()|.
+  thread_->Stop();
+}
+
+void SyntheticAudioSource::AddSink(webrtc::AudioTrackSinkInterface* sink) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (std::find(sinks_.begin(), sinks_.end(), sink) == sinks_.end()) {
+    sinks_.push_back(sink);
+  }
+}
+
+void SyntheticAudioSource::RemoveSink(webrtc::AudioTrackSinkInterface* sink) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sinks_.erase(std::remove(sinks_.begin(), sinks_.end(), sink),
+                 sinks_.end());
+  }
+  // Wait for the frame being delivered, if any, so that once this returns the
+  // sink is guaranteed not to be called anymore. A sink removing itself or
+  // another sink from its callback is already on the delivery thread, which
+  // checks each sink before calling it.
+  if (!thread_->IsCurrent()) {
+    std::lock_guard<std::mutex> delivery_lock(delivery_mutex_);
+  }
+}
+
+void SyntheticAudioSource::OnMessage(rtc::Message* msg) {
+  RTC_DCHECK(thread_->IsCurrent());
+  RTC_DCHECK_EQ(kMsgGenerateFrame, msg->message_id);
+
+  GenerateFrame();
+  {
+    // Deliver outside of |mutex_|, so that the sinks can call |AddSink()| and
+    // |RemoveSink()| from their callback without deadlocking.
+    std::lock_guard<std::mutex> delivery_lock(delivery_mutex_);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      delivery_sinks_.assign(sinks_.begin(), sinks_.end());
+    }
+    for (webrtc::AudioTrackSinkInterface* sink : delivery_sinks_) {
+      {
+        // Skip the sinks removed by the callback of a previous sink
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (std::find(sinks_.begin(), sinks_.end(), sink) == sinks_.end()) {
+          continue;
+        }
+      }
+      sink->OnData(samples_.data(), 16, sample_rate_hz_, channel_count_,
+                   samples_per_frame_);
+    }
+  }
+
+  // Schedule the next frame on an absolute time to avoid drifting. If the
+  // thread fell behind by more than a few frames, skip ahead instead of
+  // bursting to catch up.
+  next_frame_time_ms_ += kFrameDurationMs;
+  const int64_t now_ms = rtc::TimeMillis();
+  if (next_frame_time_ms_ < now_ms - 5 * kFrameDurationMs) {
+    next_frame_time_ms_ = now_ms;
+  }
+  thread_->PostAt(RTC_FROM_HERE, next_frame_time_ms_, this, kMsgGenerateFrame);
+}
+
+void SyntheticAudioSource::GenerateFrame() {
+  const double scale = amplitude_ * 32767.0;
+  int16_t* out = samples_.data();
+  for (size_t i = 0; i < samples_per_frame_; ++i, ++sample_index_) {
+    double value = 0.0;
+    switch (waveform_) {
+      case mrsSyntheticAudioWaveform::kTone:
+        value = std::sin(phase_);
+        phase_ += kTwoPi * frequency_hz_ / sample_rate_hz_;
+        break;
+      case mrsSyntheticAudioWaveform::kChirp: {
+        const double t =
+            (double)(sample_index_ % period_samples_) / period_samples_;
+        const double freq =
+            frequency_hz_ + (end_frequency_hz_ - frequency_hz_) * t;
+        value = std::sin(phase_);
+        phase_ += kTwoPi * freq / sample_rate_hz_;
+      } break;
+      case mrsSyntheticAudioWaveform::kPulse: {
+        const uint64_t offset = sample_index_ % period_samples_;
+        if (offset == 0) {
+          // Restart each pulse at zero phase, so all pulses are identical
+          phase_ = 0.0;
+        }
+        if (offset < pulse_samples_) {
+          value = std::sin(phase_);
+          phase_ += kTwoPi * frequency_hz_ / sample_rate_hz_;
+        }
+      } break;
+    }
+    // Keep the phase bounded to preserve precision over long runs
+    if (phase_ >= kTwoPi) {
+      phase_ -= kTwoPi;
+    }
+    const int16_t sample = static_cast<int16_t>(std::lround(value * scale));
+    for (size_t c = 0; c < channel_count_; ++c) {
+      *out++ = sample;
+    }
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
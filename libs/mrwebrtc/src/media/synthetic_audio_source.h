@@ -0,0 +1,105 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "api/mediastreaminterface.h"
+#include "api/notifier.h"
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/thread.h"
+
+#include "local_audio_track_interop.h"
+#include "mrs_errors.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Audio track source generating a deterministic waveform, and delivering it
+/// in 10 ms frames of 16-bit samples to all its sinks, which include the audio
+/// send streams of all RTP senders the track is attached to.
+///
+/// Unlike the default local audio source, which relies on the audio device
+/// module to feed the audio engine, this source pushes its frames from its own
+/// thread, so works on machines without any audio capture device.
+class SyntheticAudioSource
+    : public webrtc::Notifier<webrtc::AudioSourceInterface>,
+      public rtc::MessageHandler {
+ public:
+  /// Check that the given configuration is valid for a synthetic source.
+  static Result ValidateConfig(const mrsSyntheticAudioTrackInitConfig& config);
+
+  /// Create a new synthetic source and start generating frames.
+  static rtc::scoped_refptr<SyntheticAudioSource> Create(
+      const mrsSyntheticAudioTrackInitConfig& config);
+
+  //
+  // AudioSourceInterface
+  //
+
+  SourceState state() const override { return SourceState::kLive; }
+  bool remote() const override { return false; }
+  void AddSink(webrtc::AudioTrackSinkInterface* sink) override;
+  void RemoveSink(webrtc::AudioTrackSinkInterface* sink) override;
+
+  //
+  // MessageHandler
+  //
+
+  void OnMessage(rtc::Message* msg) override;
+
+ protected:
+  explicit SyntheticAudioSource(const mrsSyntheticAudioTrackInitConfig& config);
+  ~SyntheticAudioSource() override;
+
+  /// Fill |samples_| with the next frame of the waveform.
+  void GenerateFrame();
+
+ private:
+  const mrsSyntheticAudioWaveform waveform_;
+  const int sample_rate_hz_;
+  const size_t channel_count_;
+  const size_t samples_per_frame_;
+  const double frequency_hz_;
+  const double end_frequency_hz_;
+  const uint64_t period_samples_;
+  const uint64_t pulse_samples_;
+  const double amplitude_;
+
+  /// Thread generating the frames on a fixed schedule.
+  std::unique_ptr<rtc::Thread> thread_;
+
+  /// Time the next frame is due, in milliseconds. Frames are scheduled on
+  /// absolute times to avoid drifting. Only accessed on |thread_|.
+  int64_t next_frame_time_ms_{0};
+
+  /// Index of the next sample to generate, since the source started. Only
+  /// accessed on |thread_|.
+  uint64_t sample_index_{0};
+
+  /// Current phase of the oscillator, in radians. Only accessed on |thread_|.
+  double phase_{0.0};
+
+  /// Interleaved samples of the current frame. Only accessed on |thread_|.
+  std::vector<int16_t> samples_;
+
+  /// Sinks to deliver the frames to.
+  std::vector<webrtc::AudioTrackSinkInterface*> sinks_ RTC_GUARDED_BY(mutex_);
+  std::mutex mutex_;
+
+  /// Copy of |sinks_| the current frame is delivered to, outside of |mutex_|
+  /// so that a sink can add or remove sinks from its callback. Only accessed
+  /// on |thread_|.
+  std::vector<webrtc::AudioTrackSinkInterface*> delivery_sinks_;
+
+  /// Mutex held by |thread_| while delivering a frame, for |RemoveSink()| to
+  /// wait for the delivery in progress when called from another thread.
+  std::mutex delivery_mutex_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,324 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+
+#include "rtc_base/timeutils.h"
+
+#include "synthetic_video_source.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Maximum framerate of a synthetic source, in frames per second.
+constexpr double kMaxFramerate = 120.0;
+
+/// The marker is a grid of |kMarkerColumns| x |kMarkerRows| cells covering the
+/// top quarter of the frame, each cell encoding a single bit as a black or
+/// white luma block. Cell boundaries are proportional to the frame size, so
+/// that the marker can still be decoded after the frame was rescaled, as long
+/// as the aspect ratio is preserved. The grid encodes, least significant bit
+/// first, the frame number, the timestamp, and a check word.
+constexpr int kMarkerColumns = 16;
+constexpr int kMarkerRows = 6;
+constexpr int kMarkerBitCount = kMarkerColumns * kMarkerRows;
+constexpr uint8_t kMarkerBlack = 16;
+constexpr uint8_t kMarkerWhite = 235;
+constexpr uint32_t kMarkerThreshold = 128;
+
+/// Minimum frame size for the marker cells to be at least 4x2 pixels.
+constexpr int kMarkerMinWidth = kMarkerColumns * 4;
+constexpr int kMarkerMinHeight = kMarkerRows * 2 * 4;
+
+/// Check word of the marker, allowing the receiver to reject corrupted
+/// markers, or frames not produced by a synthetic source.
+uint32_t MarkerCheck(uint32_t frame_number, uint32_t timestamp_us) {
+  return ~(frame_number ^ ((timestamp_us << 16) | (timestamp_us >> 16)));
+}
+
+/// Get the |index|-th bit of the marker.
+bool GetMarkerBit(const uint32_t (&words)[3], int index) {
+  return ((words[index / 32] >> (index % 32)) & 1u) != 0;
+}
+
+/// Compute the rectangle of the |index|-th marker cell in a frame of size
+/// |width| x |height|.
+void GetMarkerCell(int index,
+                   int width,
+                   int height,
+                   int* x0,
+                   int* y0,
+                   int* x1,
+                   int* y1) {
+  const int col = index % kMarkerColumns;
+  const int row = index / kMarkerColumns;
+  const int marker_height = height / 4;
+  *x0 = col * width / kMarkerColumns;
+  *x1 = (col + 1) * width / kMarkerColumns;
+  *y0 = row * marker_height / kMarkerRows;
+  *y1 = (row + 1) * marker_height / kMarkerRows;
+}
+
+/// Standard color bars, in BT.601 limited range YUV.
+struct YuvColor {
+  uint8_t y, u, v;
+};
+constexpr YuvColor kColorBars[] = {
+    {235, 128, 128},  // white
+    {210, 16, 146},   // yellow
+    {170, 166, 16},   // cyan
+    {145, 54, 34},    // green
+    {106, 202, 222},  // magenta
+    {81, 90, 240},    // red
+    {41, 240, 110},   // blue
+    {16, 128, 128},   // black
+};
+constexpr int kColorBarCount = sizeof(kColorBars) / sizeof(kColorBars[0]);
+
+/// Fill a rectangle of a plane with a constant value.
+void FillRect(uint8_t* plane,
+              int stride,
+              int x0,
+              int y0,
+              int x1,
+              int y1,
+              uint8_t value) {
+  for (int y = y0; y < y1; ++y) {
+    memset(plane + (size_t)y * stride + x0, value, (size_t)(x1 - x0));
+  }
+}
+
+/// Deterministic 32-bit xorshift pseudo-random generator.
+uint32_t XorShift32(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+void FillNoise(std::vector<uint8_t>& plane, uint32_t& state) {
+  const size_t size = plane.size();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    const uint32_t r = XorShift32(state);
+    memcpy(&plane[i], &r, 4);
+  }
+  for (; i < size; ++i) {
+    plane[i] = static_cast<uint8_t>(XorShift32(state));
+  }
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+Result SyntheticVideoSource::ValidateConfig(
+    const mrsSyntheticVideoTrackInitConfig& config) {
+  if ((config.width == 0) || (config.height == 0) || (config.width & 1) ||
+      (config.height & 1) || (config.width > 8192) || (config.height > 8192)) {
+    RTC_LOG(LS_ERROR) << "Invalid synthetic video resolution " << config.width
+                      << "x" << config.height
+                      << "; must be non-zero multiples of 2.";
+    return Result::kOutOfRange;
+  }
+  if (!(config.framerate > 0.0) || (config.framerate > kMaxFramerate)) {
+    RTC_LOG(LS_ERROR) << "Invalid synthetic video framerate "
+                      << config.framerate << ".";
+    return Result::kOutOfRange;
+  }
+  if ((config.embed_marker != mrsBool::kFalse) &&
+      ((config.width < kMarkerMinWidth) ||
+       (config.height < kMarkerMinHeight))) {
+    RTC_LOG(LS_ERROR) << "Synthetic video resolution " << config.width << "x"
+                      << config.height << " too small to embed a marker.";
+    return Result::kOutOfRange;
+  }
+  switch (config.pattern) {
+    case mrsSyntheticVideoPattern::kColorBars:
+    case mrsSyntheticVideoPattern::kMovingGradient:
+    case mrsSyntheticVideoPattern::kNoise:
+      break;
+    default:
+      RTC_LOG(LS_ERROR) << "Unknown synthetic video pattern "
+                        << (int)config.pattern << ".";
+      return Result::kInvalidParameter;
+  }
+  return Result::kSuccess;
+}
+
+SyntheticVideoSource::SyntheticVideoSource(
+    const mrsSyntheticVideoTrackInitConfig& config)
+    : width_(static_cast<int>(config.width)),
+      height_(static_cast<int>(config.height)),
+      frame_interval_ms_(
+          std::max(1, static_cast<int>(1000.0 / config.framerate + 0.5))),
+      pattern_(config.pattern),
+      embed_marker_(config.embed_marker != mrsBool::kFalse),
+      ydata_((size_t)width_ * height_),
+      udata_((size_t)width_ * height_ / 4),
+      vdata_((size_t)width_ * height_ / 4) {
+  if (pattern_ == mrsSyntheticVideoPattern::kColorBars) {
+    DrawColorBars();
+  }
+}
+
+Result SyntheticVideoSource::FrameRequested(
+    I420AVideoFrameRequest& frame_request) {
+  const uint32_t frame_number = frame_number_++;
+  DrawPattern(frame_number);
+  if (embed_marker_) {
+    DrawMarker(frame_number, static_cast<uint32_t>(rtc::TimeMicros()));
+  }
+  I420AVideoFrame frame{};
+  frame.width_ = static_cast<uint32_t>(width_);
+  frame.height_ = static_cast<uint32_t>(height_);
+  frame.ydata_ = ydata_.data();
+  frame.udata_ = udata_.data();
+  frame.vdata_ = vdata_.data();
+  frame.ystride_ = width_;
+  frame.ustride_ = width_ / 2;
+  frame.vstride_ = width_ / 2;
+  return frame_request.CompleteRequest(frame);
+}
+
+bool SyntheticVideoSource::ReadMarker(const I420AVideoFrame& frame,
+                                      mrsSyntheticVideoFrameMarker* marker) {
+  const int width = static_cast<int>(frame.width_);
+  const int height = static_cast<int>(frame.height_);
+  if (!frame.ydata_ || (width < kMarkerColumns) ||
+      (height < 4 * kMarkerRows)) {
+    return false;
+  }
+  const uint8_t* const ydata = static_cast<const uint8_t*>(frame.ydata_);
+  uint32_t words[3]{};
+  for (int bit = 0; bit < kMarkerBitCount; ++bit) {
+    int x0, y0, x1, y1;
+    GetMarkerCell(bit, width, height, &x0, &y0, &x1, &y1);
+    // Only sample the center of the cell, which is more resilient to
+    // compression and scaling artifacts on cell edges.
+    const int mx = (x1 - x0) / 4;
+    const int my = (y1 - y0) / 4;
+    x0 += mx;
+    x1 -= mx;
+    y0 += my;
+    y1 -= my;
+    uint32_t sum = 0;
+    for (int y = y0; y < y1; ++y) {
+      const uint8_t* row = ydata + (size_t)y * frame.ystride_;
+      for (int x = x0; x < x1; ++x) {
+        sum += row[x];
+      }
+    }
+    const uint32_t count = static_cast<uint32_t>((x1 - x0) * (y1 - y0));
+    if (sum > kMarkerThreshold * count) {
+      words[bit / 32] |= (1u << (bit % 32));
+    }
+  }
+  if (words[2] != MarkerCheck(words[0], words[1])) {
+    return false;
+  }
+  marker->frame_number = words[0];
+  marker->timestamp_us = words[1];
+  marker->age_us = static_cast<uint32_t>(rtc::TimeMicros()) - words[1];
+  return true;
+}
+
+void SyntheticVideoSource::DrawColorBars() {
+  ybackground_.resize(ydata_.size());
+  ubackground_.resize(udata_.size());
+  vbackground_.resize(vdata_.size());
+  const int chroma_width = width_ / 2;
+  const int chroma_height = height_ / 2;
+  for (int i = 0; i < kColorBarCount; ++i) {
+    const YuvColor& color = kColorBars[i];
+    const int x0 = i * chroma_width / kColorBarCount;
+    const int x1 = (i + 1) * chroma_width / kColorBarCount;
+    FillRect(ybackground_.data(), width_, 2 * x0, 0, 2 * x1, height_, color.y);
+    FillRect(ubackground_.data(), chroma_width, x0, 0, x1, chroma_height,
+             color.u);
+    FillRect(vbackground_.data(), chroma_width, x0, 0, x1, chroma_height,
+             color.v);
+  }
+}
+
+void SyntheticVideoSource::DrawPattern(uint32_t frame_number) {
+  const int chroma_width = width_ / 2;
+  const int chroma_height = height_ / 2;
+  switch (pattern_) {
+    case mrsSyntheticVideoPattern::kColorBars: {
+      ydata_ = ybackground_;
+      udata_ = ubackground_;
+      vdata_ = vbackground_;
+      // White square moving horizontally across the middle of the frame,
+      // 2-pixel aligned to match chroma downsampling.
+      const int size = std::max(2, (height_ / 8) & ~1);
+      const int range = std::max(2, width_ - size);
+      const int x0 = static_cast<int>((frame_number * 4u) % range) & ~1;
+      const int y0 = (height_ / 2) & ~1;
+      const int x1 = std::min(x0 + size, width_);
+      const int y1 = std::min(y0 + size, height_);
+      FillRect(ydata_.data(), width_, x0, y0, x1, y1, 235);
+      FillRect(udata_.data(), chroma_width, x0 / 2, y0 / 2, x1 / 2, y1 / 2,
+               128);
+      FillRect(vdata_.data(), chroma_width, x0 / 2, y0 / 2, x1 / 2, y1 / 2,
+               128);
+    } break;
+
+    case mrsSyntheticVideoPattern::kMovingGradient: {
+      const uint32_t offset = frame_number * 2u;
+      for (int y = 0; y < height_; ++y) {
+        uint8_t* row = ydata_.data() + (size_t)y * width_;
+        for (int x = 0; x < width_; ++x) {
+          row[x] = static_cast<uint8_t>(x + y + offset);
+        }
+      }
+      for (int y = 0; y < chroma_height; ++y) {
+        uint8_t* urow = udata_.data() + (size_t)y * chroma_width;
+        uint8_t* vrow = vdata_.data() + (size_t)y * chroma_width;
+        for (int x = 0; x < chroma_width; ++x) {
+          urow[x] = static_cast<uint8_t>(2 * x + offset);
+          vrow[x] = static_cast<uint8_t>(2 * y + offset);
+        }
+      }
+    } break;
+
+    case mrsSyntheticVideoPattern::kNoise: {
+      // Never zero, which is a fixed point of xorshift
+      uint32_t state = (frame_number + 1) * 0x9E3779B9u | 1u;
+      FillNoise(ydata_, state);
+      FillNoise(udata_, state);
+      FillNoise(vdata_, state);
+    } break;
+  }
+}
+
+void SyntheticVideoSource::DrawMarker(uint32_t frame_number,
+                                      uint32_t timestamp_us) {
+  const uint32_t words[3]{frame_number, timestamp_us,
+                          MarkerCheck(frame_number, timestamp_us)};
+  for (int bit = 0; bit < kMarkerBitCount; ++bit) {
+    int x0, y0, x1, y1;
+    GetMarkerCell(bit, width_, height_, &x0, &y0, &x1, &y1);
+    FillRect(ydata_.data(), width_, x0, y0, x1, y1,
+             GetMarkerBit(words, bit) ? kMarkerWhite : kMarkerBlack);
+  }
+  // Neutral chroma under the marker, to avoid color bleeding into the luma
+  // after lossy compression.
+  const int chroma_width = width_ / 2;
+  const int marker_chroma_height = (height_ / 4 + 1) / 2;
+  FillRect(udata_.data(), chroma_width, 0, 0, chroma_width,
+           marker_chroma_height, 128);
+  FillRect(vdata_.data(), chroma_width, 0, 0, chroma_width,
+           marker_chroma_height, 128);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
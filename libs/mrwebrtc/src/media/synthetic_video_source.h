@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <vector>
+
+#include "local_video_track_interop.h"
+#include "media/external_video_track_source.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Custom video source generating deterministic test patterns, optionally
+/// stamped with a marker encoding the frame number and generation time.
+///
+/// The source is pulled by an external video track source on its capture
+/// thread, which is the only thread calling |FrameRequested()|, so the frame
+/// buffers are reused without locking.
+class SyntheticVideoSource : public I420AExternalVideoSource {
+ public:
+  /// Check that the given configuration is valid for a synthetic source.
+  static Result ValidateConfig(const mrsSyntheticVideoTrackInitConfig& config);
+
+  explicit SyntheticVideoSource(const mrsSyntheticVideoTrackInitConfig& config);
+
+  /// Interval between two consecutive frames, in milliseconds.
+  int GetFrameIntervalMs() const noexcept { return frame_interval_ms_; }
+
+  Result FrameRequested(I420AVideoFrameRequest& frame_request) override;
+
+  /// Decode the marker embedded into |frame|, if any. Return |true| and fill
+  /// |marker| if a valid marker was found.
+  static bool ReadMarker(const I420AVideoFrame& frame,
+                         mrsSyntheticVideoFrameMarker* marker);
+
+ protected:
+  /// Draw the static background of the color bars pattern.
+  void DrawColorBars();
+
+  /// Draw the pattern for the frame number |frame_number|.
+  void DrawPattern(uint32_t frame_number);
+
+  /// Overwrite the top quarter of the frame with the marker.
+  void DrawMarker(uint32_t frame_number, uint32_t timestamp_us);
+
+ private:
+  const int width_;
+  const int height_;
+  const int frame_interval_ms_;
+  const mrsSyntheticVideoPattern pattern_;
+  const bool embed_marker_;
+
+  /// Number of the next frame to generate.
+  uint32_t frame_number_{0};
+
+  /// Frame planes, with strides equal to the plane widths.
+  std::vector<uint8_t> ydata_;
+  std::vector<uint8_t> udata_;
+  std::vector<uint8_t> vdata_;
+
+  /// Background planes for patterns with a static background, copied into the
+  /// frame planes before drawing the animated parts.
+  std::vector<uint8_t> ybackground_;
+  std::vector<uint8_t> ubackground_;
+  std::vector<uint8_t> vbackground_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -3,8 +3,11 @@
 
 #include "pch.h"
 
+#include <cctype>
+
 #include "interop/global_factory.h"
 #include "peer_connection.h"
+#include "sdp_utils.h"
 #include "transceiver.h"
 #include "utils.h"
 
@@ -27,8 +30,90 @@ struct Transceiver::PlanBEmulation {
   /// transceivers not changing any transceiver direction nor generating a
   /// renegotiation in Unified Plan.
   rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> sender_track_;
+
+  /// Parameters of the single encoding of the RTP sender, if set by the user.
+  /// This is re-applied each time the RTP sender is negotiated. The |rid|
+  /// field is unused and always NULL.
+  absl::optional<mrsSendEncodingParameters> send_encoding_;
 };
 
+namespace {
+
+/// Check that |rid| is a valid RTP stream identifier; see RFC 8851.
+bool IsValidRid(const char* rid) {
+  if (IsStringNullOrEmpty(rid)) {
+    return false;
+  }
+  for (const char* c = rid; *c != '\0'; ++c) {
+    if (!std::isalnum(static_cast<unsigned char>(*c)) && (*c != '-') &&
+        (*c != '_')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Check the parameters of an encoding, other than its RID.
+Result ValidateSendEncoding(const mrsSendEncodingParameters& encoding) {
+  if ((encoding.scale_resolution_down_by != 0.0) &&
+      !(encoding.scale_resolution_down_by >= 1.0)) {
+    RTC_LOG(LS_ERROR) << "Invalid resolution scale-down factor "
+                      << encoding.scale_resolution_down_by
+                      << " for send encoding.";
+    return Result::kOutOfRange;
+  }
+  if (encoding.max_bitrate_bps > (uint32_t)INT_MAX) {
+    RTC_LOG(LS_ERROR) << "Invalid maximum bitrate " << encoding.max_bitrate_bps
+                      << " bps for send encoding.";
+    return Result::kOutOfRange;
+  }
+  if (encoding.max_framerate > (uint32_t)INT_MAX) {
+    RTC_LOG(LS_ERROR) << "Invalid maximum framerate " << encoding.max_framerate
+                      << " for send encoding.";
+    return Result::kOutOfRange;
+  }
+  return Result::kSuccess;
+}
+
+/// Apply the parameters of an encoding, other than its RID which cannot change
+/// after creation, to its RTP counterpart.
+void ApplySendEncoding(const mrsSendEncodingParameters& encoding,
+                       webrtc::RtpEncodingParameters& rtp_encoding) {
+  if (encoding.scale_resolution_down_by > 0.0) {
+    rtp_encoding.scale_resolution_down_by = encoding.scale_resolution_down_by;
+  } else {
+    rtp_encoding.scale_resolution_down_by.reset();
+  }
+  if (encoding.max_bitrate_bps > 0) {
+    rtp_encoding.max_bitrate_bps = static_cast<int>(encoding.max_bitrate_bps);
+  } else {
+    rtp_encoding.max_bitrate_bps.reset();
+  }
+  if (encoding.max_framerate > 0) {
+    rtp_encoding.max_framerate = static_cast<int>(encoding.max_framerate);
+  } else {
+    rtp_encoding.max_framerate.reset();
+  }
+  rtp_encoding.active = (encoding.active != mrsBool::kFalse);
+}
+
+/// Convert the parameters of an RTP encoding back into an interop encoding.
+/// The RID is not converted, since its storage is not owned by the caller.
+mrsSendEncodingParameters GetSendEncoding(
+    const webrtc::RtpEncodingParameters& rtp_encoding) {
+  mrsSendEncodingParameters encoding{};
+  encoding.scale_resolution_down_by =
+      rtp_encoding.scale_resolution_down_by.value_or(0.0);
+  encoding.max_bitrate_bps =
+      static_cast<uint32_t>(rtp_encoding.max_bitrate_bps.value_or(0));
+  encoding.max_framerate =
+      static_cast<uint32_t>(rtp_encoding.max_framerate.value_or(0));
+  encoding.active = (rtp_encoding.active ? mrsBool::kTrue : mrsBool::kFalse);
+  return encoding;
+}
+
+}  // namespace
+
 RefPtr<Transceiver> Transceiver::CreateForPlanB(
     RefPtr<GlobalFactory> global_factory,
     MediaKind kind,
@@ -111,6 +196,15 @@ Transceiver::Transceiver(
 Transceiver::~Transceiver() {
   // RTC_CHECK(!owner_);
 
+  // Stop delivering encoded frames; the tap itself may outlive the
+  // transceiver, since it is referenced by the media streams.
+  {
+    std::lock_guard<std::mutex> lock(tap_mutex_);
+    if (encoded_frame_tap_) {
+      encoded_frame_tap_->SetCallback({});
+    }
+  }
+
   // Keep the tracks alive for now. This prevents them from being destroyed when
   // detaching them below, which would invoke their destructor while the
   // transceiver is in an inconsistent state (in the middle of being destroyed),
@@ -175,6 +269,268 @@ Result Transceiver::SetDirection(Direction new_direction) noexcept {
   return Result::kSuccess;
 }
 
+Result Transceiver::SetCodecPreferences(
+    std::vector<std::string> codec_names) noexcept {
+  for (auto&& name : codec_names) {
+    if (!SdpIsValidToken(name)) {
+      RTC_LOG(LS_ERROR) << "Invalid codec name '" << name.c_str()
+                        << "' for codec preferences of transceiver "
+                        << name_.c_str();
+      return Result::kInvalidParameter;
+    }
+  }
+  std::lock_guard<std::mutex> lock(codec_mutex_);
+  codec_preferences_ = std::move(codec_names);
+  return Result::kSuccess;
+}
+
+std::vector<std::string> Transceiver::GetCodecPreferences() const {
+  std::lock_guard<std::mutex> lock(codec_mutex_);
+  return codec_preferences_;
+}
+
+bool Transceiver::ApplyCodecPreferences(
+    cricket::MediaContentDescription* media_desc) const {
+  std::lock_guard<std::mutex> lock(codec_mutex_);
+  if (codec_preferences_.empty()) {
+    return false;
+  }
+  if (!SdpApplyCodecPreferences(media_desc, codec_preferences_)) {
+    RTC_LOG(LS_WARNING) << "None of the preferred codecs of transceiver "
+                        << name_.c_str()
+                        << " is supported; keeping default codecs.";
+    return false;
+  }
+  return true;
+}
+
+Result Transceiver::BuildSendEncodings(
+    MediaKind kind,
+    const mrsSendEncodingParameters* encodings,
+    uint32_t count,
+    std::vector<webrtc::RtpEncodingParameters>& rtp_encodings) noexcept {
+  rtp_encodings.clear();
+  if (count == 0) {
+    return Result::kSuccess;
+  }
+  if (!encodings) {
+    return Result::kInvalidParameter;
+  }
+  if ((count > 1) && (kind != MediaKind::kVideo)) {
+    RTC_LOG(LS_ERROR) << "Multiple send encodings are only supported for video "
+                         "transceivers.";
+    return Result::kInvalidMediaKind;
+  }
+  rtp_encodings.resize(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const mrsSendEncodingParameters& encoding = encodings[i];
+    const Result result = ValidateSendEncoding(encoding);
+    if (result != Result::kSuccess) {
+      rtp_encodings.clear();
+      return result;
+    }
+    if (!IsStringNullOrEmpty(encoding.rid) || (count > 1)) {
+      if (!IsValidRid(encoding.rid)) {
+        RTC_LOG(LS_ERROR) << "Invalid RID '"
+                          << (encoding.rid ? encoding.rid : "")
+                          << "' for send encoding #" << i << ".";
+        rtp_encodings.clear();
+        return Result::kInvalidParameter;
+      }
+      for (uint32_t j = 0; j < i; ++j) {
+        if (rtp_encodings[j].rid == encoding.rid) {
+          RTC_LOG(LS_ERROR) << "Duplicate RID '" << encoding.rid
+                            << "' for send encoding #" << i << ".";
+          rtp_encodings.clear();
+          return Result::kInvalidParameter;
+        }
+      }
+      rtp_encodings[i].rid = encoding.rid;
+    }
+    ApplySendEncoding(encoding, rtp_encodings[i]);
+  }
+  return Result::kSuccess;
+}
+
+Result Transceiver::SetSendEncodings(const mrsSendEncodingParameters* encodings,
+                                     uint32_t count) noexcept {
+  if (!encodings || (count == 0)) {
+    return Result::kInvalidParameter;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    const Result result = ValidateSendEncoding(encodings[i]);
+    if (result != Result::kSuccess) {
+      return result;
+    }
+  }
+
+  if (transceiver_) {  // Unified Plan
+    rtc::scoped_refptr<webrtc::RtpSenderInterface> sender =
+        transceiver_->sender();
+    webrtc::RtpParameters parameters = sender->GetParameters();
+    if (parameters.encodings.size() != count) {
+      RTC_LOG(LS_ERROR) << "Cannot set " << count
+                        << " send encodings on transceiver " << name_.c_str()
+                        << " with " << parameters.encodings.size()
+                        << " negotiated encodings.";
+      return (parameters.encodings.empty() ? Result::kInvalidOperation
+                                           : Result::kInvalidParameter);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      webrtc::RtpEncodingParameters& rtp_encoding = parameters.encodings[i];
+      if (!IsStringNullOrEmpty(encodings[i].rid) &&
+          (rtp_encoding.rid != encodings[i].rid)) {
+        RTC_LOG(LS_ERROR) << "Send encoding #" << i << " of transceiver "
+                          << name_.c_str() << " has RID '"
+                          << rtp_encoding.rid.c_str() << "', not '"
+                          << encodings[i].rid << "'.";
+        return Result::kInvalidParameter;
+      }
+      ApplySendEncoding(encodings[i], rtp_encoding);
+    }
+    const webrtc::RTCError error = sender->SetParameters(parameters);
+    if (!error.ok()) {
+      RTC_LOG(LS_ERROR) << "Failed to set send encodings of transceiver "
+                        << name_.c_str() << ": " << error.message();
+      return ResultFromRTCErrorType(error.type());
+    }
+    return Result::kSuccess;
+  }
+
+  // Plan B
+  RTC_DCHECK(plan_b_);
+  if (count != 1) {
+    RTC_LOG(LS_ERROR) << "Plan B transceivers support a single send encoding.";
+    return Result::kUnsupported;
+  }
+  mrsSendEncodingParameters encoding = encodings[0];
+  encoding.rid = nullptr;
+  plan_b_->send_encoding_ = encoding;
+  if (!plan_b_->rtp_sender_) {
+    // Applied once the RTP sender is created and negotiated
+    return Result::kSuccess;
+  }
+  return ApplySendEncodingPlanB();
+}
+
+Result Transceiver::GetSendEncodings(
+    std::vector<mrsSendEncodingParameters>& encodings) const noexcept {
+  encodings.clear();
+  rtc::scoped_refptr<webrtc::RtpSenderInterface> sender;
+  if (transceiver_) {  // Unified Plan
+    sender = transceiver_->sender();
+  } else {  // Plan B
+    RTC_DCHECK(plan_b_);
+    sender = plan_b_->rtp_sender_;
+  }
+  if (sender) {
+    const webrtc::RtpParameters parameters = sender->GetParameters();
+    encodings.reserve(parameters.encodings.size());
+    for (const webrtc::RtpEncodingParameters& rtp_encoding :
+         parameters.encodings) {
+      encodings.push_back(GetSendEncoding(rtp_encoding));
+    }
+  }
+  if (encodings.empty() && plan_b_ && plan_b_->send_encoding_.has_value()) {
+    // Not negotiated yet; report the encoding to be applied once negotiated.
+    encodings.push_back(plan_b_->send_encoding_.value());
+  }
+  return Result::kSuccess;
+}
+
+Result Transceiver::ApplySendEncodingPlanB() noexcept {
+  RTC_DCHECK(plan_b_);
+  if (!plan_b_->send_encoding_.has_value() || !plan_b_->rtp_sender_) {
+    return Result::kSuccess;
+  }
+  webrtc::RtpParameters parameters = plan_b_->rtp_sender_->GetParameters();
+  if (parameters.encodings.empty()) {
+    // Not negotiated yet; this is called again once negotiated.
+    return Result::kSuccess;
+  }
+  ApplySendEncoding(plan_b_->send_encoding_.value(), parameters.encodings[0]);
+  const webrtc::RTCError error =
+      plan_b_->rtp_sender_->SetParameters(parameters);
+  if (!error.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to set send encoding of transceiver "
+                      << name_.c_str() << ": " << error.message();
+    return ResultFromRTCErrorType(error.type());
+  }
+  return Result::kSuccess;
+}
+
+void Transceiver::RegisterEncodedFrameCallback(
+    EncodedFrameCallback&& callback) noexcept {
+  {
+    std::lock_guard<std::mutex> lock(tap_mutex_);
+    if (!encoded_frame_tap_) {
+      if (!callback) {
+        return;
+      }
+      encoded_frame_tap_ = EncodedFrameTap::Create(kind_);
+    }
+    encoded_frame_tap_->SetCallback(std::move(callback));
+  }
+  ApplyEncodedFrameTap();
+}
+
+void Transceiver::AddEncodedFrameSink(EncodedFrameSink* sink) noexcept {
+  {
+    std::lock_guard<std::mutex> lock(tap_mutex_);
+    if (!encoded_frame_tap_) {
+      encoded_frame_tap_ = EncodedFrameTap::Create(kind_);
+    }
+    encoded_frame_tap_->AddSink(sink);
+  }
+  ApplyEncodedFrameTap();
+}
+
+void Transceiver::RemoveEncodedFrameSink(EncodedFrameSink* sink) noexcept {
+  std::lock_guard<std::mutex> lock(tap_mutex_);
+  if (encoded_frame_tap_) {
+    encoded_frame_tap_->RemoveSink(sink);
+  }
+}
+
+void Transceiver::ApplyEncodedFrameTap() noexcept {
+  rtc::scoped_refptr<EncodedFrameTap> tap;
+  {
+    std::lock_guard<std::mutex> lock(tap_mutex_);
+    tap = encoded_frame_tap_;
+  }
+  if (!tap) {
+    return;
+  }
+  rtc::scoped_refptr<webrtc::RtpSenderInterface> sender;
+  rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver;
+  if (transceiver_) {  // Unified Plan
+    sender = transceiver_->sender();
+    receiver = transceiver_->receiver();
+  } else {  // Plan B
+    sender = plan_b_->rtp_sender_;
+    receiver = plan_b_->rtp_receiver_;
+  }
+  // The tap is passthrough, so re-installing a new instance on a sender or
+  // receiver which already has one is harmless, and keeps this stateless.
+  if (sender) {
+    sender->SetFrameEncryptor(tap->CreateSenderTap());
+    const webrtc::RtpParameters parameters = sender->GetParameters();
+    if (!parameters.codecs.empty()) {
+      tap->SetCodecName(mrsEncodedFrameDirection::kSend,
+                        parameters.codecs[0].name);
+    }
+  }
+  if (receiver) {
+    receiver->SetFrameDecryptor(tap->CreateReceiverTap());
+    // The remote peer sends with the first codec of the negotiated list
+    const webrtc::RtpParameters parameters = receiver->GetParameters();
+    if (!parameters.codecs.empty()) {
+      tap->SetCodecName(mrsEncodedFrameDirection::kReceive,
+                        parameters.codecs[0].name);
+    }
+  }
+}
+
 bool Transceiver::HasSender(webrtc::RtpSenderInterface* sender) const {
   if (transceiver_) {
     return (transceiver_->sender() == sender);
@@ -444,6 +800,12 @@ void Transceiver::SetReceiverPlanB(
   plan_b_->rtp_receiver_ = std::move(receiver);
 }
 
+rtc::scoped_refptr<webrtc::RtpReceiverInterface> Transceiver::GetReceiverPlanB()
+    const {
+  RTC_DCHECK(plan_b_);
+  return plan_b_->rtp_receiver_;
+}
+
 void Transceiver::SetTrackPlanB(webrtc::MediaStreamTrackInterface* new_track) {
   RTC_DCHECK(plan_b_);
   plan_b_->sender_track_ = new_track;
@@ -508,8 +870,16 @@ void Transceiver::OnSessionDescUpdated(bool remote, bool forced) {
     }
 
     // TODO - Check desired direction?
+
+    // Re-apply the user send encoding to the RTP sender, which may have been
+    // re-created since last negotiated.
+    ApplySendEncodingPlanB();
   }
 
+  // Install the encoded frame tap on any new RTP sender or receiver, and
+  // refresh the negotiated codecs.
+  ApplyEncodedFrameTap();
+
   // Invoke interop callback if any
   if (changed || forced) {
     FireStateUpdatedEvent(remote
@@ -5,6 +5,7 @@
 
 #include "callback.h"
 #include "interop_api.h"
+#include "media/encoded_frame_tap.h"
 #include "media/local_audio_track.h"
 #include "media/local_video_track.h"
 #include "media/remote_audio_track.h"
@@ -17,9 +18,14 @@ class scoped_refptr;
 }
 
 namespace webrtc {
+struct RtpEncodingParameters;
 class RtpTransceiverInterface;
 }
 
+namespace cricket {
+class MediaContentDescription;
+}
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
@@ -86,6 +92,43 @@ class Transceiver : public TrackedObject {
   /// offers/answers.
   Result SetDirection(Direction new_direction) noexcept;
 
+  /// Set the list of codecs this transceiver is allowed to negotiate, by SDP
+  /// codec name (e.g. "VP8", "H264", "opus") and in decreasing order of
+  /// preference. An empty list restores the default codecs. The preferences
+  /// apply to the next SDP offer or answer created, and do not by themselves
+  /// trigger a renegotiation.
+  Result SetCodecPreferences(std::vector<std::string> codec_names) noexcept;
+
+  /// Get the list of codec names previously set with |SetCodecPreferences()|.
+  MRS_NODISCARD std::vector<std::string> GetCodecPreferences() const;
+
+  /// Validate an array of |count| send encodings for a new transceiver of
+  /// media kind |kind|, and convert them into |rtp_encodings|. An empty array
+  /// is valid, and produces an empty list to use the default encoding.
+  MRS_NODISCARD static Result BuildSendEncodings(
+      MediaKind kind,
+      const mrsSendEncodingParameters* encodings,
+      uint32_t count,
+      std::vector<webrtc::RtpEncodingParameters>& rtp_encodings) noexcept;
+
+  /// Change the parameters of the encodings of the RTP sender, without any
+  /// renegotiation. The number of encodings and their RID cannot change.
+  ///
+  /// In Unified Plan this requires the sender to have been negotiated. In Plan
+  /// B, where the RTP sender is re-created on each offer, only a single
+  /// encoding is supported, and its parameters are saved and re-applied each
+  /// time the RTP sender is negotiated.
+  Result SetSendEncodings(const mrsSendEncodingParameters* encodings,
+                          uint32_t count) noexcept;
+
+  /// Get the current parameters of the encodings of the RTP sender. The list
+  /// is empty if the sender was not negotiated yet. In Plan B this returns the
+  /// encoding saved by |SetSendEncodings()| until the RTP sender is negotiated.
+  /// The |rid| field of the returned encodings is always NULL, since the RID
+  /// strings are not owned by the caller; encodings keep their creation order.
+  Result GetSendEncodings(
+      std::vector<mrsSendEncodingParameters>& encodings) const noexcept;
+
   MRS_NODISCARD bool IsUnifiedPlan() const {
     RTC_DCHECK(!plan_b_ != !transceiver_);
     return (transceiver_ != nullptr);
@@ -172,20 +215,24 @@ class Transceiver : public TrackedObject {
     state_updated_callback_ = std::move(callback);
   }
 
+  /// Callback invoked for each encoded frame sent or received.
+  using EncodedFrameCallback = EncodedFrameTap::FrameCallback;
+
+  /// Register a callback intercepting the encoded frames, installing the
+  /// encoded frame tap on the RTP sender and receiver on first use.
+  void RegisterEncodedFrameCallback(EncodedFrameCallback&& callback) noexcept;
+
+  /// Add an internal sink intercepting the encoded frames, installing the
+  /// encoded frame tap on the RTP sender and receiver on first use.
+  void AddEncodedFrameSink(EncodedFrameSink* sink) noexcept;
+
+  /// Remove a sink added with |AddEncodedFrameSink()|.
+  void RemoveEncodedFrameSink(EncodedFrameSink* sink) noexcept;
+
   //
   // Advanced
   //
 
-  /// Get a handle to the tranceiver. This is not virtual on purpose, as the
-  /// API doesn't differentiate between audio and video transceivers, so any
-  /// handle would be cast back to a base class |Transceiver| pointer. This
-  /// handle is valid until the transceiver is removed from the peer
-  /// connection and destroyed, which happens during
-  /// |PeerConnection::Close()|.
-  MRS_NODISCARD constexpr mrsTransceiverHandle GetHandle() const noexcept {
-    return (mrsTransceiverHandle)this;
-  }
-
   MRS_NODISCARD rtc::scoped_refptr<webrtc::RtpTransceiverInterface> impl()
       const;
 
@@ -203,6 +250,10 @@ class Transceiver : public TrackedObject {
   void SetReceiverPlanB(
       rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver);
 
+  /// Get the RTP receiver set with |SetReceiverPlanB()|, if any.
+  MRS_NODISCARD rtc::scoped_refptr<webrtc::RtpReceiverInterface>
+  GetReceiverPlanB() const;
+
   /// Hot-swap the local sender track on this transceiver, without changing
   /// the transceiver direction. This emulates the RTP transceiver's SetTrack
   /// function. Because the RTP sender in Plan B only exists when the track is
@@ -212,6 +263,14 @@ class Transceiver : public TrackedObject {
   /// sender already exists at the time of the call.
   void SetTrackPlanB(webrtc::MediaStreamTrackInterface* new_track);
 
+  /// Apply the codec preferences of this transceiver, if any, to the media
+  /// content description of its media line in a local description about to
+  /// be applied. This is the fallback for the lack of
+  /// |webrtc::RtpTransceiverInterface::SetCodecPreferences()| in the current
+  /// WebRTC version. Return |true| if the description was modified.
+  bool ApplyCodecPreferences(
+      cricket::MediaContentDescription* media_desc) const;
+
   /// Callback on associated with a media line.
   void OnAssociated(int mline_index);
 
@@ -282,6 +341,14 @@ class Transceiver : public TrackedObject {
 
   Result SetLocalTrackImpl(RefPtr<MediaTrack> local_track) noexcept;
 
+  /// Apply the send encoding saved by |SetSendEncodings()| in Plan B, if any,
+  /// to the current RTP sender, if any.
+  Result ApplySendEncodingPlanB() noexcept;
+
+  /// Install the encoded frame tap, if any, on the current RTP sender and
+  /// receiver, and update the negotiated codec names it reports.
+  void ApplyEncodedFrameTap() noexcept;
+
  protected:
   struct PlanBEmulation;
 
@@ -346,6 +413,21 @@ class Transceiver : public TrackedObject {
   StateUpdatedCallback state_updated_callback_ RTC_GUARDED_BY(cb_mutex_);
 
   std::mutex cb_mutex_;
+
+  /// Encoded frame tap installed on the RTP sender and receiver, created on
+  /// first registration of an encoded frame callback. Set once and never
+  /// cleared, since the media streams may still reference it.
+  rtc::scoped_refptr<EncodedFrameTap> encoded_frame_tap_
+      RTC_GUARDED_BY(tap_mutex_);
+  std::mutex tap_mutex_;
+
+  /// Preferred codec names, in decreasing order of preference. Empty if the
+  /// transceiver uses the default codecs.
+  std::vector<std::string> codec_preferences_ RTC_GUARDED_BY(codec_mutex_);
+
+  /// Mutex for |codec_preferences_|, which is read from the signaling thread
+  /// when a local description is created.
+  mutable std::mutex codec_mutex_;
 };
 
 }  // namespace WebRTC
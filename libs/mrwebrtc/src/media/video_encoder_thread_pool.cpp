@@ -0,0 +1,201 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+
+#include "api/video_codecs/video_encoder.h"
+#include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/include/video_error_codes.h"
+#include "rtc_base/refcountedobject.h"
+#include "rtc_base/stringutils.h"
+
+#include "video_encoder_thread_pool.h"
+
+namespace {
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+/// Encoder applying a threading configuration to a wrapped encoder, and
+/// holding the threads it reserved from the pool while initialized.
+class ThreadPoolVideoEncoder : public webrtc::VideoEncoder {
+ public:
+  ThreadPoolVideoEncoder(const mrsVideoEncoderThreadingConfig& config,
+                         rtc::scoped_refptr<VideoEncoderThreadPool> pool,
+                         std::unique_ptr<webrtc::VideoEncoder> encoder)
+      : config_(config), pool_(std::move(pool)), encoder_(std::move(encoder)) {}
+
+  ~ThreadPoolVideoEncoder() override { ReleaseThreads(); }
+
+  int32_t InitEncode(const webrtc::VideoCodec* codec_settings,
+                     int32_t number_of_cores,
+                     size_t max_payload_size) override {
+    if (!codec_settings) {
+      return WEBRTC_VIDEO_CODEC_ERR_PARAMETER;
+    }
+    webrtc::VideoCodec settings = *codec_settings;
+    const auto complexity =
+        static_cast<webrtc::VideoCodecComplexity>(config_.complexity);
+    if (settings.codecType == webrtc::kVideoCodecVP8) {
+      settings.VP8()->complexity = complexity;
+    } else if (settings.codecType == webrtc::kVideoCodecVP9) {
+      settings.VP9()->complexity = complexity;
+    }
+
+    // Re-initializing returns the previous threads before reserving new ones.
+    ReleaseThreads();
+    const int requested =
+        (config_.thread_count > 0 ? static_cast<int>(config_.thread_count)
+                                  : std::max(number_of_cores, 1));
+    reserved_threads_ = pool_->Acquire(requested);
+    const int32_t ret =
+        encoder_->InitEncode(&settings, reserved_threads_, max_payload_size);
+    if (ret != WEBRTC_VIDEO_CODEC_OK) {
+      ReleaseThreads();
+    }
+    return ret;
+  }
+
+  int32_t RegisterEncodeCompleteCallback(
+      webrtc::EncodedImageCallback* callback) override {
+    return encoder_->RegisterEncodeCompleteCallback(callback);
+  }
+
+  int32_t Release() override {
+    const int32_t ret = encoder_->Release();
+    ReleaseThreads();
+    return ret;
+  }
+
+  int32_t Encode(const webrtc::VideoFrame& frame,
+                 const webrtc::CodecSpecificInfo* codec_specific_info,
+                 const std::vector<webrtc::FrameType>* frame_types) override {
+    return encoder_->Encode(frame, codec_specific_info, frame_types);
+  }
+
+  int32_t SetChannelParameters(uint32_t packet_loss, int64_t rtt) override {
+    return encoder_->SetChannelParameters(packet_loss, rtt);
+  }
+
+  int32_t SetRateAllocation(const webrtc::VideoBitrateAllocation& allocation,
+                            uint32_t framerate) override {
+    return encoder_->SetRateAllocation(allocation, framerate);
+  }
+
+  ScalingSettings GetScalingSettings() const override {
+    return encoder_->GetScalingSettings();
+  }
+
+  bool SupportsNativeHandle() const override {
+    return encoder_->SupportsNativeHandle();
+  }
+
+  const char* ImplementationName() const override {
+    return encoder_->ImplementationName();
+  }
+
+ protected:
+  void ReleaseThreads() {
+    if (reserved_threads_ > 0) {
+      pool_->Release(reserved_threads_);
+      reserved_threads_ = 0;
+    }
+  }
+
+ private:
+  const mrsVideoEncoderThreadingConfig config_;
+  rtc::scoped_refptr<VideoEncoderThreadPool> pool_;
+  std::unique_ptr<webrtc::VideoEncoder> encoder_;
+
+  /// Number of threads reserved from the pool while initialized. Only
+  /// accessed on the encoder thread, like all encoder methods.
+  int reserved_threads_{0};
+};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+rtc::scoped_refptr<VideoEncoderThreadPool> VideoEncoderThreadPool::Create(
+    uint32_t size) {
+  return new rtc::RefCountedObject<VideoEncoderThreadPool>(size);
+}
+
+int VideoEncoderThreadPool::Acquire(int count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (size_ > 0) {
+    const int available = std::max(static_cast<int>(size_) - in_use_, 0);
+    count = std::min(count, available);
+  }
+  count = std::max(count, 1);
+  in_use_ += count;
+  return count;
+}
+
+void VideoEncoderThreadPool::Release(int count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RTC_DCHECK_GE(in_use_, count);
+  in_use_ -= count;
+}
+
+int VideoEncoderThreadPool::in_use() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return in_use_;
+}
+
+ThreadPoolVideoEncoderFactory::ThreadPoolVideoEncoderFactory(
+    std::vector<VideoEncoderThreadingOverride> overrides,
+    rtc::scoped_refptr<VideoEncoderThreadPool> pool,
+    std::unique_ptr<webrtc::VideoEncoderFactory> factory)
+    : overrides_(std::move(overrides)),
+      pool_(std::move(pool)),
+      factory_(std::move(factory)) {}
+
+std::vector<webrtc::SdpVideoFormat>
+ThreadPoolVideoEncoderFactory::GetSupportedFormats() const {
+  return factory_->GetSupportedFormats();
+}
+
+webrtc::VideoEncoderFactory::CodecInfo
+ThreadPoolVideoEncoderFactory::QueryVideoEncoder(
+    const webrtc::SdpVideoFormat& format) const {
+  return factory_->QueryVideoEncoder(format);
+}
+
+std::unique_ptr<webrtc::VideoEncoder>
+ThreadPoolVideoEncoderFactory::CreateVideoEncoder(
+    const webrtc::SdpVideoFormat& format) {
+  std::unique_ptr<webrtc::VideoEncoder> encoder =
+      factory_->CreateVideoEncoder(format);
+  if (!encoder) {
+    return nullptr;
+  }
+  // Every encoder reserves its threads, even without configuration, so that
+  // the pool accounts for all of them.
+  const mrsVideoEncoderThreadingConfig* config = Find(format.name);
+  return absl::make_unique<ThreadPoolVideoEncoder>(
+      config ? *config : mrsVideoEncoderThreadingConfig{}, pool_,
+      std::move(encoder));
+}
+
+const mrsVideoEncoderThreadingConfig* ThreadPoolVideoEncoderFactory::Find(
+    const std::string& codec_name) const {
+  const mrsVideoEncoderThreadingConfig* default_config = nullptr;
+  for (const VideoEncoderThreadingOverride& item : overrides_) {
+    if (item.codec_name.empty()) {
+      default_config = &item.config;
+    } else if (_stricmp(item.codec_name.c_str(), codec_name.c_str()) == 0) {
+      return &item.config;
+    }
+  }
+  return default_config;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "api/video_codecs/video_encoder_factory.h"
+#include "rtc_base/refcount.h"
+#include "rtc_base/scoped_ref_ptr.h"
+#include "rtc_base/thread_annotations.h"
+
+#include "video_encoder_threading_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Threading configuration of the encoders of a video codec.
+struct VideoEncoderThreadingOverride {
+  /// SDP name of the codec, compared case-insensitively, or empty for the
+  /// default configuration of all codecs.
+  std::string codec_name;
+
+  mrsVideoEncoderThreadingConfig config;
+};
+
+/// Process-wide budget of encoder threads. Encoders reserve their threads when
+/// initialized and return them when released, so that the total number of
+/// threads of all encoders stays within the size of the pool.
+class VideoEncoderThreadPool : public rtc::RefCountInterface {
+ public:
+  /// Create a pool of the given number of threads, or an unlimited pool if
+  /// |size| is zero.
+  static rtc::scoped_refptr<VideoEncoderThreadPool> Create(uint32_t size);
+
+  /// Reserve up to |count| threads from the pool, and return the number of
+  /// threads reserved. This always reserves at least one thread, even if the
+  /// pool is exhausted, so that encoders can make progress.
+  int Acquire(int count);
+
+  /// Return threads reserved with |Acquire()| to the pool.
+  void Release(int count);
+
+  /// Number of threads currently reserved.
+  int in_use() const;
+
+ protected:
+  explicit VideoEncoderThreadPool(uint32_t size) : size_(size) {}
+
+ private:
+  const uint32_t size_;
+  mutable std::mutex mutex_;
+  int in_use_ RTC_GUARDED_BY(mutex_){0};
+};
+
+/// Video encoder factory applying a threading configuration to the encoders
+/// created by a wrapped factory, and reserving their threads from a shared
+/// pool. Codecs without configuration use WebRTC's default number of cores.
+class ThreadPoolVideoEncoderFactory : public webrtc::VideoEncoderFactory {
+ public:
+  ThreadPoolVideoEncoderFactory(
+      std::vector<VideoEncoderThreadingOverride> overrides,
+      rtc::scoped_refptr<VideoEncoderThreadPool> pool,
+      std::unique_ptr<webrtc::VideoEncoderFactory> factory);
+
+  std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
+  CodecInfo QueryVideoEncoder(
+      const webrtc::SdpVideoFormat& format) const override;
+  std::unique_ptr<webrtc::VideoEncoder> CreateVideoEncoder(
+      const webrtc::SdpVideoFormat& format) override;
+
+ private:
+  /// Find the configuration of the given codec, falling back to the default
+  /// configuration, or NULL if none.
+  const mrsVideoEncoderThreadingConfig* Find(
+      const std::string& codec_name) const;
+
+  const std::vector<VideoEncoderThreadingOverride> overrides_;
+  rtc::scoped_refptr<VideoEncoderThreadPool> pool_;
+  std::unique_ptr<webrtc::VideoEncoderFactory> factory_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,423 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+
+#include "rtc_base/stringutils.h"
+#include "rtc_base/timeutils.h"
+
+#include "virtual_audio_device_module.h"
+
+namespace {
+
+/// Message ID for the period processing task.
+constexpr uint32_t kMsgRunPeriod = 0;
+
+/// Duration of a single period, in milliseconds, as expected by the audio
+/// engine.
+constexpr int kPeriodDurationMs = 10;
+
+/// Name and GUID of the single virtual device in each direction.
+constexpr char kDeviceName[] = "Virtual audio device";
+constexpr char kDeviceGuid[] = "mrs-virtual-audio-device";
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+Result VirtualAudioDeviceModule::ValidateConfig(
+    const mrsAudioDeviceModuleConfig& config) {
+  switch (config.clock) {
+    case mrsVirtualAudioClock::kRealTime:
+    case mrsVirtualAudioClock::kNone:
+      break;
+    default:
+      RTC_LOG(LS_ERROR) << "Unknown virtual audio clock " << (int)config.clock
+                        << ".";
+      return Result::kInvalidParameter;
+  }
+  switch (config.sample_rate_hz) {
+    case 8000:
+    case 16000:
+    case 32000:
+    case 44100:
+    case 48000:
+      break;
+    default:
+      RTC_LOG(LS_ERROR) << "Invalid virtual audio device sampling rate "
+                        << config.sample_rate_hz << " Hz.";
+      return Result::kOutOfRange;
+  }
+  if ((config.channel_count < 1) || (config.channel_count > 2)) {
+    RTC_LOG(LS_ERROR) << "Invalid virtual audio device channel count "
+                      << config.channel_count << ".";
+    return Result::kOutOfRange;
+  }
+  return Result::kSuccess;
+}
+
+rtc::scoped_refptr<VirtualAudioDeviceModule> VirtualAudioDeviceModule::Create(
+    const mrsAudioDeviceModuleConfig& config) {
+  return new rtc::RefCountedObject<VirtualAudioDeviceModule>(config);
+}
+
+VirtualAudioDeviceModule::VirtualAudioDeviceModule(
+    const mrsAudioDeviceModuleConfig& config)
+    : clock_(config.clock),
+      sample_rate_hz_(config.sample_rate_hz),
+      channel_count_(config.channel_count),
+      samples_per_period_(config.sample_rate_hz * kPeriodDurationMs / 1000),
+      max_queued_samples_(config.sample_rate_hz * config.channel_count),
+      samples_(samples_per_period_ * channel_count_) {}
+
+VirtualAudioDeviceModule::~VirtualAudioDeviceModule() {
+  Terminate();
+}
+
+Result VirtualAudioDeviceModule::PushCaptureFrame(const AudioFrame& frame) {
+  if ((frame.bits_per_sample_ != 16) ||
+      (frame.sampling_rate_hz_ != sample_rate_hz_) ||
+      (frame.channel_count_ != channel_count_)) {
+    RTC_LOG(LS_ERROR) << "Virtual audio device capture frame format ("
+                      << frame.bits_per_sample_ << " bits, "
+                      << frame.sampling_rate_hz_ << " Hz, "
+                      << frame.channel_count_
+                      << " channels) does not match device format (16 bits, "
+                      << sample_rate_hz_ << " Hz, " << channel_count_
+                      << " channels).";
+    return Result::kInvalidParameter;
+  }
+  if ((frame.sample_count_ > 0) && !frame.data_) {
+    return Result::kInvalidParameter;
+  }
+  // Keep only the most recent audio if the frame alone overflows the queue
+  const size_t frame_size = frame.sample_count_ * channel_count_;
+  const size_t count = std::min(frame_size, max_queued_samples_);
+  const int16_t* const data =
+      static_cast<const int16_t*>(frame.data_) + (frame_size - count);
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t new_size = capture_queue_.size() + count;
+  if (new_size > max_queued_samples_) {
+    capture_queue_.erase(
+        capture_queue_.begin(),
+        capture_queue_.begin() + (new_size - max_queued_samples_));
+  }
+  capture_queue_.insert(capture_queue_.end(), data, data + count);
+  return Result::kSuccess;
+}
+
+void VirtualAudioDeviceModule::SetPlayoutCallback(
+    AudioFrameReadyCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  playout_callback_ = std::move(callback);
+}
+
+Result VirtualAudioDeviceModule::Process(uint32_t period_count) {
+  if (clock_ != mrsVirtualAudioClock::kNone) {
+    RTC_LOG(LS_ERROR) << "Cannot manually process a virtual audio device "
+                         "driven by a real-time clock.";
+    return Result::kInvalidOperation;
+  }
+  for (uint32_t i = 0; i < period_count; ++i) {
+    RunPeriod();
+  }
+  return Result::kSuccess;
+}
+
+int32_t VirtualAudioDeviceModule::ActiveAudioLayer(
+    AudioLayer* audio_layer) const {
+  *audio_layer = AudioLayer::kDummyAudio;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::RegisterAudioCallback(
+    webrtc::AudioTransport* transport) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  transport_ = transport;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::Init() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (initialized_) {
+    return 0;
+  }
+  initialized_ = true;
+  if (clock_ == mrsVirtualAudioClock::kRealTime) {
+    thread_ = rtc::Thread::Create();
+    thread_->SetName("VirtualAudioDeviceModule thread", this);
+    thread_->Start();
+    next_period_time_ms_ = rtc::TimeMillis();
+    thread_->PostAt(RTC_FROM_HERE, next_period_time_ms_, this, kMsgRunPeriod);
+  }
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::Terminate() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    initialized_ = false;
+    playout_initialized_ = false;
+    recording_initialized_ = false;
+    playing_ = false;
+    recording_ = false;
+  }
+  // Stop the thread outside the lock, since it may be waiting on it to run a
+  // period.
+  if (thread_) {
+    thread_->Stop();
+    thread_.reset();
+  }
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::Initialized() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return initialized_;
+}
+
+int32_t VirtualAudioDeviceModule::PlayoutDeviceName(
+    uint16_t index,
+    char name[webrtc::kAdmMaxDeviceNameSize],
+    char guid[webrtc::kAdmMaxGuidSize]) {
+  if (index != 0) {
+    return -1;
+  }
+  rtc::strcpyn(name, webrtc::kAdmMaxDeviceNameSize, kDeviceName);
+  if (guid) {
+    rtc::strcpyn(guid, webrtc::kAdmMaxGuidSize, kDeviceGuid);
+  }
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::RecordingDeviceName(
+    uint16_t index,
+    char name[webrtc::kAdmMaxDeviceNameSize],
+    char guid[webrtc::kAdmMaxGuidSize]) {
+  return PlayoutDeviceName(index, name, guid);
+}
+
+int32_t VirtualAudioDeviceModule::SetPlayoutDevice(uint16_t index) {
+  return (index == 0 ? 0 : -1);
+}
+
+int32_t VirtualAudioDeviceModule::SetRecordingDevice(uint16_t index) {
+  return (index == 0 ? 0 : -1);
+}
+
+int32_t VirtualAudioDeviceModule::PlayoutIsAvailable(bool* available) {
+  *available = true;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::InitPlayout() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  playout_initialized_ = true;
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::PlayoutIsInitialized() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return playout_initialized_;
+}
+
+int32_t VirtualAudioDeviceModule::RecordingIsAvailable(bool* available) {
+  *available = true;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::InitRecording() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  recording_initialized_ = true;
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::RecordingIsInitialized() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return recording_initialized_;
+}
+
+int32_t VirtualAudioDeviceModule::StartPlayout() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!playout_initialized_) {
+    return -1;
+  }
+  playing_ = true;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::StopPlayout() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  playing_ = false;
+  playout_initialized_ = false;
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::Playing() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return playing_;
+}
+
+int32_t VirtualAudioDeviceModule::StartRecording() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!recording_initialized_) {
+    return -1;
+  }
+  recording_ = true;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::StopRecording() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  recording_ = false;
+  recording_initialized_ = false;
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::Recording() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return recording_;
+}
+
+int32_t VirtualAudioDeviceModule::SpeakerVolumeIsAvailable(bool* available) {
+  *available = false;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::MicrophoneVolumeIsAvailable(
+    bool* available) {
+  *available = false;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::SpeakerMuteIsAvailable(bool* available) {
+  *available = false;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::MicrophoneMuteIsAvailable(bool* available) {
+  *available = false;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::StereoPlayoutIsAvailable(
+    bool* available) const {
+  *available = (channel_count_ == 2);
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::SetStereoPlayout(bool enable) {
+  // The channel count is fixed by the configuration
+  return (enable == (channel_count_ == 2) ? 0 : -1);
+}
+
+int32_t VirtualAudioDeviceModule::StereoPlayout(bool* enabled) const {
+  *enabled = (channel_count_ == 2);
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::StereoRecordingIsAvailable(
+    bool* available) const {
+  *available = (channel_count_ == 2);
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::SetStereoRecording(bool enable) {
+  return (enable == (channel_count_ == 2) ? 0 : -1);
+}
+
+int32_t VirtualAudioDeviceModule::StereoRecording(bool* enabled) const {
+  *enabled = (channel_count_ == 2);
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::PlayoutDelay(uint16_t* delay_ms) const {
+  *delay_ms = 0;
+  return 0;
+}
+
+void VirtualAudioDeviceModule::OnMessage(rtc::Message* msg) {
+  RTC_DCHECK(thread_->IsCurrent());
+  RTC_DCHECK_EQ(kMsgRunPeriod, msg->message_id);
+
+  RunPeriod();
+
+  // Schedule the next period on an absolute time to avoid drifting. If the
+  // thread fell behind by more than a few periods, skip ahead instead of
+  // bursting to catch up.
+  next_period_time_ms_ += kPeriodDurationMs;
+  const int64_t now_ms = rtc::TimeMillis();
+  if (next_period_time_ms_ < now_ms - 5 * kPeriodDurationMs) {
+    next_period_time_ms_ = now_ms;
+  }
+  thread_->PostAt(RTC_FROM_HERE, next_period_time_ms_, this, kMsgRunPeriod);
+}
+
+void VirtualAudioDeviceModule::RunPeriod() {
+  std::lock_guard<std::mutex> period_lock(period_mutex_);
+  const size_t sample_count = samples_per_period_ * channel_count_;
+  const size_t bytes_per_frame = channel_count_ * sizeof(int16_t);
+
+  webrtc::AudioTransport* transport;
+  AudioFrameReadyCallback playout_callback;
+  bool recording;
+  bool playing;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!transport_) {
+      return;
+    }
+    transport = transport_;
+    playout_callback = playout_callback_;
+    recording = recording_;
+    playing = playing_;
+    if (recording) {
+      // Record the queued audio, padded with silence if the application did
+      // not push enough of it.
+      const size_t queued = std::min(sample_count, capture_queue_.size());
+      std::copy(capture_queue_.begin(), capture_queue_.begin() + queued,
+                samples_.begin());
+      std::fill(samples_.begin() + queued, samples_.end(), (int16_t)0);
+      capture_queue_.erase(capture_queue_.begin(),
+                           capture_queue_.begin() + queued);
+    }
+  }
+
+  if (recording) {
+    uint32_t new_mic_level = 0;
+    transport->RecordedDataIsAvailable(
+        samples_.data(), samples_per_period_, bytes_per_frame, channel_count_,
+        sample_rate_hz_, /* total_delay_ms = */ 0, /* clock_drift = */ 0,
+        /* current_mic_level = */ 0, /* key_pressed = */ false,
+        new_mic_level);
+  }
+
+  if (playing) {
+    size_t samples_out = 0;
+    int64_t elapsed_time_ms = -1;
+    int64_t ntp_time_ms = -1;
+    transport->NeedMorePlayData(samples_per_period_, bytes_per_frame,
+                                channel_count_, sample_rate_hz_,
+                                samples_.data(), samples_out,
+                                &elapsed_time_ms, &ntp_time_ms);
+    if (playout_callback && (samples_out > 0)) {
+      AudioFrame frame;
+      frame.data_ = samples_.data();
+      frame.bits_per_sample_ = 16;
+      frame.sampling_rate_hz_ = sample_rate_hz_;
+      frame.channel_count_ = static_cast<uint32_t>(channel_count_);
+      frame.sample_count_ = static_cast<uint32_t>(samples_out);
+      playout_callback(frame);
+    }
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,200 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "modules/audio_device/include/audio_device.h"
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/thread.h"
+
+#include "audio_frame_observer.h"
+#include "mrs_errors.h"
+#include "virtual_audio_device_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Audio device module without any device I/O, for headless machines.
+///
+/// Every 10 ms period, the module records the next 10 ms of audio pushed by the
+/// application into its capture queue (or silence if the queue is empty), and
+/// pulls the next 10 ms of mixed playout audio from the audio engine to deliver
+/// it to the playout callback. Periods are driven either by a real-time clock
+/// on a dedicated thread, scheduled on absolute times to avoid drifting, or
+/// manually by the application with |Process()|.
+class VirtualAudioDeviceModule : public webrtc::AudioDeviceModule,
+                                 public rtc::MessageHandler {
+ public:
+  /// Check that the given configuration is valid for a virtual device.
+  static Result ValidateConfig(const mrsAudioDeviceModuleConfig& config);
+
+  /// Create a new virtual audio device module. The clock, if any, only starts
+  /// when the audio engine initializes the module.
+  static rtc::scoped_refptr<VirtualAudioDeviceModule> Create(
+      const mrsAudioDeviceModuleConfig& config);
+
+  /// Append some audio to the capture queue.
+  Result PushCaptureFrame(const AudioFrame& frame);
+
+  /// Register the callback receiving the mixed playout audio.
+  void SetPlayoutCallback(AudioFrameReadyCallback callback);
+
+  /// Run the given number of periods synchronously. Only valid without clock.
+  Result Process(uint32_t period_count);
+
+  //
+  // AudioDeviceModule
+  //
+
+  int32_t ActiveAudioLayer(AudioLayer* audio_layer) const override;
+  int32_t RegisterAudioCallback(webrtc::AudioTransport* transport) override;
+  int32_t Init() override;
+  int32_t Terminate() override;
+  bool Initialized() const override;
+  int16_t PlayoutDevices() override { return 1; }
+  int16_t RecordingDevices() override { return 1; }
+  int32_t PlayoutDeviceName(uint16_t index,
+                            char name[webrtc::kAdmMaxDeviceNameSize],
+                            char guid[webrtc::kAdmMaxGuidSize]) override;
+  int32_t RecordingDeviceName(uint16_t index,
+                              char name[webrtc::kAdmMaxDeviceNameSize],
+                              char guid[webrtc::kAdmMaxGuidSize]) override;
+  int32_t SetPlayoutDevice(uint16_t index) override;
+  int32_t SetPlayoutDevice(WindowsDeviceType device) override { return 0; }
+  int32_t SetRecordingDevice(uint16_t index) override;
+  int32_t SetRecordingDevice(WindowsDeviceType device) override { return 0; }
+  int32_t PlayoutIsAvailable(bool* available) override;
+  int32_t InitPlayout() override;
+  bool PlayoutIsInitialized() const override;
+  int32_t RecordingIsAvailable(bool* available) override;
+  int32_t InitRecording() override;
+  bool RecordingIsInitialized() const override;
+  int32_t StartPlayout() override;
+  int32_t StopPlayout() override;
+  bool Playing() const override;
+  int32_t StartRecording() override;
+  int32_t StopRecording() override;
+  bool Recording() const override;
+  int32_t InitSpeaker() override { return 0; }
+  bool SpeakerIsInitialized() const override { return true; }
+  int32_t InitMicrophone() override { return 0; }
+  bool MicrophoneIsInitialized() const override { return true; }
+  int32_t SpeakerVolumeIsAvailable(bool* available) override;
+  int32_t SetSpeakerVolume(uint32_t volume) override { return -1; }
+  int32_t SpeakerVolume(uint32_t* volume) const override { return -1; }
+  int32_t MaxSpeakerVolume(uint32_t* max_volume) const override { return -1; }
+  int32_t MinSpeakerVolume(uint32_t* min_volume) const override { return -1; }
+  int32_t MicrophoneVolumeIsAvailable(bool* available) override;
+  int32_t SetMicrophoneVolume(uint32_t volume) override { return -1; }
+  int32_t MicrophoneVolume(uint32_t* volume) const override { return -1; }
+  int32_t MaxMicrophoneVolume(uint32_t* max_volume) const override {
+    return -1;
+  }
+  int32_t MinMicrophoneVolume(uint32_t* min_volume) const override {
+    return -1;
+  }
+  int32_t SpeakerMuteIsAvailable(bool* available) override;
+  int32_t SetSpeakerMute(bool enable) override { return -1; }
+  int32_t SpeakerMute(bool* enabled) const override { return -1; }
+  int32_t MicrophoneMuteIsAvailable(bool* available) override;
+  int32_t SetMicrophoneMute(bool enable) override { return -1; }
+  int32_t MicrophoneMute(bool* enabled) const override { return -1; }
+  int32_t StereoPlayoutIsAvailable(bool* available) const override;
+  int32_t SetStereoPlayout(bool enable) override;
+  int32_t StereoPlayout(bool* enabled) const override;
+  int32_t StereoRecordingIsAvailable(bool* available) const override;
+  int32_t SetStereoRecording(bool enable) override;
+  int32_t StereoRecording(bool* enabled) const override;
+  int32_t PlayoutDelay(uint16_t* delay_ms) const override;
+  bool BuiltInAECIsAvailable() const override { return false; }
+  bool BuiltInAGCIsAvailable() const override { return false; }
+  bool BuiltInNSIsAvailable() const override { return false; }
+  int32_t EnableBuiltInAEC(bool enable) override { return -1; }
+  int32_t EnableBuiltInAGC(bool enable) override { return -1; }
+  int32_t EnableBuiltInNS(bool enable) override { return -1; }
+#if defined(WEBRTC_IOS)
+  int GetPlayoutAudioParameters(
+      webrtc::AudioParameters* params) const override {
+    return -1;
+  }
+  int GetRecordAudioParameters(webrtc::AudioParameters* params) const override {
+    return -1;
+  }
+#endif  // WEBRTC_IOS
+
+  //
+  // MessageHandler
+  //
+
+  void OnMessage(rtc::Message* msg) override;
+
+ protected:
+  explicit VirtualAudioDeviceModule(const mrsAudioDeviceModuleConfig& config);
+  ~VirtualAudioDeviceModule() override;
+
+  /// Run a single 10 ms capture and playout period. The caller must not hold
+  /// |mutex_|, which is only held to read the state of the module, and not
+  /// while invoking the audio transport and the playout callback.
+  void RunPeriod();
+
+ private:
+  const mrsVirtualAudioClock clock_;
+  const uint32_t sample_rate_hz_;
+  const size_t channel_count_;
+  const size_t samples_per_period_;
+
+  /// Maximum number of interleaved samples in |capture_queue_|.
+  const size_t max_queued_samples_;
+
+  /// Thread running the periods for |mrsVirtualAudioClock::kRealTime|, while
+  /// the module is initialized. NULL otherwise. Only created and destroyed by
+  /// |Init()| and |Terminate()|, which the audio engine calls on its worker
+  /// thread.
+  std::unique_ptr<rtc::Thread> thread_;
+
+  /// Time the next period is due, in milliseconds. Only accessed on |thread_|.
+  int64_t next_period_time_ms_{0};
+
+  /// Audio transport of the audio engine, which consumes the recorded audio
+  /// and produces the playout audio.
+  webrtc::AudioTransport* transport_ RTC_GUARDED_BY(mutex_){nullptr};
+
+  bool initialized_ RTC_GUARDED_BY(mutex_){false};
+  bool playout_initialized_ RTC_GUARDED_BY(mutex_){false};
+  bool recording_initialized_ RTC_GUARDED_BY(mutex_){false};
+  bool playing_ RTC_GUARDED_BY(mutex_){false};
+  bool recording_ RTC_GUARDED_BY(mutex_){false};
+
+  /// Interleaved 16-bit samples pushed by the application and not yet
+  /// recorded.
+  std::deque<int16_t> capture_queue_ RTC_GUARDED_BY(mutex_);
+
+  /// Interleaved samples of the current period, for either direction.
+  std::vector<int16_t> samples_ RTC_GUARDED_BY(period_mutex_);
+
+  /// Callback receiving the playout audio.
+  AudioFrameReadyCallback playout_callback_ RTC_GUARDED_BY(mutex_);
+
+  /// Protects the state of the module. Periods copy the transport, callback
+  /// and state under lock, then invoke them after releasing it, since the
+  /// audio engine may call back into the module from the transport while
+  /// holding its own locks. A period in progress can therefore still invoke
+  /// the previous transport or callback once after |StopPlayout()|,
+  /// |StopRecording()|, |RegisterAudioCallback()| or |SetPlayoutCallback()|
+  /// return.
+  mutable std::mutex mutex_;
+
+  /// Serializes the periods, which can run concurrently when the application
+  /// calls |Process()| from multiple threads. Always acquired before
+  /// |mutex_|.
+  std::mutex period_mutex_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
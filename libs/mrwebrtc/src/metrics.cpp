@@ -0,0 +1,263 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "rtc_base/strings/string_builder.h"
+
+#include "metrics.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace {
+
+constexpr int kCounterCount = static_cast<int>(MetricCounter::kCount);
+constexpr int kHistogramCount = static_cast<int>(MetricHistogram::kCount);
+
+/// Names of the counters in the snapshot, in enum order.
+const char* const kCounterNames[kCounterCount] = {
+    "video_frames_converted",
+    "argb_scratch_buffer_reallocations",
+    "nv12_scratch_buffer_reallocations",
+    "data_channel_messages_sent",
+    "data_channel_messages_dropped",
+    "data_channel_messages_received",
+    "audio_read_underruns",
+};
+
+/// Names of the histograms in the snapshot, in enum order.
+const char* const kHistogramNames[kHistogramCount] = {
+    "video_frame_conversion_us",
+};
+
+/// Values of all metrics. The values of a thread are only modified by that
+/// thread, and read by the thread taking a snapshot, so they are atomic but
+/// updated without read-modify-write operations.
+struct MetricValues {
+  struct Histogram {
+    std::atomic<uint64_t> buckets[Metrics::kBucketCount]{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+  };
+
+  std::atomic<uint64_t> counters[kCounterCount]{};
+  Histogram histograms[kHistogramCount];
+};
+
+/// Increment a value only modified by the calling thread.
+inline void Increment(std::atomic<uint64_t>& value, uint64_t delta) noexcept {
+  value.store(value.load(std::memory_order_relaxed) + delta,
+              std::memory_order_relaxed);
+}
+
+/// Accumulate all the values of |src| into |dst|.
+void Accumulate(const MetricValues& src, MetricValues& dst) noexcept {
+  for (int i = 0; i < kCounterCount; ++i) {
+    Increment(dst.counters[i], src.counters[i].load(std::memory_order_relaxed));
+  }
+  for (int i = 0; i < kHistogramCount; ++i) {
+    const MetricValues::Histogram& src_histogram = src.histograms[i];
+    MetricValues::Histogram& dst_histogram = dst.histograms[i];
+    for (int j = 0; j < Metrics::kBucketCount; ++j) {
+      Increment(dst_histogram.buckets[j],
+                src_histogram.buckets[j].load(std::memory_order_relaxed));
+    }
+    Increment(dst_histogram.count,
+              src_histogram.count.load(std::memory_order_relaxed));
+    Increment(dst_histogram.sum,
+              src_histogram.sum.load(std::memory_order_relaxed));
+  }
+}
+
+/// Registry of the values of all threads.
+struct Registry {
+  std::mutex mutex_;
+
+  /// Values of the threads alive.
+  std::vector<MetricValues*> threads_ RTC_GUARDED_BY(mutex_);
+
+  /// Values accumulated from the threads which exited.
+  MetricValues retired_ RTC_GUARDED_BY(mutex_);
+
+  /// Values at the time of the last reset, subtracted from the snapshots.
+  MetricValues baseline_ RTC_GUARDED_BY(mutex_);
+
+  /// Sum the values of all threads, minus the baseline, into |values|. This
+  /// must be called with |mutex_| held, and |values| zero-initialized.
+  void SumNoLock(MetricValues& values) {
+    Accumulate(retired_, values);
+    for (MetricValues* thread : threads_) {
+      Accumulate(*thread, values);
+    }
+    for (int i = 0; i < kCounterCount; ++i) {
+      Increment(values.counters[i],
+                0 - baseline_.counters[i].load(std::memory_order_relaxed));
+    }
+    for (int i = 0; i < kHistogramCount; ++i) {
+      const MetricValues::Histogram& base = baseline_.histograms[i];
+      MetricValues::Histogram& histogram = values.histograms[i];
+      for (int j = 0; j < Metrics::kBucketCount; ++j) {
+        Increment(histogram.buckets[j],
+                  0 - base.buckets[j].load(std::memory_order_relaxed));
+      }
+      Increment(histogram.count,
+                0 - base.count.load(std::memory_order_relaxed));
+      Increment(histogram.sum, 0 - base.sum.load(std::memory_order_relaxed));
+    }
+  }
+};
+
+/// Get the registry, which is never destroyed since threads can exit during
+/// static deinitializing of the process.
+Registry& GetRegistry() {
+  static Registry* const registry = new Registry();
+  return *registry;
+}
+
+/// Values of the calling thread, registered for its lifetime.
+class ThreadMetricValues {
+ public:
+  ThreadMetricValues() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex_);
+    registry.threads_.push_back(&values_);
+  }
+
+  ~ThreadMetricValues() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex_);
+    Accumulate(values_, registry.retired_);
+    registry.threads_.erase(std::remove(registry.threads_.begin(),
+                                        registry.threads_.end(), &values_),
+                            registry.threads_.end());
+  }
+
+  MetricValues& values() noexcept { return values_; }
+
+ private:
+  MetricValues values_;
+};
+
+MetricValues& GetThreadValues() {
+  thread_local ThreadMetricValues thread_values;
+  return thread_values.values();
+}
+
+/// Get the lowest value of the histogram bucket holding the given quantile of
+/// the recorded values.
+uint64_t GetQuantile(const MetricValues::Histogram& histogram,
+                     double quantile) {
+  const uint64_t count = histogram.count.load(std::memory_order_relaxed);
+  if (count == 0) {
+    return 0;
+  }
+  const uint64_t rank = static_cast<uint64_t>(quantile * (count - 1)) + 1;
+  uint64_t total = 0;
+  for (int i = 0; i < Metrics::kBucketCount; ++i) {
+    total += histogram.buckets[i].load(std::memory_order_relaxed);
+    if (total >= rank) {
+      return Metrics::GetBucketLowerBound(i);
+    }
+  }
+  return Metrics::GetBucketLowerBound(Metrics::kBucketCount - 1);
+}
+
+}  // namespace
+
+void Metrics::Add(MetricCounter counter, uint64_t value) noexcept {
+  Increment(GetThreadValues().counters[static_cast<int>(counter)], value);
+}
+
+void Metrics::Record(MetricHistogram histogram, uint64_t value) noexcept {
+  MetricValues::Histogram& values =
+      GetThreadValues().histograms[static_cast<int>(histogram)];
+  Increment(values.buckets[GetBucketIndex(value)], 1);
+  Increment(values.count, 1);
+  Increment(values.sum, value);
+}
+
+uint64_t Metrics::GetCount(MetricCounter counter) noexcept {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex_);
+  const int index = static_cast<int>(counter);
+  uint64_t count = registry.retired_.counters[index].load();
+  for (MetricValues* thread : registry.threads_) {
+    count += thread->counters[index].load(std::memory_order_relaxed);
+  }
+  return count - registry.baseline_.counters[index].load();
+}
+
+std::string Metrics::GetSnapshotJson() {
+  auto values = std::make_unique<MetricValues>();
+  {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex_);
+    registry.SumNoLock(*values);
+  }
+  rtc::StringBuilder builder;
+  builder << "{\"counters\":{";
+  for (int i = 0; i < kCounterCount; ++i) {
+    builder << (i > 0 ? ",\"" : "\"") << kCounterNames[i] << "\":"
+            << values->counters[i].load(std::memory_order_relaxed);
+  }
+  builder << "},\"histograms\":{";
+  for (int i = 0; i < kHistogramCount; ++i) {
+    const MetricValues::Histogram& histogram = values->histograms[i];
+    builder << (i > 0 ? ",\"" : "\"") << kHistogramNames[i]
+            << "\":{\"count\":" << histogram.count.load()
+            << ",\"sum\":" << histogram.sum.load()
+            << ",\"p50\":" << GetQuantile(histogram, 0.5)
+            << ",\"p90\":" << GetQuantile(histogram, 0.9)
+            << ",\"p99\":" << GetQuantile(histogram, 0.99)
+            << ",\"buckets\":[";
+    // Only write non-empty buckets, as [lower bound, count] pairs.
+    bool first = true;
+    for (int j = 0; j < kBucketCount; ++j) {
+      const uint64_t count = histogram.buckets[j].load();
+      if (count > 0) {
+        builder << (first ? "[" : ",[") << GetBucketLowerBound(j) << ","
+                << count << "]";
+        first = false;
+      }
+    }
+    builder << "]}";
+  }
+  builder << "}}";
+  return builder.Release();
+}
+
+void Metrics::Reset() noexcept {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex_);
+  // Threads cannot be written by another thread, so instead of clearing them
+  // record the current values as the new baseline.
+  auto values = std::make_unique<MetricValues>();
+  Accumulate(registry.retired_, *values);
+  for (MetricValues* thread : registry.threads_) {
+    Accumulate(*thread, *values);
+  }
+  for (int i = 0; i < kCounterCount; ++i) {
+    registry.baseline_.counters[i].store(values->counters[i].load());
+  }
+  for (int i = 0; i < kHistogramCount; ++i) {
+    MetricValues::Histogram& base = registry.baseline_.histograms[i];
+    const MetricValues::Histogram& histogram = values->histograms[i];
+    for (int j = 0; j < kBucketCount; ++j) {
+      base.buckets[j].store(histogram.buckets[j].load());
+    }
+    base.count.store(histogram.count.load());
+    base.sum.store(histogram.sum.load());
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
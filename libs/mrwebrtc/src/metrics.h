@@ -0,0 +1,156 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "rtc_base/timeutils.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Counters of the metrics registry.
+enum class MetricCounter : int {
+  /// Video frames converted to another pixel format before delivery to a
+  /// frame callback.
+  kVideoFramesConverted,
+
+  /// Reallocations of the ARGB32 scratch buffer of a video frame observer.
+  kArgbScratchBufferReallocations,
+
+  /// Reallocations of the NV12 scratch buffer of a video frame observer.
+  kNv12ScratchBufferReallocations,
+
+  /// Data channel messages sent successfully.
+  kDataChannelMessagesSent,
+
+  /// Data channel messages rejected because the send buffer was full.
+  kDataChannelMessagesDropped,
+
+  /// Data channel messages received.
+  kDataChannelMessagesReceived,
+
+  /// Reads of an audio track read buffer which ran out of audio.
+  kAudioReadUnderruns,
+
+  kCount
+};
+
+/// Latency histograms of the metrics registry. All values are in
+/// microseconds.
+enum class MetricHistogram : int {
+  /// Duration of the conversion of a video frame to another pixel format.
+  kVideoFrameConversionUs,
+
+  kCount
+};
+
+/// Registry of the counters and latency histograms of the library. Each thread
+/// updates its own set of values with relaxed atomic operations, so that
+/// updates never contend. The values of all threads are summed only when a
+/// snapshot is taken.
+///
+/// Histograms use log-linear buckets in the spirit of HDR histograms: values
+/// below 16 have their own bucket, and each power-of-two range above is split
+/// into 16 buckets, for a relative error below 6.25% over the whole range.
+class Metrics {
+ public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBucketCount = (1 << kSubBucketBits);
+
+  /// Values are clamped to 32 bits, a bit more than one hour in microseconds.
+  static constexpr int kBucketCount = kSubBucketCount * (33 - kSubBucketBits);
+
+  /// Add a value to a counter.
+  static void Add(MetricCounter counter, uint64_t value = 1) noexcept;
+
+  /// Record a value into a histogram.
+  static void Record(MetricHistogram histogram, uint64_t value) noexcept;
+
+  /// Get the sum of a counter over all threads.
+  static uint64_t GetCount(MetricCounter counter) noexcept;
+
+  /// Get the index of the histogram bucket of a value. This is defined inline
+  /// with |GetBucketLowerBound()|, so that the bucket layout can be unit tested
+  /// without the library exporting it.
+  static int GetBucketIndex(uint64_t value) noexcept;
+
+  /// Get the lowest value of a histogram bucket.
+  static uint64_t GetBucketLowerBound(int index) noexcept;
+
+  /// Take a snapshot of all the metrics, in JSON format.
+  static std::string GetSnapshotJson();
+
+  /// Reset all the metrics to zero.
+  static void Reset() noexcept;
+};
+
+inline int Metrics::GetBucketIndex(uint64_t value) noexcept {
+  if (value < kSubBucketCount) {
+    return static_cast<int>(value);
+  }
+  const uint32_t clamped =
+      static_cast<uint32_t>(std::min<uint64_t>(value, UINT32_MAX));
+  // Find the most significant bit, which is at least |kSubBucketBits|.
+  int msb = 0;
+  uint32_t v = clamped;
+  if (v >= (1u << 16)) {
+    v >>= 16;
+    msb += 16;
+  }
+  if (v >= (1u << 8)) {
+    v >>= 8;
+    msb += 8;
+  }
+  if (v >= (1u << 4)) {
+    v >>= 4;
+    msb += 4;
+  }
+  if (v >= (1u << 2)) {
+    v >>= 2;
+    msb += 2;
+  }
+  if (v >= (1u << 1)) {
+    msb += 1;
+  }
+  // Keep the most significant bit and the |kSubBucketBits| bits below it.
+  const int shift = msb - kSubBucketBits;
+  const int sub_bucket = static_cast<int>(clamped >> shift) - kSubBucketCount;
+  return kSubBucketCount * (shift + 1) + sub_bucket;
+}
+
+inline uint64_t Metrics::GetBucketLowerBound(int index) noexcept {
+  if (index < kSubBucketCount) {
+    return static_cast<uint64_t>(index);
+  }
+  const int shift = index / kSubBucketCount - 1;
+  const uint64_t sub_bucket = index % kSubBucketCount + kSubBucketCount;
+  return (sub_bucket << shift);
+}
+
+/// Helper recording the duration of a scope into a latency histogram.
+class ScopedMetricTimer {
+ public:
+  explicit ScopedMetricTimer(MetricHistogram histogram) noexcept
+      : histogram_(histogram), start_us_(rtc::TimeMicros()) {}
+  ~ScopedMetricTimer() noexcept {
+    Metrics::Record(histogram_,
+                    static_cast<uint64_t>(rtc::TimeMicros() - start_us_));
+  }
+
+  ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+  ScopedMetricTimer& operator=(const ScopedMetricTimer&) = delete;
+
+ private:
+  const MetricHistogram histogram_;
+  const int64_t start_us_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -14,8 +14,10 @@
 #include "media/local_video_track.h"
 #include "media/remote_audio_track.h"
 #include "media/remote_video_track.h"
+#include "pc/mediasession.h"
 #include "peer_connection.h"
 #include "sdp_utils.h"
+#include "tracing.h"
 #include "utils.h"
 #include "video_frame_observer.h"
 
@@ -379,7 +381,7 @@ void PeerConnection::RemoveDataChannel(
     std::lock_guard<std::mutex> lock(data_channel_removed_callback_mutex_);
     auto removed_cb = data_channel_removed_callback_;
     if (removed_cb) {
-      mrsDataChannelHandle data_native_handle = (void*)&data_channel;
+      mrsDataChannelHandle data_native_handle = data_channel.GetHandle();
       removed_cb(data_native_handle);
     }
   }
@@ -389,11 +391,23 @@ void PeerConnection::RemoveDataChannel(
   data_channel_ptr->OnRemovedFromPeerConnection();
 }
 
-void PeerConnection::RemoveAllDataChannels() noexcept {
-  std::lock_guard<std::mutex> lock_cb(data_channel_removed_callback_mutex_);
-  auto removed_cb = data_channel_removed_callback_;
-  std::lock_guard<std::mutex> lock(data_channel_mutex_);
-  for (auto&& data_channel : data_channels_) {
+void PeerConnection::RemoveAllDataChannels(bool invoke_callbacks) noexcept {
+  // Detach all data channels under the lock, but close them and invoke the
+  // callbacks outside of it, so that other threads accessing the data channels
+  // of this peer connection are not blocked while the channels are closed.
+  std::vector<std::shared_ptr<DataChannel>> data_channels;
+  {
+    std::lock_guard<std::mutex> lock(data_channel_mutex_);
+    data_channels.swap(data_channels_);
+    data_channel_from_id_.clear();
+    data_channel_from_label_.clear();
+  }
+  DataChannelRemovedCallback removed_cb;
+  if (invoke_callbacks) {
+    std::lock_guard<std::mutex> lock_cb(data_channel_removed_callback_mutex_);
+    removed_cb = data_channel_removed_callback_;
+  }
+  for (auto&& data_channel : data_channels) {
     // Close the WebRTC data channel
     webrtc::DataChannelInterface* const impl = data_channel->impl();
     impl->UnregisterObserver();  // force here, as ~DataChannel() didn't run yet
@@ -401,17 +415,13 @@ void PeerConnection::RemoveAllDataChannels() noexcept {
 
     // Invoke the DataChannelRemoved callback on the wrapper if any
     if (removed_cb) {
-      DataChannel* const dc = data_channel.get();
-      mrsDataChannelHandle data_native_handle = (void*)dc;
+      mrsDataChannelHandle data_native_handle = data_channel->GetHandle();
       removed_cb(data_native_handle);
     }
 
     // Clear the back pointer
     data_channel->OnRemovedFromPeerConnection();
   }
-  data_channel_from_id_.clear();
-  data_channel_from_label_.clear();
-  data_channels_.clear();
 }
 
 void PeerConnection::OnDataChannelAdded(
@@ -435,7 +445,7 @@ void PeerConnection::OnDataChannelAdded(
     auto added_cb = data_channel_added_callback_;
     if (added_cb) {
       mrsDataChannelAddedInfo info{};
-      info.handle = (void*)&data_channel;
+      info.handle = data_channel.GetHandle();
       info.id = data_channel.id();
       info.flags = data_channel.flags();
       str label_str = data_channel.label();  // keep alive
@@ -462,6 +472,7 @@ void PeerConnection::OnStreamChanged(
 
 Error PeerConnection::AddIceCandidate(
     const mrsIceCandidate& candidate) noexcept {
+  MRS_TRACE_SCOPE("PeerConnection::AddIceCandidate");
   if (!peer_) {
     return Error(Result::kInvalidOperation);
   }
@@ -480,6 +491,7 @@ Error PeerConnection::AddIceCandidate(
 }
 
 bool PeerConnection::CreateOffer() noexcept {
+  MRS_TRACE_SCOPE("PeerConnection::CreateOffer");
   if (!peer_) {
     return false;
   }
@@ -537,6 +549,7 @@ bool PeerConnection::CreateOffer() noexcept {
 }
 
 bool PeerConnection::CreateAnswer() noexcept {
+  MRS_TRACE_SCOPE("PeerConnection::CreateAnswer");
   if (!peer_) {
     return false;
   }
@@ -548,10 +561,12 @@ bool PeerConnection::CreateAnswer() noexcept {
   return true;
 }
 
-void PeerConnection::Close() noexcept {
+void PeerConnection::Close(bool invoke_callbacks) noexcept {
+  std::lock_guard<std::recursive_mutex> close_lock(close_mutex_);
   if (!peer_) {
     return;
   }
+  MRS_TRACE_SCOPE("PeerConnection::Close");
 
   // Keep a reference to the implementation while shutting down, but clear the
   // visible value in |peer_| to ensure |IsClosed()| returns false. This
@@ -559,6 +574,10 @@ void PeerConnection::Close() noexcept {
   // transceivers.
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> pc(std::move(peer_));
 
+  // Stop sampling stats before closing, since the sampler holds a reference to
+  // the implementation.
+  StopStatsSampler();
+
   // Close the connection
   pc->Close();
 
@@ -568,8 +587,12 @@ void PeerConnection::Close() noexcept {
     // Force-remove remote tracks. It doesn't look like the TrackRemoved
     // callback is called when Close() is used, so force it here.
     std::lock_guard<std::mutex> cb_lock{media_track_callback_mutex_};
-    auto audio_cb = audio_track_removed_callback_;
-    auto video_cb = video_track_removed_callback_;
+    AudioTrackRemovedCallback audio_cb;
+    VideoTrackRemovedCallback video_cb;
+    if (invoke_callbacks) {
+      audio_cb = audio_track_removed_callback_;
+      video_cb = video_track_removed_callback_;
+    }
     for (auto&& transceiver : transceivers_) {
       if (auto remote_track = transceiver->GetRemoteTrack()) {
         if (remote_track->GetKind() == mrsTrackKind::kAudioTrack) {
@@ -577,14 +600,14 @@ void PeerConnection::Close() noexcept {
               static_cast<RemoteAudioTrack*>(remote_track));  // keep alive
           audio_track->OnTrackRemoved(*this);
           if (audio_cb) {
-            audio_cb(audio_track.get(), transceiver.get());
+            audio_cb(audio_track->GetHandle(), transceiver->GetHandle());
           }
         } else if (remote_track->GetKind() == mrsTrackKind::kVideoTrack) {
           RefPtr<RemoteVideoTrack> video_track(
               static_cast<RemoteVideoTrack*>(remote_track));  // keep alive
           video_track->OnTrackRemoved(*this);
           if (video_cb) {
-            video_cb(video_track.get(), transceiver.get());
+            video_cb(video_track->GetHandle(), transceiver->GetHandle());
           }
         }
       }
@@ -592,12 +615,14 @@ void PeerConnection::Close() noexcept {
 
     // Clear and destroy transceivers (unless some implementation somewhere has
     // a reference, which should not happen).
+    transceiver_from_rtp_.clear();
+    transceiver_from_receiver_.clear();
     transceivers_.clear();
   }
 
   remote_streams_.clear();
 
-  RemoveAllDataChannels();
+  RemoveAllDataChannels(invoke_callbacks);
 
   // Release the internal webrtc::PeerConnection implementation. This call will
   // get proxied to the WebRTC signaling thread, so needs to occur before the
@@ -630,15 +655,35 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
   }
   std::vector<std::string> stream_ids =
       Transceiver::DecodeStreamIDs(config.stream_ids);
+  std::vector<webrtc::RtpEncodingParameters> send_encodings;
+  {
+    const Result result = Transceiver::BuildSendEncodings(
+        config.media_kind, config.send_encodings, config.send_encoding_count,
+        send_encodings);
+    if (result != Result::kSuccess) {
+      return Error(result, "Invalid send encodings.");
+    }
+  }
 
   RefPtr<Transceiver> transceiver;
   const int mline_index = -1;  // just created, so not associated yet
   switch (peer_->GetConfiguration().sdp_semantics) {
     case webrtc::SdpSemantics::kPlanB: {
+      // Simulcast in Plan B requires SDP munging, which is not supported.
+      if (send_encodings.size() > 1) {
+        return Error(Result::kUnsupported,
+                     "Multiple send encodings require Unified Plan.");
+      }
       // Plan B doesn't have transceivers; just create a wrapper.
       transceiver = Transceiver::CreateForPlanB(
           global_factory_, config.media_kind, *this, mline_index, name,
           std::move(stream_ids), config.desired_direction);
+      // Save the send encoding, if any, to apply it to the RTP sender once
+      // created and negotiated. This cannot fail, as already validated.
+      if (!send_encodings.empty()) {
+        transceiver->SetSendEncodings(config.send_encodings,
+                                      config.send_encoding_count);
+      }
       // Manually invoke the renegotiation needed event for parity with Unified
       // Plan, like the internal implementation would do.
       OnRenegotiationNeeded();
@@ -648,6 +693,7 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
       webrtc::RtpTransceiverInit init{};
       init.direction = Transceiver::ToRtp(config.desired_direction);
       init.stream_ids = stream_ids;
+      init.send_encodings = std::move(send_encodings);
       const cricket::MediaType rtc_media_type =
           MediaKindToRtc(config.media_kind);
       webrtc::RTCErrorOr<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>
@@ -666,17 +712,14 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
       return Error(Result::kUnknownError, "Unknown SDP semantic.");
   }
   RTC_DCHECK(transceiver);
-  {
-    rtc::CritScope lock(&transceivers_mutex_);
-    transceivers_.push_back(transceiver);
-  }
+  InsertTransceiver(transceiver);
 
   // Invoke the TransceiverAdded callback
   {
     std::lock_guard<std::mutex> lock(callbacks_mutex_);
     if (auto cb = transceiver_added_callback_) {
       mrsTransceiverAddedInfo info{};
-      info.transceiver_handle = transceiver.get();
+      info.transceiver_handle = transceiver->GetHandle();
       info.transceiver_name = name.c_str();
       info.media_kind = config.media_kind;
       info.mline_index = mline_index;
@@ -689,10 +732,78 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
   return transceiver.get();
 }
 
+Error PeerConnection::AddTransceivers(
+    const mrsTransceiverInitConfig* configs,
+    size_t count,
+    std::vector<Transceiver*>& transceivers) noexcept {
+  if (IsClosed()) {
+    return Error(Result::kInvalidOperation, "The peer connection is closed.");
+  }
+  if ((count > 0) && !configs) {
+    return Error(Result::kInvalidParameter);
+  }
+
+  // Validate the user-provided names and encodings upfront, to avoid creating
+  // only part of the batch on invalid input. Generated names are always valid.
+  std::vector<webrtc::RtpEncodingParameters> send_encodings;
+  for (size_t i = 0; i < count; ++i) {
+    if (!IsStringNullOrEmpty(configs[i].name) &&
+        !SdpIsValidToken(configs[i].name)) {
+      rtc::StringBuilder str("Invalid transceiver name: ");
+      str << configs[i].name;
+      return Error(Result::kInvalidParameter, str.Release());
+    }
+    const Result result = Transceiver::BuildSendEncodings(
+        configs[i].media_kind, configs[i].send_encodings,
+        configs[i].send_encoding_count, send_encodings);
+    if (result != Result::kSuccess) {
+      return Error(result, "Invalid send encodings.");
+    }
+  }
+  transceivers.reserve(transceivers.size() + count);
+
+  // Defer the RenegotiationNeeded events raised by each transceiver added.
+  {
+    std::lock_guard<std::mutex> lock(renegotiation_needed_callback_mutex_);
+    ++renegotiation_batch_depth_;
+  }
+
+  // Create all transceivers on the signaling thread, where the calls to the
+  // proxy of the WebRTC implementation are direct calls instead of a thread
+  // hop each.
+  Error error = global_factory_->GetSignalingThread()->Invoke<Error>(
+      RTC_FROM_HERE, [this, configs, count, &transceivers] {
+        for (size_t i = 0; i < count; ++i) {
+          ErrorOr<Transceiver*> ret = AddTransceiver(configs[i]);
+          if (!ret.ok()) {
+            return ret.MoveError();
+          }
+          transceivers.push_back(ret.value());
+        }
+        return Error(Result::kSuccess);
+      });
+
+  // Raise a single RenegotiationNeeded event for the entire batch, if any was
+  // deferred.
+  bool renegotiation_needed = false;
+  {
+    std::lock_guard<std::mutex> lock(renegotiation_needed_callback_mutex_);
+    if (--renegotiation_batch_depth_ == 0) {
+      renegotiation_needed = renegotiation_needed_pending_;
+      renegotiation_needed_pending_ = false;
+    }
+  }
+  if (renegotiation_needed) {
+    OnRenegotiationNeeded();
+  }
+  return error;
+}
+
 Error PeerConnection::SetRemoteDescriptionAsync(
     mrsSdpMessageType type,
     const char* sdp,
     RemoteDescriptionAppliedCallback callback) noexcept {
+  MRS_TRACE_SCOPE("PeerConnection::SetRemoteDescriptionAsync");
   if (!peer_) {
     return Error(mrsResult::kInvalidOperation);
   }
@@ -741,6 +852,8 @@ Error PeerConnection::SetRemoteDescriptionAsync(
 
 void PeerConnection::OnSignalingChange(
     webrtc::PeerConnectionInterface::SignalingState new_state) noexcept {
+  MRS_TRACE_INSTANT_ARG("PeerConnection::OnSignalingChange", "state",
+                        new_state);
   // See https://w3c.github.io/webrtc-pc/#rtcsignalingstate-enum
   switch (new_state) {
     case webrtc::PeerConnectionInterface::kStable:
@@ -839,7 +952,7 @@ void PeerConnection::OnDataChannel(
     auto added_cb = data_channel_added_callback_;
     if (added_cb) {
       mrsDataChannelAddedInfo info{};
-      info.handle = data_channel.get();
+      info.handle = data_channel->GetHandle();
       info.id = config.id;
       info.flags = config.flags;
       info.label = config.label;
@@ -849,7 +962,12 @@ void PeerConnection::OnDataChannel(
 }
 
 void PeerConnection::OnRenegotiationNeeded() noexcept {
+  MRS_TRACE_SCOPE("PeerConnection::OnRenegotiationNeeded");
   std::lock_guard<std::mutex> lock(renegotiation_needed_callback_mutex_);
+  if (renegotiation_batch_depth_ > 0) {
+    renegotiation_needed_pending_ = true;
+    return;
+  }
   auto cb = renegotiation_needed_callback_;
   if (cb) {
     cb();
@@ -858,6 +976,8 @@ void PeerConnection::OnRenegotiationNeeded() noexcept {
 
 void PeerConnection::OnIceConnectionChange(
     webrtc::PeerConnectionInterface::IceConnectionState new_state) noexcept {
+  MRS_TRACE_INSTANT_ARG("PeerConnection::OnIceConnectionChange", "state",
+                        new_state);
   std::lock_guard<std::mutex> lock(ice_state_changed_callback_mutex_);
   auto cb = ice_state_changed_callback_;
   if (cb) {
@@ -876,6 +996,7 @@ void PeerConnection::OnIceGatheringChange(
 
 void PeerConnection::OnIceCandidate(
     const webrtc::IceCandidateInterface* candidate) noexcept {
+  MRS_TRACE_SCOPE("PeerConnection::OnIceCandidate");
   std::lock_guard<std::mutex> lock(ice_candidate_ready_to_send_callback_mutex_);
   auto cb = ice_candidate_ready_to_send_callback_;
   if (cb) {
@@ -969,6 +1090,15 @@ void PeerConnection::OnTrack(
   for (auto&& id : receiver->stream_ids()) {
     RTC_LOG(LS_INFO) << "+ Stream #" << id;
   }
+
+  // Create the wrapper now, before the remote track is added, so that it can
+  // be looked up by RTP receiver.
+  ErrorOr<Transceiver*> err =
+      GetOrCreateTransceiverUnifiedPlan(std::move(transceiver));
+  if (!err.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to create a Transceiver object to hold a new "
+                         "RTP transceiver.";
+  }
 }
 
 void PeerConnection::OnRemoveTrack(
@@ -993,6 +1123,7 @@ void PeerConnection::OnRemoveTrack(
 
 void PeerConnection::OnLocalDescCreated(
     webrtc::SessionDescriptionInterface* desc) noexcept {
+  MRS_TRACE_SCOPE("PeerConnection::OnLocalDescCreated");
   if (!peer_) {
     return;
   }
@@ -1019,26 +1150,100 @@ void PeerConnection::OnLocalDescCreated(
           }
         }
       });
+  ApplyCodecPreferences(desc);
   // SetLocalDescription will invoke observer.OnSuccess() once done, which
   // will in turn invoke the |local_sdp_ready_to_send_callback_| registered if
   // any, or do nothing otherwise. The observer is a mandatory parameter.
   peer_->SetLocalDescription(observer, desc);
 }
 
+void PeerConnection::ApplyCodecPreferences(
+    webrtc::SessionDescriptionInterface* desc) {
+  cricket::SessionDescription* const session_desc = desc->description();
+  if (!session_desc) {
+    return;
+  }
+  const bool is_unified_plan = IsUnifiedPlan();
+  bool audio_done = false;
+  bool video_done = false;
+  rtc::CritScope lock(&transceivers_mutex_);
+  for (auto&& tr : transceivers_) {
+    cricket::ContentInfo* content = nullptr;
+    if (is_unified_plan) {
+      // Each transceiver has its own media line, identified by its mid.
+      const absl::optional<std::string> mid = tr->impl()->mid();
+      if (!mid.has_value()) {
+        continue;
+      }
+      content = session_desc->GetContentByName(mid.value());
+    } else {
+      // Plan B has a single media line per media kind, so the first
+      // transceiver with codec preferences for a given kind takes precedence.
+      bool& done =
+          (tr->GetMediaKind() == mrsMediaKind::kAudio ? audio_done
+                                                      : video_done);
+      if (done || tr->GetCodecPreferences().empty()) {
+        continue;
+      }
+      content = (tr->GetMediaKind() == mrsMediaKind::kAudio
+                     ? cricket::GetFirstAudioContent(session_desc)
+                     : cricket::GetFirstVideoContent(session_desc));
+      done = true;
+    }
+    if (content) {
+      tr->ApplyCodecPreferences(content->media_description());
+    }
+  }
+}
+
 RefPtr<Transceiver> PeerConnection::FindWrapperFromRtpTransceiver(
     webrtc::RtpTransceiverInterface* rtp_tr) const {
   RTC_DCHECK(rtp_tr);
   rtc::CritScope lock(&transceivers_mutex_);
-  auto it = std::find_if(transceivers_.begin(), transceivers_.end(),
-                         [&rtp_tr](const RefPtr<Transceiver>& tr) {
-                           return (tr->impl() == rtp_tr);
-                         });
-  if (it != transceivers_.end()) {
-    return *it;
+  auto it = transceiver_from_rtp_.find(rtp_tr);
+  if (it != transceiver_from_rtp_.end()) {
+    return it->second;
+  }
+  return nullptr;
+}
+
+RefPtr<Transceiver> PeerConnection::FindWrapperFromRtpReceiver(
+    webrtc::RtpReceiverInterface* receiver) const {
+  RTC_DCHECK(receiver);
+  rtc::CritScope lock(&transceivers_mutex_);
+  auto it = transceiver_from_receiver_.find(receiver);
+  if (it != transceiver_from_receiver_.end()) {
+    return it->second;
   }
   return nullptr;
 }
 
+void PeerConnection::InsertTransceiver(RefPtr<Transceiver> transceiver) {
+  RTC_DCHECK(transceiver);
+  // Read the RTP objects before locking, since in Unified Plan this goes
+  // through the proxies of the RTP transceiver.
+  rtc::scoped_refptr<webrtc::RtpTransceiverInterface> rtp_tr =
+      transceiver->impl();
+  rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver;
+  if (rtp_tr) {
+    receiver = rtp_tr->receiver();
+  } else {
+    receiver = transceiver->GetReceiverPlanB();
+  }
+  rtc::CritScope lock(&transceivers_mutex_);
+  if (rtp_tr) {
+    RTC_DCHECK(transceiver_from_rtp_.find(rtp_tr.get()) ==
+               transceiver_from_rtp_.end());
+    transceiver_from_rtp_.emplace(rtp_tr.get(), transceiver.get());
+  }
+  if (receiver) {
+    RTC_DCHECK(transceiver_from_receiver_.find(receiver.get()) ==
+               transceiver_from_receiver_.end());
+    transceiver_from_receiver_.emplace(receiver.get(), transceiver.get());
+  }
+  transceivers_.push_back(std::move(transceiver));
+}
+
 int PeerConnection::ExtractMlineIndexFromRtpTransceiver(
     webrtc::RtpTransceiverInterface* tr) {
   RTC_DCHECK(tr);
@@ -1067,17 +1272,11 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
   RTC_DCHECK(MediaKindFromRtc(receiver->media_type()) == media_kind);
 
   // Try to find an existing |Transceiver| instance for the given RTP receiver
-  // of the remote track.
-  {
-    auto it_tr = std::find_if(transceivers_.begin(), transceivers_.end(),
-                              [receiver](const RefPtr<Transceiver>& tr) {
-                                return tr->HasReceiver(receiver);
-                              });
-    if (it_tr != transceivers_.end()) {
-      RTC_DCHECK(media_kind == (*it_tr)->GetMediaKind());
-      Transceiver* transceiver = static_cast<Transceiver*>(it_tr->get());
-      return transceiver;
-    }
+  // of the remote track. In Unified Plan this is the common case, as the
+  // wrapper is created by |OnTrack()|.
+  if (RefPtr<Transceiver> transceiver = FindWrapperFromRtpReceiver(receiver)) {
+    RTC_DCHECK(media_kind == transceiver->GetMediaKind());
+    return transceiver.get();
   }
 
   if (IsUnifiedPlan()) {
@@ -1095,19 +1294,8 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
           Result::kNotFound,
           "Failed to match RTP receiver with an existing RTP transceiver.");
     }
-    rtc::scoped_refptr<webrtc::RtpTransceiverInterface> impl = *it_impl;
-    const int mline_index = ExtractMlineIndexFromRtpTransceiver(impl);
-    RTC_DCHECK(mline_index >= 0);  // should be always associated here
-    absl::optional<std::string> mid = impl->mid();
-    RTC_CHECK(mid.has_value());  // should be always true here
-    std::string name = mid.value();
-    std::vector<std::string> stream_ids =
-        ExtractTransceiverStreamIDsFromReceiver(receiver);
-
-    // Create a new transceiver wrapper for it
-    return CreateTransceiverUnifiedPlan(media_kind, mline_index,
-                                        std::move(name), std::move(stream_ids),
-                                        std::move(impl));
+    RTC_DCHECK(ExtractMlineIndexFromRtpTransceiver(*it_impl) >= 0);
+    return GetOrCreateTransceiverUnifiedPlan(*it_impl);
   } else {
     RTC_DCHECK(IsPlanB());
     // In Plan B, since there is no guarantee about the order of tracks, they
@@ -1132,17 +1320,14 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
         global_factory_, media_kind, *this, mline_index, name,
         std::move(stream_ids), desired_direction);
     transceiver->SetReceiverPlanB(receiver);
-    {
-      rtc::CritScope lock(&transceivers_mutex_);
-      transceivers_.push_back(transceiver);
-    }
+    InsertTransceiver(transceiver);
 
     // Invoke the TransceiverAdded callback
     {
       std::lock_guard<std::mutex> lock(callbacks_mutex_);
       if (auto cb = transceiver_added_callback_) {
         mrsTransceiverAddedInfo info{};
-        info.transceiver_handle = transceiver.get();
+        info.transceiver_handle = transceiver->GetHandle();
         info.transceiver_name = name.c_str();
         info.media_kind = media_kind;
         info.mline_index = mline_index;
@@ -1156,60 +1341,47 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
   }
 }
 
+ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverUnifiedPlan(
+    rtc::scoped_refptr<webrtc::RtpTransceiverInterface> rtp_transceiver) {
+  if (RefPtr<Transceiver> wrapper =
+          FindWrapperFromRtpTransceiver(rtp_transceiver.get())) {
+    return wrapper.get();
+  }
+  const int mline_index = ExtractMlineIndexFromRtpTransceiver(rtp_transceiver);
+  std::string name = rtp_transceiver->mid().value_or(std::string{});
+  RTC_LOG(LS_INFO) << "Creating new wrapper for RTP transceiver mid='"
+                   << name.c_str() << "' (#" << mline_index << ")";
+  std::vector<std::string> stream_ids =
+      ExtractTransceiverStreamIDsFromReceiver(rtp_transceiver->receiver());
+  return CreateTransceiverUnifiedPlan(
+      MediaKindFromRtc(rtp_transceiver->media_type()), mline_index,
+      std::move(name), std::move(stream_ids), std::move(rtp_transceiver));
+}
+
 void PeerConnection::SynchronizeTransceiversUnifiedPlan(bool remote) {
-  // Get RTP transceivers sorted by address in memory
+  // Match each RTP transceiver with its wrapper, and create wrappers for the
+  // ones without one yet. Lookups are indexed, so this is linear in the number
+  // of transceivers.
   auto rtp_transceivers = peer_->GetTransceivers();
-  std::sort(
-      rtp_transceivers.begin(), rtp_transceivers.end(),
-      [](auto const& t1, auto const& t2) { return (t1.get() < t2.get()); });
-  // Get transceiver wrappers sorted by RTP transceiver address in memory
-  std::vector<RefPtr<Transceiver>> wrappers;
-  {
-    rtc::CritScope lock(&transceivers_mutex_);
-    wrappers = transceivers_;
-  }
-  std::sort(wrappers.begin(), wrappers.end(),
-            [](auto const& t1, auto const& t2) {
-              return (t1->impl().get() < t2->impl().get());
-            });
-  // Match transceiver wrappers with their implementation, and create wrappers
-  // for the ones without one yet.
-  RTC_DCHECK_GE(rtp_transceivers.size(), wrappers.size());
-  auto it_wrapper = wrappers.begin();
   RTC_LOG(LS_INFO) << "Synchronizing " << rtp_transceivers.size()
-                   << " RTP transceivers with " << wrappers.size()
-                   << " transceiver wrappers (remote = " << remote << ").";
+                   << " RTP transceivers (remote = " << remote << ").";
   for (auto&& rtp_tr : rtp_transceivers) {
     const int mline_index = ExtractMlineIndexFromRtpTransceiver(rtp_tr);
-    // Compare the current item on the sorted arrays of RTP transceiver and
-    // transceiver wrappers; if the current items don't match, this means
-    // there's a missing wrapper for an existing RTP transceiver, so create it.
-    if ((it_wrapper == wrappers.end()) || ((*it_wrapper)->impl() != rtp_tr)) {
-      std::string name = rtp_tr->mid().value_or(std::string{});
-      RTC_LOG(LS_INFO) << "Creating new wrapper for RTP transceiver mid='"
-                       << name.c_str() << "' (#" << mline_index << ")";
-      std::vector<std::string> stream_ids =
-          ExtractTransceiverStreamIDsFromReceiver(rtp_tr->receiver());
-      ErrorOr<Transceiver*> err = CreateTransceiverUnifiedPlan(
-          MediaKindFromRtc(rtp_tr->media_type()), mline_index, std::move(name),
-          std::move(stream_ids), rtp_tr);
-      if (!err.ok()) {
-        RTC_LOG(LS_ERROR) << "Failed to create a Transceiver object to hold a "
-                             "new RTP transceiver.";
-        continue;
-      }
-      it_wrapper = wrappers.insert(it_wrapper, err.MoveValue());
+    ErrorOr<Transceiver*> err = GetOrCreateTransceiverUnifiedPlan(rtp_tr);
+    if (!err.ok()) {
+      RTC_LOG(LS_ERROR) << "Failed to create a Transceiver object to hold a "
+                           "new RTP transceiver.";
+      continue;
     }
-    RTC_DCHECK(it_wrapper != wrappers.end());
+    Transceiver* const wrapper = err.value();
     // Ensure the Transceiver object is in sync with its RTP counterpart
-    (*it_wrapper)->OnSessionDescUpdated(remote);
+    wrapper->OnSessionDescUpdated(remote);
     // Check if newly associated
-    if ((*it_wrapper)->GetMlineIndex() != mline_index) {
+    if (wrapper->GetMlineIndex() != mline_index) {
       RTC_DCHECK(mline_index >= 0);
       RTC_DCHECK(!remote);  // already created associated with remote
-      (*it_wrapper)->OnAssociated(mline_index);
+      wrapper->OnAssociated(mline_index);
     }
-    ++it_wrapper;
   }
 }
 
@@ -1224,16 +1396,13 @@ ErrorOr<Transceiver*> PeerConnection::CreateTransceiverUnifiedPlan(
   RefPtr<Transceiver> transceiver = Transceiver::CreateForUnifiedPlan(
       global_factory_, media_kind, *this, mline_index, std::move(name),
       stream_ids, std::move(rtp_transceiver), desired_direction);
-  {
-    rtc::CritScope lock(&transceivers_mutex_);
-    transceivers_.push_back(transceiver);
-  }
+  InsertTransceiver(transceiver);
   {
     std::lock_guard<std::mutex> lock(callbacks_mutex_);
     if (auto cb = transceiver_added_callback_) {
       std::string encoded_stream_ids = Transceiver::EncodeStreamIDs(stream_ids);
       mrsTransceiverAddedInfo info{};
-      info.transceiver_handle = transceiver.get();
+      info.transceiver_handle = transceiver->GetHandle();
       info.transceiver_name = name.c_str();
       info.media_kind = media_kind;
       info.mline_index = mline_index;
@@ -1343,6 +1512,51 @@ ErrorOr<RefPtr<PeerConnection>> PeerConnection::create(
   return RefPtr<PeerConnection>(peer);
 }
 
+Result PeerConnection::StartStatsSampler(
+    const mrsStatsSamplerConfig& config) noexcept {
+  if (!peer_) {
+    return Result::kPeerConnectionClosed;
+  }
+  rtc::Thread* const signaling_thread = global_factory_->GetSignalingThread();
+  if (!signaling_thread) {
+    return Result::kNotInitialized;
+  }
+  rtc::scoped_refptr<StatsSampler> sampler =
+      StatsSampler::Create(signaling_thread, peer_, config);
+  rtc::scoped_refptr<StatsSampler> old_sampler;
+  {
+    std::lock_guard<std::mutex> lock(stats_sampler_mutex_);
+    old_sampler = std::move(stats_sampler_);
+    stats_sampler_ = sampler;
+  }
+  // Stop outside the lock, since this blocks on the signaling thread.
+  if (old_sampler) {
+    old_sampler->Stop();
+  }
+  sampler->Start();
+  return Result::kSuccess;
+}
+
+void PeerConnection::StopStatsSampler() noexcept {
+  rtc::scoped_refptr<StatsSampler> sampler;
+  {
+    std::lock_guard<std::mutex> lock(stats_sampler_mutex_);
+    sampler = stats_sampler_;
+  }
+  if (sampler) {
+    sampler->Stop();
+  }
+}
+
+uint32_t PeerConnection::ReadStatsSamples(mrsStatsSample* samples,
+                                          uint32_t capacity) const noexcept {
+  std::lock_guard<std::mutex> lock(stats_sampler_mutex_);
+  if (!stats_sampler_) {
+    return 0;
+  }
+  return stats_sampler_->ReadSamples(samples, capacity);
+}
+
 void PeerConnection::GetStats(webrtc::RTCStatsCollectorCallback* callback) {
   peer_->GetStats(callback);
 }
@@ -10,6 +10,7 @@
 #include "mrs_errors.h"
 #include "peer_connection_interop.h"
 #include "refptr.h"
+#include "stats_sampler.h"
 #include "toggle_audio_mixer.h"
 #include "tracked_object.h"
 #include "utils.h"
@@ -234,8 +235,11 @@ class PeerConnection : public TrackedObject,
 
   /// Close the peer connection. After the connection is closed, it cannot be
   /// opened again with the same C++ object. Instantiate a new |PeerConnection|
-  /// object instead to create a new connection. No-op if already closed.
-  void Close() noexcept;
+  /// object instead to create a new connection. No-op if already closed. If
+  /// another thread is closing the connection, wait until it is closed. If
+  /// |invoke_callbacks| is |false|, the track removed and data channel removed
+  /// callbacks are not invoked.
+  void Close(bool invoke_callbacks = true) noexcept;
 
   /// Check if the connection is closed. This returns |true| once |Close()| has
   /// been called.
@@ -263,6 +267,20 @@ class PeerConnection : public TrackedObject,
   ErrorOr<Transceiver*> AddTransceiver(
       const mrsTransceiverInitConfig& config) noexcept;
 
+  /// Add a batch of audio and/or video transceivers to the peer connection, in
+  /// order, and append them to |transceivers|. This is equivalent to calling
+  /// |AddTransceiver()| for each configuration, except that all transceivers
+  /// are created with a single hop to the signaling thread, and a single
+  /// |RenegotiationNeeded| event is raised for the entire batch.
+  ///
+  /// All configurations are validated before any transceiver is created. If
+  /// the creation of a transceiver fails nonetheless, the ones already created
+  /// are kept and returned in |transceivers|, as transceivers cannot be removed
+  /// from a peer connection.
+  Error AddTransceivers(const mrsTransceiverInitConfig* configs,
+                        size_t count,
+                        std::vector<Transceiver*>& transceivers) noexcept;
+
   //
   // Video
   //
@@ -395,8 +413,9 @@ class PeerConnection : public TrackedObject,
   void RemoveDataChannel(const DataChannel& data_channel) noexcept;
 
   /// Close and remove from the peer connection all data channels at once.
-  /// This invokes the DataChannelRemoved callback for each data channel.
-  void RemoveAllDataChannels() noexcept;
+  /// This invokes the DataChannelRemoved callback for each data channel,
+  /// unless |invoke_callbacks| is |false|.
+  void RemoveAllDataChannels(bool invoke_callbacks = true) noexcept;
 
   /// Notification from a non-negotiated DataChannel that it is open, so that
   /// the PeerConnection can fire a DataChannelAdded event. This is called
@@ -406,6 +425,23 @@ class PeerConnection : public TrackedObject,
   void OnStreamChanged(
       rtc::scoped_refptr<webrtc::MediaStreamInterface> stream) noexcept;
 
+  //
+  // Stats
+  //
+
+  /// Start sampling stats periodically on the signaling thread. This replaces
+  /// any sampler already running, discarding its samples.
+  Result StartStatsSampler(const mrsStatsSamplerConfig& config) noexcept;
+
+  /// Stop the periodic stats sampler, if any. Samples collected so far remain
+  /// readable with |ReadStatsSamples()|.
+  void StopStatsSampler() noexcept;
+
+  /// Copy the most recent stats samples, oldest first, into |samples|. Return
+  /// the number of samples copied.
+  uint32_t ReadStatsSamples(mrsStatsSample* samples,
+                            uint32_t capacity) const noexcept;
+
   // Internal use.
   void GetStats(webrtc::RTCStatsCollectorCallback* callback);
   void InvokeRenegotiationNeeded();
@@ -458,6 +494,9 @@ class PeerConnection : public TrackedObject,
       const std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface>>&
           streams) noexcept override;
 
+  /// Callback on RTP transceiver starting to receive a remote track (Unified
+  /// Plan only). This creates the transceiver wrapper if needed, so that the
+  /// associated |OnAddTrack()| finds it without scanning all RTP transceivers.
   void OnTrack(rtc::scoped_refptr<webrtc::RtpTransceiverInterface>
                    transceiver) noexcept override;
 
@@ -475,6 +514,12 @@ class PeerConnection : public TrackedObject,
   /// after |Close()| is called.
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_;
 
+  /// Serialize the calls to |Close()|, for example from a bulk close and from
+  /// the application, so that the connection is closed once and every caller
+  /// returns only after it is closed. This is recursive so that a callback
+  /// invoked while closing can call |Close()| again, which is a no-op.
+  std::recursive_mutex close_mutex_;
+
  protected:
   /// Peer connection name assigned by the user. This has no meaning for the
   /// implementation.
@@ -523,6 +568,16 @@ class PeerConnection : public TrackedObject,
   RenegotiationNeededCallback renegotiation_needed_callback_
       RTC_GUARDED_BY(renegotiation_needed_callback_mutex_);
 
+  /// Number of nested batch operations in progress, during which the
+  /// |RenegotiationNeeded| events are coalesced into a single one raised at
+  /// the end of the outermost batch.
+  int renegotiation_batch_depth_
+      RTC_GUARDED_BY(renegotiation_needed_callback_mutex_){0};
+
+  /// Whether a |RenegotiationNeeded| event was deferred by a batch operation.
+  bool renegotiation_needed_pending_
+      RTC_GUARDED_BY(renegotiation_needed_callback_mutex_){false};
+
   /// User callback invoked when a remote audio track is added.
   AudioTrackAddedCallback audio_track_added_callback_
       RTC_GUARDED_BY(media_track_callback_mutex_);
@@ -575,6 +630,17 @@ class PeerConnection : public TrackedObject,
   std::vector<RefPtr<Transceiver>> transceivers_
       RTC_GUARDED_BY(transceivers_mutex_);
 
+  /// Index of the transceivers of |transceivers_| from their RTP transceiver.
+  /// This only contains Unified Plan transceivers, as Plan B emulated ones do
+  /// not have any RTP transceiver.
+  std::unordered_map<webrtc::RtpTransceiverInterface*, Transceiver*>
+      transceiver_from_rtp_ RTC_GUARDED_BY(transceivers_mutex_);
+
+  /// Index of the transceivers of |transceivers_| from their RTP receiver.
+  /// The RTP receiver of a transceiver never changes once assigned.
+  std::unordered_map<webrtc::RtpReceiverInterface*, Transceiver*>
+      transceiver_from_receiver_ RTC_GUARDED_BY(transceivers_mutex_);
+
   /// Mutex for the collections of transceivers.
   rtc::CriticalSection transceivers_mutex_;
 
@@ -610,6 +676,14 @@ class PeerConnection : public TrackedObject,
 
   rtc::scoped_refptr<ToggleAudioMixer> audio_mixer_;
 
+  /// Periodic stats sampler, if started. Kept after being stopped so that the
+  /// samples it collected remain readable.
+  rtc::scoped_refptr<StatsSampler> stats_sampler_
+      RTC_GUARDED_BY(stats_sampler_mutex_);
+
+  /// Mutex for |stats_sampler_|.
+  mutable std::mutex stats_sampler_mutex_;
+
  private:
   PeerConnection(RefPtr<GlobalFactory> global_factory);
   PeerConnection(const PeerConnection&) = delete;
@@ -625,11 +699,25 @@ class PeerConnection : public TrackedObject,
             webrtc::SdpSemantics::kUnifiedPlan);
   }
 
+  /// Apply the codec preferences of all transceivers to a newly created local
+  /// description, before it is applied. The description object is modified in
+  /// place, without any SDP string round-trip.
+  void ApplyCodecPreferences(webrtc::SessionDescriptionInterface* desc);
+
   /// Find the |Transceiver| wrapper of an RTP transceiver, or |nullptr| if the
   /// RTP transceiver doesn't have a wrapper yet.
   RefPtr<Transceiver> FindWrapperFromRtpTransceiver(
       webrtc::RtpTransceiverInterface* tr) const;
 
+  /// Find the transceiver wrapper owning a given RTP receiver, or |nullptr| if
+  /// the receiver is not associated with any wrapper yet.
+  RefPtr<Transceiver> FindWrapperFromRtpReceiver(
+      webrtc::RtpReceiverInterface* receiver) const;
+
+  /// Append a newly created transceiver wrapper to |transceivers_| and index
+  /// it. For Plan B, the RTP receiver, if any, must be set before this call.
+  void InsertTransceiver(RefPtr<Transceiver> transceiver);
+
   /// Extract the media line index from an RTP transceiver, or -1 if not
   /// associated.
   static int ExtractMlineIndexFromRtpTransceiver(
@@ -647,6 +735,11 @@ class PeerConnection : public TrackedObject,
       mrsMediaKind media_kind,
       webrtc::RtpReceiverInterface* receiver);
 
+  /// Get the existing or create a new |Transceiver| wrapper for an RTP
+  /// transceiver (Unified Plan only).
+  ErrorOr<Transceiver*> GetOrCreateTransceiverUnifiedPlan(
+      rtc::scoped_refptr<webrtc::RtpTransceiverInterface> rtp_transceiver);
+
   /// Ensure each RTP transceiver has a corresponding |Transceiver| instance
   /// associated with it. This is called each time a local or remote description
   /// was just applied on the local peer.
@@ -770,7 +863,8 @@ class PeerConnection : public TrackedObject,
       // Read the function pointer inside the lock to avoid race condition
       auto cb = *track_added_cb;
       if (cb) {
-        Media::ExecTrackAdded(remote_media_track.get(), transceiver,
+        Media::ExecTrackAdded(remote_media_track->GetHandle(),
+                              transceiver->GetHandle(),
                               remote_media_track->GetName().c_str(), cb);
       }
     }
@@ -788,18 +882,14 @@ class PeerConnection : public TrackedObject,
     using Media = MediaTrait<MEDIA_KIND>;
 
     rtc::CritScope tracks_lock(&transceivers_mutex_);
-    auto it = std::find_if(transceivers_.begin(), transceivers_.end(),
-                           [receiver](const RefPtr<Transceiver>& tr) {
-                             return tr->HasReceiver(receiver);
-                           });
-    if (it == transceivers_.end()) {
+    RefPtr<Transceiver> transceiver = FindWrapperFromRtpReceiver(receiver);
+    if (!transceiver) {
       RTC_LOG(LS_ERROR)
           << "Trying to remove receiver " << receiver->id().c_str()
           << " from peer connection " << GetName()
           << " but no transceiver was found which owns such receiver.";
       return;
     }
-    RefPtr<Transceiver> transceiver = *it;
     RTC_DCHECK(transceiver->GetMediaKind() == MEDIA_KIND);
     RefPtr<typename Media::RemoteMediaTrackT> media_track(
         static_cast<typename Media::RemoteMediaTrackT*>(
@@ -812,7 +902,7 @@ class PeerConnection : public TrackedObject,
       // Read the function pointer inside the lock to avoid race condition
       auto cb = *track_removed_cb;
       if (cb) {
-        cb(media_track.get(), transceiver.get());
+        cb(media_track->GetHandle(), transceiver->GetHandle());
       }
     }
     // |media_track| goes out of scope and destroys the C++ instance
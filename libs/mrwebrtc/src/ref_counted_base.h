@@ -18,6 +18,21 @@ class RefCountedBase {
     ref_count_.fetch_add(1, std::memory_order_relaxed);
   }
 
+  /// Add a reference only if the object is still referenced, and return
+  /// whether a reference was added. This allows safely acquiring a reference
+  /// to an object found through a weak pointer, like the live object
+  /// registry, which may be already being destroyed.
+  bool TryAddRef() const noexcept {
+    std::uint32_t count = ref_count_.load(std::memory_order_relaxed);
+    while (count > 0) {
+      if (ref_count_.compare_exchange_weak(count, count + 1,
+                                           std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   void RemoveRef() const noexcept {
     if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
       delete this;
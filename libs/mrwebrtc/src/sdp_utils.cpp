@@ -7,8 +7,10 @@
 #include "sdp_utils.h"
 
 #include "api/jsepsessiondescription.h"
+#include "media/base/mediaconstants.h"
 #include "pc/sessiondescription.h"
 #include "pc/webrtcsdp.h"
+#include "rtc_base/stringutils.h"
 
 namespace {
 
@@ -47,6 +49,50 @@ bool SetPreferredCodec(
   return true;
 }
 
+/// Restrict the codecs of the media content description to the given list of
+/// codec names, reordered by preference. See |SdpApplyCodecPreferences()|.
+template <typename C>
+bool FilterCodecsByName(const std::vector<std::string>& codec_names,
+                        cricket::MediaContentDescriptionImpl<C>* desc) {
+  const std::vector<C>& codecs = desc->codecs();
+  std::vector<C> new_codecs;
+  new_codecs.reserve(codecs.size());
+  auto has_payload_type = [&new_codecs](int id) {
+    return std::any_of(new_codecs.begin(), new_codecs.end(),
+                       [id](const C& codec) { return (codec.id == id); });
+  };
+
+  // Add primary codecs in order of preference
+  for (auto&& name : codec_names) {
+    for (auto&& codec : codecs) {
+      if ((_stricmp(codec.name.c_str(), name.c_str()) == 0) &&
+          (_stricmp(codec.name.c_str(), cricket::kRtxCodecName) != 0) &&
+          !has_payload_type(codec.id)) {
+        new_codecs.push_back(codec);
+      }
+    }
+  }
+  if (new_codecs.empty()) {
+    return false;
+  }
+
+  // Keep the retransmission codecs associated with any preserved codec
+  for (auto&& codec : codecs) {
+    if (_stricmp(codec.name.c_str(), cricket::kRtxCodecName) != 0) {
+      continue;
+    }
+    int associated_id{};
+    if (codec.GetParam(cricket::kCodecParamAssociatedPayloadType,
+                       &associated_id) &&
+        has_payload_type(associated_id)) {
+      new_codecs.push_back(codec);
+    }
+  }
+
+  desc->set_codecs(new_codecs);
+  return true;
+}
+
 bool TryExtractSuffix(const std::string& str,
                       const std::string& prefix,
                       std::string& suffixOut) {
@@ -150,6 +196,23 @@ std::string SdpForceCodecs(
   return webrtc::SdpSerialize(jdesc);
 }
 
+bool SdpApplyCodecPreferences(cricket::MediaContentDescription* media_desc,
+                              const std::vector<std::string>& codec_names) {
+  if (!media_desc || codec_names.empty()) {
+    return false;
+  }
+  switch (media_desc->type()) {
+    case cricket::MediaType::MEDIA_TYPE_AUDIO:
+      return FilterCodecsByName<cricket::AudioCodec>(codec_names,
+                                                     media_desc->as_audio());
+    case cricket::MediaType::MEDIA_TYPE_VIDEO:
+      return FilterCodecsByName<cricket::VideoCodec>(codec_names,
+                                                     media_desc->as_video());
+    default:
+      return false;
+  }
+}
+
 webrtc::PeerConnectionInterface::IceServers DecodeIceServers(
     const std::string& str) {
   if (str.empty())
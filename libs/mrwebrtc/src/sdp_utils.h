@@ -9,6 +9,10 @@
 #include "callback.h"
 #include "interop_api.h"
 
+namespace cricket {
+class MediaContentDescription;
+}
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
@@ -43,6 +47,17 @@ std::string SdpForceCodecs(
     const std::string& video_codec_name,
     const std::map<std::string, std::string>& extra_video_codec_params);
 
+/// Restrict in-place the codecs of a single media content description to the
+/// given list of codec names, in decreasing order of preference. Codec names
+/// are compared case-insensitively. Retransmission (RTX) codecs associated
+/// with a preserved codec are preserved too. If none of the codec names is
+/// found in the media content description, it is left untouched and the
+/// function returns |false|.
+/// This operates directly on an already-parsed session description, and
+/// therefore avoids the deserialize/serialize round-trip of |SdpForceCodecs()|.
+bool SdpApplyCodecPreferences(cricket::MediaContentDescription* media_desc,
+                              const std::vector<std::string>& codec_names);
+
 /// Decode a marshalled ICE server string.
 /// Syntax is:
 ///   string = blocks
@@ -0,0 +1,229 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "stats_sampler.h"
+
+namespace {
+
+/// Message ID for the periodic sampling task.
+constexpr uint32_t kMsgSample = 0;
+
+/// Compute the increase of a cumulative counter since the previous sample.
+/// Totals can shrink when a stream is removed from the report, in which case
+/// the delta is clamped to zero instead of wrapping around.
+uint64_t CounterDelta(uint64_t current, uint64_t previous) {
+  return (current > previous ? current - previous : 0);
+}
+
+/// Compute a per-second rate from a counter delta over an interval in
+/// microseconds.
+double RatePerSecond(double delta, int64_t interval_us) {
+  return (interval_us > 0 ? delta * 1000000.0 / interval_us : 0.0);
+}
+
+/// Compute the fraction of packets lost over an interval.
+double LossRate(int64_t lost_delta, uint64_t received_delta) {
+  const double total = static_cast<double>(lost_delta) +
+                       static_cast<double>(received_delta);
+  return (total > 0.0 && lost_delta > 0 ? lost_delta / total : 0.0);
+}
+
+template <class T>
+T GetValueIfDefined(const webrtc::RTCStatsMember<T>& member) {
+  return member.is_defined() ? *member : 0;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+rtc::scoped_refptr<StatsSampler> StatsSampler::Create(
+    rtc::Thread* signaling_thread,
+    rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer,
+    const mrsStatsSamplerConfig& config) {
+  return new rtc::RefCountedObject<StatsSampler>(signaling_thread,
+                                                 std::move(peer), config);
+}
+
+StatsSampler::StatsSampler(
+    rtc::Thread* signaling_thread,
+    rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer,
+    const mrsStatsSamplerConfig& config)
+    : signaling_thread_(signaling_thread),
+      interval_ms_(config.interval_ms),
+      peer_(std::move(peer)),
+      samples_(static_cast<size_t>(config.capacity)) {
+  RTC_CHECK(signaling_thread_);
+  RTC_CHECK(interval_ms_ > 0);
+  RTC_CHECK(!samples_.empty());
+}
+
+void StatsSampler::Start() {
+  signaling_thread_->Invoke<void>(RTC_FROM_HERE, [this] {
+    if (running_ || !peer_) {
+      return;
+    }
+    running_ = true;
+    has_previous_ = false;
+    signaling_thread_->Post(RTC_FROM_HERE, this, kMsgSample);
+  });
+}
+
+void StatsSampler::Stop() {
+  // Run synchronously on the signaling thread so that on return no sampling
+  // task is in progress. Any report still in flight is discarded on delivery.
+  signaling_thread_->Invoke<void>(RTC_FROM_HERE, [this] {
+    running_ = false;
+    signaling_thread_->Clear(this);
+    peer_ = nullptr;
+  });
+}
+
+uint32_t StatsSampler::ReadSamples(mrsStatsSample* samples,
+                                   uint32_t capacity) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t ring_size = samples_.size();
+  const uint64_t available = std::min<uint64_t>(sample_count_, ring_size);
+  const uint64_t count = std::min<uint64_t>(available, capacity);
+  // Copy the |count| most recent samples, oldest first.
+  uint64_t index = sample_count_ - count;
+  for (uint64_t i = 0; i < count; ++i, ++index) {
+    samples[i] = samples_[index % ring_size];
+  }
+  return static_cast<uint32_t>(count);
+}
+
+void StatsSampler::OnMessage(rtc::Message* msg) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  RTC_DCHECK_EQ(kMsgSample, msg->message_id);
+  if (!running_ || !peer_) {
+    return;
+  }
+  peer_->GetStats(this);
+  signaling_thread_->PostDelayed(RTC_FROM_HERE, interval_ms_, this,
+                                 kMsgSample);
+}
+
+void StatsSampler::OnStatsDelivered(
+    const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  if (!running_) {
+    return;
+  }
+  const Totals totals = ExtractTotals(*report);
+  if (has_previous_) {
+    const Totals& prev = previous_;
+    const int64_t interval_us = totals.timestamp_us - prev.timestamp_us;
+    mrsStatsSample sample{};
+    sample.timestamp_us = totals.timestamp_us;
+    sample.interval_us = interval_us;
+    sample.audio_send_bitrate_bps = RatePerSecond(
+        8.0 * CounterDelta(totals.audio_bytes_sent, prev.audio_bytes_sent),
+        interval_us);
+    sample.audio_receive_bitrate_bps =
+        RatePerSecond(8.0 * CounterDelta(totals.audio_bytes_received,
+                                         prev.audio_bytes_received),
+                      interval_us);
+    sample.video_send_bitrate_bps = RatePerSecond(
+        8.0 * CounterDelta(totals.video_bytes_sent, prev.video_bytes_sent),
+        interval_us);
+    sample.video_receive_bitrate_bps =
+        RatePerSecond(8.0 * CounterDelta(totals.video_bytes_received,
+                                         prev.video_bytes_received),
+                      interval_us);
+    sample.audio_packet_loss_rate =
+        LossRate(totals.audio_packets_lost - prev.audio_packets_lost,
+                 CounterDelta(totals.audio_packets_received,
+                              prev.audio_packets_received));
+    sample.video_packet_loss_rate =
+        LossRate(totals.video_packets_lost - prev.video_packets_lost,
+                 CounterDelta(totals.video_packets_received,
+                              prev.video_packets_received));
+    sample.audio_jitter_s = totals.audio_jitter_s;
+    sample.video_jitter_s = totals.video_jitter_s;
+    sample.video_send_framerate = RatePerSecond(
+        static_cast<double>(
+            CounterDelta(totals.frames_encoded, prev.frames_encoded)),
+        interval_us);
+    sample.video_receive_framerate = RatePerSecond(
+        static_cast<double>(
+            CounterDelta(totals.frames_decoded, prev.frames_decoded)),
+        interval_us);
+    PushSample(sample);
+  }
+  previous_ = totals;
+  has_previous_ = true;
+}
+
+StatsSampler::Totals StatsSampler::ExtractTotals(
+    const webrtc::RTCStatsReport& report) {
+  Totals totals;
+  totals.timestamp_us = report.timestamp_us();
+  int audio_jitter_count = 0;
+  int video_jitter_count = 0;
+  for (auto&& stats : report) {
+    // Compare type pointers; |RTCStats::type()| always returns the static
+    // |kType| string of the most derived stats class.
+    const char* const type = stats.type();
+    if (type == webrtc::RTCOutboundRTPStreamStats::kType) {
+      const auto& ortp_stats =
+          stats.cast_to<webrtc::RTCOutboundRTPStreamStats>();
+      const uint64_t bytes_sent = GetValueIfDefined(ortp_stats.bytes_sent);
+      if (*ortp_stats.kind == webrtc::RTCMediaStreamTrackKind::kAudio) {
+        totals.audio_bytes_sent += bytes_sent;
+      } else {
+        totals.video_bytes_sent += bytes_sent;
+        totals.frames_encoded += GetValueIfDefined(ortp_stats.frames_encoded);
+      }
+    } else if (type == webrtc::RTCInboundRTPStreamStats::kType) {
+      const auto& irtp_stats =
+          stats.cast_to<webrtc::RTCInboundRTPStreamStats>();
+      const uint64_t bytes_received =
+          GetValueIfDefined(irtp_stats.bytes_received);
+      const uint64_t packets_received =
+          GetValueIfDefined(irtp_stats.packets_received);
+      const int64_t packets_lost = GetValueIfDefined(irtp_stats.packets_lost);
+      const double jitter = GetValueIfDefined(irtp_stats.jitter);
+      if (*irtp_stats.kind == webrtc::RTCMediaStreamTrackKind::kAudio) {
+        totals.audio_bytes_received += bytes_received;
+        totals.audio_packets_received += packets_received;
+        totals.audio_packets_lost += packets_lost;
+        totals.audio_jitter_s += jitter;
+        ++audio_jitter_count;
+      } else {
+        totals.video_bytes_received += bytes_received;
+        totals.video_packets_received += packets_received;
+        totals.video_packets_lost += packets_lost;
+        totals.video_jitter_s += jitter;
+        totals.frames_decoded += GetValueIfDefined(irtp_stats.frames_decoded);
+        ++video_jitter_count;
+      }
+    }
+  }
+  // Jitter is not cumulative; report the average over all inbound streams.
+  if (audio_jitter_count > 0) {
+    totals.audio_jitter_s /= audio_jitter_count;
+  }
+  if (video_jitter_count > 0) {
+    totals.video_jitter_s /= video_jitter_count;
+  }
+  return totals;
+}
+
+void StatsSampler::PushSample(const mrsStatsSample& sample) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  mrsStatsSample& dest = samples_[sample_count_ % samples_.size()];
+  dest = sample;
+  dest.sequence_number = sample_count_;
+  ++sample_count_;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <mutex>
+
+#include "api/stats/rtcstatscollectorcallback.h"
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/thread.h"
+
+#include "peer_connection_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Periodic stats sampler collecting stats reports from a peer connection at a
+/// fixed interval on the WebRTC signaling thread, and storing the rates
+/// computed between consecutive reports into a fixed-size ring buffer.
+///
+/// The sampler runs entirely on the signaling thread; only the ring buffer is
+/// shared with other threads, under a short-lived lock, so reading samples
+/// never requires a thread hop nor a call into the stats collector.
+class StatsSampler : public webrtc::RTCStatsCollectorCallback,
+                     public rtc::MessageHandler {
+ public:
+  /// Create a new sampler for the given peer connection implementation. The
+  /// sampler is idle until |Start()| is called.
+  static rtc::scoped_refptr<StatsSampler> Create(
+      rtc::Thread* signaling_thread,
+      rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer,
+      const mrsStatsSamplerConfig& config);
+
+  /// Start sampling. This is a no-op if already started.
+  void Start();
+
+  /// Stop sampling and release the peer connection. On return, no sampling
+  /// task is running nor will run anymore. The samples already collected can
+  /// still be read.
+  void Stop();
+
+  /// Copy the most recent samples, oldest first, into |samples|, up to
+  /// |capacity| samples. Return the number of samples copied.
+  uint32_t ReadSamples(mrsStatsSample* samples, uint32_t capacity) const;
+
+  //
+  // RTCStatsCollectorCallback interface
+  //
+
+  void OnStatsDelivered(
+      const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) override;
+
+  //
+  // MessageHandler interface
+  //
+
+  void OnMessage(rtc::Message* msg) override;
+
+ protected:
+  StatsSampler(rtc::Thread* signaling_thread,
+               rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer,
+               const mrsStatsSamplerConfig& config);
+  ~StatsSampler() override = default;
+
+  /// Cumulative counters extracted from a single stats report, used to
+  /// compute the rates of the next sample.
+  struct Totals {
+    int64_t timestamp_us{0};
+    uint64_t audio_bytes_sent{0};
+    uint64_t audio_bytes_received{0};
+    uint64_t video_bytes_sent{0};
+    uint64_t video_bytes_received{0};
+    uint64_t audio_packets_received{0};
+    int64_t audio_packets_lost{0};
+    uint64_t video_packets_received{0};
+    int64_t video_packets_lost{0};
+    uint64_t frames_encoded{0};
+    uint64_t frames_decoded{0};
+    double audio_jitter_s{0.0};
+    double video_jitter_s{0.0};
+  };
+
+  static Totals ExtractTotals(const webrtc::RTCStatsReport& report);
+
+  /// Append a new sample to the ring buffer, overwriting the oldest one if
+  /// full.
+  void PushSample(const mrsStatsSample& sample);
+
+ private:
+  rtc::Thread* const signaling_thread_;
+  const int interval_ms_;
+
+  /// Peer connection being sampled. Only accessed on the signaling thread.
+  rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_;
+
+  /// Is the sampler currently running? Only accessed on the signaling thread.
+  bool running_{false};
+
+  /// Totals of the previous report, if |has_previous_| is |true|. Only
+  /// accessed on the signaling thread.
+  Totals previous_;
+  bool has_previous_{false};
+
+  /// Ring buffer of samples, allocated once on creation.
+  std::vector<mrsStatsSample> samples_ RTC_GUARDED_BY(mutex_);
+
+  /// Total number of samples ever pushed. The next sample is written at index
+  /// |sample_count_ % samples_.size()|.
+  uint64_t sample_count_ RTC_GUARDED_BY(mutex_){0};
+
+  mutable std::mutex mutex_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,239 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "rtc_base/platform_thread_types.h"
+#include "rtc_base/thread.h"
+
+#include "tracing.h"
+#include "utils.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace {
+
+/// Ring buffer of the events of a single thread for a single recording
+/// session. Only the owning thread writes events, without locking.
+struct ThreadBuffer {
+  ThreadBuffer(uint32_t session, uint32_t capacity)
+      : session_(session),
+        thread_id_(rtc::CurrentThreadId()),
+        events_(capacity) {
+    if (rtc::Thread* const thread = rtc::Thread::Current()) {
+      thread_name_ = thread->name();
+    }
+  }
+
+  const uint32_t session_;
+  const rtc::PlatformThreadId thread_id_;
+  std::string thread_name_;
+  std::vector<TraceEvent> events_;
+
+  /// Total number of events written, including the overwritten ones.
+  uint64_t event_count_{0};
+
+  /// The owning thread is writing an event. |Tracing::Stop()| waits for this
+  /// to be cleared on all buffers before returning.
+  std::atomic_bool writing_{false};
+};
+
+/// Protect the global recording state below, but not the events themselves.
+std::mutex g_mutex;
+
+/// Identifier of the current or last recording session, which invalidates
+/// the buffers of the previous sessions still referenced by their thread.
+std::atomic<uint32_t> g_session{0};
+
+uint32_t g_capacity RTC_GUARDED_BY(g_mutex){0};
+
+/// Buffers of all threads for the current or last recording session. This
+/// keeps the buffers alive after their thread exits, so that their events
+/// can still be written.
+std::vector<std::shared_ptr<ThreadBuffer>> g_buffers RTC_GUARDED_BY(g_mutex);
+
+thread_local std::shared_ptr<ThreadBuffer> tls_buffer;
+
+/// Get the buffer of the calling thread for the current session, creating it
+/// if needed. Return NULL if recording stopped in the meantime.
+ThreadBuffer* GetThreadBuffer() noexcept {
+  ThreadBuffer* buffer = tls_buffer.get();
+  if (buffer &&
+      (buffer->session_ == g_session.load(std::memory_order_relaxed))) {
+    return buffer;
+  }
+  try {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!Tracing::IsRecording()) {
+      return nullptr;
+    }
+    tls_buffer = std::make_shared<ThreadBuffer>(
+        g_session.load(std::memory_order_relaxed), g_capacity);
+    g_buffers.push_back(tls_buffer);
+    return tls_buffer.get();
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+/// Write a string as a JSON string literal.
+void WriteJsonString(FILE* file, const std::string& str) {
+  fputc('"', file);
+  for (char c : str) {
+    if ((c == '"') || (c == '\\')) {
+      fputc('\\', file);
+      fputc(c, file);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      fprintf(file, "\\u%04x", c);
+    } else {
+      fputc(c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+}  // namespace
+
+std::atomic_bool Tracing::recording_{false};
+
+Result Tracing::Start(const mrsTracingConfig& config) noexcept {
+#if defined(MRS_DISABLE_TRACING)
+  (void)config;
+  return Result::kUnsupported;
+#else   // defined(MRS_DISABLE_TRACING)
+  if (config.events_per_thread == 0) {
+    return Result::kInvalidParameter;
+  }
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (recording_.load(std::memory_order_relaxed)) {
+    return Result::kInvalidOperation;
+  }
+  // Release the events of the previous session. Threads still referencing
+  // their old buffer replace it on their next event.
+  g_buffers.clear();
+  g_capacity = config.events_per_thread;
+  g_session.fetch_add(1, std::memory_order_relaxed);
+  recording_.store(true, std::memory_order_seq_cst);
+  return Result::kSuccess;
+#endif  // defined(MRS_DISABLE_TRACING)
+}
+
+Result Tracing::Stop() noexcept {
+#if defined(MRS_DISABLE_TRACING)
+  return Result::kUnsupported;
+#else   // defined(MRS_DISABLE_TRACING)
+  std::lock_guard<std::mutex> lock(g_mutex);
+  recording_.store(false, std::memory_order_seq_cst);
+  // Wait for the events being written to complete, so that the buffers are
+  // not modified anymore once this returns.
+  for (auto&& buffer : g_buffers) {
+    while (buffer->writing_.load(std::memory_order_seq_cst)) {
+      std::this_thread::yield();
+    }
+  }
+  return Result::kSuccess;
+#endif  // defined(MRS_DISABLE_TRACING)
+}
+
+Result Tracing::WriteJson(const char* path) noexcept {
+#if defined(MRS_DISABLE_TRACING)
+  (void)path;
+  return Result::kUnsupported;
+#else   // defined(MRS_DISABLE_TRACING)
+  if (IsStringNullOrEmpty(path)) {
+    return Result::kInvalidParameter;
+  }
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (recording_.load(std::memory_order_relaxed)) {
+    return Result::kInvalidOperation;
+  }
+  FILE* const file = fopen(path, "wb");
+  if (!file) {
+    RTC_LOG(LS_ERROR) << "Failed to open trace file " << path;
+    return Result::kUnknownError;
+  }
+  // The Chrome trace format doesn't require the events to be sorted, so write
+  // each buffer in turn, oldest event first.
+  fputs("{\"traceEvents\":[", file);
+  bool first = true;
+  for (auto&& buffer : g_buffers) {
+    const unsigned long tid = static_cast<unsigned long>(buffer->thread_id_);
+    if (!buffer->thread_name_.empty()) {
+      fprintf(file,
+              "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+              "\"tid\":%lu,\"args\":{\"name\":",
+              first ? "" : ",", tid);
+      WriteJsonString(file, buffer->thread_name_);
+      fputs("}}", file);
+      first = false;
+    }
+    const uint64_t capacity = buffer->events_.size();
+    const uint64_t end = buffer->event_count_;
+    const uint64_t begin = (end > capacity ? end - capacity : 0);
+    for (uint64_t i = begin; i < end; ++i) {
+      const TraceEvent& event = buffer->events_[i % capacity];
+      fprintf(file,
+              "%s\n{\"name\":\"%s\",\"cat\":\"mrwebrtc\",\"ph\":\"%c\","
+              "\"pid\":1,\"tid\":%lu,\"ts\":%lld",
+              first ? "" : ",", event.name, event.phase, tid,
+              static_cast<long long>(event.timestamp_us));
+      if (event.phase == 'X') {
+        fprintf(file, ",\"dur\":%lld",
+                static_cast<long long>(event.duration_us));
+      } else {
+        fputs(",\"s\":\"t\"", file);
+      }
+      if (event.arg_name) {
+        fprintf(file, ",\"args\":{\"%s\":%lld}", event.arg_name,
+                static_cast<long long>(event.arg_value));
+      }
+      fputc('}', file);
+      first = false;
+    }
+  }
+  fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+  const bool failed = (ferror(file) != 0);
+  fclose(file);
+  return (failed ? Result::kUnknownError : Result::kSuccess);
+#endif  // defined(MRS_DISABLE_TRACING)
+}
+
+void Tracing::AddEvent(char phase,
+                       const char* name,
+                       int64_t timestamp_us,
+                       int64_t duration_us,
+                       const char* arg_name,
+                       int64_t arg_value) noexcept {
+  ThreadBuffer* const buffer = GetThreadBuffer();
+  if (!buffer) {
+    return;
+  }
+  // Publish the write before checking the recording state again, so that
+  // either |Stop()| waits for it, or the event is discarded.
+  buffer->writing_.store(true, std::memory_order_seq_cst);
+  if (recording_.load(std::memory_order_seq_cst)) {
+    const size_t capacity = buffer->events_.size();
+    TraceEvent& event = buffer->events_[buffer->event_count_ % capacity];
+    event.name = name;
+    event.arg_name = arg_name;
+    event.timestamp_us = timestamp_us;
+    event.duration_us = duration_us;
+    event.arg_value = arg_value;
+    event.phase = phase;
+    ++buffer->event_count_;
+  }
+  buffer->writing_.store(false, std::memory_order_release);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "rtc_base/timeutils.h"
+
+#include "mrs_errors.h"
+#include "tracing_interop.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Trace event recorded by a trace point. Names are not copied, and must be
+/// string literals.
+struct TraceEvent {
+  const char* name;
+  const char* arg_name;
+  int64_t timestamp_us;
+  int64_t duration_us;
+  int64_t arg_value;
+
+  /// Event phase in the Chrome trace event format: 'X' for a complete event
+  /// with a duration, or 'i' for an instant event.
+  char phase;
+};
+
+/// Recorder of the trace events of the trace points of the library. Each
+/// thread records its events into its own ring buffer without locking, and
+/// the events of all threads are merged only when written to a file.
+class Tracing {
+ public:
+  /// Check whether trace events are currently being recorded. Trace points
+  /// check this before doing any other work.
+  static bool IsRecording() noexcept {
+    return recording_.load(std::memory_order_relaxed);
+  }
+
+  /// Start recording, discarding any previous event.
+  static Result Start(const mrsTracingConfig& config) noexcept;
+
+  /// Stop recording, and wait for the trace points being recorded to finish.
+  static Result Stop() noexcept;
+
+  /// Write the events recorded in the Chrome trace event JSON format.
+  static Result WriteJson(const char* path) noexcept;
+
+  /// Record an event into the buffer of the calling thread.
+  static void AddEvent(char phase,
+                       const char* name,
+                       int64_t timestamp_us,
+                       int64_t duration_us,
+                       const char* arg_name,
+                       int64_t arg_value) noexcept;
+
+ private:
+  static std::atomic_bool recording_;
+};
+
+/// Trace point recording a complete event for the duration of a scope, with
+/// an optional integer argument.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name,
+                      const char* arg_name = nullptr,
+                      int64_t arg_value = 0) noexcept
+      : name_(Tracing::IsRecording() ? name : nullptr),
+        arg_name_(arg_name),
+        arg_value_(arg_value) {
+    if (name_) {
+      start_us_ = rtc::TimeMicros();
+    }
+  }
+
+  ~TraceScope() noexcept {
+    if (name_) {
+      Tracing::AddEvent('X', name_, start_us_, rtc::TimeMicros() - start_us_,
+                        arg_name_, arg_value_);
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* const name_;
+  const char* const arg_name_;
+  const int64_t arg_value_;
+  int64_t start_us_{0};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
+
+// Trace points. These are compiled out if MRS_DISABLE_TRACING is defined.
+#if defined(MRS_DISABLE_TRACING)
+
+#define MRS_TRACE_SCOPE(name)
+#define MRS_TRACE_SCOPE_ARG(name, arg_name, arg_value)
+#define MRS_TRACE_INSTANT(name)
+#define MRS_TRACE_INSTANT_ARG(name, arg_name, arg_value)
+
+#else  // defined(MRS_DISABLE_TRACING)
+
+#define MRS_TRACE_CONCAT_IMPL(a, b) a##b
+#define MRS_TRACE_CONCAT(a, b) MRS_TRACE_CONCAT_IMPL(a, b)
+
+/// Record the duration of the enclosing scope.
+#define MRS_TRACE_SCOPE(name)                                     \
+  ::Microsoft::MixedReality::WebRTC::TraceScope MRS_TRACE_CONCAT( \
+      mrs_trace_scope_, __LINE__)(name)
+
+/// Record the duration of the enclosing scope with an integer argument.
+#define MRS_TRACE_SCOPE_ARG(name, arg_name, arg_value)            \
+  ::Microsoft::MixedReality::WebRTC::TraceScope MRS_TRACE_CONCAT( \
+      mrs_trace_scope_, __LINE__)(name, arg_name,                 \
+                                  static_cast<int64_t>(arg_value))
+
+/// Record an instant event.
+#define MRS_TRACE_INSTANT(name) MRS_TRACE_INSTANT_ARG(name, nullptr, 0)
+
+/// Record an instant event with an integer argument.
+#define MRS_TRACE_INSTANT_ARG(name, arg_name, arg_value)             \
+  do {                                                               \
+    if (::Microsoft::MixedReality::WebRTC::Tracing::IsRecording()) { \
+      ::Microsoft::MixedReality::WebRTC::Tracing::AddEvent(          \
+          'i', name, rtc::TimeMicros(), 0, arg_name,                 \
+          static_cast<int64_t>(arg_value));                          \
+    }                                                                \
+  } while (false)
+
+#endif  // defined(MRS_DISABLE_TRACING)
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 
+#include "handle_table.h"
 #include "interop/global_factory.h"
 #include "tracked_object.h"
 
@@ -12,12 +13,15 @@ namespace WebRTC {
 
 TrackedObject::TrackedObject(RefPtr<GlobalFactory> global_factory,
                              ObjectType object_type)
-    : global_factory_(std::move(global_factory)), object_type_(object_type) {
+    : global_factory_(std::move(global_factory)),
+      object_type_(object_type),
+      handle_(HandleTable::Instance().Allocate(this, object_type)) {
   global_factory_->AddObject(this);
 }
 
 TrackedObject::~TrackedObject() noexcept {
   global_factory_->RemoveObject(this);
+  HandleTable::Instance().Free(handle_);
 }
 
 }  // namespace WebRTC
@@ -13,6 +13,7 @@ namespace MixedReality {
 namespace WebRTC {
 
 class GlobalFactory;
+class LiveObjectRegistry;
 
 /// Enumeration of all object types that the global factory keeps track of for
 /// the purpose of keeping itself alive. Each value correspond to a type of
@@ -24,11 +25,13 @@ enum class ObjectType : int {
   kLocalAudioTrack,
   kLocalVideoTrack,
   kExternalVideoTrackSource,
+  kEncodedVideoTrackSource,
   kRemoteAudioTrack,
   kRemoteVideoTrack,
   kDataChannel,
   kAudioTransceiver,
   kVideoTransceiver,
+  kEncodedFrameRecorder,
 };
 
 /// Object tracked for interop, exposing helper methods for debugging purpose.
@@ -50,6 +53,11 @@ class TrackedObject : public RefCountedBase {
   /// limitation.
   virtual std::string GetName() const = 0;
 
+  /// Get the handle of the object for the interop API. The handle is valid
+  /// until the object is destroyed, after which the interop API rejects it
+  /// with |Result::kInvalidNativeHandle|.
+  MRS_NODISCARD constexpr void* GetHandle() const noexcept { return handle_; }
+
   MRS_NODISCARD constexpr void* GetUserData() const noexcept {
     return user_data_;
   }
@@ -61,7 +69,17 @@ class TrackedObject : public RefCountedBase {
  protected:
   RefPtr<GlobalFactory> global_factory_;
   const ObjectType object_type_;
+  void* const handle_;
   void* user_data_{nullptr};
+
+ private:
+  friend class LiveObjectRegistry;
+
+  /// Intrusive links of the |LiveObjectRegistry| shard the object is in, or
+  /// -1 if the object is not registered. Guarded by the lock of that shard.
+  TrackedObject* prev_live_{nullptr};
+  TrackedObject* next_live_{nullptr};
+  int live_shard_{-1};
 };
 
 }  // namespace WebRTC
@@ -4,6 +4,10 @@
 
 #include "pch.h"
 
+#include <algorithm>
+
+#include "metrics.h"
+#include "tracing.h"
 #include "video_frame_observer.h"
 
 namespace {
@@ -11,6 +15,14 @@ namespace {
 // Aligning pointer to 64 bytes for improved performance, e.g. use SIMD.
 constexpr int kBufferAlignment = 64;
 
+/// Maximum value of each field of a scaling configuration, in pixels. This
+/// keeps the crop rectangle and target size well within the range of |int|.
+constexpr uint32_t kMaxScalingSize = 16384;
+
+/// Registry of the live NV12 buffers, to identify them among native buffers.
+std::unordered_set<const webrtc::VideoFrameBuffer*> s_nv12_buffers;
+std::mutex s_nv12_buffers_mutex;
+
 }  // namespace
 
 namespace Microsoft {
@@ -40,6 +52,64 @@ rtc::scoped_refptr<webrtc::I420BufferInterface> ArgbBuffer::ToI420() {
   return i420_buffer;
 }
 
+Nv12Buffer::Nv12Buffer(int width, int height) noexcept
+    : width_(width),
+      height_(height),
+      stride_y_(width),
+      stride_uv_(2 * ((width + 1) / 2)),
+      uv_offset_(static_cast<size_t>(height) * width),
+      data_(static_cast<uint8_t*>(webrtc::AlignedMalloc(
+          uv_offset_ + static_cast<size_t>((height + 1) / 2) * stride_uv_,
+          kBufferAlignment))) {
+  RTC_DCHECK_GT(width, 0);
+  RTC_DCHECK_GT(height, 0);
+  std::lock_guard<std::mutex> lock(s_nv12_buffers_mutex);
+  s_nv12_buffers.insert(this);
+}
+
+Nv12Buffer::~Nv12Buffer() {
+  std::lock_guard<std::mutex> lock(s_nv12_buffers_mutex);
+  s_nv12_buffers.erase(this);
+}
+
+rtc::scoped_refptr<Nv12Buffer> Nv12Buffer::Create(int width, int height) {
+  return new rtc::RefCountedObject<Nv12Buffer>(width, height);
+}
+
+rtc::scoped_refptr<Nv12Buffer> Nv12Buffer::Copy(
+    const Nv12VideoFrame& frame_view) {
+  const int width = static_cast<int>(frame_view.width_);
+  const int height = static_cast<int>(frame_view.height_);
+  rtc::scoped_refptr<Nv12Buffer> buffer = Create(width, height);
+  libyuv::CopyPlane(static_cast<const uint8_t*>(frame_view.ydata_),
+                    frame_view.ystride_, buffer->MutableDataY(),
+                    buffer->StrideY(), width, height);
+  libyuv::CopyPlane(static_cast<const uint8_t*>(frame_view.uvdata_),
+                    frame_view.uvstride_, buffer->MutableDataUV(),
+                    buffer->StrideUV(), buffer->StrideUV(), (height + 1) / 2);
+  return buffer;
+}
+
+const Nv12Buffer* Nv12Buffer::FromBuffer(
+    const webrtc::VideoFrameBuffer* buffer) {
+  std::lock_guard<std::mutex> lock(s_nv12_buffers_mutex);
+  if (s_nv12_buffers.find(buffer) == s_nv12_buffers.end()) {
+    return nullptr;
+  }
+  return static_cast<const Nv12Buffer*>(buffer);
+}
+
+rtc::scoped_refptr<webrtc::I420BufferInterface> Nv12Buffer::ToI420() {
+  rtc::scoped_refptr<webrtc::I420Buffer> i420_buffer =
+      webrtc::I420Buffer::Create(width_, height_);
+  libyuv::NV12ToI420(DataY(), StrideY(), DataUV(), StrideUV(),
+                     i420_buffer->MutableDataY(), i420_buffer->StrideY(),
+                     i420_buffer->MutableDataU(), i420_buffer->StrideU(),
+                     i420_buffer->MutableDataV(), i420_buffer->StrideV(),
+                     width_, height_);
+  return i420_buffer;
+}
+
 void VideoFrameObserver::SetCallback(
     I420AFrameReadyCallback callback) noexcept {
   std::lock_guard<std::mutex> lock(mutex_);
@@ -52,104 +122,352 @@ void VideoFrameObserver::SetCallback(
   argb_callback_ = std::move(callback);
 }
 
+void VideoFrameObserver::SetCallback(Nv12FrameReadyCallback callback) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  nv12_callback_ = std::move(callback);
+}
+
 ArgbBuffer* VideoFrameObserver::GetArgbScratchBuffer(int width, int height) {
-  const size_t needed_size = Argb32FrameSize(width, height);
+  // The frame is written with the stride of the buffer, so a larger buffer can
+  // only be reused if each of its rows fits the width, and it has enough rows.
   if (auto* buffer = argb_scratch_buffer_.get()) {
-    if (buffer->Size() >= needed_size) {
+    if ((buffer->Stride() >= width * 4) && (buffer->height() >= height)) {
       return buffer;
     }
   }
+  Metrics::Add(MetricCounter::kArgbScratchBufferReallocations);
   argb_scratch_buffer_ = ArgbBuffer::Create(width, height);
   return argb_scratch_buffer_.get();
 }
 
+Result VideoFrameObserver::SetScaling(
+    mrsVideoFrameFormat format,
+    const mrsVideoFrameScaling* scaling) noexcept {
+  switch (format) {
+    case mrsVideoFrameFormat::kI420A:
+    case mrsVideoFrameFormat::kNv12:
+    case mrsVideoFrameFormat::kArgb32:
+      break;
+    default:
+      RTC_LOG(LS_ERROR) << "Unknown video frame format " << (int)format << ".";
+      return Result::kInvalidParameter;
+  }
+  if (scaling &&
+      ((scaling->crop_x > kMaxScalingSize) ||
+       (scaling->crop_y > kMaxScalingSize) ||
+       (scaling->crop_width > kMaxScalingSize) ||
+       (scaling->crop_height > kMaxScalingSize) ||
+       (scaling->target_width > kMaxScalingSize) ||
+       (scaling->target_height > kMaxScalingSize))) {
+    RTC_LOG(LS_ERROR) << "Video frame scaling values cannot exceed "
+                      << kMaxScalingSize << " pixels.";
+    return Result::kOutOfRange;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  ScalingConfig& config = scalings_[static_cast<int>(format)];
+  config.enabled = (scaling != nullptr);
+  config.scaling = (scaling ? *scaling : mrsVideoFrameScaling{});
+  return Result::kSuccess;
+}
+
+Nv12Buffer* VideoFrameObserver::GetNv12ScratchBuffer(int width, int height) {
+  // The strides depend on the width, so only a buffer of the exact same size
+  // can be reused.
+  if (auto* buffer = nv12_scratch_buffer_.get()) {
+    if ((buffer->width() == width) && (buffer->height() == height)) {
+      return buffer;
+    }
+  }
+  Metrics::Add(MetricCounter::kNv12ScratchBufferReallocations);
+  nv12_scratch_buffer_ = Nv12Buffer::Create(width, height);
+  return nv12_scratch_buffer_.get();
+}
+
 void VideoFrameObserver::OnFrame(const webrtc::VideoFrame& frame) noexcept {
+  MRS_TRACE_SCOPE_ARG("VideoFrameObserver::OnFrame", "width", frame.width());
   std::lock_guard<std::mutex> lock(mutex_);
-  if (!i420a_callback_ && !argb_callback_) {
+  if (!i420a_callback_ && !nv12_callback_ && !argb_callback_) {
     return;
   }
 
   rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer(
       frame.video_frame_buffer());
 
-  const int width = frame.width();
-  const int height = frame.height();
+  // Deliver the scaled frames first, all from the same I420 view of the
+  // buffer, which is converted at most once.
+  const bool has_callback[3] = {!!i420a_callback_, !!nv12_callback_,
+                                !!argb_callback_};
+  rtc::scoped_refptr<webrtc::I420BufferInterface> source;
+  bool has_unscaled_callback = false;
+  for (int i = 0; i < 3; ++i) {
+    if (!has_callback[i]) {
+      continue;
+    }
+    const auto format = static_cast<mrsVideoFrameFormat>(i);
+    if (!IsScaled(format)) {
+      has_unscaled_callback = true;
+      continue;
+    }
+    if (!source) {
+      source = buffer->ToI420();
+    }
+    DeliverScaled(format, *source);
+  }
+  if (!has_unscaled_callback) {
+    return;
+  }
 
-  if (buffer->type() != webrtc::VideoFrameBuffer::Type::kI420A) {
-    // The buffer is not encoded in I420 with alpha channel; use I420 without
-    // alpha channel as interchange format for the callback, and convert the
-    // buffer to that (or do nothing if already in I420).
-    rtc::scoped_refptr<webrtc::I420BufferInterface> i420_buffer =
-        buffer->ToI420();
-    const uint8_t* const yptr = i420_buffer->DataY();
-    const uint8_t* const uptr = i420_buffer->DataU();
-    const uint8_t* const vptr = i420_buffer->DataV();
+  if (buffer->type() == webrtc::VideoFrameBuffer::Type::kI420A) {
+    // The buffer is encoded in I420 with alpha channel, use it directly.
+    webrtc::I420ABufferInterface* i420a_buffer = buffer->GetI420A();
+    DeliverI420(i420a_buffer->DataY(), i420a_buffer->StrideY(),
+                i420a_buffer->DataU(), i420a_buffer->StrideU(),
+                i420a_buffer->DataV(), i420a_buffer->StrideV(),
+                i420a_buffer->DataA(), i420a_buffer->StrideA(), frame.width(),
+                frame.height());
+    return;
+  }
 
-    if (i420a_callback_) {
-      I420AVideoFrame i420a_frame;
-      i420a_frame.ydata_ = yptr;
-      i420a_frame.udata_ = uptr;
-      i420a_frame.vdata_ = vptr;
-      i420a_frame.adata_ = nullptr;
-      i420a_frame.ystride_ = i420_buffer->StrideY();
-      i420a_frame.ustride_ = i420_buffer->StrideU();
-      i420a_frame.vstride_ = i420_buffer->StrideV();
-      i420a_frame.astride_ = 0;
-      i420a_frame.width_ = width;
-      i420a_frame.height_ = height;
-      i420a_callback_(i420a_frame);
+  if (Nv12Buffer::FromBuffer(buffer.get())) {
+    // The buffer is a native NV12 buffer from this library, deliver it as is
+    // to the NV12 callback.
+    DeliverNv12(*static_cast<Nv12Buffer*>(buffer.get()));
+    return;
+  }
+
+  // The buffer is not encoded in I420 with alpha channel; use I420 without
+  // alpha channel as interchange format for the callback, and convert the
+  // buffer to that (or do nothing if already in I420).
+  rtc::scoped_refptr<webrtc::I420BufferInterface> i420_buffer =
+      buffer->ToI420();
+  DeliverI420(i420_buffer->DataY(), i420_buffer->StrideY(),
+              i420_buffer->DataU(), i420_buffer->StrideU(),
+              i420_buffer->DataV(), i420_buffer->StrideV(), nullptr, 0,
+              frame.width(), frame.height());
+}
+
+void VideoFrameObserver::DeliverI420(const uint8_t* yptr,
+                                     int ystride,
+                                     const uint8_t* uptr,
+                                     int ustride,
+                                     const uint8_t* vptr,
+                                     int vstride,
+                                     const uint8_t* aptr,
+                                     int astride,
+                                     int width,
+                                     int height) {
+  if (i420a_callback_ && !IsScaled(mrsVideoFrameFormat::kI420A)) {
+    I420AVideoFrame i420a_frame;
+    i420a_frame.ydata_ = yptr;
+    i420a_frame.udata_ = uptr;
+    i420a_frame.vdata_ = vptr;
+    i420a_frame.adata_ = aptr;
+    i420a_frame.ystride_ = ystride;
+    i420a_frame.ustride_ = ustride;
+    i420a_frame.vstride_ = vstride;
+    i420a_frame.astride_ = astride;
+    i420a_frame.width_ = width;
+    i420a_frame.height_ = height;
+    i420a_callback_(i420a_frame);
+  }
+
+  if (nv12_callback_ && !IsScaled(mrsVideoFrameFormat::kNv12)) {
+    // NV12 has no alpha plane, which is discarded
+    Nv12Buffer* const nv12_buffer = GetNv12ScratchBuffer(width, height);
+    {
+      ScopedMetricTimer timer(MetricHistogram::kVideoFrameConversionUs);
+      libyuv::I420ToNV12(yptr, ystride, uptr, ustride, vptr, vstride,
+                         nv12_buffer->MutableDataY(), nv12_buffer->StrideY(),
+                         nv12_buffer->MutableDataUV(), nv12_buffer->StrideUV(),
+                         width, height);
     }
+    Metrics::Add(MetricCounter::kVideoFramesConverted);
+    Nv12VideoFrame nv12_frame;
+    nv12_frame.ydata_ = nv12_buffer->DataY();
+    nv12_frame.uvdata_ = nv12_buffer->DataUV();
+    nv12_frame.ystride_ = nv12_buffer->StrideY();
+    nv12_frame.uvstride_ = nv12_buffer->StrideUV();
+    nv12_frame.width_ = width;
+    nv12_frame.height_ = height;
+    nv12_callback_(nv12_frame);
+  }
 
-    if (argb_callback_) {
-      ArgbBuffer* const argb_buffer = GetArgbScratchBuffer(width, height);
-      libyuv::I420ToARGB(yptr, i420_buffer->StrideY(), uptr,
-                         i420_buffer->StrideU(), vptr, i420_buffer->StrideV(),
-                         argb_buffer->Data(), argb_buffer->Stride(), width,
-                         height);
-      Argb32VideoFrame argb32_frame;
-      argb32_frame.argb32_data_ = argb_buffer->Data();
-      argb32_frame.stride_ = argb_buffer->Stride();
-      argb32_frame.width_ = width;
-      argb32_frame.height_ = height;
-      argb_callback_(argb32_frame);
+  if (argb_callback_ && !IsScaled(mrsVideoFrameFormat::kArgb32)) {
+    ArgbBuffer* const argb_buffer = GetArgbScratchBuffer(width, height);
+    {
+      ScopedMetricTimer timer(MetricHistogram::kVideoFrameConversionUs);
+      if (aptr) {
+        libyuv::I420AlphaToARGB(yptr, ystride, uptr, ustride, vptr, vstride,
+                                aptr, astride, argb_buffer->Data(),
+                                argb_buffer->Stride(), width, height, 0);
+      } else {
+        libyuv::I420ToARGB(yptr, ystride, uptr, ustride, vptr, vstride,
+                           argb_buffer->Data(), argb_buffer->Stride(), width,
+                           height);
+      }
     }
+    Metrics::Add(MetricCounter::kVideoFramesConverted);
+    Argb32VideoFrame argb32_frame;
+    argb32_frame.argb32_data_ = argb_buffer->Data();
+    argb32_frame.stride_ = argb_buffer->Stride();
+    argb32_frame.width_ = width;
+    argb32_frame.height_ = height;
+    argb_callback_(argb32_frame);
+  }
+}
 
-  } else {
-    // The buffer is encoded in I420 with alpha channel, use it directly.
-    webrtc::I420ABufferInterface* i420a_buffer = buffer->GetI420A();
-    const uint8_t* const yptr = i420a_buffer->DataY();
-    const uint8_t* const uptr = i420a_buffer->DataU();
-    const uint8_t* const vptr = i420a_buffer->DataV();
-    const uint8_t* const aptr = i420a_buffer->DataA();
+void VideoFrameObserver::DeliverNv12(Nv12Buffer& buffer) {
+  const int width = buffer.width();
+  const int height = buffer.height();
 
-    if (i420a_callback_) {
+  if (i420a_callback_ && !IsScaled(mrsVideoFrameFormat::kI420A)) {
+    rtc::scoped_refptr<webrtc::I420BufferInterface> i420_buffer =
+        buffer.ToI420();
+    I420AVideoFrame i420a_frame;
+    i420a_frame.ydata_ = i420_buffer->DataY();
+    i420a_frame.udata_ = i420_buffer->DataU();
+    i420a_frame.vdata_ = i420_buffer->DataV();
+    i420a_frame.adata_ = nullptr;
+    i420a_frame.ystride_ = i420_buffer->StrideY();
+    i420a_frame.ustride_ = i420_buffer->StrideU();
+    i420a_frame.vstride_ = i420_buffer->StrideV();
+    i420a_frame.astride_ = 0;
+    i420a_frame.width_ = width;
+    i420a_frame.height_ = height;
+    i420a_callback_(i420a_frame);
+  }
+
+  if (nv12_callback_ && !IsScaled(mrsVideoFrameFormat::kNv12)) {
+    Nv12VideoFrame nv12_frame;
+    nv12_frame.ydata_ = buffer.DataY();
+    nv12_frame.uvdata_ = buffer.DataUV();
+    nv12_frame.ystride_ = buffer.StrideY();
+    nv12_frame.uvstride_ = buffer.StrideUV();
+    nv12_frame.width_ = width;
+    nv12_frame.height_ = height;
+    nv12_callback_(nv12_frame);
+  }
+
+  if (argb_callback_ && !IsScaled(mrsVideoFrameFormat::kArgb32)) {
+    // Convert directly, without I420 intermediate
+    ArgbBuffer* const argb_buffer = GetArgbScratchBuffer(width, height);
+    {
+      ScopedMetricTimer timer(MetricHistogram::kVideoFrameConversionUs);
+      libyuv::NV12ToARGB(buffer.DataY(), buffer.StrideY(), buffer.DataUV(),
+                         buffer.StrideUV(), argb_buffer->Data(),
+                         argb_buffer->Stride(), width, height);
+    }
+    Metrics::Add(MetricCounter::kVideoFramesConverted);
+    Argb32VideoFrame argb32_frame;
+    argb32_frame.argb32_data_ = argb_buffer->Data();
+    argb32_frame.stride_ = argb_buffer->Stride();
+    argb32_frame.width_ = width;
+    argb32_frame.height_ = height;
+    argb_callback_(argb32_frame);
+  }
+}
+
+void VideoFrameObserver::DeliverScaled(
+    mrsVideoFrameFormat format,
+    const webrtc::I420BufferInterface& source) {
+  const mrsVideoFrameScaling& scaling =
+      scalings_[static_cast<int>(format)].scaling;
+
+  // Clip the crop rectangle to the frame. The origin is aligned on even
+  // coordinates so that it maps exactly to a chroma sample.
+  const int frame_width = source.width();
+  const int frame_height = source.height();
+  const int crop_x =
+      std::min<int>(scaling.crop_x & ~1u, std::max(frame_width - 2, 0));
+  const int crop_y =
+      std::min<int>(scaling.crop_y & ~1u, std::max(frame_height - 2, 0));
+  int crop_width = frame_width - crop_x;
+  if ((scaling.crop_width > 0) && ((int)scaling.crop_width < crop_width)) {
+    crop_width = scaling.crop_width;
+  }
+  int crop_height = frame_height - crop_y;
+  if ((scaling.crop_height > 0) && ((int)scaling.crop_height < crop_height)) {
+    crop_height = scaling.crop_height;
+  }
+
+  // Compute the output size, deriving a missing dimension from the aspect
+  // ratio of the crop rectangle.
+  int width = scaling.target_width;
+  int height = scaling.target_height;
+  if ((width == 0) && (height == 0)) {
+    width = crop_width;
+    height = crop_height;
+  } else if (width == 0) {
+    width = (int)std::min<int64_t>(
+        std::max<int64_t>(1, (int64_t)height * crop_width / crop_height),
+        kMaxScalingSize);
+  } else if (height == 0) {
+    height = (int)std::min<int64_t>(
+        std::max<int64_t>(1, (int64_t)width * crop_height / crop_width),
+        kMaxScalingSize);
+  }
+
+  rtc::scoped_refptr<webrtc::I420Buffer> scaled =
+      scaled_buffer_pool_.CreateBuffer(width, height);
+  if (!scaled) {
+    return;
+  }
+  const int chroma_x = crop_x / 2;
+  const int chroma_y = crop_y / 2;
+  libyuv::I420Scale(
+      source.DataY() + crop_y * source.StrideY() + crop_x, source.StrideY(),
+      source.DataU() + chroma_y * source.StrideU() + chroma_x,
+      source.StrideU(),
+      source.DataV() + chroma_y * source.StrideV() + chroma_x,
+      source.StrideV(), crop_width, crop_height, scaled->MutableDataY(),
+      scaled->StrideY(), scaled->MutableDataU(), scaled->StrideU(),
+      scaled->MutableDataV(), scaled->StrideV(), width, height,
+      libyuv::kFilterBox);
+
+  switch (format) {
+    case mrsVideoFrameFormat::kI420A: {
       I420AVideoFrame i420a_frame;
-      i420a_frame.ydata_ = yptr;
-      i420a_frame.udata_ = uptr;
-      i420a_frame.vdata_ = vptr;
-      i420a_frame.adata_ = aptr;
-      i420a_frame.ystride_ = i420a_buffer->StrideY();
-      i420a_frame.ustride_ = i420a_buffer->StrideU();
-      i420a_frame.vstride_ = i420a_buffer->StrideV();
-      i420a_frame.astride_ = i420a_buffer->StrideA();
+      i420a_frame.ydata_ = scaled->DataY();
+      i420a_frame.udata_ = scaled->DataU();
+      i420a_frame.vdata_ = scaled->DataV();
+      i420a_frame.adata_ = nullptr;
+      i420a_frame.ystride_ = scaled->StrideY();
+      i420a_frame.ustride_ = scaled->StrideU();
+      i420a_frame.vstride_ = scaled->StrideV();
+      i420a_frame.astride_ = 0;
       i420a_frame.width_ = width;
       i420a_frame.height_ = height;
       i420a_callback_(i420a_frame);
-    }
-
-    if (argb_callback_) {
+    } break;
+    case mrsVideoFrameFormat::kNv12: {
+      Nv12Buffer* const nv12_buffer = GetNv12ScratchBuffer(width, height);
+      libyuv::I420ToNV12(scaled->DataY(), scaled->StrideY(), scaled->DataU(),
+                         scaled->StrideU(), scaled->DataV(), scaled->StrideV(),
+                         nv12_buffer->MutableDataY(), nv12_buffer->StrideY(),
+                         nv12_buffer->MutableDataUV(), nv12_buffer->StrideUV(),
+                         width, height);
+      Nv12VideoFrame nv12_frame;
+      nv12_frame.ydata_ = nv12_buffer->DataY();
+      nv12_frame.uvdata_ = nv12_buffer->DataUV();
+      nv12_frame.ystride_ = nv12_buffer->StrideY();
+      nv12_frame.uvstride_ = nv12_buffer->StrideUV();
+      nv12_frame.width_ = width;
+      nv12_frame.height_ = height;
+      nv12_callback_(nv12_frame);
+    } break;
+    case mrsVideoFrameFormat::kArgb32: {
       ArgbBuffer* const argb_buffer = GetArgbScratchBuffer(width, height);
-      libyuv::I420AlphaToARGB(
-          yptr, i420a_buffer->StrideY(), uptr, i420a_buffer->StrideU(), vptr,
-          i420a_buffer->StrideV(), aptr, i420a_buffer->StrideA(),
-          argb_buffer->Data(), argb_buffer->Stride(), width, height, 0);
+      libyuv::I420ToARGB(scaled->DataY(), scaled->StrideY(), scaled->DataU(),
+                         scaled->StrideU(), scaled->DataV(), scaled->StrideV(),
+                         argb_buffer->Data(), argb_buffer->Stride(), width,
+                         height);
       Argb32VideoFrame argb32_frame;
       argb32_frame.argb32_data_ = argb_buffer->Data();
       argb32_frame.stride_ = argb_buffer->Stride();
       argb32_frame.width_ = width;
       argb32_frame.height_ = height;
       argb_callback_(argb32_frame);
-    }
+    } break;
   }
 }
 
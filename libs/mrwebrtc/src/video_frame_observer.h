@@ -7,8 +7,11 @@
 
 #include "api/video/video_frame.h"
 #include "api/video/video_sink_interface.h"
+#include "common_video/include/i420_buffer_pool.h"
 
 #include "callback.h"
+#include "interop_api.h"
+#include "mrs_errors.h"
 #include "video_frame.h"
 
 #include "rtc_base/memory/aligned_malloc.h"
@@ -20,6 +23,9 @@ namespace WebRTC {
 /// Callback fired on newly available video frame, encoded as I420.
 using I420AFrameReadyCallback = Callback<const I420AVideoFrame&>;
 
+/// Callback fired on newly available video frame, encoded as NV12.
+using Nv12FrameReadyCallback = Callback<const Nv12VideoFrame&>;
+
 /// Callback fired on newly available video frame, encoded as ARGB.
 using Argb32FrameReadyCallback = Callback<const Argb32VideoFrame&>;
 
@@ -96,7 +102,71 @@ class ArgbBuffer : public webrtc::VideoFrameBuffer {
   const std::unique_ptr<uint8_t, webrtc::AlignedFreeDeleter> data_;
 };
 
+/// Native video frame buffer holding an NV12 frame, for sources producing NV12
+/// frames. Observers deliver such buffers as is to their NV12 callbacks, and
+/// the other consumers convert them with |ToI420()|.
+class Nv12Buffer : public webrtc::VideoFrameBuffer {
+ public:
+  /// Create a new buffer with enough storage for a frame with the given
+  /// width and height in pixels.
+  static rtc::scoped_refptr<Nv12Buffer> Create(int width, int height);
+
+  /// Create a new buffer and copy the frame |frame_view| into it.
+  static rtc::scoped_refptr<Nv12Buffer> Copy(const Nv12VideoFrame& frame_view);
+
+  /// Get the NV12 buffer |buffer| is, or NULL if it is not one. WebRTC is
+  /// built without RTTI, so native buffers cannot be identified otherwise.
+  static const Nv12Buffer* FromBuffer(const webrtc::VideoFrameBuffer* buffer);
+
+  // VideoFrameBuffer implementation.
+
+  Type type() const override { return VideoFrameBuffer::Type::kNative; }
+  int width() const override { return width_; }
+  int height() const override { return height_; }
+  rtc::scoped_refptr<webrtc::I420BufferInterface> ToI420() override;
+
+  uint8_t* MutableDataY() { return data_.get(); }
+  uint8_t* MutableDataUV() { return data_.get() + uv_offset_; }
+  const uint8_t* DataY() const { return data_.get(); }
+  const uint8_t* DataUV() const { return data_.get() + uv_offset_; }
+
+  /// Row stride of the Y plane, in bytes.
+  int StrideY() const { return stride_y_; }
+
+  /// Row stride of the interleaved UV plane, in bytes.
+  int StrideUV() const { return stride_uv_; }
+
+ protected:
+  Nv12Buffer(int width, int height) noexcept;
+  ~Nv12Buffer() override;
+
+ private:
+  /// Frame width, in pixels.
+  const int width_;
+
+  /// Frame height, in pixels.
+  const int height_;
+
+  const int stride_y_;
+  const int stride_uv_;
+
+  /// Offset of the UV plane from the start of |data_|, in bytes.
+  const size_t uv_offset_;
+
+  /// Raw buffer of NV12 data for the frame, with the UV plane following the
+  /// Y plane.
+  const std::unique_ptr<uint8_t, webrtc::AlignedFreeDeleter> data_;
+};
+
 /// Video frame observer to get notified of newly available video frames.
+///
+/// Each frame is delivered to each registered callback in the format of that
+/// callback. Frames are only converted when that format differs from the one
+/// of the frame buffer, and each conversion is done at most once per frame.
+///
+/// Each callback can optionally receive a cropped and scaled copy of the frames
+/// instead, which is scaled in I420 into a pooled buffer before any conversion
+/// to the format of the callback.
 class VideoFrameObserver : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
  public:
   /// Register a callback to get notified on frame available,
@@ -109,6 +179,17 @@ class VideoFrameObserver : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
   /// This is not exclusive and can be used along another I420 callback.
   void SetCallback(Argb32FrameReadyCallback callback) noexcept;
 
+  /// Register a callback to get notified on frame available,
+  /// and received that frame as an NV12-encoded buffer.
+  /// This is not exclusive and can be used along the other callbacks.
+  void SetCallback(Nv12FrameReadyCallback callback) noexcept;
+
+  /// Set the crop and scale applied to the frames delivered to the callback
+  /// of the given format, or deliver full frames again if |scaling| is NULL.
+  /// Each field of |scaling| must not exceed 16384 pixels.
+  Result SetScaling(mrsVideoFrameFormat format,
+                    const mrsVideoFrameScaling* scaling) noexcept;
+
  protected:
   /// Get a temporary scratch buffer for an ARGB32 frame of the given
   /// dimensions. The returned buffer does not need to be deallocated, but can
@@ -117,6 +198,39 @@ class VideoFrameObserver : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
   /// it for the duration of its access.
   ArgbBuffer* GetArgbScratchBuffer(int width, int height);
 
+  /// Get a temporary scratch buffer for an NV12 frame of the given dimensions,
+  /// with the same requirements as |GetArgbScratchBuffer()|.
+  Nv12Buffer* GetNv12ScratchBuffer(int width, int height);
+
+  /// Deliver a frame in I420 format to the I420A callback, and convert it for
+  /// the NV12 and ARGB callbacks. The caller needs to hold |mutex_|.
+  void DeliverI420(const uint8_t* yptr,
+                   int ystride,
+                   const uint8_t* uptr,
+                   int ustride,
+                   const uint8_t* vptr,
+                   int vstride,
+                   const uint8_t* aptr,
+                   int astride,
+                   int width,
+                   int height);
+
+  /// Deliver a native NV12 buffer to the NV12 callback, and convert it for the
+  /// I420A and ARGB callbacks. The caller needs to hold |mutex_|.
+  void DeliverNv12(Nv12Buffer& buffer);
+
+  /// Crop and scale |source| as configured for the callback of the given
+  /// format, and deliver the result to that callback. The caller needs to hold
+  /// |mutex_|.
+  void DeliverScaled(mrsVideoFrameFormat format,
+                     const webrtc::I420BufferInterface& source);
+
+  /// Check if the callback of the given format receives scaled frames. The
+  /// caller needs to hold |mutex_|.
+  bool IsScaled(mrsVideoFrameFormat format) const {
+    return scalings_[static_cast<int>(format)].enabled;
+  }
+
   // VideoSinkInterface interface
   void OnFrame(const webrtc::VideoFrame& frame) noexcept override;
 
@@ -127,11 +241,30 @@ class VideoFrameObserver : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
   /// Registered callback for receiving raw decoded ARGB frame.
   Argb32FrameReadyCallback argb_callback_ RTC_GUARDED_BY(mutex_);
 
+  /// Registered callback for receiving NV12-encoded frame.
+  Nv12FrameReadyCallback nv12_callback_ RTC_GUARDED_BY(mutex_);
+
   /// Mutex protecting all callbacks as well as the ARGB32 scratch buffer.
   std::mutex mutex_;
 
   /// Reusable ARGB scratch buffer to avoid per-frame allocation.
   rtc::scoped_refptr<ArgbBuffer> argb_scratch_buffer_ RTC_GUARDED_BY(mutex_);
+
+  /// Reusable NV12 scratch buffer to avoid per-frame allocation.
+  rtc::scoped_refptr<Nv12Buffer> nv12_scratch_buffer_ RTC_GUARDED_BY(mutex_);
+
+  /// Scaling configuration of a frame callback.
+  struct ScalingConfig {
+    bool enabled{false};
+    mrsVideoFrameScaling scaling{};
+  };
+
+  /// Scaling configuration of each callback, indexed by the frame format.
+  ScalingConfig scalings_[3] RTC_GUARDED_BY(mutex_);
+
+  /// Pool of the I420 buffers holding the cropped and scaled frames, which are
+  /// only held for the duration of the callbacks, so are reused every frame.
+  webrtc::I420BufferPool scaled_buffer_pool_ RTC_GUARDED_BY(mutex_);
 };
 
 }  // namespace WebRTC
@@ -3,11 +3,16 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+
 #include "audio_frame.h"
 #include "interop_api.h"
 #include "local_audio_track_interop.h"
 #include "remote_audio_track_interop.h"
 #include "transceiver_interop.h"
+#include "virtual_audio_device_interop.h"
 
 #include "test_utils.h"
 
@@ -16,12 +21,6 @@ namespace {
 class AudioTrackTests : public TestUtils::TestBase,
                         public testing::WithParamInterface<mrsSdpSemantic> {};
 
-}  // namespace
-
-#if !defined(MRSW_EXCLUDE_DEVICE_TESTS)
-
-namespace {
-
 // PeerConnectionAudioTrackAddedCallback
 using AudioTrackAddedCallback =
     InteropCallback<const mrsRemoteAudioTrackAddedInfo*>;
@@ -29,6 +28,12 @@ using AudioTrackAddedCallback =
 // PeerConnectionAudioFrameCallback
 using AudioFrameCallback = InteropCallback<const AudioFrame&>;
 
+}  // namespace
+
+#if !defined(MRSW_EXCLUDE_DEVICE_TESTS)
+
+namespace {
+
 bool IsSilent_uint8(const uint8_t* data,
                     uint32_t size,
                     uint8_t& min,
@@ -380,3 +385,182 @@ TEST_P(AudioTrackTests, Muted) {
 }
 
 #endif  // MRSW_EXCLUDE_DEVICE_TESTS
+
+TEST_F(AudioTrackTests, SyntheticSource) {
+  mrsSyntheticAudioTrackInitConfig config{};
+  config.sample_rate_hz = 16000;
+  config.channel_count = 2;
+  config.amplitude = 0.25;
+  mrsLocalAudioTrackHandle track_handle{};
+  {
+    mrsSyntheticAudioTrackInitConfig bad_config = config;
+    bad_config.sample_rate_hz = 22050;
+    ASSERT_EQ(Result::kOutOfRange,
+              mrsLocalAudioTrackCreateSynthetic(
+                  &bad_config, "synthetic_audio_track", &track_handle));
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateSynthetic(&config, "synthetic_audio_track",
+                                              &track_handle));
+  ASSERT_NE(nullptr, track_handle);
+
+  // The source pushes 10 ms frames of the configured format on its own
+  // thread, without any audio device nor peer connection.
+  std::atomic<uint32_t> frame_count{0};
+  std::atomic<uint32_t> bad_format_count{0};
+  std::atomic<uint32_t> bad_level_count{0};
+  AudioFrameCallback frame_cb = [&](const AudioFrame& frame) {
+    if ((frame.bits_per_sample_ != 16) ||
+        (frame.sampling_rate_hz_ != 16000) || (frame.channel_count_ != 2) ||
+        (frame.sample_count_ != 160)) {
+      ++bad_format_count;
+    } else {
+      // Both channels carry the same tone, within the configured amplitude
+      const int16_t* samples = static_cast<const int16_t*>(frame.data_);
+      int max_level = 0;
+      for (uint32_t i = 0; i < frame.sample_count_; ++i) {
+        if (samples[2 * i] != samples[2 * i + 1]) {
+          ++bad_level_count;
+          break;
+        }
+        max_level = std::max(max_level, std::abs((int)samples[2 * i]));
+      }
+      if ((max_level == 0) || (max_level > 8192)) {
+        ++bad_level_count;
+      }
+    }
+    ++frame_count;
+  };
+  mrsLocalAudioTrackRegisterFrameCallback(track_handle, CB(frame_cb));
+  {
+    Event ev;
+    ev.WaitFor(1s);
+  }
+  mrsLocalAudioTrackRegisterFrameCallback(track_handle, nullptr, nullptr);
+  ASSERT_LT(50u, frame_count.load());  // 100 frames per second
+  ASSERT_EQ(0u, bad_format_count.load());
+  ASSERT_EQ(0u, bad_level_count.load());
+
+  mrsLocalAudioTrackRemoveRef(track_handle);
+}
+
+TEST_F(AudioTrackTests, VirtualAudioDevice) {
+  mrsAudioDeviceModuleConfig device_config{};
+  device_config.kind = mrsAudioDeviceModuleKind::kVirtual;
+  device_config.clock = mrsVirtualAudioClock::kNone;
+  device_config.sample_rate_hz = 48000;
+  device_config.channel_count = 1;
+  ASSERT_EQ(Result::kInvalidParameter, mrsSetAudioDeviceModuleConfig(nullptr));
+  {
+    mrsAudioDeviceModuleConfig bad_config = device_config;
+    bad_config.sample_rate_hz = 22050;
+    ASSERT_EQ(Result::kOutOfRange, mrsSetAudioDeviceModuleConfig(&bad_config));
+  }
+  ASSERT_EQ(Result::kNotInitialized, mrsVirtualAudioDeviceProcess(1));
+  ASSERT_EQ(Result::kSuccess, mrsSetAudioDeviceModuleConfig(&device_config));
+
+  {
+    mrsPeerConnectionConfiguration pc_config{};
+    LocalPeerPairRaii pair(pc_config);
+
+    // The device cannot change while the library is initialized
+    ASSERT_EQ(Result::kInvalidOperation,
+              mrsSetAudioDeviceModuleConfig(&device_config));
+
+    mrsRemoteAudioTrackHandle audio_track2{};
+    Event track_added2_ev;
+    AudioTrackAddedCallback track_added2_cb =
+        [&audio_track2,
+         &track_added2_ev](const mrsRemoteAudioTrackAddedInfo* info) {
+          audio_track2 = info->track_handle;
+          track_added2_ev.Set();
+        };
+    mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                     CB(track_added2_cb));
+
+    // Capture from the virtual device on #1
+    mrsTransceiverHandle audio_transceiver1{};
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "transceiver1";
+    transceiver_config.media_kind = mrsMediaKind::kAudio;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &audio_transceiver1));
+    mrsLocalAudioTrackInitConfig config{};
+    mrsLocalAudioTrackHandle audio_track1{};
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalAudioTrackCreateFromDevice(&config, "test_audio_track",
+                                                 &audio_track1));
+    ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalAudioTrack(
+                                    audio_transceiver1, audio_track1));
+
+    pair.ConnectAndWait();
+    ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+    ASSERT_NE(nullptr, audio_track2);
+
+    std::atomic<uint32_t> remote_count{0};
+    AudioFrameCallback remote_cb = [&remote_count](const AudioFrame&) {
+      ++remote_count;
+    };
+    mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, CB(remote_cb));
+
+    uint32_t playout_count = 0;
+    uint32_t playout_bad_format = 0;
+    AudioFrameCallback playout_cb = [&](const AudioFrame& frame) {
+      if ((frame.bits_per_sample_ != 16) ||
+          (frame.sampling_rate_hz_ != 48000) || (frame.channel_count_ != 1) ||
+          (frame.sample_count_ != 480)) {
+        ++playout_bad_format;
+      }
+      ++playout_count;
+    };
+    ASSERT_EQ(Result::kSuccess,
+              mrsVirtualAudioDeviceRegisterPlayoutCallback(CB(playout_cb)));
+
+    // Capture frames must match the format of the device
+    {
+      mrsAudioFrame frame{};
+      frame.bits_per_sample_ = 8;
+      frame.sampling_rate_hz_ = 48000;
+      frame.channel_count_ = 1;
+      ASSERT_EQ(Result::kInvalidParameter,
+                mrsVirtualAudioDevicePushCaptureFrame(&frame));
+    }
+
+    // Drive the device manually, pushing a 440 Hz tone for 2 seconds
+    std::vector<int16_t> samples(480);
+    mrsAudioFrame frame{};
+    frame.data_ = samples.data();
+    frame.bits_per_sample_ = 16;
+    frame.sampling_rate_hz_ = 48000;
+    frame.channel_count_ = 1;
+    frame.sample_count_ = 480;
+    uint32_t sample_index = 0;
+    for (int i = 0; i < 200; ++i) {
+      for (int16_t& sample : samples) {
+        sample = static_cast<int16_t>(
+            10000.0 * std::sin(6.283185307179586 * 440.0 * sample_index++ /
+                               48000.0));
+      }
+      ASSERT_EQ(Result::kSuccess,
+                mrsVirtualAudioDevicePushCaptureFrame(&frame));
+      ASSERT_EQ(Result::kSuccess, mrsVirtualAudioDeviceProcess(1));
+      Event ev;
+      ev.WaitFor(10ms);
+    }
+    ASSERT_EQ(Result::kSuccess,
+              mrsVirtualAudioDeviceRegisterPlayoutCallback(nullptr, nullptr));
+    ASSERT_LT(100u, playout_count);
+    ASSERT_EQ(0u, playout_bad_format);
+    ASSERT_LT(0u, remote_count.load());
+
+    mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, nullptr, nullptr);
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+    mrsLocalAudioTrackRemoveRef(audio_track1);
+  }
+
+  // Restore the platform device for the other tests, now that the library
+  // shut down.
+  const mrsAudioDeviceModuleConfig default_config{};
+  ASSERT_EQ(Result::kSuccess, mrsSetAudioDeviceModuleConfig(&default_config));
+}
@@ -116,6 +116,40 @@ void ValidateQuadTestFrame(const void* data,
   ASSERT_LE(std::fabs(err), 768.0);  // +/-1 per component over 256 pixels
 }
 
+uint8_t Nv12FrameBuffer[16 * 16 + 16 * 8];
+
+/// Luma value of the NV12 test frame at the given pixel.
+inline uint8_t Nv12TestLuma(int x, int y) {
+  return static_cast<uint8_t>(16 + x * 8 + y);
+}
+
+/// Generate a 16px by 16px NV12 test frame, with a horizontal luma gradient
+/// and a uniform chroma.
+mrsResult MRS_CALL
+GenerateNv12TestFrame(void* /*user_data*/,
+                      mrsExternalVideoTrackSourceHandle source_handle,
+                      uint32_t request_id,
+                      int64_t timestamp_ms) {
+  for (int j = 0; j < 16; ++j) {
+    for (int i = 0; i < 16; ++i) {
+      Nv12FrameBuffer[j * 16 + i] = Nv12TestLuma(i, j);
+    }
+  }
+  for (int k = 0; k < 16 * 8; k += 2) {
+    Nv12FrameBuffer[16 * 16 + k] = 64;       // U
+    Nv12FrameBuffer[16 * 16 + k + 1] = 192;  // V
+  }
+  mrsNv12VideoFrame frame_view{};
+  frame_view.width_ = 16;
+  frame_view.height_ = 16;
+  frame_view.ydata_ = Nv12FrameBuffer;
+  frame_view.uvdata_ = Nv12FrameBuffer + 16 * 16;
+  frame_view.ystride_ = 16;
+  frame_view.uvstride_ = 16;
+  return mrsExternalVideoTrackSourceCompleteNv12FrameRequest(
+      source_handle, request_id, timestamp_ms, &frame_view);
+}
+
 // PeerConnectionVideoTrackAddedCallback
 using VideoTrackAddedCallback =
     InteropCallback<const mrsRemoteVideoTrackAddedInfo*>;
@@ -123,6 +157,12 @@ using VideoTrackAddedCallback =
 // mrsArgb32VideoFrameCallback
 using Argb32VideoFrameCallback = InteropCallback<const mrsArgb32VideoFrame&>;
 
+// mrsNv12VideoFrameCallback
+using Nv12VideoFrameCallback = InteropCallback<const mrsNv12VideoFrame&>;
+
+// mrsI420AVideoFrameCallback
+using I420AVideoFrameCallback = InteropCallback<const mrsI420AVideoFrame&>;
+
 }  // namespace
 
 INSTANTIATE_TEST_CASE_P(,
@@ -220,4 +260,116 @@ TEST_P(ExternalVideoTrackSourceTests, Simple) {
   mrsExternalVideoTrackSourceRemoveRef(source_handle1);
 }
 
+TEST_P(ExternalVideoTrackSourceTests, Nv12) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  mrsExternalVideoTrackSourceHandle source_handle1 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromNv12Callback(
+                &GenerateNv12TestFrame, nullptr, &source_handle1));
+  ASSERT_NE(nullptr, source_handle1);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle1);
+
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsLocalVideoTrackFromExternalSourceInitConfig source_config{};
+    source_config.source_handle = source_handle1;
+    source_config.track_name = "nv12_track";
+    ASSERT_EQ(mrsResult::kSuccess, mrsLocalVideoTrackCreateFromExternalSource(
+                                       &source_config, &track_handle1));
+    ASSERT_NE(nullptr, track_handle1);
+  }
+
+  // The local NV12 frames are delivered as produced, so are bit-exact, and
+  // the I420 conversion preserves the luma plane.
+  uint32_t local_nv12_count = 0;
+  Nv12VideoFrameCallback local_nv12_cb = [&](const mrsNv12VideoFrame& frame) {
+    ASSERT_EQ(16u, frame.width_);
+    ASSERT_EQ(16u, frame.height_);
+    const uint8_t* const y = static_cast<const uint8_t*>(frame.ydata_);
+    const uint8_t* const uv = static_cast<const uint8_t*>(frame.uvdata_);
+    for (int j = 0; j < 16; ++j) {
+      for (int i = 0; i < 16; ++i) {
+        ASSERT_EQ(Nv12TestLuma(i, j), y[j * frame.ystride_ + i]);
+      }
+    }
+    ASSERT_EQ(64, uv[0]);
+    ASSERT_EQ(192, uv[1]);
+    ++local_nv12_count;
+  };
+  mrsLocalVideoTrackRegisterNv12FrameCallback(track_handle1,
+                                              CB(local_nv12_cb));
+  uint32_t local_i420_count = 0;
+  I420AVideoFrameCallback local_i420_cb = [&](const mrsI420AVideoFrame& frame) {
+    ASSERT_EQ(16u, frame.width_);
+    ASSERT_EQ(16u, frame.height_);
+    const uint8_t* const y = static_cast<const uint8_t*>(frame.ydata_);
+    ASSERT_EQ(Nv12TestLuma(5, 7), y[7 * frame.ystride_ + 5]);
+    ASSERT_EQ(64, static_cast<const uint8_t*>(frame.udata_)[0]);
+    ASSERT_EQ(192, static_cast<const uint8_t*>(frame.vdata_)[0]);
+    ++local_i420_count;
+  };
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle1,
+                                               CB(local_i420_cb));
+
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  ASSERT_EQ(mrsResult::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                     transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  // Decoded frames are I420, and converted for the remote NV12 callback.
+  uint32_t remote_nv12_count = 0;
+  Nv12VideoFrameCallback remote_nv12_cb =
+      [&](const mrsNv12VideoFrame& frame) {
+        ASSERT_EQ(16u, frame.width_);
+        ASSERT_EQ(16u, frame.height_);
+        ASSERT_NE(nullptr, frame.ydata_);
+        ASSERT_NE(nullptr, frame.uvdata_);
+        ASSERT_LE(16, frame.ystride_);
+        ASSERT_LE(16, frame.uvstride_);
+        ++remote_nv12_count;
+      };
+  mrsRemoteVideoTrackRegisterNv12FrameCallback(track_handle2,
+                                               CB(remote_nv12_cb));
+
+  Event ev;
+  ev.WaitFor(3s);
+  mrsRemoteVideoTrackRegisterNv12FrameCallback(track_handle2, nullptr,
+                                               nullptr);
+  mrsLocalVideoTrackRegisterNv12FrameCallback(track_handle1, nullptr, nullptr);
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle1, nullptr,
+                                               nullptr);
+  ASSERT_LT(30u, local_nv12_count) << "Expected at least 10 FPS";
+  ASSERT_LT(30u, local_i420_count) << "Expected at least 10 FPS";
+  ASSERT_LT(30u, remote_nv12_count) << "Expected at least 10 FPS";
+
+  mrsLocalVideoTrackRemoveRef(track_handle1);
+  mrsExternalVideoTrackSourceShutdown(source_handle1);
+  mrsExternalVideoTrackSourceRemoveRef(source_handle1);
+}
+
 #endif  // MRSW_EXCLUDE_DEVICE_TESTS
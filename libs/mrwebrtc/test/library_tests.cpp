@@ -3,10 +3,71 @@
 
 #include "pch.h"
 
+#include <atomic>
+
+#include "data_channel_interop.h"
 #include "external_video_track_source_interop.h"
 #include "interop_api.h"
+#include "local_video_track_interop.h"
+#include "log_sink_interop.h"
+#include "metrics_interop.h"
+#include "tracing_interop.h"
 #include "video_test_utils.h"
 
+namespace {
+
+/// Log message copied by |StaticLogMessageCallback()|.
+struct ReceivedLogMessage {
+  mrsLogSeverity severity;
+  std::string tag;
+  std::string message;
+};
+
+/// Log messages received by |StaticLogMessageCallback()|.
+struct ReceivedLogMessages {
+  std::mutex mutex_;
+  std::vector<ReceivedLogMessage> messages_;
+};
+
+/// Copy the messages delivered to a log sink, to be checked on the test thread
+/// once the sink is destroyed, since this runs on the delivery thread.
+void MRS_CALL StaticLogMessageCallback(void* user_data,
+                                       const mrsLogMessage* message) {
+  auto received = static_cast<ReceivedLogMessages*>(user_data);
+  std::lock_guard<std::mutex> lock(received->mutex_);
+  received->messages_.push_back(
+      {message->severity, message->tag, message->message});
+}
+
+void MRS_CALL StaticMessageCallback(void* user_data,
+                                    const void* data,
+                                    const uint64_t size) noexcept {
+  auto func = *static_cast<std::function<void(const void*, const uint64_t)>*>(
+      user_data);
+  func(data, size);
+}
+
+void MRS_CALL StaticStateCallback(void* user_data,
+                                  int32_t state,
+                                  int32_t id) noexcept {
+  auto func = *static_cast<std::function<void(int32_t, int32_t)>*>(user_data);
+  func(state, id);
+}
+
+/// Produce a test frame, and signal the |Event| passed as user data.
+mrsResult MRS_CALL MakeTestFrameAndSignal(
+    void* user_data,
+    mrsExternalVideoTrackSourceHandle handle,
+    uint32_t request_id,
+    int64_t timestamp_ms) {
+  const mrsResult result = VideoTestUtils::MakeTestFrame(
+      nullptr, handle, request_id, timestamp_ms);
+  static_cast<Event*>(user_data)->Set();
+  return result;
+}
+
+}  // namespace
+
 TEST(LibraryTests, SetShutdownOptions) {
   ASSERT_EQ(0u, mrsReportLiveObjects());
   auto const initial_options = mrsGetShutdownOptions();
@@ -30,6 +91,36 @@ TEST(LibraryTests, ReportLiveObjects) {
   ASSERT_EQ(0u, mrsReportLiveObjects());
 }
 
+TEST(LibraryTests, LiveObjectCount) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  ASSERT_EQ(0u,
+            mrsGetLiveObjectCount(mrsObjectType::kExternalVideoTrackSource));
+  constexpr int kNumSources = 5;
+  mrsExternalVideoTrackSourceHandle source_handles[kNumSources]{};
+  for (int i = 0; i < kNumSources; ++i) {
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                  &VideoTestUtils::MakeTestFrame, nullptr, &source_handles[i]));
+    mrsExternalVideoTrackSourceFinishCreation(source_handles[i]);
+  }
+  ASSERT_EQ(static_cast<uint32_t>(kNumSources),
+            mrsGetLiveObjectCount(mrsObjectType::kExternalVideoTrackSource));
+  ASSERT_EQ(0u, mrsGetLiveObjectCount(mrsObjectType::kLocalVideoTrack));
+  ASSERT_EQ(0u, mrsGetLiveObjectCount((mrsObjectType)42));
+  ASSERT_EQ(static_cast<uint32_t>(kNumSources), mrsReportLiveObjects());
+
+  // Remove in an order different from the creation order
+  mrsExternalVideoTrackSourceRemoveRef(source_handles[2]);
+  mrsExternalVideoTrackSourceRemoveRef(source_handles[0]);
+  mrsExternalVideoTrackSourceRemoveRef(source_handles[4]);
+  ASSERT_EQ(2u,
+            mrsGetLiveObjectCount(mrsObjectType::kExternalVideoTrackSource));
+  ASSERT_EQ(2u, mrsReportLiveObjects());
+  mrsExternalVideoTrackSourceRemoveRef(source_handles[1]);
+  mrsExternalVideoTrackSourceRemoveRef(source_handles[3]);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+}
+
 TEST(LibraryTests, ForceShutdown) {
   // Disable kDebugBreakOnForceShutdown; debug break makes the test fail
   mrsSetShutdownOptions(mrsShutdownOptions::kNone);
@@ -44,3 +135,271 @@ TEST(LibraryTests, ForceShutdown) {
   mrsForceShutdown();
   ASSERT_EQ(0u, mrsReportLiveObjects());
 }
+
+TEST(LibraryTests, StaleHandle) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle);
+  mrsExternalVideoTrackSourceRemoveRef(source_handle);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Create another object, which may reuse the memory of the first one
+  mrsExternalVideoTrackSourceHandle source_handle2 = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &source_handle2));
+  ASSERT_NE(nullptr, source_handle2);
+  ASSERT_NE(source_handle, source_handle2);
+  mrsExternalVideoTrackSourceFinishCreation(source_handle2);
+
+  // The handle of the destroyed object is rejected
+  uint8_t data[4]{};
+  mrsI420AVideoFrame frame{};
+  frame.width_ = 2;
+  frame.height_ = 2;
+  frame.ydata_ = data;
+  frame.udata_ = data;
+  frame.vdata_ = data;
+  frame.ystride_ = 2;
+  frame.ustride_ = 1;
+  frame.vstride_ = 1;
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsExternalVideoTrackSourceCompleteI420AFrameRequest(
+                source_handle, 0, 0, &frame));
+
+  mrsExternalVideoTrackSourceRemoveRef(source_handle2);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+}
+
+TEST(LibraryTests, Tracing) {
+  constexpr char kPath[] = "mrwebrtc_test_trace.json";
+  mrsTracingConfig config{};
+  config.events_per_thread = 0;
+  ASSERT_EQ(mrsResult::kInvalidParameter, mrsTracingStart(&config));
+  ASSERT_EQ(mrsResult::kSuccess, mrsTracingStart(nullptr));
+  ASSERT_EQ(mrsResult::kInvalidOperation, mrsTracingStart(nullptr));
+  ASSERT_EQ(mrsResult::kInvalidOperation, mrsTracingWriteJson(kPath));
+
+  // Run a traced path: the capture thread of an external video track source
+  // requests frames from its |OnMessage()| handler.
+  {
+    Event frame_requested;
+    mrsExternalVideoTrackSourceHandle source_handle = nullptr;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                  &MakeTestFrameAndSignal, &frame_requested, &source_handle));
+    ASSERT_NE(nullptr, source_handle);
+    mrsExternalVideoTrackSourceFinishCreation(source_handle);
+    const bool requested = frame_requested.WaitFor(5s);
+    // Stops the capture thread, so that the traced scope is complete
+    mrsExternalVideoTrackSourceRemoveRef(source_handle);
+    ASSERT_TRUE(requested);
+  }
+
+  ASSERT_EQ(mrsResult::kSuccess, mrsTracingStop());
+  ASSERT_EQ(mrsResult::kInvalidParameter, mrsTracingWriteJson(nullptr));
+  ASSERT_EQ(mrsResult::kSuccess, mrsTracingWriteJson(kPath));
+
+  // Check that the file is a Chrome trace containing the traced scope
+  std::string content;
+  {
+    FILE* const file = fopen(kPath, "rb");
+    ASSERT_NE(nullptr, file);
+    char buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      content.append(buffer, size);
+    }
+    fclose(file);
+    remove(kPath);
+  }
+  ASSERT_EQ(0u, content.find("{\"traceEvents\":["));
+  ASSERT_NE(std::string::npos,
+            content.find("\"ExternalVideoTrackSourceImpl::OnMessage\""));
+}
+
+TEST(LibraryTests, Metrics) {
+  mrsMetricsReset();
+
+  LocalPeerPairRaii pair;
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "data";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  const char msg_data[] = "test message";
+  const int kMessageCount = 3;
+
+  // Send some messages from peer #1 to peer #2 once the channels are open
+  Event ev_state1, ev_state2, ev_msg;
+  std::atomic<int> received_count{0};
+  std::function<void(const void*, const uint64_t)> message_cb(
+      [&](const void* /*data*/, const uint64_t /*size*/) {
+        if (++received_count == kMessageCount) {
+          ev_msg.Set();
+        }
+      });
+  std::function<void(int32_t, int32_t)> state1_cb(
+      [&](int32_t state, int32_t /*id*/) {
+        if (state == 1) {  // kOpen
+          ev_state1.Set();
+        }
+      });
+  std::function<void(int32_t, int32_t)> state2_cb(
+      [&](int32_t state, int32_t /*id*/) {
+        if (state == 1) {  // kOpen
+          ev_state2.Set();
+        }
+      });
+  mrsDataChannelHandle handle1;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle1));
+  mrsDataChannelCallbacks callbacks1{};
+  callbacks1.state_callback = &StaticStateCallback;
+  callbacks1.state_user_data = &state1_cb;
+  mrsDataChannelRegisterCallbacks(handle1, &callbacks1);
+  mrsDataChannelHandle handle2;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle2));
+  mrsDataChannelCallbacks callbacks2{};
+  callbacks2.message_callback = &StaticMessageCallback;
+  callbacks2.message_user_data = &message_cb;
+  callbacks2.state_callback = &StaticStateCallback;
+  callbacks2.state_user_data = &state2_cb;
+  mrsDataChannelRegisterCallbacks(handle2, &callbacks2);
+  pair.ConnectAndWait();
+  ASSERT_TRUE(ev_state1.WaitFor(60s));
+  ASSERT_TRUE(ev_state2.WaitFor(60s));
+  for (int i = 0; i < kMessageCount; ++i) {
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsDataChannelSendMessage(handle1, msg_data, sizeof(msg_data)));
+  }
+  ASSERT_TRUE(ev_msg.WaitFor(60s));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc1(), handle1));
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsPeerConnectionRemoveDataChannel(pair.pc2(), handle2));
+
+  // Query the snapshot size, then the snapshot itself
+  uint64_t size = 0;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsMetricsGetSnapshot(nullptr, &size));
+  ASSERT_LT(0u, size);
+  std::vector<char> buffer(static_cast<size_t>(size));
+  ASSERT_EQ(mrsResult::kSuccess, mrsMetricsGetSnapshot(buffer.data(), &size));
+  std::string snapshot(buffer.data());
+  ASSERT_EQ(size - 1, snapshot.size());
+  ASSERT_NE(std::string::npos,
+            snapshot.find("\"data_channel_messages_sent\":3,"));
+  ASSERT_NE(std::string::npos,
+            snapshot.find("\"data_channel_messages_received\":3,"));
+  ASSERT_NE(std::string::npos,
+            snapshot.find("\"data_channel_messages_dropped\":0,"));
+
+  // Resetting clears the counters
+  mrsMetricsReset();
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsMetricsGetSnapshot(nullptr, &size));
+  buffer.resize(static_cast<size_t>(size));
+  ASSERT_EQ(mrsResult::kSuccess, mrsMetricsGetSnapshot(buffer.data(), &size));
+  snapshot = buffer.data();
+  ASSERT_NE(std::string::npos,
+            snapshot.find("\"data_channel_messages_sent\":0,"));
+}
+
+TEST(LibraryTests, LogSink) {
+  ReceivedLogMessages received;
+  mrsLogSinkHandle handle = nullptr;
+  mrsLogSinkConfig config{};
+  config.queue_capacity = 0;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLogSinkCreate(&config, &StaticLogMessageCallback, &received,
+                             &handle));
+
+  // Only deliver the errors of the frame scaling logic of video tracks
+  config.queue_capacity = 16;
+  config.min_severity = mrsLogSeverity::kError;
+  config.tag_filter = "video_frame_observer";
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLogSinkCreate(&config, &StaticLogMessageCallback, &received,
+                             &handle));
+  ASSERT_NE(nullptr, handle);
+
+  // Make the library log an error by requesting an out-of-range scaling
+  mrsLocalVideoTrackHandle track_handle{};
+  {
+    mrsSyntheticVideoTrackInitConfig track_config{};
+    track_config.width = 320;
+    track_config.height = 240;
+    track_config.framerate = 30.0;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(
+                  &track_config, "synthetic_track", &track_handle));
+  }
+  mrsVideoFrameScaling scaling{};
+  scaling.target_width = 0xFFFFFFFFu;
+  ASSERT_EQ(mrsResult::kOutOfRange,
+            mrsLocalVideoTrackSetFrameScaling(
+                track_handle, mrsVideoFrameFormat::kArgb32, &scaling));
+  mrsLocalVideoTrackRemoveRef(track_handle);
+
+  // Destroying the sink delivers the messages already enqueued
+  uint64_t dropped = 1;
+  ASSERT_EQ(mrsResult::kSuccess, mrsLogSinkGetDroppedCount(handle, &dropped));
+  ASSERT_EQ(0u, dropped);
+  ASSERT_EQ(mrsResult::kSuccess, mrsLogSinkDestroy(handle));
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle, mrsLogSinkDestroy(handle));
+  ASSERT_EQ(1u, received.messages_.size());
+  const ReceivedLogMessage& message = received.messages_[0];
+  ASSERT_EQ(mrsLogSeverity::kError, message.severity);
+  ASSERT_EQ("video_frame_observer.cpp", message.tag);
+  ASSERT_NE(std::string::npos,
+            message.message.find("Video frame scaling values cannot exceed"));
+
+  // The handle of a destroyed sink stays invalid after another sink is created,
+  // even if that new sink reuses the memory of the destroyed one.
+  mrsLogSinkHandle handle2{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLogSinkCreate(&config, &StaticLogMessageCallback, &received,
+                             &handle2));
+  ASSERT_NE(handle, handle2);
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+            mrsLogSinkGetDroppedCount(handle, &dropped));
+  ASSERT_EQ(mrsResult::kInvalidNativeHandle, mrsLogSinkDestroy(handle));
+  ASSERT_EQ(mrsResult::kSuccess, mrsLogSinkDestroy(handle2));
+}
+
+TEST(LibraryTests, LogSinkSeverity) {
+  // Accept all messages from info up, to check that each message is reported
+  // with its own severity and not the minimum severity of the sink.
+  ReceivedLogMessages received;
+  mrsLogSinkConfig config{};
+  config.min_severity = mrsLogSeverity::kInfo;
+  config.tag_filter = "local_video_track_interop";
+  mrsLogSinkHandle handle = nullptr;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLogSinkCreate(&config, &StaticLogMessageCallback, &received,
+                             &handle));
+
+  // Log a warning, then an error
+  mrsLocalVideoTrackRemoveRef(nullptr);
+  mrsSyntheticVideoTrackInitConfig track_config{};
+  mrsLocalVideoTrackHandle track_handle{};
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLocalVideoTrackCreateSynthetic(&track_config, "",
+                                              &track_handle));
+
+  // Each message is delivered once, with its severity
+  ASSERT_EQ(mrsResult::kSuccess, mrsLogSinkDestroy(handle));
+  ASSERT_EQ(2u, received.messages_.size());
+  ASSERT_EQ(mrsLogSeverity::kWarning, received.messages_[0].severity);
+  ASSERT_NE(std::string::npos,
+            received.messages_[0].message.find("Trying to remove reference"));
+  ASSERT_EQ(mrsLogSeverity::kError, received.messages_[1].severity);
+  ASSERT_NE(std::string::npos, received.messages_[1].message.find(
+                                   "Invalid empty local video track name"));
+}
@@ -0,0 +1,50 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "metrics.h"
+
+// The bucket layout of the histograms is defined inline in the header of the
+// metrics registry, so these tests compile it directly instead of requiring the
+// library to export it. The registry itself is tested through the interop API.
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+TEST(MetricsTests, BucketBounds) {
+  // Each bucket holds the values between its lower bound and the lower bound
+  // of the next bucket.
+  for (int i = 0; i < Metrics::kBucketCount; ++i) {
+    const uint64_t lower = Metrics::GetBucketLowerBound(i);
+    ASSERT_EQ(i, Metrics::GetBucketIndex(lower));
+    if (i > 0) {
+      ASSERT_LT(Metrics::GetBucketLowerBound(i - 1), lower);
+      ASSERT_EQ(i - 1, Metrics::GetBucketIndex(lower - 1));
+    }
+  }
+
+  // Values too large for the last bucket are clamped into it
+  ASSERT_EQ(Metrics::kBucketCount - 1, Metrics::GetBucketIndex(UINT32_MAX));
+  ASSERT_EQ(Metrics::kBucketCount - 1,
+            Metrics::GetBucketIndex(uint64_t{UINT32_MAX} + 1));
+  ASSERT_EQ(Metrics::kBucketCount - 1, Metrics::GetBucketIndex(UINT64_MAX));
+}
+
+TEST(MetricsTests, BucketPrecision) {
+  const uint64_t sub_bucket_count = Metrics::kSubBucketCount;
+
+  // Small values have their own bucket
+  for (uint64_t value = 0; value < sub_bucket_count; ++value) {
+    ASSERT_EQ(value, Metrics::GetBucketLowerBound(
+                         Metrics::GetBucketIndex(value)));
+  }
+
+  // Larger values are rounded down by less than 1/16th of their value
+  for (uint64_t value = sub_bucket_count; value <= UINT32_MAX;
+       value = value * 3 / 2 + 1) {
+    const uint64_t lower =
+        Metrics::GetBucketLowerBound(Metrics::GetBucketIndex(value));
+    ASSERT_LE(lower, value);
+    ASSERT_LT((value - lower) * sub_bucket_count, value) << "Value " << value;
+  }
+}
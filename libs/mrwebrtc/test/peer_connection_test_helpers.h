@@ -264,6 +264,11 @@ class LocalPeerPairRaii {
     return exchange_completed_.WaitFor(timeout);
   }
 
+  /// SDP offer and answer of the last exchange. These are only valid once the
+  /// exchange completed.
+  const std::string& offer_sdp() const { return offer_sdp_; }
+  const std::string& answer_sdp() const { return answer_sdp_; }
+
  protected:
   PCRaii pc1_;
   PCRaii pc2_;
@@ -275,8 +280,11 @@ class LocalPeerPairRaii {
   InteropCallback<> connected2_cb_;
   bool is_exchange_pending_{false};
   Event exchange_completed_;
+  std::string offer_sdp_;
+  std::string answer_sdp_;
   void setup() {
     sdp1_cb_ = [this](mrsSdpMessageType type, const char* sdp_data) {
+      (type == mrsSdpMessageType::kOffer ? offer_sdp_ : answer_sdp_) = sdp_data;
       Event ev;
       ASSERT_EQ(Result::kSuccess, mrsPeerConnectionSetRemoteDescriptionAsync(
                                       pc2_.handle(), type, sdp_data,
@@ -292,6 +300,7 @@ class LocalPeerPairRaii {
       }
     };
     sdp2_cb_ = [this](mrsSdpMessageType type, const char* sdp_data) {
+      (type == mrsSdpMessageType::kOffer ? offer_sdp_ : answer_sdp_) = sdp_data;
       Event ev;
       ASSERT_EQ(Result::kSuccess, mrsPeerConnectionSetRemoteDescriptionAsync(
                                       pc1_.handle(), type, sdp_data,
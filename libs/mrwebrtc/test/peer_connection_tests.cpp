@@ -3,7 +3,15 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <vector>
+
+#include "data_channel_interop.h"
 #include "interop_api.h"
+#include "local_audio_track_interop.h"
+#include "local_video_track_interop.h"
+#include "peer_connection_interop.h"
+#include "transceiver_interop.h"
 
 #include "test_utils.h"
 
@@ -13,6 +21,77 @@ class PeerConnectionTests : public TestUtils::TestBase,
                             public testing::WithParamInterface<mrsSdpSemantic> {
 };
 
+/// Stats report delivered to |StaticStatsReportCallback()|.
+struct StatsReportResult {
+  Event ready_;
+  mrsStatsReportHandle report_{};
+};
+
+void MRS_CALL StaticStatsReportCallback(void* user_data,
+                                        mrsStatsReportHandle report) {
+  auto result = static_cast<StatsReportResult*>(user_data);
+  result->report_ = report;
+  result->ready_.Set();
+}
+
+/// Append the stats objects enumerated by |mrsStatsReportGetObjects()| to a
+/// vector of objects of the stats type.
+template <typename T>
+void MRS_CALL AppendStatsObject(void* user_data, const void* stats_object) {
+  static_cast<std::vector<T>*>(user_data)->push_back(
+      *static_cast<const T*>(stats_object));
+}
+
+// PeerConnectionAudioTrackAddedCallback
+using AudioTrackAddedCallback =
+    InteropCallback<const mrsRemoteAudioTrackAddedInfo*>;
+
+// PeerConnectionVideoTrackAddedCallback
+using VideoTrackAddedCallback =
+    InteropCallback<const mrsRemoteVideoTrackAddedInfo*>;
+
+// PeerConnectionVideoTrackRemovedCallback
+using VideoTrackRemovedCallback =
+    InteropCallback<mrsRemoteVideoTrackHandle, mrsTransceiverHandle>;
+
+// PeerConnectionDataChannelRemovedCallback
+using DataChannelRemovedCallback = InteropCallback<mrsDataChannelHandle>;
+
+/// Storage of a snapshot of the media stats of a peer connection.
+struct MediaStatsSnapshot {
+  static constexpr uint32_t kCapacity = 4;
+  mrsAudioSenderStats audio_sender_stats[kCapacity]{};
+  mrsAudioReceiverStats audio_receiver_stats[kCapacity]{};
+  mrsVideoSenderStats video_sender_stats[kCapacity]{};
+  mrsVideoReceiverStats video_receiver_stats[kCapacity]{};
+  mrsStatsSnapshot snapshot{};
+
+  MediaStatsSnapshot() {
+    snapshot.audio_sender_stats = audio_sender_stats;
+    snapshot.audio_sender_stats_capacity = kCapacity;
+    snapshot.audio_receiver_stats = audio_receiver_stats;
+    snapshot.audio_receiver_stats_capacity = kCapacity;
+    snapshot.video_sender_stats = video_sender_stats;
+    snapshot.video_sender_stats_capacity = kCapacity;
+    snapshot.video_receiver_stats = video_receiver_stats;
+    snapshot.video_receiver_stats_capacity = kCapacity;
+  }
+};
+
+/// Add a negotiated data channel to both peers of a pair.
+void AddDataChannelPair(const LocalPeerPairRaii& pair) {
+  mrsDataChannelConfig config{};
+  config.id = 42;
+  config.label = "data";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc1(), &config, &handle));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pair.pc2(), &config, &handle));
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_CASE_P(,
@@ -89,3 +168,464 @@ TEST_P(PeerConnectionTests, LocalIce) {
                                                              nullptr, nullptr);
   }
 }
+
+TEST_P(PeerConnectionTests, StatsSampler) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Invalid parameters
+  mrsStatsSamplerConfig config{};
+  config.interval_ms = 0;
+  ASSERT_EQ(Result::kOutOfRange,
+            mrsPeerConnectionStartStatsSampler(pair.pc1(), &config));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionStartStatsSampler(pair.pc1(), nullptr));
+  config.interval_ms = 50;
+  config.capacity = 4;
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionStartStatsSampler(nullptr, &config));
+
+  // No sample before the sampler is started
+  mrsStatsSample samples[8]{};
+  uint32_t count = 42;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionReadStatsSamples(pair.pc1(), samples, 8, &count));
+  ASSERT_EQ(0u, count);
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionStartStatsSampler(pair.pc1(), &config));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  std::this_thread::sleep_for(500ms);
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionStopStatsSampler(pair.pc1()));
+
+  // The ring buffer keeps at most |capacity| samples, oldest first
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionReadStatsSamples(pair.pc1(), samples, 8, &count));
+  ASSERT_LT(0u, count);
+  ASSERT_GE(4u, count);
+  for (uint32_t i = 1; i < count; ++i) {
+    ASSERT_EQ(samples[i - 1].sequence_number + 1, samples[i].sequence_number);
+    ASSERT_LE(samples[i - 1].timestamp_us, samples[i].timestamp_us);
+  }
+
+  // Samples remain readable after the sampler stopped
+  uint32_t count2 = 0;
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionReadStatsSamples(
+                                  pair.pc1(), samples, 8, &count2));
+  ASSERT_EQ(count, count2);
+}
+
+TEST_P(PeerConnectionTests, CloseAll) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair1(pc_config);
+  LocalPeerPairRaii pair2(pc_config);
+
+  // Send a video track and open a data channel on the first pair, so that
+  // closing it removes a remote track and some data channels.
+  mrsLocalVideoTrackHandle track_handle{};
+  {
+    mrsSyntheticVideoTrackInitConfig track_config{};
+    track_config.width = 320;
+    track_config.height = 240;
+    track_config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(
+                  &track_config, "synthetic_track", &track_handle));
+  }
+  mrsTransceiverHandle transceiver_handle{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair1.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalVideoTrack(transceiver_handle, track_handle));
+  AddDataChannelPair(pair1);
+  Event track_added_ev;
+  VideoTrackAddedCallback track_added_cb =
+      [&track_added_ev](const mrsRemoteVideoTrackAddedInfo* /*info*/) {
+        track_added_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair1.pc2(),
+                                                   CB(track_added_cb));
+  pair1.ConnectAndWait();
+  ASSERT_TRUE(pair1.WaitExchangeCompletedFor(5s));
+  ASSERT_TRUE(track_added_ev.WaitFor(5s));
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair1.pc2(), nullptr,
+                                                   nullptr);
+  pair2.ConnectAndWait();
+  ASSERT_TRUE(pair2.WaitExchangeCompletedFor(5s));
+
+  // Count the removed callbacks, which are suppressed
+  std::atomic<uint32_t> removed_count{0};
+  VideoTrackRemovedCallback track_removed_cb =
+      [&removed_count](mrsRemoteVideoTrackHandle /*track*/,
+                       mrsTransceiverHandle /*transceiver*/) {
+        ++removed_count;
+      };
+  DataChannelRemovedCallback data_removed_cb =
+      [&removed_count](mrsDataChannelHandle /*data_channel*/) {
+        ++removed_count;
+      };
+  for (mrsPeerConnectionHandle handle : {pair1.pc1(), pair1.pc2()}) {
+    mrsPeerConnectionRegisterVideoTrackRemovedCallback(handle,
+                                                       CB(track_removed_cb));
+    mrsPeerConnectionRegisterDataChannelRemovedCallback(handle,
+                                                        CB(data_removed_cb));
+  }
+
+  mrsCloseAllConfig config{};
+  config.max_parallelism = 2;
+  config.timeout_ms = 0;  // wait until all are closed
+  config.suppress_callbacks = mrsBool::kTrue;
+  uint32_t pending_count = 42;
+  ASSERT_EQ(Result::kSuccess,
+            mrsCloseAllPeerConnections(&config, &pending_count));
+  ASSERT_EQ(0u, pending_count);
+  ASSERT_EQ(0u, removed_count.load());
+  for (mrsPeerConnectionHandle handle : {pair1.pc1(), pair1.pc2()}) {
+    mrsPeerConnectionRegisterVideoTrackRemovedCallback(handle, nullptr,
+                                                       nullptr);
+    mrsPeerConnectionRegisterDataChannelRemovedCallback(handle, nullptr,
+                                                        nullptr);
+  }
+  mrsLocalVideoTrackRemoveRef(track_handle);
+
+  // All connections are closed, but their handles remain valid
+  const mrsStatsSamplerConfig sampler_config{};
+  for (mrsPeerConnectionHandle handle :
+       {pair1.pc1(), pair1.pc2(), pair2.pc1(), pair2.pc2()}) {
+    ASSERT_EQ(Result::kPeerConnectionClosed,
+              mrsPeerConnectionStartStatsSampler(handle, &sampler_config));
+  }
+
+  // Nothing left to close
+  ASSERT_EQ(Result::kSuccess, mrsCloseAllPeerConnections(nullptr, nullptr));
+}
+
+TEST_P(PeerConnectionTests, CloseAllTimeout) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+  AddDataChannelPair(pair);
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  // Block the close of the first peer in its data channel removed callback
+  // until the bulk close timed out.
+  Event removing_ev, release_ev;
+  std::atomic<uint32_t> removed_count{0};
+  DataChannelRemovedCallback data_removed_cb =
+      [&](mrsDataChannelHandle /*data_channel*/) {
+        ++removed_count;
+        removing_ev.Set();
+        release_ev.WaitFor(30s);
+      };
+  mrsPeerConnectionRegisterDataChannelRemovedCallback(pair.pc1(),
+                                                      CB(data_removed_cb));
+
+  mrsCloseAllConfig config{};
+  config.timeout_ms = 100;
+  uint32_t pending_count = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsCloseAllPeerConnections(&config, &pending_count));
+  ASSERT_LE(1u, pending_count);
+  ASSERT_TRUE(removing_ev.WaitFor(5s));
+
+  // Closing a peer connection still being closed by the bulk close waits until
+  // it is closed.
+  release_ev.Set();
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionClose(pair.pc1()));
+  ASSERT_EQ(1u, removed_count.load());
+  mrsPeerConnectionRegisterDataChannelRemovedCallback(pair.pc1(), nullptr,
+                                                      nullptr);
+  const mrsStatsSamplerConfig sampler_config{};
+  ASSERT_EQ(Result::kPeerConnectionClosed,
+            mrsPeerConnectionStartStatsSampler(pair.pc1(), &sampler_config));
+
+  // Any other peer connection still closing is waited for too
+  ASSERT_EQ(Result::kSuccess,
+            mrsCloseAllPeerConnections(nullptr, &pending_count));
+  ASSERT_EQ(0u, pending_count);
+}
+
+TEST_P(PeerConnectionTests, StatsSnapshot) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Add a data channel before connecting, so that the report contains data
+  // channel and transport stats.
+  mrsDataChannelConfig data_config{};
+  data_config.label = "data";
+  data_config.flags = mrsDataChannelConfigFlags::kOrdered |
+                      mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle data_handle{};
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddDataChannel(
+                                  pair.pc1(), &data_config, &data_handle));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  StatsReportResult result;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetSimpleStats(
+                pair.pc1(), &StaticStatsReportCallback, &result));
+  ASSERT_TRUE(result.ready_.WaitFor(5s));
+  ASSERT_NE(nullptr, result.report_);
+
+  // Enumerate the objects of each type one type at a time
+  std::vector<mrsDataChannelStats> data_channel_stats;
+  std::vector<mrsAudioSenderStats> audio_sender_stats;
+  std::vector<mrsAudioReceiverStats> audio_receiver_stats;
+  std::vector<mrsVideoSenderStats> video_sender_stats;
+  std::vector<mrsVideoReceiverStats> video_receiver_stats;
+  std::vector<mrsTransportStats> transport_stats;
+  ASSERT_EQ(Result::kSuccess,
+            mrsStatsReportGetObjects(
+                result.report_, "DataChannelStats",
+                &AppendStatsObject<mrsDataChannelStats>, &data_channel_stats));
+  ASSERT_EQ(Result::kSuccess,
+            mrsStatsReportGetObjects(
+                result.report_, "AudioSenderStats",
+                &AppendStatsObject<mrsAudioSenderStats>, &audio_sender_stats));
+  ASSERT_EQ(Result::kSuccess,
+            mrsStatsReportGetObjects(result.report_, "AudioReceiverStats",
+                                     &AppendStatsObject<mrsAudioReceiverStats>,
+                                     &audio_receiver_stats));
+  ASSERT_EQ(Result::kSuccess,
+            mrsStatsReportGetObjects(
+                result.report_, "VideoSenderStats",
+                &AppendStatsObject<mrsVideoSenderStats>, &video_sender_stats));
+  ASSERT_EQ(Result::kSuccess,
+            mrsStatsReportGetObjects(result.report_, "VideoReceiverStats",
+                                     &AppendStatsObject<mrsVideoReceiverStats>,
+                                     &video_receiver_stats));
+  ASSERT_EQ(Result::kSuccess,
+            mrsStatsReportGetObjects(
+                result.report_, "TransportStats",
+                &AppendStatsObject<mrsTransportStats>, &transport_stats));
+
+  // Extract all objects at once
+  constexpr uint32_t kCapacity = 8;
+  mrsDataChannelStats snapshot_data_channel_stats[kCapacity]{};
+  mrsAudioSenderStats snapshot_audio_sender_stats[kCapacity]{};
+  mrsAudioReceiverStats snapshot_audio_receiver_stats[kCapacity]{};
+  mrsVideoSenderStats snapshot_video_sender_stats[kCapacity]{};
+  mrsVideoReceiverStats snapshot_video_receiver_stats[kCapacity]{};
+  mrsTransportStats snapshot_transport_stats[kCapacity]{};
+  mrsStatsSnapshot snapshot{};
+  snapshot.data_channel_stats = snapshot_data_channel_stats;
+  snapshot.data_channel_stats_capacity = kCapacity;
+  snapshot.audio_sender_stats = snapshot_audio_sender_stats;
+  snapshot.audio_sender_stats_capacity = kCapacity;
+  snapshot.audio_receiver_stats = snapshot_audio_receiver_stats;
+  snapshot.audio_receiver_stats_capacity = kCapacity;
+  snapshot.video_sender_stats = snapshot_video_sender_stats;
+  snapshot.video_sender_stats_capacity = kCapacity;
+  snapshot.video_receiver_stats = snapshot_video_receiver_stats;
+  snapshot.video_receiver_stats_capacity = kCapacity;
+  snapshot.transport_stats = snapshot_transport_stats;
+  snapshot.transport_stats_capacity = kCapacity;
+  ASSERT_EQ(Result::kSuccess,
+            mrsStatsReportGetSnapshot(result.report_, &snapshot));
+
+  // Both APIs report the same objects. No track was added, so there is no
+  // track without RTP stream which only the per-type enumeration reports.
+  ASSERT_EQ(1u, data_channel_stats.size());
+  ASSERT_EQ(data_channel_stats.size(), snapshot.data_channel_stats_count);
+  for (size_t i = 0; i < data_channel_stats.size(); ++i) {
+    ASSERT_EQ(data_channel_stats[i].data_channel_identifier,
+              snapshot_data_channel_stats[i].data_channel_identifier);
+    ASSERT_EQ(data_channel_stats[i].messages_sent,
+              snapshot_data_channel_stats[i].messages_sent);
+    ASSERT_EQ(data_channel_stats[i].bytes_sent,
+              snapshot_data_channel_stats[i].bytes_sent);
+    ASSERT_EQ(data_channel_stats[i].messages_received,
+              snapshot_data_channel_stats[i].messages_received);
+    ASSERT_EQ(data_channel_stats[i].bytes_received,
+              snapshot_data_channel_stats[i].bytes_received);
+  }
+  ASSERT_EQ(audio_sender_stats.size(), snapshot.audio_sender_stats_count);
+  ASSERT_EQ(audio_receiver_stats.size(), snapshot.audio_receiver_stats_count);
+  ASSERT_EQ(video_sender_stats.size(), snapshot.video_sender_stats_count);
+  ASSERT_EQ(video_receiver_stats.size(), snapshot.video_receiver_stats_count);
+  ASSERT_LT(0u, transport_stats.size());
+  ASSERT_EQ(transport_stats.size(), snapshot.transport_stats_count);
+  for (size_t i = 0; i < transport_stats.size(); ++i) {
+    ASSERT_EQ(transport_stats[i].bytes_sent,
+              snapshot_transport_stats[i].bytes_sent);
+    ASSERT_EQ(transport_stats[i].bytes_received,
+              snapshot_transport_stats[i].bytes_received);
+  }
+
+  ASSERT_EQ(Result::kSuccess, mrsStatsReportRemoveRef(result.report_));
+}
+
+TEST_P(PeerConnectionTests, StatsSnapshotMedia) {
+  mrsPeerConnectionConfiguration pc_config{};  // local connection only
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Send synthetic audio and video from #1 to #2
+  mrsTransceiverHandle audio_transceiver{};
+  mrsTransceiverHandle video_transceiver{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "audio_transceiver";
+    transceiver_config.media_kind = mrsMediaKind::kAudio;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &audio_transceiver));
+    transceiver_config.name = "video_transceiver";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &video_transceiver));
+  }
+  mrsLocalAudioTrackHandle audio_track{};
+  {
+    mrsSyntheticAudioTrackInitConfig config{};
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalAudioTrackCreateSynthetic(&config, "synthetic_audio",
+                                                &audio_track));
+  }
+  mrsLocalVideoTrackHandle video_track{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 320;
+    config.height = 240;
+    config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_video",
+                                                &video_track));
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalAudioTrack(audio_transceiver, audio_track));
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalVideoTrack(video_transceiver, video_track));
+
+  Event audio_added_ev;
+  AudioTrackAddedCallback audio_added_cb =
+      [&](const mrsRemoteAudioTrackAddedInfo*) { audio_added_ev.Set(); };
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                   CB(audio_added_cb));
+  Event video_added_ev;
+  VideoTrackAddedCallback video_added_cb =
+      [&](const mrsRemoteVideoTrackAddedInfo*) { video_added_ev.Set(); };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(video_added_cb));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  ASSERT_TRUE(audio_added_ev.WaitFor(5s));
+  ASSERT_TRUE(video_added_ev.WaitFor(5s));
+
+  // Let some media flow
+  {
+    Event ev;
+    ev.WaitFor(2s);
+  }
+
+  // #1 only has outbound streams, one per kind
+  {
+    StatsReportResult result;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionGetSimpleStats(
+                  pair.pc1(), &StaticStatsReportCallback, &result));
+    ASSERT_TRUE(result.ready_.WaitFor(5s));
+    ASSERT_NE(nullptr, result.report_);
+    MediaStatsSnapshot stats;
+    ASSERT_EQ(Result::kSuccess,
+              mrsStatsReportGetSnapshot(result.report_, &stats.snapshot));
+    ASSERT_EQ(1u, stats.snapshot.audio_sender_stats_count);
+    ASSERT_EQ(1u, stats.snapshot.video_sender_stats_count);
+    ASSERT_EQ(0u, stats.snapshot.audio_receiver_stats_count);
+    ASSERT_EQ(0u, stats.snapshot.video_receiver_stats_count);
+    const mrsAudioSenderStats& audio = stats.audio_sender_stats[0];
+    ASSERT_NE(nullptr, audio.track_identifier);
+    ASSERT_LT(0u, audio.packets_sent);
+    ASSERT_LT(0u, audio.bytes_sent);
+    const mrsVideoSenderStats& video = stats.video_sender_stats[0];
+    ASSERT_NE(nullptr, video.track_identifier);
+    ASSERT_LT(0u, video.packets_sent);
+    ASSERT_LT(0u, video.bytes_sent);
+    ASSERT_LT(0u, video.frames_encoded);
+
+    // The per-type enumeration reports the same senders
+    std::vector<mrsAudioSenderStats> audio_sender_stats;
+    ASSERT_EQ(Result::kSuccess,
+              mrsStatsReportGetObjects(
+                  result.report_, "AudioSenderStats",
+                  &AppendStatsObject<mrsAudioSenderStats>,
+                  &audio_sender_stats));
+    ASSERT_EQ(1u, audio_sender_stats.size());
+    ASSERT_EQ(audio.packets_sent, audio_sender_stats[0].packets_sent);
+    std::vector<mrsVideoSenderStats> video_sender_stats;
+    ASSERT_EQ(Result::kSuccess,
+              mrsStatsReportGetObjects(
+                  result.report_, "VideoSenderStats",
+                  &AppendStatsObject<mrsVideoSenderStats>,
+                  &video_sender_stats));
+    ASSERT_EQ(1u, video_sender_stats.size());
+    ASSERT_EQ(video.frames_encoded, video_sender_stats[0].frames_encoded);
+    ASSERT_EQ(Result::kSuccess, mrsStatsReportRemoveRef(result.report_));
+  }
+
+  // #2 only has inbound streams, one per kind
+  {
+    StatsReportResult result;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionGetSimpleStats(
+                  pair.pc2(), &StaticStatsReportCallback, &result));
+    ASSERT_TRUE(result.ready_.WaitFor(5s));
+    ASSERT_NE(nullptr, result.report_);
+    MediaStatsSnapshot stats;
+    ASSERT_EQ(Result::kSuccess,
+              mrsStatsReportGetSnapshot(result.report_, &stats.snapshot));
+    ASSERT_EQ(0u, stats.snapshot.audio_sender_stats_count);
+    ASSERT_EQ(0u, stats.snapshot.video_sender_stats_count);
+    ASSERT_EQ(1u, stats.snapshot.audio_receiver_stats_count);
+    ASSERT_EQ(1u, stats.snapshot.video_receiver_stats_count);
+    const mrsAudioReceiverStats& audio = stats.audio_receiver_stats[0];
+    ASSERT_NE(nullptr, audio.track_identifier);
+    ASSERT_LT(0u, audio.packets_received);
+    ASSERT_LT(0u, audio.bytes_received);
+    const mrsVideoReceiverStats& video = stats.video_receiver_stats[0];
+    ASSERT_NE(nullptr, video.track_identifier);
+    ASSERT_LT(0u, video.packets_received);
+    ASSERT_LT(0u, video.bytes_received);
+    ASSERT_LT(0u, video.frames_decoded);
+
+    std::vector<mrsAudioReceiverStats> audio_receiver_stats;
+    ASSERT_EQ(Result::kSuccess,
+              mrsStatsReportGetObjects(
+                  result.report_, "AudioReceiverStats",
+                  &AppendStatsObject<mrsAudioReceiverStats>,
+                  &audio_receiver_stats));
+    ASSERT_EQ(1u, audio_receiver_stats.size());
+    ASSERT_EQ(audio.packets_received,
+              audio_receiver_stats[0].packets_received);
+    std::vector<mrsVideoReceiverStats> video_receiver_stats;
+    ASSERT_EQ(Result::kSuccess,
+              mrsStatsReportGetObjects(
+                  result.report_, "VideoReceiverStats",
+                  &AppendStatsObject<mrsVideoReceiverStats>,
+                  &video_receiver_stats));
+    ASSERT_EQ(1u, video_receiver_stats.size());
+    ASSERT_EQ(video.frames_decoded, video_receiver_stats[0].frames_decoded);
+    ASSERT_EQ(Result::kSuccess, mrsStatsReportRemoveRef(result.report_));
+  }
+
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(), nullptr,
+                                                   nullptr);
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(), nullptr,
+                                                   nullptr);
+  mrsLocalAudioTrackRemoveRef(audio_track);
+  mrsLocalVideoTrackRemoveRef(video_track);
+}
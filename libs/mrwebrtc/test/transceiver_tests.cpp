@@ -3,6 +3,11 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <set>
+#include <string>
+#include <vector>
+
 #include "external_video_track_source_interop.h"
 #include "interop_api.h"
 #include "local_video_track_interop.h"
@@ -12,6 +17,31 @@
 #include "simple_interop.h"
 #include "video_test_utils.h"
 
+namespace {
+
+/// Get the names of the codecs of the first media line of the given kind
+/// ("audio" or "video") of an SDP message, from its "a=rtpmap" attributes.
+std::vector<std::string> GetSdpCodecNames(const std::string& sdp,
+                                          const char* media) {
+  std::vector<std::string> names;
+  const std::string media_line = std::string("m=") + media + " ";
+  size_t pos = sdp.find(media_line);
+  if (pos == std::string::npos) {
+    return names;
+  }
+  const size_t end = sdp.find("\nm=", pos);
+  const std::string rtpmap = "a=rtpmap:";
+  while ((pos = sdp.find(rtpmap, pos)) < end) {
+    const size_t name_begin = sdp.find(' ', pos) + 1;
+    const size_t name_end = sdp.find('/', name_begin);
+    names.push_back(sdp.substr(name_begin, name_end - name_begin));
+    pos = name_end;
+  }
+  return names;
+}
+
+}  // namespace
+
 // Named types for readability of auto-generated test names.
 struct AudioTest {};
 struct VideoTest {};
@@ -73,10 +103,18 @@ struct MediaTrait<AudioTest> {
     ASSERT_EQ(nullptr, remote_handle);
   }
 
-  static void Test_SetLocalTrack_InvalidHandle() {
+  static void Test_SetLocalTrack_InvalidHandle(
+      mrsTransceiverHandle transceiver_handle) {
     mrsLocalAudioTrackHandle dummy = (void*)0x1;  // looks legit
     ASSERT_EQ(Result::kInvalidNativeHandle,
               mrsTransceiverSetLocalAudioTrack(nullptr, dummy));
+    ASSERT_EQ(Result::kInvalidNativeHandle,
+              mrsTransceiverSetLocalAudioTrack((void*)0x1, nullptr));
+    // A stale track handle doesn't clear the track like a NULL handle does.
+    ASSERT_EQ(Result::kInvalidNativeHandle,
+              mrsTransceiverSetLocalAudioTrack(transceiver_handle, dummy));
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetLocalAudioTrack(transceiver_handle, nullptr));
   }
 };
 
@@ -95,10 +133,18 @@ struct MediaTrait<VideoTest> {
     ASSERT_EQ(nullptr, remote_handle);
   }
 
-  static void Test_SetLocalTrack_InvalidHandle() {
+  static void Test_SetLocalTrack_InvalidHandle(
+      mrsTransceiverHandle transceiver_handle) {
     mrsLocalVideoTrackHandle dummy = (void*)0x1;  // looks legit
     ASSERT_EQ(Result::kInvalidNativeHandle,
               mrsTransceiverSetLocalVideoTrack(nullptr, dummy));
+    ASSERT_EQ(Result::kInvalidNativeHandle,
+              mrsTransceiverSetLocalVideoTrack((void*)0x1, nullptr));
+    // A stale track handle doesn't clear the track like a NULL handle does.
+    ASSERT_EQ(Result::kInvalidNativeHandle,
+              mrsTransceiverSetLocalVideoTrack(transceiver_handle, dummy));
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetLocalVideoTrack(transceiver_handle, nullptr));
   }
 };
 
@@ -458,6 +504,56 @@ TYPED_TEST_P(TransceiverTests, SetDirection_InvalidHandle) {
       mrsTransceiverSetDirection(nullptr, mrsTransceiverDirection::kRecvOnly));
 }
 
+TYPED_TEST_P(TransceiverTests, SetCodecPreferences) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  LocalPeerPairRaii pair(pc_config);
+  mrsTransceiverHandle transceiver_handle1{};
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = TypeParam::kMediaKind;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &transceiver_handle1));
+  ASSERT_NE(nullptr, transceiver_handle1);
+
+  // Invalid codec names are rejected
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetCodecPreferences(transceiver_handle1,
+                                              "invalid name with space"));
+
+  // Unknown codecs are ignored, and the preferences can be reset
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetCodecPreferences(
+                                  transceiver_handle1, "unknown-codec"));
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetCodecPreferences(transceiver_handle1, nullptr));
+
+  // Negotiation succeeds with a single codec
+  const char* const codec_names =
+      (TypeParam::kMediaKind == mrsMediaKind::kAudio ? "opus" : "VP8");
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetCodecPreferences(
+                                  transceiver_handle1, codec_names));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(60s));
+
+  // Only the preferred codec and its retransmission codec are offered, and
+  // therefore negotiated in the answer.
+  const char* const media =
+      (TypeParam::kMediaKind == mrsMediaKind::kAudio ? "audio" : "video");
+  for (const std::string& sdp : {pair.offer_sdp(), pair.answer_sdp()}) {
+    const std::vector<std::string> names = GetSdpCodecNames(sdp, media);
+    ASSERT_FALSE(names.empty());
+    ASSERT_EQ(codec_names, names[0]);
+    for (auto&& name : names) {
+      ASSERT_TRUE((name == codec_names) || (name == "rtx")) << name;
+    }
+  }
+}
+
+TYPED_TEST_P(TransceiverTests, SetCodecPreferences_InvalidHandle) {
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverSetCodecPreferences(nullptr, "VP8"));
+}
+
 TYPED_TEST_P(TransceiverTests, SetLocalTrackSendRecv) {
   const mrsSdpSemantic sdp_semantic = TypeParam::kSdpSemantic;
   Test_SetLocalTrack(sdp_semantic, mrsTransceiverDirection::kSendRecv,
@@ -471,7 +567,18 @@ TYPED_TEST_P(TransceiverTests, SetLocalTrackRecvOnly) {
 }
 
 TYPED_TEST_P(TransceiverTests, SetLocalTrack_InvalidHandle) {
-  MediaTrait<TypeParam::MediaType>::Test_SetLocalTrack_InvalidHandle();
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  PCRaii pc(pc_config);
+  ASSERT_NE(nullptr, pc.handle());
+  mrsTransceiverHandle transceiver_handle{};
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = TypeParam::kMediaKind;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                            &transceiver_handle));
+  MediaTrait<TypeParam::MediaType>::Test_SetLocalTrack_InvalidHandle(
+      transceiver_handle);
 }
 
 TYPED_TEST_P(TransceiverTests, UserData) {
@@ -549,16 +656,288 @@ TYPED_TEST_P(TransceiverTests, StreamIDs) {
   pair.WaitExchangeCompletedFor(60s);
 }
 
+TYPED_TEST_P(TransceiverTests, ManyTransceivers) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  LocalPeerPairRaii pair(pc_config);
+
+  constexpr int kTransceiverCount = 32;
+
+  // Count the transceivers created on the remote peer (#2) while applying the
+  // offer. Callbacks are invoked on the signaling thread only.
+  std::set<mrsTransceiverHandle> remote_handles;
+  InteropCallback<const mrsTransceiverAddedInfo*> transceiver_added2_cb =
+      [&](const mrsTransceiverAddedInfo* info) {
+        ASSERT_EQ(TypeParam::kMediaKind, info->media_kind);
+        ASSERT_TRUE(remote_handles.insert(info->transceiver_handle).second);
+      };
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(),
+                                                    CB(transceiver_added2_cb));
+
+  // Add many transceivers to the local peer (#1)
+  for (int i = 0; i < kTransceiverCount; ++i) {
+    std::string name = "transceiver_" + std::to_string(i);
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = name.c_str();
+    transceiver_config.media_kind = TypeParam::kMediaKind;
+    transceiver_config.desired_direction = mrsTransceiverDirection::kRecvOnly;
+    mrsTransceiverHandle handle{};
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &handle));
+    ASSERT_NE(nullptr, handle);
+  }
+
+  // Connect #1 and #2
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(60s));
+
+  // In Unified Plan each media line maps to a distinct remote transceiver.
+  // Plan B only creates remote transceivers for received tracks, and none are
+  // sent here.
+  if (TypeParam::kSdpSemantic == mrsSdpSemantic::kUnifiedPlan) {
+    ASSERT_EQ((size_t)kTransceiverCount, remote_handles.size());
+  }
+
+  // Renegotiating must reuse the existing transceivers on both peers
+  const size_t remote_count = remote_handles.size();
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(60s));
+  ASSERT_EQ(remote_count, remote_handles.size());
+
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(), nullptr,
+                                                    nullptr);
+}
+
+TYPED_TEST_P(TransceiverTests, AddTransceivers) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  LocalPeerPairRaii pair(pc_config);
+
+  constexpr int kTransceiverCount = 16;
+
+  // Count events on the local peer (#1)
+  std::atomic<int> renegotiation_needed_count{0};
+  InteropCallback<> renegotiation_needed1_cb = [&]() {
+    ++renegotiation_needed_count;
+  };
+  mrsPeerConnectionRegisterRenegotiationNeededCallback(
+      pair.pc1(), CB(renegotiation_needed1_cb));
+  std::atomic<int> transceiver_added_count{0};
+  InteropCallback<const mrsTransceiverAddedInfo*> transceiver_added1_cb =
+      [&](const mrsTransceiverAddedInfo* info) {
+        ASSERT_EQ(TypeParam::kMediaKind, info->media_kind);
+        ++transceiver_added_count;
+      };
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc1(),
+                                                    CB(transceiver_added1_cb));
+
+  std::vector<std::string> names(kTransceiverCount);
+  std::vector<mrsTransceiverInitConfig> configs(kTransceiverCount);
+  for (int i = 0; i < kTransceiverCount; ++i) {
+    names[i] = "transceiver_" + std::to_string(i);
+    configs[i].name = names[i].c_str();
+    configs[i].media_kind = TypeParam::kMediaKind;
+    configs[i].desired_direction = mrsTransceiverDirection::kRecvOnly;
+  }
+  std::vector<mrsTransceiverHandle> handles(kTransceiverCount);
+
+  // Invalid parameters
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddTransceivers(pair.pc1(), nullptr,
+                                             kTransceiverCount,
+                                             handles.data()));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddTransceivers(pair.pc1(), configs.data(),
+                                             kTransceiverCount, nullptr));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionAddTransceivers(nullptr, configs.data(),
+                                             kTransceiverCount,
+                                             handles.data()));
+
+  // An invalid name anywhere in the batch fails the entire batch
+  {
+    std::vector<mrsTransceiverInitConfig> bad_configs = configs;
+    bad_configs[kTransceiverCount / 2].name = "invalid name";
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceivers(pair.pc1(), bad_configs.data(),
+                                               kTransceiverCount,
+                                               handles.data()));
+    for (mrsTransceiverHandle handle : handles) {
+      ASSERT_EQ(nullptr, handle);
+    }
+    ASSERT_EQ(0, transceiver_added_count.load());
+    ASSERT_EQ(0, renegotiation_needed_count.load());
+  }
+
+  // Add the batch; a single renegotiation is needed
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceivers(pair.pc1(), configs.data(),
+                                             kTransceiverCount,
+                                             handles.data()));
+  for (mrsTransceiverHandle handle : handles) {
+    ASSERT_NE(nullptr, handle);
+  }
+  ASSERT_EQ(kTransceiverCount, transceiver_added_count.load());
+  ASSERT_EQ(1, renegotiation_needed_count.load());
+
+  // Connect #1 and #2
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(60s));
+
+  mrsPeerConnectionRegisterRenegotiationNeededCallback(pair.pc1(), nullptr,
+                                                       nullptr);
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc1(), nullptr,
+                                                    nullptr);
+}
+
+TYPED_TEST_P(TransceiverTests, SendEncodings) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = TypeParam::kMediaKind;
+  mrsTransceiverHandle handle{};
+
+  // Invalid scale-down factor
+  {
+    mrsSendEncodingParameters encoding{};
+    encoding.scale_resolution_down_by = 0.5;
+    transceiver_config.send_encodings = &encoding;
+    transceiver_config.send_encoding_count = 1;
+    ASSERT_EQ(Result::kOutOfRange,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &handle));
+    ASSERT_EQ(nullptr, handle);
+  }
+
+  // Multiple encodings need unique RIDs, and are only supported for video
+  {
+    mrsSendEncodingParameters encodings[2]{};
+    transceiver_config.send_encodings = encodings;
+    transceiver_config.send_encoding_count = 2;
+    const Result missing_rid_result =
+        (TypeParam::kMediaKind == mrsMediaKind::kVideo
+             ? Result::kInvalidParameter
+             : Result::kInvalidMediaKind);
+    ASSERT_EQ(missing_rid_result,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &handle));
+    encodings[0].rid = "h";
+    encodings[1].rid = "h";
+    ASSERT_EQ(missing_rid_result,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &handle));
+    encodings[1].rid = "l";
+    encodings[1].scale_resolution_down_by = 2.0;
+    if (TypeParam::kMediaKind == mrsMediaKind::kAudio) {
+      ASSERT_EQ(Result::kInvalidMediaKind,
+                mrsPeerConnectionAddTransceiver(
+                    pair.pc1(), &transceiver_config, &handle));
+    } else if (TypeParam::kSdpSemantic == mrsSdpSemantic::kPlanB) {
+      ASSERT_EQ(Result::kUnsupported,
+                mrsPeerConnectionAddTransceiver(
+                    pair.pc1(), &transceiver_config, &handle));
+    }
+    ASSERT_EQ(nullptr, handle);
+  }
+
+  // Simulcast with valid RIDs, for video with Unified Plan only
+  mrsTransceiverHandle simulcast_handle{};
+  if ((TypeParam::kMediaKind == mrsMediaKind::kVideo) &&
+      (TypeParam::kSdpSemantic == mrsSdpSemantic::kUnifiedPlan)) {
+    mrsSendEncodingParameters encodings[3]{};
+    encodings[0].rid = "h";
+    encodings[0].max_bitrate_bps = 1000000;
+    encodings[1].rid = "m";
+    encodings[1].scale_resolution_down_by = 2.0;
+    encodings[1].max_bitrate_bps = 300000;
+    encodings[2].rid = "l";
+    encodings[2].scale_resolution_down_by = 4.0;
+    encodings[2].max_bitrate_bps = 100000;
+    transceiver_config.send_encodings = encodings;
+    transceiver_config.send_encoding_count = 3;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &simulcast_handle));
+    ASSERT_NE(nullptr, simulcast_handle);
+  }
+
+  // Single encoding
+  {
+    mrsSendEncodingParameters encoding{};
+    encoding.max_bitrate_bps = 500000;
+    encoding.max_framerate = 15;
+    transceiver_config.send_encodings = &encoding;
+    transceiver_config.send_encoding_count = 1;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &handle));
+    ASSERT_NE(nullptr, handle);
+  }
+
+  // Runtime changes
+  {
+    mrsSendEncodingParameters encoding{};
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsTransceiverSetSendEncodings(handle, nullptr, 1));
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsTransceiverSetSendEncodings(handle, &encoding, 0));
+    ASSERT_EQ(Result::kInvalidNativeHandle,
+              mrsTransceiverSetSendEncodings(nullptr, &encoding, 1));
+    encoding.scale_resolution_down_by = 0.5;
+    ASSERT_EQ(Result::kOutOfRange,
+              mrsTransceiverSetSendEncodings(handle, &encoding, 1));
+  }
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(60s));
+
+  // Runtime changes on the negotiated senders
+  {
+    mrsSendEncodingParameters encoding{};
+    encoding.max_bitrate_bps = 250000;
+    encoding.max_framerate = 10;
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetSendEncodings(handle, &encoding, 1));
+  }
+  if (simulcast_handle) {
+    mrsSendEncodingParameters encodings[3]{};
+    encodings[0].rid = "h";
+    encodings[0].max_bitrate_bps = 800000;
+    encodings[1].scale_resolution_down_by = 2.0;  // RID can be omitted
+    encodings[1].max_bitrate_bps = 250000;
+    encodings[2].rid = "l";
+    encodings[2].scale_resolution_down_by = 4.0;
+    encodings[2].active = mrsBool::kFalse;
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetSendEncodings(simulcast_handle, encodings, 3));
+
+    // The number of encodings and their RID cannot change
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsTransceiverSetSendEncodings(simulcast_handle, encodings, 2));
+    encodings[2].rid = "x";
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsTransceiverSetSendEncodings(simulcast_handle, encodings, 3));
+  }
+}
+
 // Note: All tests must be listed in this macro
 REGISTER_TYPED_TEST_CASE_P(TransceiverTests,
                            InvalidName,
                            SetDirection,
                            SetDirection_InvalidHandle,
+                           SetCodecPreferences,
+                           SetCodecPreferences_InvalidHandle,
                            SetLocalTrack_InvalidHandle,
                            SetLocalTrackSendRecv,
                            SetLocalTrackRecvOnly,
                            UserData,
-                           StreamIDs);
+                           StreamIDs,
+                           ManyTransceivers,
+                           AddTransceivers,
+                           SendEncodings);
 
 using TestTypes = ::testing::Types<TestParams<AudioTest, SdpPlanB>,
                                    TestParams<AudioTest, SdpUnifiedPlan>,
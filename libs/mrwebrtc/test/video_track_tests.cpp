@@ -3,11 +3,19 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+#include "encoded_frame_recorder_interop.h"
+#include "encoded_video_track_source_interop.h"
+#include "external_video_codec_interop.h"
 #include "external_video_track_source_interop.h"
 #include "interop_api.h"
 #include "local_video_track_interop.h"
 #include "remote_video_track_interop.h"
 #include "transceiver_interop.h"
+#include "video_encoder_threading_interop.h"
 
 #include "simple_interop.h"
 #include "test_utils.h"
@@ -25,6 +33,158 @@ using VideoTrackAddedCallback =
 // PeerConnectionI420VideoFrameCallback
 using I420VideoFrameCallback = InteropCallback<const I420AVideoFrame&>;
 
+// mrsArgb32VideoFrameCallback
+using Argb32VideoFrameCallback = InteropCallback<const mrsArgb32VideoFrame&>;
+
+/// Luma value of the frames produced by the fake external decoder.
+constexpr uint8_t kFakeCodecLuma = 42;
+
+/// Calls to the fake external VP8 encoder and decoder.
+struct FakeCodecStats {
+  std::atomic<uint32_t> instance_count{0};
+  std::atomic<uint32_t> encode_count{0};
+  std::atomic<uint32_t> decode_count{0};
+  std::atomic<uint32_t> key_frame_count{0};
+
+  /// Number of encoder instances which encoded at least one frame.
+  std::atomic<uint32_t> encoding_instance_count{0};
+
+  /// Number of cores the last initialized encoder was allowed to use.
+  std::atomic<uint32_t> encoder_cores{0};
+};
+
+/// Fake external codec instance.
+struct FakeCodec {
+  FakeCodecStats* stats{nullptr};
+  uint32_t width{0};
+  uint32_t height{0};
+  bool key_frame_sent{false};
+  bool has_encoded{false};
+};
+
+mrsExternalVideoCodecInstance MRS_CALL FakeCodecCreate(void* user_data) {
+  auto stats = static_cast<FakeCodecStats*>(user_data);
+  ++stats->instance_count;
+  auto codec = new FakeCodec();
+  codec->stats = stats;
+  return codec;
+}
+
+void MRS_CALL FakeCodecDestroy(void* /*user_data*/,
+                               mrsExternalVideoCodecInstance instance) {
+  auto codec = static_cast<FakeCodec*>(instance);
+  --codec->stats->instance_count;
+  delete codec;
+}
+
+mrsResult MRS_CALL
+FakeEncoderInit(void* /*user_data*/,
+                mrsExternalVideoCodecInstance instance,
+                const mrsExternalVideoEncoderSettings* settings) {
+  auto codec = static_cast<FakeCodec*>(instance);
+  codec->width = settings->width;
+  codec->height = settings->height;
+  codec->key_frame_sent = false;
+  codec->stats->encoder_cores = settings->number_of_cores;
+  return Result::kSuccess;
+}
+
+/// Emit the smallest payload the VP8 RTP depacketizer accepts: the 3-byte
+/// frame tag, followed for key frames by the start code and frame size, and a
+/// single byte of "data".
+mrsResult MRS_CALL
+FakeEncoderEncode(void* /*user_data*/,
+                  mrsExternalVideoCodecInstance instance,
+                  const mrsI420AVideoFrame* frame,
+                  mrsBool force_key_frame,
+                  mrsExternalVideoEncoderOutputCallback output,
+                  void* output_context) {
+  auto codec = static_cast<FakeCodec*>(instance);
+  ++codec->stats->encode_count;
+  if (!codec->has_encoded) {
+    codec->has_encoded = true;
+    ++codec->stats->encoding_instance_count;
+  }
+  const bool key_frame =
+      (force_key_frame == mrsBool::kTrue) || !codec->key_frame_sent;
+  codec->key_frame_sent = true;
+  std::vector<uint8_t> data;
+  if (key_frame) {
+    ++codec->stats->key_frame_count;
+    data = {0x00,
+            0x00,
+            0x00,
+            0x9d,
+            0x01,
+            0x2a,
+            static_cast<uint8_t>(frame->width_ & 0xFF),
+            static_cast<uint8_t>(frame->width_ >> 8),
+            static_cast<uint8_t>(frame->height_ & 0xFF),
+            static_cast<uint8_t>(frame->height_ >> 8)};
+  } else {
+    data = {0x01, 0x00, 0x00};
+  }
+  data.push_back(kFakeCodecLuma);
+  mrsEncodedVideoFrame encoded{};
+  encoded.data = data.data();
+  encoded.size = static_cast<uint32_t>(data.size());
+  encoded.width = frame->width_;
+  encoded.height = frame->height_;
+  encoded.is_key_frame = (key_frame ? mrsBool::kTrue : mrsBool::kFalse);
+  return output(output_context, &encoded);
+}
+
+mrsResult MRS_CALL
+FakeEncoderSetRates(void* /*user_data*/,
+                    mrsExternalVideoCodecInstance /*instance*/,
+                    uint32_t /*bitrate_kbps*/,
+                    uint32_t /*framerate*/) {
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+FakeDecoderInit(void* /*user_data*/,
+                mrsExternalVideoCodecInstance instance,
+                const mrsExternalVideoDecoderSettings* /*settings*/) {
+  auto codec = static_cast<FakeCodec*>(instance);
+  codec->width = 0;
+  codec->height = 0;
+  return Result::kSuccess;
+}
+
+/// Decode the payload of |FakeEncoderEncode()| into a uniform frame.
+mrsResult MRS_CALL
+FakeDecoderDecode(void* /*user_data*/,
+                  mrsExternalVideoCodecInstance instance,
+                  const mrsEncodedVideoFrame* frame,
+                  mrsExternalVideoDecoderOutputCallback output,
+                  void* output_context) {
+  auto codec = static_cast<FakeCodec*>(instance);
+  ++codec->stats->decode_count;
+  if ((frame->size >= 11) && ((frame->data[0] & 0x01) == 0)) {
+    codec->width = frame->data[6] | (frame->data[7] << 8);
+    codec->height = frame->data[8] | (frame->data[9] << 8);
+  }
+  if ((codec->width == 0) || (codec->height == 0)) {
+    return Result::kInvalidOperation;  // no key frame yet
+  }
+  const uint8_t luma = frame->data[frame->size - 1];
+  const uint32_t chroma_width = (codec->width + 1) / 2;
+  const uint32_t chroma_height = (codec->height + 1) / 2;
+  std::vector<uint8_t> ydata(codec->width * codec->height, luma);
+  std::vector<uint8_t> uvdata(chroma_width * chroma_height, 128);
+  mrsI420AVideoFrame decoded{};
+  decoded.width_ = codec->width;
+  decoded.height_ = codec->height;
+  decoded.ydata_ = ydata.data();
+  decoded.udata_ = uvdata.data();
+  decoded.vdata_ = uvdata.data();
+  decoded.ystride_ = codec->width;
+  decoded.ustride_ = chroma_width;
+  decoded.vstride_ = chroma_width;
+  return output(output_context, &decoded);
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_CASE_P(,
@@ -553,3 +713,1371 @@ TEST_P(VideoTrackTests, ExternalI420) {
   mrsExternalVideoTrackSourceShutdown(source_handle1);
   mrsExternalVideoTrackSourceRemoveRef(source_handle1);
 }
+
+TEST_F(VideoTrackTests, SyntheticInvalidConfig) {
+  mrsLocalVideoTrackHandle track_handle{};
+  mrsSyntheticVideoTrackInitConfig config{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackCreateSynthetic(nullptr, "synth", &track_handle));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackCreateSynthetic(&config, "synth", nullptr));
+  {
+    mrsSyntheticVideoTrackInitConfig bad_config = config;
+    bad_config.width = 641;
+    ASSERT_EQ(Result::kOutOfRange, mrsLocalVideoTrackCreateSynthetic(
+                                       &bad_config, "synth", &track_handle));
+  }
+  {
+    mrsSyntheticVideoTrackInitConfig bad_config = config;
+    bad_config.framerate = 0.0;
+    ASSERT_EQ(Result::kOutOfRange, mrsLocalVideoTrackCreateSynthetic(
+                                       &bad_config, "synth", &track_handle));
+  }
+  {
+    mrsSyntheticVideoTrackInitConfig bad_config = config;
+    bad_config.pattern = (mrsSyntheticVideoPattern)42;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsLocalVideoTrackCreateSynthetic(&bad_config, "synth",
+                                                &track_handle));
+  }
+  ASSERT_EQ(nullptr, track_handle);
+}
+
+TEST_P(VideoTrackTests, Synthetic) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Grab the handle of the remote track from the remote peer (#2) via the
+  // VideoTrackAdded callback.
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  // Create the video transceiver #1
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+    ASSERT_NE(nullptr, transceiver_handle1);
+  }
+
+  // Create the synthetic local video track (#1), which owns its source
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 320;
+    config.height = 240;
+    config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_track",
+                                                &track_handle1));
+    ASSERT_NE(nullptr, track_handle1);
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  // Connect #1 and #2
+  pair.ConnectAndWait();
+
+  // Wait for remote track to be added on #2
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  // Register a frame callback for the remote video of #2, and check that the
+  // marker survives the encoding, with increasing frame numbers.
+  uint32_t frame_count = 0;
+  uint32_t marker_count = 0;
+  uint32_t last_frame_number = 0;
+  bool out_of_order = false;
+  I420VideoFrameCallback i420cb = [&](const I420AVideoFrame& frame) {
+    ++frame_count;
+    mrsSyntheticVideoFrameMarker marker{};
+    if (mrsSyntheticVideoFrameReadMarker(&frame, &marker) ==
+        Result::kSuccess) {
+      if ((marker_count > 0) && (marker.frame_number <= last_frame_number)) {
+        out_of_order = true;
+      }
+      last_frame_number = marker.frame_number;
+      ++marker_count;
+    }
+  };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, CB(i420cb));
+
+  Event ev;
+  ev.WaitFor(3s);
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, nullptr,
+                                                nullptr);
+  ASSERT_LT(30u, frame_count) << "Expected at least 10 FPS";
+  // Allow a few frames at the start of the stream to be too blurry to decode
+  ASSERT_LT(frame_count / 2, marker_count);
+  ASSERT_FALSE(out_of_order);
+
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  mrsLocalVideoTrackRemoveRef(track_handle1);
+}
+
+TEST_P(VideoTrackTests, SendEncodings) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+    ASSERT_NE(nullptr, transceiver_handle1);
+  }
+
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 320;
+    config.height = 240;
+    config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_track",
+                                                &track_handle1));
+    ASSERT_NE(nullptr, track_handle1);
+  }
+
+  // Invalid parameters
+  mrsSendEncodingParameters encoding{};
+  uint32_t count = 0;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackGetSendEncodings(nullptr, nullptr, &count));
+  ASSERT_EQ(
+      Result::kInvalidParameter,
+      mrsLocalVideoTrackGetSendEncodings(track_handle1, nullptr, nullptr));
+  count = 1;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackGetSendEncodings(track_handle1, nullptr, &count));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackSetSendEncoding(nullptr, 0, &encoding));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackSetSendEncoding(track_handle1, 0, nullptr));
+
+  // Not attached to any transceiver
+  count = 0;
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsLocalVideoTrackGetSendEncodings(track_handle1, nullptr, &count));
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsLocalVideoTrackSetSendEncoding(track_handle1, 0, &encoding));
+
+  // The degradation preference does not depend on any sender
+  mrsDegradationPreference preference{};
+  ASSERT_EQ(Result::kSuccess, mrsLocalVideoTrackGetDegradationPreference(
+                                  track_handle1, &preference));
+  ASSERT_EQ(mrsDegradationPreference::kDefault, preference);
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackSetDegradationPreference(
+                track_handle1, (mrsDegradationPreference)42));
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetDegradationPreference(
+                track_handle1, mrsDegradationPreference::kMaintainResolution));
+  ASSERT_EQ(Result::kSuccess, mrsLocalVideoTrackGetDegradationPreference(
+                                  track_handle1, &preference));
+  ASSERT_EQ(mrsDegradationPreference::kMaintainResolution, preference);
+
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+  pair.ConnectAndWait();
+
+  // Query the number of encodings of the negotiated sender
+  count = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackGetSendEncodings(track_handle1, nullptr, &count));
+  ASSERT_EQ(1u, count);
+
+  // Change the encoding on the live sender, and read it back
+  encoding.scale_resolution_down_by = 2.0;
+  encoding.max_bitrate_bps = 200000;
+  encoding.max_framerate = 15;
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetSendEncoding(track_handle1, 0, &encoding));
+  {
+    mrsSendEncodingParameters encodings[2]{};
+    count = 2;
+    ASSERT_EQ(Result::kSuccess, mrsLocalVideoTrackGetSendEncodings(
+                                    track_handle1, encodings, &count));
+    ASSERT_EQ(1u, count);
+    ASSERT_EQ(nullptr, encodings[0].rid);
+    ASSERT_EQ(2.0, encodings[0].scale_resolution_down_by);
+    ASSERT_EQ(200000u, encodings[0].max_bitrate_bps);
+    ASSERT_EQ(15u, encodings[0].max_framerate);
+    ASSERT_EQ(mrsBool::kTrue, encodings[0].active);
+  }
+
+  // Invalid runtime changes
+  ASSERT_EQ(Result::kOutOfRange,
+            mrsLocalVideoTrackSetSendEncoding(track_handle1, 1, &encoding));
+  encoding.scale_resolution_down_by = 0.5;
+  ASSERT_EQ(Result::kOutOfRange,
+            mrsLocalVideoTrackSetSendEncoding(track_handle1, 0, &encoding));
+
+  mrsLocalVideoTrackRemoveRef(track_handle1);
+}
+
+TEST_P(VideoTrackTests, EncodedFrameTap) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverRegisterEncodedFrameCallback(nullptr, nullptr,
+                                                       nullptr));
+
+  // Frames are delivered sequentially for each transceiver, and the callbacks
+  // are unregistered before the counters are read.
+  uint32_t sent_count = 0;
+  uint32_t sent_key_count = 0;
+  bool sent_invalid = false;
+  InteropCallback<const mrsEncodedFrameInfo*> sent_cb =
+      [&](const mrsEncodedFrameInfo* frame) {
+        if ((frame->direction != mrsEncodedFrameDirection::kSend) ||
+            (frame->media_kind != mrsMediaKind::kVideo) ||
+            (frame->ssrc == 0) || !frame->data || (frame->size == 0)) {
+          sent_invalid = true;
+        }
+        if ((sent_count == 0) &&
+            (frame->frame_type != mrsEncodedFrameType::kKey)) {
+          sent_invalid = true;  // stream must start with a key frame
+        }
+        if (frame->frame_type == mrsEncodedFrameType::kKey) {
+          ++sent_key_count;
+        }
+        ++sent_count;
+      };
+  uint32_t received_count = 0;
+  uint32_t received_key_count = 0;
+  bool received_invalid = false;
+  InteropCallback<const mrsEncodedFrameInfo*> received_cb =
+      [&](const mrsEncodedFrameInfo* frame) {
+        if ((frame->direction != mrsEncodedFrameDirection::kReceive) ||
+            (frame->media_kind != mrsMediaKind::kVideo) || !frame->data ||
+            (frame->size == 0)) {
+          received_invalid = true;
+        }
+        if (frame->frame_type == mrsEncodedFrameType::kKey) {
+          ++received_key_count;
+        }
+        ++received_count;
+      };
+
+  // Tap the transceiver of #2 as soon as it is created, before it is
+  // negotiated.
+  mrsTransceiverHandle transceiver_handle2{};
+  InteropCallback<const mrsTransceiverAddedInfo*> transceiver_added2_cb =
+      [&](const mrsTransceiverAddedInfo* info) {
+        transceiver_handle2 = info->transceiver_handle;
+        ASSERT_EQ(Result::kSuccess,
+                  mrsTransceiverRegisterEncodedFrameCallback(
+                      transceiver_handle2, CB(received_cb)));
+      };
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(),
+                                                    CB(transceiver_added2_cb));
+
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+    ASSERT_NE(nullptr, transceiver_handle1);
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverRegisterEncodedFrameCallback(
+                                  transceiver_handle1, CB(sent_cb)));
+
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 320;
+    config.height = 240;
+    config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_track",
+                                                &track_handle1));
+    ASSERT_NE(nullptr, track_handle1);
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_NE(nullptr, transceiver_handle2);
+
+  Event ev;
+  ev.WaitFor(3s);
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverRegisterEncodedFrameCallback(
+                                  transceiver_handle1, nullptr, nullptr));
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverRegisterEncodedFrameCallback(
+                                  transceiver_handle2, nullptr, nullptr));
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(), nullptr,
+                                                    nullptr);
+
+  ASSERT_LT(30u, sent_count) << "Expected at least 10 FPS";
+  ASSERT_LT(0u, sent_key_count);
+  ASSERT_FALSE(sent_invalid);
+  ASSERT_LT(0u, received_count);
+  ASSERT_LT(0u, received_key_count);
+  ASSERT_FALSE(received_invalid);
+
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  mrsLocalVideoTrackRemoveRef(track_handle1);
+}
+
+TEST_F(VideoTrackTests, EncodedSourceInvalid) {
+  mrsEncodedVideoTrackSourceHandle source_handle{};
+  mrsEncodedVideoTrackSourceInitConfig config{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsEncodedVideoTrackSourceCreate(nullptr, &source_handle));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsEncodedVideoTrackSourceCreate(&config, nullptr));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsEncodedVideoTrackSourceCreate(&config, &source_handle));
+  config.codec_name = "AV1";
+  ASSERT_EQ(Result::kUnsupported,
+            mrsEncodedVideoTrackSourceCreate(&config, &source_handle));
+  ASSERT_EQ(nullptr, source_handle);
+
+  config.codec_name = "VP8";
+  ASSERT_EQ(Result::kSuccess,
+            mrsEncodedVideoTrackSourceCreate(&config, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  const uint8_t data[16]{};
+  mrsEncodedVideoFrame frame{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsEncodedVideoTrackSourcePushFrame(nullptr, &frame));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsEncodedVideoTrackSourcePushFrame(source_handle, nullptr));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsEncodedVideoTrackSourcePushFrame(source_handle, &frame));
+  frame.data = data;
+  frame.size = sizeof(data);
+  ASSERT_EQ(Result::kOutOfRange,
+            mrsEncodedVideoTrackSourcePushFrame(source_handle, &frame));
+  frame.width = 320;
+  frame.height = 240;
+  // The first frame must be a key frame
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsEncodedVideoTrackSourcePushFrame(source_handle, &frame));
+
+  mrsLocalVideoTrackHandle track_handle{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsLocalVideoTrackCreateFromEncodedSource(nullptr, "track",
+                                                      &track_handle));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackCreateFromEncodedSource(source_handle, nullptr,
+                                                      &track_handle));
+  ASSERT_EQ(Result::kSuccess, mrsLocalVideoTrackCreateFromEncodedSource(
+                                  source_handle, "track", &track_handle));
+  ASSERT_NE(nullptr, track_handle);
+
+  mrsLocalVideoTrackRemoveRef(track_handle);
+  mrsEncodedVideoTrackSourceRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, EncodedSourceRelay) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+
+  // Relay pair, sending the encoded frames of the source without re-encoding
+  // them, and decoding them on the remote peer.
+  LocalPeerPairRaii relay_pair(pc_config);
+  mrsEncodedVideoTrackSourceHandle source_handle{};
+  {
+    mrsEncodedVideoTrackSourceInitConfig config{};
+    config.codec_name = "VP8";
+    ASSERT_EQ(Result::kSuccess,
+              mrsEncodedVideoTrackSourceCreate(&config, &source_handle));
+  }
+  mrsLocalVideoTrackHandle relay_track_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackCreateFromEncodedSource(
+                source_handle, "relay_track", &relay_track_handle));
+  mrsTransceiverHandle relay_transceiver_handle{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "relay_transceiver";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddTransceiver(
+                                    relay_pair.pc1(), &transceiver_config,
+                                    &relay_transceiver_handle));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetCodecPreferences(
+                                  relay_transceiver_handle, "VP8"));
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalVideoTrack(relay_transceiver_handle,
+                                             relay_track_handle));
+  mrsRemoteVideoTrackHandle remote_track_handle{};
+  Event track_added_ev;
+  VideoTrackAddedCallback track_added_cb =
+      [&](const mrsRemoteVideoTrackAddedInfo* info) {
+        remote_track_handle = info->track_handle;
+        track_added_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(relay_pair.pc2(),
+                                                   CB(track_added_cb));
+  relay_pair.ConnectAndWait();
+  ASSERT_TRUE(track_added_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, remote_track_handle);
+
+  uint32_t marker_count = 0;
+  I420VideoFrameCallback i420cb = [&](const I420AVideoFrame& frame) {
+    mrsSyntheticVideoFrameMarker marker{};
+    if (mrsSyntheticVideoFrameReadMarker(&frame, &marker) ==
+        Result::kSuccess) {
+      ++marker_count;
+    }
+  };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(remote_track_handle,
+                                                CB(i420cb));
+
+  // Source pair, whose encoded frames are captured and pushed into the relay
+  // source. Frames are only pushed once the relay is connected, so the first
+  // frame is a key frame.
+  LocalPeerPairRaii source_pair(pc_config);
+  constexpr uint32_t kWidth = 320;
+  constexpr uint32_t kHeight = 240;
+  std::atomic<uint32_t> push_error_count{0};
+  InteropCallback<const mrsEncodedFrameInfo*> sent_cb =
+      [&](const mrsEncodedFrameInfo* info) {
+        mrsEncodedVideoFrame frame{};
+        frame.data = info->data;
+        frame.size = info->size;
+        frame.width = kWidth;
+        frame.height = kHeight;
+        frame.is_key_frame =
+            (info->frame_type == mrsEncodedFrameType::kKey ? mrsBool::kTrue
+                                                           : mrsBool::kFalse);
+        if (mrsEncodedVideoTrackSourcePushFrame(source_handle, &frame) !=
+            Result::kSuccess) {
+          ++push_error_count;
+        }
+      };
+  mrsTransceiverHandle source_transceiver_handle{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "source_transceiver";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddTransceiver(
+                                    source_pair.pc1(), &transceiver_config,
+                                    &source_transceiver_handle));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetCodecPreferences(
+                                  source_transceiver_handle, "VP8"));
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverRegisterEncodedFrameCallback(
+                                  source_transceiver_handle, CB(sent_cb)));
+  mrsLocalVideoTrackHandle source_track_handle{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = kWidth;
+    config.height = kHeight;
+    config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(&config, "source_track",
+                                                &source_track_handle));
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalVideoTrack(source_transceiver_handle,
+                                             source_track_handle));
+  source_pair.ConnectAndWait();
+
+  Event ev;
+  ev.WaitFor(3s);
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverRegisterEncodedFrameCallback(
+                source_transceiver_handle, nullptr, nullptr));
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(remote_track_handle, nullptr,
+                                                nullptr);
+
+  // The relayed frames are decoded with their marker intact
+  ASSERT_EQ(0u, push_error_count.load());
+  ASSERT_LT(30u, marker_count) << "Expected at least 10 FPS";
+
+  ASSERT_TRUE(source_pair.WaitExchangeCompletedFor(5s));
+  ASSERT_TRUE(relay_pair.WaitExchangeCompletedFor(5s));
+  mrsLocalVideoTrackRemoveRef(source_track_handle);
+  mrsLocalVideoTrackRemoveRef(relay_track_handle);
+  mrsEncodedVideoTrackSourceRemoveRef(source_handle);
+}
+
+TEST_P(VideoTrackTests, EncodedFrameRecorder) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  constexpr char kPath[] = "mrwebrtc_test_recording.ivf";
+  mrsEncodedFrameRecorderConfig recorder_config{};
+  recorder_config.path = kPath;
+  recorder_config.index_flush_interval_ms = 500;
+
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+    ASSERT_NE(nullptr, transceiver_handle1);
+  }
+
+  // Invalid parameters
+  {
+    mrsEncodedFrameRecorderHandle handle{};
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsEncodedFrameRecorderCreate(transceiver_handle1, nullptr,
+                                            &handle));
+    ASSERT_EQ(Result::kInvalidNativeHandle,
+              mrsEncodedFrameRecorderCreate(nullptr, &recorder_config,
+                                            &handle));
+    mrsEncodedFrameRecorderConfig empty_config{};
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsEncodedFrameRecorderCreate(transceiver_handle1, &empty_config,
+                                            &handle));
+    ASSERT_EQ(nullptr, handle);
+
+    mrsTransceiverHandle audio_transceiver{};
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "audio_transceiver";
+    transceiver_config.media_kind = mrsMediaKind::kAudio;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &audio_transceiver));
+    ASSERT_EQ(Result::kInvalidMediaKind,
+              mrsEncodedFrameRecorderCreate(audio_transceiver,
+                                            &recorder_config, &handle));
+    ASSERT_EQ(nullptr, handle);
+  }
+
+  // Record the transceiver of #2 as soon as it is created, before it is
+  // negotiated.
+  mrsEncodedFrameRecorderHandle recorder_handle{};
+  InteropCallback<const mrsTransceiverAddedInfo*> transceiver_added2_cb =
+      [&](const mrsTransceiverAddedInfo* info) {
+        if (info->media_kind != mrsMediaKind::kVideo) {
+          return;
+        }
+        ASSERT_EQ(Result::kSuccess,
+                  mrsEncodedFrameRecorderCreate(info->transceiver_handle,
+                                                &recorder_config,
+                                                &recorder_handle));
+      };
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(),
+                                                    CB(transceiver_added2_cb));
+
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 320;
+    config.height = 240;
+    config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_track",
+                                                &track_handle1));
+    ASSERT_NE(nullptr, track_handle1);
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_NE(nullptr, recorder_handle);
+
+  Event ev;
+  ev.WaitFor(3s);
+  ASSERT_EQ(Result::kSuccess, mrsEncodedFrameRecorderStop(recorder_handle));
+  mrsPeerConnectionRegisterTransceiverAddedCallback(pair.pc2(), nullptr,
+                                                    nullptr);
+
+  mrsEncodedFrameRecorderStats stats{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsEncodedFrameRecorderGetStats(recorder_handle, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsEncodedFrameRecorderGetStats(recorder_handle, &stats));
+  ASSERT_LT(0u, stats.frames_written);
+  ASSERT_LT(0u, stats.key_frames_written);
+  ASSERT_LE(stats.key_frames_written, stats.frames_written);
+  ASSERT_LT(stats.frames_written, stats.bytes_written);
+  ASSERT_EQ(0u, stats.frames_dropped);
+
+  // Stopping again has no effect
+  ASSERT_EQ(Result::kSuccess, mrsEncodedFrameRecorderStop(recorder_handle));
+  mrsEncodedFrameRecorderRemoveRef(recorder_handle);
+
+  // Check the file header, and that the frame count was finalized.
+  {
+    FILE* file = fopen(kPath, "rb");
+    ASSERT_NE(nullptr, file);
+    uint8_t header[32]{};
+    const size_t read = fread(header, 1, sizeof(header), file);
+    fclose(file);
+    ASSERT_EQ(sizeof(header), read);
+    ASSERT_EQ(0, memcmp(header, "DKIF", 4));
+    const uint32_t frame_count = header[24] | (header[25] << 8) |
+                                 (header[26] << 16) | (header[27] << 24);
+    ASSERT_EQ(stats.frames_written, frame_count);
+  }
+  std::remove(kPath);
+  std::remove((std::string(kPath) + ".idx").c_str());
+
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  mrsLocalVideoTrackRemoveRef(track_handle1);
+}
+
+TEST_P(VideoTrackTests, RemoteTrackPriority) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteVideoTrackSetPriority(
+                nullptr, mrsRemoteVideoTrackPriority::kPaused));
+
+  mrsRemoteVideoTrackHandle track_handle2{};
+  Event track_added2_ev;
+  VideoTrackAddedCallback track_added2_cb =
+      [&track_handle2,
+       &track_added2_ev](const mrsRemoteVideoTrackAddedInfo* info) {
+        track_handle2 = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  mrsTransceiverHandle transceiver_handle1{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video_transceiver_1";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle1));
+  }
+  mrsLocalVideoTrackHandle track_handle1{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 320;
+    config.height = 240;
+    config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_track",
+                                                &track_handle1));
+  }
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                  transceiver_handle1, track_handle1));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+  ASSERT_NE(nullptr, track_handle2);
+
+  mrsRemoteVideoTrackPriority priority{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteVideoTrackGetPriority(track_handle2, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteVideoTrackGetPriority(track_handle2, &priority));
+  ASSERT_EQ(mrsRemoteVideoTrackPriority::kNormal, priority);
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteVideoTrackSetPriority(
+                track_handle2, (mrsRemoteVideoTrackPriority)42));
+
+  std::atomic<uint32_t> frame_count{0};
+  I420VideoFrameCallback i420cb = [&](const I420AVideoFrame&) {
+    ++frame_count;
+  };
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, CB(i420cb));
+
+  // Count the frames delivered during 2 seconds at the given priority.
+  auto count_frames = [&](mrsRemoteVideoTrackPriority priority) {
+    EXPECT_EQ(Result::kSuccess,
+              mrsRemoteVideoTrackSetPriority(track_handle2, priority));
+    frame_count = 0;
+    Event ev;
+    ev.WaitFor(2s);
+    return frame_count.load();
+  };
+  ASSERT_LT(20u, count_frames(mrsRemoteVideoTrackPriority::kNormal));
+  ASSERT_EQ(0u, count_frames(mrsRemoteVideoTrackPriority::kPaused));
+  const uint32_t low_count = count_frames(mrsRemoteVideoTrackPriority::kLow);
+  ASSERT_LT(0u, low_count);
+  ASSERT_GE(11u, low_count);  // 5 FPS, plus one on priority change
+  ASSERT_LT(20u, count_frames(mrsRemoteVideoTrackPriority::kNormal));
+
+  mrsRemoteVideoTrackRegisterI420AFrameCallback(track_handle2, nullptr,
+                                                nullptr);
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  mrsLocalVideoTrackRemoveRef(track_handle1);
+}
+
+TEST_F(VideoTrackTests, FrameScaling) {
+  mrsVideoFrameScaling scaling{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsLocalVideoTrackSetFrameScaling(
+                nullptr, mrsVideoFrameFormat::kArgb32, &scaling));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteVideoTrackSetFrameScaling(
+                nullptr, mrsVideoFrameFormat::kArgb32, &scaling));
+
+  mrsLocalVideoTrackHandle track_handle{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 320;
+    config.height = 240;
+    config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_track",
+                                                &track_handle));
+  }
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalVideoTrackSetFrameScaling(
+                track_handle, (mrsVideoFrameFormat)42, &scaling));
+  scaling.crop_width = 16385;
+  ASSERT_EQ(Result::kOutOfRange,
+            mrsLocalVideoTrackSetFrameScaling(
+                track_handle, mrsVideoFrameFormat::kArgb32, &scaling));
+  scaling = {};
+  scaling.target_height = 0xFFFFFFFFu;
+  ASSERT_EQ(Result::kOutOfRange,
+            mrsLocalVideoTrackSetFrameScaling(
+                track_handle, mrsVideoFrameFormat::kArgb32, &scaling));
+
+  // Scale the ARGB frames to a fixed width, keeping the aspect ratio.
+  scaling = {};
+  scaling.target_width = 80;
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetFrameScaling(
+                track_handle, mrsVideoFrameFormat::kArgb32, &scaling));
+
+  // Crop the bottom right quarter of the I420 frames, without scaling.
+  scaling = {};
+  scaling.crop_x = 160;
+  scaling.crop_y = 120;
+  scaling.crop_width = 160;
+  scaling.crop_height = 120;
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetFrameScaling(
+                track_handle, mrsVideoFrameFormat::kI420A, &scaling));
+
+  std::atomic<uint32_t> argb_count{0};
+  std::atomic<uint32_t> argb_bad_size{0};
+  Argb32VideoFrameCallback argb_cb = [&](const mrsArgb32VideoFrame& frame) {
+    if ((frame.width_ != 80) || (frame.height_ != 60) ||
+        (frame.stride_ < 80 * 4)) {
+      ++argb_bad_size;
+    }
+    ++argb_count;
+  };
+  std::atomic<uint32_t> i420_count{0};
+  std::atomic<uint32_t> i420_bad_size{0};
+  I420VideoFrameCallback i420_cb = [&](const I420AVideoFrame& frame) {
+    if ((frame.width_ != 160) || (frame.height_ != 120) ||
+        (frame.adata_ != nullptr)) {
+      ++i420_bad_size;
+    }
+    ++i420_count;
+  };
+  mrsLocalVideoTrackRegisterArgb32FrameCallback(track_handle, CB(argb_cb));
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, CB(i420_cb));
+  {
+    Event ev;
+    ev.WaitFor(1s);
+  }
+  mrsLocalVideoTrackRegisterArgb32FrameCallback(track_handle, nullptr,
+                                                nullptr);
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, nullptr, nullptr);
+  ASSERT_LT(0u, argb_count.load());
+  ASSERT_LT(0u, i420_count.load());
+  ASSERT_EQ(0u, argb_bad_size.load());
+  ASSERT_EQ(0u, i420_bad_size.load());
+
+  // Transpose the aspect ratio of the ARGB frames. The scratch buffer of the
+  // previous size is large enough in bytes, but its rows are too short.
+  scaling = {};
+  scaling.target_width = 16;
+  scaling.target_height = 240;
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetFrameScaling(
+                track_handle, mrsVideoFrameFormat::kArgb32, &scaling));
+
+  // Crop a thin strip of the I420 frames, such that the width derived from
+  // the target height is clamped to the maximum scaling size.
+  scaling = {};
+  scaling.crop_height = 2;
+  scaling.target_height = 256;
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetFrameScaling(
+                track_handle, mrsVideoFrameFormat::kI420A, &scaling));
+
+  argb_count = 0;
+  std::atomic<uint32_t> tall_bad_size{0};
+  Argb32VideoFrameCallback tall_cb = [&](const mrsArgb32VideoFrame& frame) {
+    if ((frame.width_ != 16) || (frame.height_ != 240) ||
+        (frame.stride_ < 16 * 4)) {
+      ++tall_bad_size;
+    }
+    ++argb_count;
+  };
+  i420_count = 0;
+  std::atomic<uint32_t> wide_bad_size{0};
+  I420VideoFrameCallback wide_cb = [&](const I420AVideoFrame& frame) {
+    if ((frame.width_ != 16384) || (frame.height_ != 256)) {
+      ++wide_bad_size;
+    }
+    ++i420_count;
+  };
+  mrsLocalVideoTrackRegisterArgb32FrameCallback(track_handle, CB(tall_cb));
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, CB(wide_cb));
+  {
+    Event ev;
+    ev.WaitFor(500ms);
+  }
+  mrsLocalVideoTrackRegisterArgb32FrameCallback(track_handle, nullptr,
+                                                nullptr);
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, nullptr, nullptr);
+  ASSERT_LT(0u, argb_count.load());
+  ASSERT_LT(0u, i420_count.load());
+  ASSERT_EQ(0u, tall_bad_size.load());
+  ASSERT_EQ(0u, wide_bad_size.load());
+
+  // Clearing the scaling delivers full frames again.
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalVideoTrackSetFrameScaling(
+                track_handle, mrsVideoFrameFormat::kI420A, nullptr));
+  std::atomic<uint32_t> full_count{0};
+  I420VideoFrameCallback full_cb = [&](const I420AVideoFrame& frame) {
+    if ((frame.width_ == 320) && (frame.height_ == 240)) {
+      ++full_count;
+    }
+  };
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, CB(full_cb));
+  {
+    Event ev;
+    ev.WaitFor(500ms);
+  }
+  mrsLocalVideoTrackRegisterI420AFrameCallback(track_handle, nullptr, nullptr);
+  ASSERT_LT(0u, full_count.load());
+
+  mrsLocalVideoTrackRemoveRef(track_handle);
+}
+
+TEST_F(VideoTrackTests, ExternalVideoCodec) {
+  FakeCodecStats stats;
+  mrsExternalVideoEncoderCallbacks encoder_callbacks{};
+  encoder_callbacks.create = &FakeCodecCreate;
+  encoder_callbacks.destroy = &FakeCodecDestroy;
+  encoder_callbacks.init = &FakeEncoderInit;
+  encoder_callbacks.encode = &FakeEncoderEncode;
+  encoder_callbacks.set_rates = &FakeEncoderSetRates;
+  encoder_callbacks.user_data = &stats;
+  mrsExternalVideoDecoderCallbacks decoder_callbacks{};
+  decoder_callbacks.create = &FakeCodecCreate;
+  decoder_callbacks.destroy = &FakeCodecDestroy;
+  decoder_callbacks.init = &FakeDecoderInit;
+  decoder_callbacks.user_data = &stats;
+
+  // Missing mandatory callbacks and invalid parameters
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRegisterExternalVideoEncoder(nullptr, nullptr,
+                                            &encoder_callbacks));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRegisterExternalVideoDecoder("VP8", nullptr,
+                                            &decoder_callbacks));
+  decoder_callbacks.decode = &FakeDecoderDecode;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRegisterExternalVideoDecoder("VP8", "no_value;",
+                                            &decoder_callbacks));
+
+  ASSERT_EQ(Result::kSuccess, mrsRegisterExternalVideoEncoder(
+                                  "VP8", nullptr, &encoder_callbacks));
+  ASSERT_EQ(Result::kSuccess, mrsRegisterExternalVideoDecoder(
+                                  "vp8", nullptr, &decoder_callbacks));
+
+  {
+    mrsPeerConnectionConfiguration pc_config{};
+    LocalPeerPairRaii pair(pc_config);
+
+    // Codecs cannot change while the library is initialized
+    ASSERT_EQ(Result::kInvalidOperation,
+              mrsRegisterExternalVideoEncoder("VP8", nullptr, nullptr));
+
+    mrsTransceiverHandle transceiver_handle{};
+    {
+      mrsTransceiverInitConfig transceiver_config{};
+      transceiver_config.name = "video_transceiver";
+      transceiver_config.media_kind = mrsMediaKind::kVideo;
+      ASSERT_EQ(Result::kSuccess,
+                mrsPeerConnectionAddTransceiver(
+                    pair.pc1(), &transceiver_config, &transceiver_handle));
+    }
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetCodecPreferences(transceiver_handle, "VP8"));
+    mrsLocalVideoTrackHandle track_handle{};
+    {
+      mrsSyntheticVideoTrackInitConfig config{};
+      config.width = 320;
+      config.height = 240;
+      config.framerate = 30.0;
+      ASSERT_EQ(Result::kSuccess,
+                mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_track",
+                                                  &track_handle));
+    }
+    ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                    transceiver_handle, track_handle));
+
+    mrsRemoteVideoTrackHandle remote_track_handle{};
+    Event track_added_ev;
+    VideoTrackAddedCallback track_added_cb =
+        [&](const mrsRemoteVideoTrackAddedInfo* info) {
+          remote_track_handle = info->track_handle;
+          track_added_ev.Set();
+        };
+    mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                     CB(track_added_cb));
+    pair.ConnectAndWait();
+    ASSERT_TRUE(track_added_ev.WaitFor(5s));
+    ASSERT_NE(nullptr, remote_track_handle);
+
+    // Remote frames are produced by the fake decoder from the payloads of the
+    // fake encoder.
+    std::atomic<uint32_t> frame_count{0};
+    std::atomic<uint32_t> bad_frame_count{0};
+    I420VideoFrameCallback i420cb = [&](const I420AVideoFrame& frame) {
+      const uint8_t* ydata = static_cast<const uint8_t*>(frame.ydata_);
+      if ((frame.width_ != 320) || (frame.height_ != 240) ||
+          (ydata[0] != kFakeCodecLuma)) {
+        ++bad_frame_count;
+      }
+      ++frame_count;
+    };
+    mrsRemoteVideoTrackRegisterI420AFrameCallback(remote_track_handle,
+                                                  CB(i420cb));
+    {
+      Event ev;
+      ev.WaitFor(2s);
+    }
+    mrsRemoteVideoTrackRegisterI420AFrameCallback(remote_track_handle, nullptr,
+                                                  nullptr);
+    ASSERT_LT(0u, stats.encode_count.load());
+    ASSERT_LT(0u, stats.decode_count.load());
+    ASSERT_LT(10u, frame_count.load());
+    ASSERT_EQ(0u, bad_frame_count.load());
+
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+    mrsLocalVideoTrackRemoveRef(track_handle);
+  }
+
+  // All instances are destroyed with the library, which can now unregister
+  // the codecs for the other tests.
+  ASSERT_EQ(0u, stats.instance_count.load());
+  ASSERT_EQ(Result::kSuccess,
+            mrsRegisterExternalVideoEncoder("VP8", nullptr, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRegisterExternalVideoDecoder("VP8", nullptr, nullptr));
+}
+
+TEST_F(VideoTrackTests, RemoteTrackPauseDecoding) {
+  // Use the fake external codec to observe the decoding and key frames.
+  FakeCodecStats stats;
+  mrsExternalVideoEncoderCallbacks encoder_callbacks{};
+  encoder_callbacks.create = &FakeCodecCreate;
+  encoder_callbacks.destroy = &FakeCodecDestroy;
+  encoder_callbacks.init = &FakeEncoderInit;
+  encoder_callbacks.encode = &FakeEncoderEncode;
+  encoder_callbacks.set_rates = &FakeEncoderSetRates;
+  encoder_callbacks.user_data = &stats;
+  mrsExternalVideoDecoderCallbacks decoder_callbacks{};
+  decoder_callbacks.create = &FakeCodecCreate;
+  decoder_callbacks.destroy = &FakeCodecDestroy;
+  decoder_callbacks.init = &FakeDecoderInit;
+  decoder_callbacks.decode = &FakeDecoderDecode;
+  decoder_callbacks.user_data = &stats;
+  ASSERT_EQ(Result::kSuccess, mrsRegisterExternalVideoEncoder(
+                                  "VP8", nullptr, &encoder_callbacks));
+  ASSERT_EQ(Result::kSuccess, mrsRegisterExternalVideoDecoder(
+                                  "VP8", nullptr, &decoder_callbacks));
+
+  {
+    mrsPeerConnectionConfiguration pc_config{};
+    LocalPeerPairRaii pair(pc_config);
+
+    mrsTransceiverHandle transceiver_handle{};
+    {
+      mrsTransceiverInitConfig transceiver_config{};
+      transceiver_config.name = "video_transceiver";
+      transceiver_config.media_kind = mrsMediaKind::kVideo;
+      ASSERT_EQ(Result::kSuccess,
+                mrsPeerConnectionAddTransceiver(
+                    pair.pc1(), &transceiver_config, &transceiver_handle));
+    }
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetCodecPreferences(transceiver_handle, "VP8"));
+    mrsLocalVideoTrackHandle track_handle{};
+    {
+      mrsSyntheticVideoTrackInitConfig config{};
+      config.width = 320;
+      config.height = 240;
+      config.framerate = 30.0;
+      ASSERT_EQ(Result::kSuccess,
+                mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_track",
+                                                  &track_handle));
+    }
+    ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                    transceiver_handle, track_handle));
+
+    mrsRemoteVideoTrackHandle remote_track_handle{};
+    Event track_added_ev;
+    VideoTrackAddedCallback track_added_cb =
+        [&](const mrsRemoteVideoTrackAddedInfo* info) {
+          remote_track_handle = info->track_handle;
+          track_added_ev.Set();
+        };
+    mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                     CB(track_added_cb));
+    pair.ConnectAndWait();
+    ASSERT_TRUE(track_added_ev.WaitFor(5s));
+    ASSERT_NE(nullptr, remote_track_handle);
+
+    std::atomic<uint32_t> frame_count{0};
+    I420VideoFrameCallback i420cb = [&](const I420AVideoFrame&) {
+      ++frame_count;
+    };
+    mrsRemoteVideoTrackRegisterI420AFrameCallback(remote_track_handle,
+                                                  CB(i420cb));
+
+    // The track finds its decoder from the first frames decoded.
+    {
+      Event ev;
+      ev.WaitFor(1s);
+    }
+    ASSERT_LT(10u, frame_count.load());
+
+    // Pausing stops the decoding, once the frame in flight is decoded.
+    ASSERT_EQ(Result::kSuccess,
+              mrsRemoteVideoTrackSetPriority(
+                  remote_track_handle, mrsRemoteVideoTrackPriority::kPaused));
+    {
+      Event ev;
+      ev.WaitFor(300ms);
+    }
+    const uint32_t paused_decode_count = stats.decode_count.load();
+    const uint32_t paused_key_frame_count = stats.key_frame_count.load();
+    frame_count = 0;
+    {
+      Event ev;
+      ev.WaitFor(1s);
+    }
+    ASSERT_EQ(paused_decode_count, stats.decode_count.load());
+    ASSERT_EQ(0u, frame_count.load());
+
+    // Resuming requests a key frame, which the decoding restarts from.
+    ASSERT_EQ(Result::kSuccess,
+              mrsRemoteVideoTrackSetPriority(
+                  remote_track_handle, mrsRemoteVideoTrackPriority::kNormal));
+    {
+      Event ev;
+      ev.WaitFor(2s);
+    }
+    ASSERT_LT(paused_key_frame_count, stats.key_frame_count.load());
+    ASSERT_LT(paused_decode_count, stats.decode_count.load());
+    ASSERT_LT(10u, frame_count.load());
+
+    mrsRemoteVideoTrackRegisterI420AFrameCallback(remote_track_handle, nullptr,
+                                                  nullptr);
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+    mrsLocalVideoTrackRemoveRef(track_handle);
+  }
+
+  ASSERT_EQ(0u, stats.instance_count.load());
+  ASSERT_EQ(Result::kSuccess,
+            mrsRegisterExternalVideoEncoder("VP8", nullptr, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRegisterExternalVideoDecoder("VP8", nullptr, nullptr));
+}
+
+TEST_F(VideoTrackTests, EncoderThreading) {
+  mrsVideoEncoderThreadingConfig threading_config{};
+  threading_config.complexity = (mrsVideoEncoderComplexity)42;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsSetVideoEncoderThreadingConfig("VP8", &threading_config));
+
+  // Ask for more threads than the pool holds, so that the encoder is capped
+  // by the pool.
+  threading_config.thread_count = 3;
+  threading_config.complexity = mrsVideoEncoderComplexity::kHigh;
+  ASSERT_EQ(Result::kSuccess,
+            mrsSetVideoEncoderThreadingConfig("VP8", &threading_config));
+  ASSERT_EQ(Result::kSuccess, mrsSetVideoEncoderThreadPoolSize(2));
+
+  // Use a fake external encoder to observe its number of cores.
+  FakeCodecStats stats;
+  mrsExternalVideoEncoderCallbacks encoder_callbacks{};
+  encoder_callbacks.create = &FakeCodecCreate;
+  encoder_callbacks.destroy = &FakeCodecDestroy;
+  encoder_callbacks.init = &FakeEncoderInit;
+  encoder_callbacks.encode = &FakeEncoderEncode;
+  encoder_callbacks.set_rates = &FakeEncoderSetRates;
+  encoder_callbacks.user_data = &stats;
+  mrsExternalVideoDecoderCallbacks decoder_callbacks{};
+  decoder_callbacks.create = &FakeCodecCreate;
+  decoder_callbacks.destroy = &FakeCodecDestroy;
+  decoder_callbacks.init = &FakeDecoderInit;
+  decoder_callbacks.decode = &FakeDecoderDecode;
+  decoder_callbacks.user_data = &stats;
+  ASSERT_EQ(Result::kSuccess, mrsRegisterExternalVideoEncoder(
+                                  "VP8", nullptr, &encoder_callbacks));
+  ASSERT_EQ(Result::kSuccess, mrsRegisterExternalVideoDecoder(
+                                  "VP8", nullptr, &decoder_callbacks));
+
+  {
+    mrsPeerConnectionConfiguration pc_config{};
+    LocalPeerPairRaii pair(pc_config);
+
+    // The configuration cannot change while the library is initialized
+    ASSERT_EQ(Result::kInvalidOperation,
+              mrsSetVideoEncoderThreadingConfig(nullptr, nullptr));
+    ASSERT_EQ(Result::kInvalidOperation, mrsSetVideoEncoderThreadPoolSize(0));
+
+    mrsTransceiverHandle transceiver_handle{};
+    {
+      mrsTransceiverInitConfig transceiver_config{};
+      transceiver_config.name = "video_transceiver";
+      transceiver_config.media_kind = mrsMediaKind::kVideo;
+      ASSERT_EQ(Result::kSuccess,
+                mrsPeerConnectionAddTransceiver(
+                    pair.pc1(), &transceiver_config, &transceiver_handle));
+    }
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetCodecPreferences(transceiver_handle, "VP8"));
+    mrsLocalVideoTrackHandle track_handle{};
+    {
+      mrsSyntheticVideoTrackInitConfig config{};
+      config.width = 320;
+      config.height = 240;
+      config.framerate = 30.0;
+      ASSERT_EQ(Result::kSuccess,
+                mrsLocalVideoTrackCreateSynthetic(&config, "synthetic_track",
+                                                  &track_handle));
+    }
+    ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                    transceiver_handle, track_handle));
+    pair.ConnectAndWait();
+    {
+      Event ev;
+      ev.WaitFor(1s);
+    }
+    ASSERT_LT(0u, stats.encode_count.load());
+    ASSERT_EQ(2u, stats.encoder_cores.load());
+
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+    mrsLocalVideoTrackRemoveRef(track_handle);
+  }
+
+  // Restore the defaults for the other tests, now that the library shut down.
+  ASSERT_EQ(0u, stats.instance_count.load());
+  ASSERT_EQ(Result::kSuccess,
+            mrsRegisterExternalVideoEncoder("VP8", nullptr, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRegisterExternalVideoDecoder("VP8", nullptr, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsSetVideoEncoderThreadingConfig("VP8", nullptr));
+  ASSERT_EQ(Result::kSuccess, mrsSetVideoEncoderThreadPoolSize(0));
+}
+
+namespace {
+
+/// Encode a synthetic 320x240 track once with a shared VP8 encoder, send it to
+/// |peer_count| peers, and check that each peer decodes more than 10 frames
+/// for which |is_expected_frame| returns true.
+void RunSharedEncoderFanOut(
+    const mrsPeerConnectionConfiguration& pc_config,
+    int peer_count,
+    std::function<bool(const I420AVideoFrame&)> is_expected_frame) {
+  // Source track encoded once by the shared encoder
+  mrsLocalVideoTrackHandle source_track_handle{};
+  {
+    mrsSyntheticVideoTrackInitConfig config{};
+    config.width = 320;
+    config.height = 240;
+    config.framerate = 30.0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateSynthetic(&config, "source_track",
+                                                &source_track_handle));
+  }
+  mrsSharedVideoEncoderConfig encoder_config{};
+  mrsEncodedVideoTrackSourceHandle source_handle{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsEncodedVideoTrackSourceCreateFromTrack(
+                nullptr, &encoder_config, &source_handle));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsEncodedVideoTrackSourceCreateFromTrack(
+                (void*)0x1, &encoder_config, &source_handle));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsEncodedVideoTrackSourceCreateFromTrack(
+                source_track_handle, &encoder_config, nullptr));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsEncodedVideoTrackSourceCreateFromTrack(
+                source_track_handle, &encoder_config, &source_handle));
+  encoder_config.codec_name = "VP8";
+  encoder_config.bitrate_kbps = 0;
+  ASSERT_EQ(Result::kOutOfRange,
+            mrsEncodedVideoTrackSourceCreateFromTrack(
+                source_track_handle, &encoder_config, &source_handle));
+  encoder_config.bitrate_kbps = 500;
+  ASSERT_EQ(Result::kSuccess,
+            mrsEncodedVideoTrackSourceCreateFromTrack(
+                source_track_handle, &encoder_config, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  // Send the encoded frames to several peers, each through its own track.
+  std::vector<std::unique_ptr<LocalPeerPairRaii>> pairs;
+  std::vector<mrsLocalVideoTrackHandle> track_handles;
+  std::vector<mrsRemoteVideoTrackHandle> remote_track_handles(peer_count);
+  std::vector<VideoTrackAddedCallback> track_added_cbs(peer_count);
+  std::vector<std::atomic<uint32_t>> frame_counts(peer_count);
+  std::vector<I420VideoFrameCallback> i420_cbs(peer_count);
+  for (int i = 0; i < peer_count; ++i) {
+    pairs.push_back(std::make_unique<LocalPeerPairRaii>(pc_config));
+    LocalPeerPairRaii& pair = *pairs.back();
+    mrsLocalVideoTrackHandle track_handle{};
+    ASSERT_EQ(Result::kSuccess,
+              mrsLocalVideoTrackCreateFromEncodedSource(
+                  source_handle, "fan_out_track", &track_handle));
+    track_handles.push_back(track_handle);
+    mrsTransceiverHandle transceiver_handle{};
+    {
+      mrsTransceiverInitConfig transceiver_config{};
+      transceiver_config.name = "fan_out_transceiver";
+      transceiver_config.media_kind = mrsMediaKind::kVideo;
+      ASSERT_EQ(Result::kSuccess,
+                mrsPeerConnectionAddTransceiver(
+                    pair.pc1(), &transceiver_config, &transceiver_handle));
+    }
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetCodecPreferences(transceiver_handle, "VP8"));
+    ASSERT_EQ(Result::kSuccess, mrsTransceiverSetLocalVideoTrack(
+                                    transceiver_handle, track_handle));
+    Event track_added_ev;
+    track_added_cbs[i] = [&, i](const mrsRemoteVideoTrackAddedInfo* info) {
+      remote_track_handles[i] = info->track_handle;
+      track_added_ev.Set();
+    };
+    mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(),
+                                                     CB(track_added_cbs[i]));
+    pair.ConnectAndWait();
+    ASSERT_TRUE(track_added_ev.WaitFor(5s));
+    mrsPeerConnectionRegisterVideoTrackAddedCallback(pair.pc2(), nullptr,
+                                                     nullptr);
+    ASSERT_NE(nullptr, remote_track_handles[i]);
+    i420_cbs[i] = [&, i](const I420AVideoFrame& frame) {
+      if ((frame.width_ == 320) && (frame.height_ == 240) &&
+          is_expected_frame(frame)) {
+        ++frame_counts[i];
+      }
+    };
+    mrsRemoteVideoTrackRegisterI420AFrameCallback(remote_track_handles[i],
+                                                  CB(i420_cbs[i]));
+  }
+
+  // Peers joining late get a key frame, and all of them decode the stream.
+  {
+    Event ev;
+    ev.WaitFor(3s);
+  }
+  for (int i = 0; i < peer_count; ++i) {
+    mrsRemoteVideoTrackRegisterI420AFrameCallback(remote_track_handles[i],
+                                                  nullptr, nullptr);
+    ASSERT_LT(10u, frame_counts[i].load()) << "Peer #" << i;
+  }
+
+  for (int i = 0; i < peer_count; ++i) {
+    ASSERT_TRUE(pairs[i]->WaitExchangeCompletedFor(5s));
+    mrsLocalVideoTrackRemoveRef(track_handles[i]);
+  }
+  pairs.clear();
+  mrsEncodedVideoTrackSourceRemoveRef(source_handle);
+  mrsLocalVideoTrackRemoveRef(source_track_handle);
+}
+
+}  // namespace
+
+TEST_P(VideoTrackTests, SharedEncoderFanOut) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+
+  // Use a fake external VP8 codec to count the encoder instances actually
+  // encoding frames. The peer connections still create their own encoder for
+  // raw frames, but these must stay idle.
+  FakeCodecStats encoder_stats;
+  FakeCodecStats decoder_stats;
+  mrsExternalVideoEncoderCallbacks encoder_callbacks{};
+  encoder_callbacks.create = &FakeCodecCreate;
+  encoder_callbacks.destroy = &FakeCodecDestroy;
+  encoder_callbacks.init = &FakeEncoderInit;
+  encoder_callbacks.encode = &FakeEncoderEncode;
+  encoder_callbacks.set_rates = &FakeEncoderSetRates;
+  encoder_callbacks.user_data = &encoder_stats;
+  mrsExternalVideoDecoderCallbacks decoder_callbacks{};
+  decoder_callbacks.create = &FakeCodecCreate;
+  decoder_callbacks.destroy = &FakeCodecDestroy;
+  decoder_callbacks.init = &FakeDecoderInit;
+  decoder_callbacks.decode = &FakeDecoderDecode;
+  decoder_callbacks.user_data = &decoder_stats;
+  ASSERT_EQ(Result::kSuccess, mrsRegisterExternalVideoEncoder(
+                                  "VP8", nullptr, &encoder_callbacks));
+  ASSERT_EQ(Result::kSuccess, mrsRegisterExternalVideoDecoder(
+                                  "VP8", nullptr, &decoder_callbacks));
+
+  ASSERT_NO_FATAL_FAILURE(RunSharedEncoderFanOut(
+      pc_config, 3, [](const I420AVideoFrame& frame) {
+        const uint8_t* ydata = static_cast<const uint8_t*>(frame.ydata_);
+        return (ydata[0] == kFakeCodecLuma);
+      }));
+
+  // A single encoder produced the frames received by all peers.
+  ASSERT_EQ(1u, encoder_stats.encoding_instance_count.load());
+  ASSERT_LT(0u, encoder_stats.encode_count.load());
+
+  // All instances are destroyed with the library, which can now unregister
+  // the codecs for the other tests.
+  ASSERT_EQ(0u, encoder_stats.instance_count.load());
+  ASSERT_EQ(0u, decoder_stats.instance_count.load());
+  ASSERT_EQ(Result::kSuccess,
+            mrsRegisterExternalVideoEncoder("VP8", nullptr, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsRegisterExternalVideoDecoder("VP8", nullptr, nullptr));
+}
+
+TEST_P(VideoTrackTests, SharedEncoderFanOutBuiltin) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+
+  // Without any external codec, the shared encoder uses the built-in VP8
+  // encoder, and the peers the built-in decoder. The frames must decode to
+  // the synthetic content, marker included, on peers joining at different
+  // times.
+  ASSERT_NO_FATAL_FAILURE(RunSharedEncoderFanOut(
+      pc_config, 3, [](const I420AVideoFrame& frame) {
+        mrsSyntheticVideoFrameMarker marker{};
+        return (mrsSyntheticVideoFrameReadMarker(&frame, &marker) ==
+                Result::kSuccess);
+      }));
+}